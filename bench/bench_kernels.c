@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "scene_generator.h"
+#include "../src/resampler/resampler.h"
+#include "../src/index_calculator/index_calculator.h"
+#include "../src/visualization/visualization.h"
+#include "../src/data_saver/data_saver.h"
+#include "../src/utils/utils.h"
+#include "../src/raster_pool/raster_pool.h"
+#include "../src/band_math/band_math.h"
+#include "../src/tiled_bands/tiled_bands.h"
+#include "../src/block_index/block_index.h"
+
+#define BYTES_PER_GB 1e9
+// Zapytanie progowe indeksu bloków: piksele NDMI w [-1, -0.2] (susza)
+#define QUERY_MIN_VALUE -1.0f
+#define QUERY_MAX_VALUE -0.2f
+
+typedef struct
+{
+    int size_10m;
+    double cloud_fraction;
+    int repeat;
+    char* output_dir;
+} BenchOptions;
+
+/**
+ * @brief Wynik pomiaru jednego jądra
+ *
+ * bytes to minimalny ruch pamięci jądra (odczyt wejść + zapis wyjść), z którego liczona jest
+ * przepustowość i dolna granica czasu wynikająca z przepustowości pamięci (roofline).
+ */
+typedef struct
+{
+    const char* name;
+    double best_s;
+    size_t bytes;
+    size_t pixels;
+    int memory_bound;
+} KernelResult;
+
+// Kontekst przekazywany do mierzonych jąder
+typedef struct
+{
+    const SyntheticScene* scene;
+    float* out_10m;
+    float* out_20m;
+    float* scl_10m;
+    float* b11_10m;
+    float* ndvi;
+    float* index_out[2];
+    BandMathProgram* index_programs[2];
+    // B04, B08, B11 i SCL spakowane w kafle dla wariantu kaflowego band_math
+    TiledBands tiled;
+    GdkPixbuf* pixbuf;
+    const char* png_path;
+    // NDMI float i int16 z indeksami bloków dla zapytania progowego
+    float* ndmi;
+    int16_t* ndmi_int16;
+    BlockIndex ndmi_blocks;
+    BlockIndex ndmi_int16_blocks;
+    // Wyniki zapytania: pełne przejście, indeks bloków float, indeks bloków int16
+    uint64_t query_counts[3];
+} BenchContext;
+
+typedef void (*KernelFunc)(BenchContext* ctx);
+
+// ====== POMOCNICZE ======
+static int parse_bench_options(int* argc, char*** argv, BenchOptions* options);
+static double measure_stream_bandwidth(size_t count, int repeat);
+static double time_best_of(KernelFunc kernel, BenchContext* ctx, int repeat);
+static void print_result(const KernelResult* result, double stream_gbps);
+
+// ====== JĄDRA ======
+static void kernel_nearest(BenchContext* ctx);
+static void kernel_bilinear(BenchContext* ctx);
+static void kernel_average(BenchContext* ctx);
+static void kernel_index(BenchContext* ctx);
+static void kernel_index_pair(BenchContext* ctx);
+static void kernel_band_math_pair(BenchContext* ctx);
+static void kernel_band_math_pair_stats(BenchContext* ctx);
+static void kernel_band_math_pair_tiled(BenchContext* ctx);
+static void kernel_tiled_pack(BenchContext* ctx);
+static void kernel_pixbuf(BenchContext* ctx);
+static void kernel_png(BenchContext* ctx);
+static void kernel_threshold_scan(BenchContext* ctx);
+static void kernel_block_index_count(BenchContext* ctx);
+static void kernel_block_index_count_int16(BenchContext* ctx);
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (parse_bench_options(&argc, &argv, &options) != 0)
+    {
+        return 1;
+    }
+
+    SyntheticScene scene;
+    if (synthetic_scene_generate(&scene, options.size_10m, options.size_10m, options.cloud_fraction, 2024) != 0)
+    {
+        return 1;
+    }
+
+    size_t pixels_10m = (size_t)scene.width_10m * scene.height_10m;
+    size_t pixels_20m = (size_t)scene.width_20m * scene.height_20m;
+
+    BenchContext ctx = {0};
+    ctx.scene = &scene;
+    ctx.out_10m = malloc(pixels_10m * sizeof(float));
+    ctx.out_20m = malloc(pixels_20m * sizeof(float));
+    ctx.scl_10m = malloc(pixels_10m * sizeof(float));
+    ctx.b11_10m = malloc(pixels_10m * sizeof(float));
+    ctx.index_out[0] = malloc(pixels_10m * sizeof(float));
+    ctx.index_out[1] = malloc(pixels_10m * sizeof(float));
+    ctx.index_programs[0] = band_math_compile_builtin("NDVI");
+    ctx.index_programs[1] = band_math_compile_builtin("NDMI");
+
+    char png_path[512];
+    snprintf(png_path, sizeof(png_path), "%s/bench_ndvi.png", options.output_dir);
+    ctx.png_path = png_path;
+
+    if (!ctx.out_10m || !ctx.out_20m || !ctx.scl_10m || !ctx.b11_10m || !ctx.index_out[0] || !ctx.index_out[1] ||
+        !ctx.index_programs[0] || !ctx.index_programs[1])
+    {
+        fprintf(stderr, "[%s] Błąd alokacji buforów benchmarku.\n", get_timestamp());
+        return 1;
+    }
+
+    // Dane wejściowe dla jąder zależnych: SCL, B11 i NDVI w rozdzielczości 10m
+    perform_nearest_neighbor_resample(scene.scl, ctx.scl_10m, scene.width_20m, scene.height_20m,
+                                      scene.width_10m, scene.height_10m);
+    perform_bilinear_resample(scene.b11, ctx.b11_10m, scene.width_20m, scene.height_20m,
+                              scene.width_10m, scene.height_10m);
+    ctx.ndvi = calculate_index_base(scene.b08, scene.b04, scene.width_10m, scene.height_10m, ctx.scl_10m, "NDVI");
+    ctx.pixbuf = ctx.ndvi ? generate_pixbuf_from_index_data(ctx.ndvi, scene.width_10m, scene.height_10m) : NULL;
+    const float* tiled_inputs[] = {scene.b04, scene.b08, ctx.b11_10m, ctx.scl_10m};
+    if (!ctx.pixbuf || tiled_bands_pack(&ctx.tiled, tiled_inputs, 4, pixels_10m, 0) != 0)
+    {
+        return 1;
+    }
+
+    // NDMI w obu reprezentacjach i ich indeksy bloków dla zapytania progowego
+    ctx.ndmi = calculate_index_base(scene.b08, ctx.b11_10m, scene.width_10m, scene.height_10m, ctx.scl_10m, "NDMI");
+    ctx.ndmi_int16 = malloc(pixels_10m * sizeof(int16_t));
+    if (!ctx.ndmi || !ctx.ndmi_int16)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji buforów benchmarku.\n", get_timestamp());
+        return 1;
+    }
+    quantize_index_values(ctx.ndmi, pixels_10m, ctx.ndmi_int16);
+    if (block_index_build(&ctx.ndmi_blocks, ctx.ndmi, scene.width_10m, scene.height_10m, 0) != 0 ||
+        block_index_build_quantized(&ctx.ndmi_int16_blocks, ctx.ndmi_int16, scene.width_10m, scene.height_10m, 0) != 0)
+    {
+        return 1;
+    }
+
+    size_t pixbuf_bytes = pixels_10m * gdk_pixbuf_get_n_channels(ctx.pixbuf);
+
+    // Przepustowość pamięci na tablicach większych niż cache, jak bufory pasm
+    double stream_gbps = measure_stream_bandwidth(pixels_10m, options.repeat);
+
+    KernelResult results[] = {
+        {"resample nearest (SCL 20m->10m)", time_best_of(kernel_nearest, &ctx, options.repeat),
+            (pixels_20m + pixels_10m) * sizeof(float), pixels_10m, 1},
+        {"resample bilinear (B11 20m->10m)", time_best_of(kernel_bilinear, &ctx, options.repeat),
+            (pixels_20m + pixels_10m) * sizeof(float), pixels_10m, 1},
+        {"resample average (B04 10m->20m)", time_best_of(kernel_average, &ctx, options.repeat),
+            (pixels_10m + pixels_20m) * sizeof(float), pixels_20m, 1},
+        {"calculate_index_base (NDVI 10m)", time_best_of(kernel_index, &ctx, options.repeat),
+            4 * pixels_10m * sizeof(float), pixels_10m, 1},
+        // NDVI i NDMI: dwa osobne przebiegi czytają B08 i SCL dwukrotnie, band_math raz
+        {"calculate_index_base x2 (NDVI+NDMI)", time_best_of(kernel_index_pair, &ctx, options.repeat),
+            8 * pixels_10m * sizeof(float), pixels_10m, 1},
+        {"band_math fused (NDVI+NDMI)", time_best_of(kernel_band_math_pair, &ctx, options.repeat),
+            6 * pixels_10m * sizeof(float), pixels_10m, 1},
+        // Statystyki z bloków w L1 - ten sam ruch w pamięci co bez statystyk
+        {"band_math fused + stats (NDVI+NDMI)", time_best_of(kernel_band_math_pair_stats, &ctx, options.repeat),
+            6 * pixels_10m * sizeof(float), pixels_10m, 1},
+        // Te same wejścia jako jeden strumień kafli zamiast czterech osobnych tablic
+        {"band_math tiled + stats (NDVI+NDMI)", time_best_of(kernel_band_math_pair_tiled, &ctx, options.repeat),
+            6 * pixels_10m * sizeof(float), pixels_10m, 1},
+        {"tiled_bands_pack (4 pasma)", time_best_of(kernel_tiled_pack, &ctx, options.repeat),
+            8 * pixels_10m * sizeof(float), pixels_10m, 1},
+        {"generate_pixbuf_from_index_data", time_best_of(kernel_pixbuf, &ctx, options.repeat),
+            pixels_10m * sizeof(float) + pixbuf_bytes, pixels_10m, 1},
+        // Kompresja PNG jest ograniczona obliczeniami, nie pamięcią
+        {"save_pixbuf_to_png", time_best_of(kernel_png, &ctx, 1), pixbuf_bytes, pixels_10m, 0},
+        // Zapytanie progowe: pełne przejście czyta cały raster, indeks bloków tylko bloki przecięte
+        // progiem, więc dla niego GB/s to przepustowość efektywna względem pełnego rastra
+        {"threshold count - full scan (NDMI)", time_best_of(kernel_threshold_scan, &ctx, options.repeat),
+            pixels_10m * sizeof(float), pixels_10m, 1},
+        {"block_index_count_in_range (NDMI)", time_best_of(kernel_block_index_count, &ctx, options.repeat),
+            pixels_10m * sizeof(float), pixels_10m, 0},
+        {"block_index_count_in_range int16", time_best_of(kernel_block_index_count_int16, &ctx, options.repeat),
+            pixels_10m * sizeof(int16_t), pixels_10m, 0}
+    };
+
+    printf("\nScena %dx%d (10m), chmury %.0f%%, wątki OpenMP: %d, powtórzenia: %d\n",
+           scene.width_10m, scene.height_10m, options.cloud_fraction * 100.0, omp_get_max_threads(), options.repeat);
+    printf("Przepustowość pamięci (STREAM triad): %.2f GB/s\n\n", stream_gbps);
+    printf("%-36s %10s %10s %10s %12s %10s\n", "jądro", "czas [s]", "Mpix/s", "GB/s", "roofline [s]", "% roofline");
+
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+    {
+        print_result(&results[i], stream_gbps);
+    }
+
+    // Wynik int16 może różnić się od float tylko o piksele leżące w odległości do 0.00005 od progu
+    size_t candidate_blocks = block_index_select(&ctx.ndmi_blocks, QUERY_MIN_VALUE, QUERY_MAX_VALUE, 0.0, NULL);
+    printf("\nZapytanie NDMI w [%.1f, %.1f]: pełne przejście %llu, indeks bloków %llu (%s), int16 %llu; "
+           "bloki kandydujące %zu z %zu\n", QUERY_MIN_VALUE, QUERY_MAX_VALUE,
+           (unsigned long long)ctx.query_counts[0], (unsigned long long)ctx.query_counts[1],
+           ctx.query_counts[0] == ctx.query_counts[1] ? "zgodne" : "NIEZGODNE",
+           (unsigned long long)ctx.query_counts[2], candidate_blocks, block_index_block_count(&ctx.ndmi_blocks));
+
+    g_object_unref(ctx.pixbuf);
+    tiled_bands_free(&ctx.tiled);
+    raster_pool_release(ctx.ndvi);
+    raster_pool_release(ctx.ndmi);
+    free(ctx.ndmi_int16);
+    block_index_free(&ctx.ndmi_blocks);
+    block_index_free(&ctx.ndmi_int16_blocks);
+    free(ctx.out_10m);
+    free(ctx.out_20m);
+    free(ctx.scl_10m);
+    free(ctx.b11_10m);
+    free(ctx.index_out[0]);
+    free(ctx.index_out[1]);
+    band_math_free(ctx.index_programs[0]);
+    band_math_free(ctx.index_programs[1]);
+    synthetic_scene_free(&scene);
+    g_free(options.output_dir);
+    return 0;
+}
+
+static int parse_bench_options(int* argc, char*** argv, BenchOptions* options)
+{
+    options->size_10m = S2_TILE_SIZE_10M;
+    options->cloud_fraction = 0.3;
+    options->repeat = 5;
+    options->output_dir = NULL;
+
+    GOptionEntry entries[] = {
+        {"size", 0, 0, G_OPTION_ARG_INT, &options->size_10m, "Rozmiar sceny w pikselach 10m (domyślnie 10980)", "N"},
+        {"cloud", 0, 0, G_OPTION_ARG_DOUBLE, &options->cloud_fraction, "Udział chmur w SCL (domyślnie 0.3)", "UDZIAŁ"},
+        {"repeat", 0, 0, G_OPTION_ARG_INT, &options->repeat, "Liczba powtórzeń pomiaru (najlepszy czas)", "N"},
+        {"output-dir", 0, 0, G_OPTION_ARG_FILENAME, &options->output_dir, "Katalog na pliki wyjściowe (domyślnie /tmp)", "KATALOG"},
+        G_OPTION_ENTRY_NULL
+    };
+
+    GOptionContext* context = g_option_context_new("- benchmarki jąder obliczeniowych");
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    GError* error = NULL;
+    gboolean parsed = g_option_context_parse(context, argc, argv, &error);
+    g_option_context_free(context);
+
+    if (!parsed)
+    {
+        fprintf(stderr, "Błąd parsowania opcji: %s\n", error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    if (options->size_10m < 2 || options->repeat < 1)
+    {
+        fprintf(stderr, "Nieprawidłowy rozmiar sceny lub liczba powtórzeń.\n");
+        return -1;
+    }
+
+    if (!options->output_dir)
+    {
+        options->output_dir = g_strdup("/tmp");
+    }
+    return 0;
+}
+
+// Triada STREAM a[i] = b[i] + s * c[i] - odczyt dwóch tablic i zapis jednej
+static double measure_stream_bandwidth(size_t count, int repeat)
+{
+    float* a = malloc(count * sizeof(float));
+    float* b = malloc(count * sizeof(float));
+    float* c = malloc(count * sizeof(float));
+    if (!a || !b || !c)
+    {
+        free(a);
+        free(b);
+        free(c);
+        return 0.0;
+    }
+
+    #pragma omp parallel for shared(a, b, c)
+    for (size_t i = 0; i < count; i++)
+    {
+        a[i] = 0.0f;
+        b[i] = 1.0f;
+        c[i] = 2.0f;
+    }
+
+    double best = -1.0;
+    for (int r = 0; r < repeat + 1; r++)
+    {
+        double start = omp_get_wtime();
+        #pragma omp parallel for shared(a, b, c)
+        for (size_t i = 0; i < count; i++)
+        {
+            a[i] = b[i] + 3.0f * c[i];
+        }
+        double elapsed = omp_get_wtime() - start;
+        // Pierwszy przebieg jest rozgrzewką
+        if (r > 0 && (best < 0.0 || elapsed < best))
+        {
+            best = elapsed;
+        }
+    }
+
+    free(a);
+    free(b);
+    free(c);
+    return 3.0 * count * sizeof(float) / best / BYTES_PER_GB;
+}
+
+static double time_best_of(KernelFunc kernel, BenchContext* ctx, int repeat)
+{
+    // Rozgrzewka: strony buforów wyjściowych i wątki puli OpenMP
+    kernel(ctx);
+
+    double best = -1.0;
+    for (int r = 0; r < repeat; r++)
+    {
+        double start = omp_get_wtime();
+        kernel(ctx);
+        double elapsed = omp_get_wtime() - start;
+        if (best < 0.0 || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static void print_result(const KernelResult* result, double stream_gbps)
+{
+    double gbps = result->bytes / result->best_s / BYTES_PER_GB;
+    double mpix = result->pixels / result->best_s / 1e6;
+
+    if (result->memory_bound && stream_gbps > 0.0)
+    {
+        double roofline_s = result->bytes / (stream_gbps * BYTES_PER_GB);
+        printf("%-36s %10.4f %10.1f %10.2f %12.4f %9.1f%%\n",
+               result->name, result->best_s, mpix, gbps, roofline_s, 100.0 * roofline_s / result->best_s);
+    }
+    else
+    {
+        printf("%-36s %10.4f %10.1f %10.2f %12s %10s\n", result->name, result->best_s, mpix, gbps, "-", "-");
+    }
+}
+
+static void kernel_nearest(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    perform_nearest_neighbor_resample(s->scl, ctx->out_10m, s->width_20m, s->height_20m, s->width_10m, s->height_10m);
+}
+
+static void kernel_bilinear(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    perform_bilinear_resample(s->b11, ctx->out_10m, s->width_20m, s->height_20m, s->width_10m, s->height_10m);
+}
+
+static void kernel_average(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    perform_average_resample(s->b04, ctx->out_20m, s->width_10m, s->height_10m, s->width_20m, s->height_20m);
+}
+
+static void kernel_index(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    raster_pool_release(calculate_index_base(s->b08, s->b04, s->width_10m, s->height_10m, ctx->scl_10m, "NDVI"));
+}
+
+static void kernel_index_pair(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    raster_pool_release(calculate_index_base(s->b08, s->b04, s->width_10m, s->height_10m, ctx->scl_10m, "NDVI"));
+    raster_pool_release(calculate_index_base(s->b08, ctx->b11_10m, s->width_10m, s->height_10m, ctx->scl_10m, "NDMI"));
+}
+
+static void kernel_band_math_pair(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    const float* bands[BAND_MATH_BAND_COUNT] = {NULL};
+    bands[band_registry_find("B04")] = s->b04;
+    bands[band_registry_find("B08")] = s->b08;
+    bands[band_registry_find("B11")] = ctx->b11_10m;
+    band_math_evaluate(ctx->index_programs, 2, bands, ctx->scl_10m, (size_t)s->width_10m * s->height_10m,
+                       ctx->index_out);
+}
+
+static void kernel_band_math_pair_stats(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    const float* bands[BAND_MATH_BAND_COUNT] = {NULL};
+    bands[band_registry_find("B04")] = s->b04;
+    bands[band_registry_find("B08")] = s->b08;
+    bands[band_registry_find("B11")] = ctx->b11_10m;
+
+    IndexStats stats[2];
+    index_stats_reset(&stats[0]);
+    index_stats_reset(&stats[1]);
+    band_math_evaluate_with_stats(ctx->index_programs, 2, bands, ctx->scl_10m, (size_t)s->width_10m * s->height_10m,
+                                  ctx->index_out, stats);
+}
+
+static void kernel_band_math_pair_tiled(BenchContext* ctx)
+{
+    int slots[BAND_MATH_BAND_COUNT];
+    for (int b = 0; b < BAND_MATH_BAND_COUNT; b++)
+    {
+        slots[b] = -1;
+    }
+    slots[band_registry_find("B04")] = 0;
+    slots[band_registry_find("B08")] = 1;
+    slots[band_registry_find("B11")] = 2;
+
+    IndexStats stats[2];
+    index_stats_reset(&stats[0]);
+    index_stats_reset(&stats[1]);
+    band_math_evaluate_tiled(ctx->index_programs, 2, &ctx->tiled, slots, 3, ctx->index_out, stats);
+}
+
+static void kernel_tiled_pack(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    const float* inputs[] = {s->b04, s->b08, ctx->b11_10m, ctx->scl_10m};
+    for (int band = 0; band < 4; band++)
+    {
+        tiled_bands_store(&ctx->tiled, band, inputs[band]);
+    }
+}
+
+static void kernel_pixbuf(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    GdkPixbuf* pixbuf = generate_pixbuf_from_index_data(ctx->ndvi, s->width_10m, s->height_10m);
+    if (pixbuf)
+    {
+        g_object_unref(pixbuf);
+    }
+}
+
+static void kernel_png(BenchContext* ctx)
+{
+    save_pixbuf_to_png(ctx->pixbuf, ctx->png_path);
+}
+
+static void kernel_threshold_scan(BenchContext* ctx)
+{
+    const SyntheticScene* s = ctx->scene;
+    long long pixels = (long long)s->width_10m * s->height_10m;
+    const float* values = ctx->ndmi;
+    uint64_t count = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+:count)
+    for (long long i = 0; i < pixels; i++)
+    {
+        count += values[i] != INDEX_NO_DATA_VALUE && values[i] >= QUERY_MIN_VALUE && values[i] <= QUERY_MAX_VALUE;
+    }
+    ctx->query_counts[0] = count;
+}
+
+static void kernel_block_index_count(BenchContext* ctx)
+{
+    ctx->query_counts[1] = block_index_count_in_range(&ctx->ndmi_blocks, ctx->ndmi, QUERY_MIN_VALUE, QUERY_MAX_VALUE);
+}
+
+static void kernel_block_index_count_int16(BenchContext* ctx)
+{
+    ctx->query_counts[2] = block_index_count_in_range_quantized(&ctx->ndmi_int16_blocks, ctx->ndmi_int16,
+                                                                QUERY_MIN_VALUE, QUERY_MAX_VALUE);
+}
@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include <glib.h>
+
+#include "scene_generator.h"
+#include "../src/pipeline_context/pipeline_context.h"
+#include "../src/metrics/metrics.h"
+#include "../src/raster_pool/raster_pool.h"
+#include "../src/utils/utils.h"
+
+#define MAX_SWEEP_VALUES 16
+#define STAGE_COUNT (sizeof(STAGES) / sizeof(STAGES[0]))
+
+/**
+ * @brief Etapy pipeline'u mierzone przez harness (nazwy metryk "pipeline")
+ *
+ * Wczytywanie jest pierwsze - pętla po 4 pasmach w load_bands_data ma tylko 4 iteracje,
+ * więc jej przyspieszenie jest ograniczone do 4 niezależnie od liczby wątków.
+ */
+static const char* STAGES[] = {
+    "total",
+    "wczytywanie",
+    "resampling",
+    // NDVI i NDMI liczone są razem przez band_math w jednym etapie
+    "wskaźniki"
+};
+
+typedef struct
+{
+    int threads[MAX_SWEEP_VALUES];
+    int thread_count;
+    int sizes[MAX_SWEEP_VALUES];
+    int size_count;
+    double cloud_fraction;
+    int repeat;
+    gboolean weak;
+    double threshold;
+    char* work_dir;
+    char* csv_path;
+} HarnessOptions;
+
+// Najlepsze czasy etapów jednej konfiguracji (rozmiar, rozdzielczość, wątki)
+typedef struct
+{
+    int size;
+    int threads;
+    double wall_s[STAGE_COUNT];
+} Measurement;
+
+// ====== POMOCNICZE ======
+static int parse_harness_options(int* argc, char*** argv, HarnessOptions* options);
+static int parse_int_list(const char* text, int* values, int max_values);
+static int prepare_scene_files(const HarnessOptions* options, int size, char paths[4][512]);
+static int measure_configuration(char paths[4][512], int size, bool target_10m, int threads, int repeat,
+                                 Measurement* measurement);
+static int run_pipeline_once(char paths[4][512], bool target_10m);
+static void report_series(FILE* csv, const HarnessOptions* options, const char* resolution,
+                          const Measurement* series, int count);
+static double karp_flatt_serial_fraction(double speedup, int threads);
+
+int main(int argc, char* argv[])
+{
+    HarnessOptions options;
+    if (parse_harness_options(&argc, &argv, &options) != 0)
+    {
+        return 1;
+    }
+
+    pipeline_global_init();
+
+    FILE* csv = fopen(options.csv_path, "w");
+    if (!csv)
+    {
+        fprintf(stderr, "[%s] Nie można otworzyć pliku CSV %s.\n", get_timestamp(), options.csv_path);
+        return 1;
+    }
+    fprintf(csv, "mode,size,resolution,threads,stage,wall_s,speedup,efficiency\n");
+
+    const char* resolutions[2] = {"10m", "20m"};
+    int status = 0;
+
+    for (int s = 0; s < options.size_count && status == 0; s++)
+    {
+        for (int r = 0; r < 2 && status == 0; r++)
+        {
+            Measurement series[MAX_SWEEP_VALUES];
+
+            for (int t = 0; t < options.thread_count && status == 0; t++)
+            {
+                int threads = options.threads[t];
+                // Skalowanie słabe: powierzchnia sceny rośnie proporcjonalnie do liczby wątków
+                int size = options.weak
+                               ? (int)lround(options.sizes[s] * sqrt((double)threads / options.threads[0]))
+                               : options.sizes[s];
+                size += size % 2;
+
+                char paths[4][512];
+                if (prepare_scene_files(&options, size, paths) != 0 ||
+                    measure_configuration(paths, size, r == 0, threads, options.repeat, &series[t]) != 0)
+                {
+                    status = 1;
+                }
+            }
+
+            if (status == 0)
+            {
+                report_series(csv, &options, resolutions[r], series, options.thread_count);
+            }
+        }
+    }
+
+    fclose(csv);
+    if (status == 0)
+    {
+        printf("\n[%s] Zapisano wyniki do %s.\n", get_timestamp(), options.csv_path);
+    }
+
+    g_free(options.work_dir);
+    g_free(options.csv_path);
+    pipeline_global_shutdown();
+    return status;
+}
+
+static int parse_harness_options(int* argc, char*** argv, HarnessOptions* options)
+{
+    gchar* threads_text = NULL;
+    gchar* sizes_text = NULL;
+
+    memset(options, 0, sizeof(*options));
+    options->cloud_fraction = 0.3;
+    options->repeat = 3;
+    options->threshold = 0.5;
+
+    GOptionEntry entries[] = {
+        {"threads", 0, 0, G_OPTION_ARG_STRING, &threads_text,
+            "Liczby wątków, np. 1,2,4,8 (domyślnie potęgi 2 do liczby procesorów)", "LISTA"},
+        {"sizes", 0, 0, G_OPTION_ARG_STRING, &sizes_text,
+            "Rozmiary AOI w pikselach 10m, np. 2745,5490,10980", "LISTA"},
+        {"cloud", 0, 0, G_OPTION_ARG_DOUBLE, &options->cloud_fraction, "Udział chmur w SCL (domyślnie 0.3)", "UDZIAŁ"},
+        {"repeat", 0, 0, G_OPTION_ARG_INT, &options->repeat, "Liczba powtórzeń konfiguracji (najlepszy czas)", "N"},
+        {"weak", 0, 0, G_OPTION_ARG_NONE, &options->weak,
+            "Skalowanie słabe: powierzchnia AOI rośnie razem z liczbą wątków", NULL},
+        {"threshold", 0, 0, G_OPTION_ARG_DOUBLE, &options->threshold,
+            "Próg efektywności, poniżej którego etap jest oznaczany (domyślnie 0.5)", "E"},
+        {"work-dir", 0, 0, G_OPTION_ARG_FILENAME, &options->work_dir,
+            "Katalog na wygenerowane sceny (domyślnie /tmp/ndindex_scaling)", "KATALOG"},
+        {"csv", 0, 0, G_OPTION_ARG_FILENAME, &options->csv_path, "Plik CSV z wynikami (domyślnie scaling.csv)", "PLIK"},
+        G_OPTION_ENTRY_NULL
+    };
+
+    GOptionContext* context = g_option_context_new("- skalowanie pipeline'u względem liczby wątków");
+    g_option_context_add_main_entries(context, entries, NULL);
+
+    GError* error = NULL;
+    gboolean parsed = g_option_context_parse(context, argc, argv, &error);
+    g_option_context_free(context);
+
+    if (!parsed)
+    {
+        fprintf(stderr, "Błąd parsowania opcji: %s\n", error->message);
+        g_error_free(error);
+        g_free(threads_text);
+        g_free(sizes_text);
+        return -1;
+    }
+
+    if (threads_text)
+    {
+        options->thread_count = parse_int_list(threads_text, options->threads, MAX_SWEEP_VALUES);
+    }
+    else
+    {
+        int max_threads = omp_get_num_procs();
+        for (int t = 1; t <= max_threads && options->thread_count < MAX_SWEEP_VALUES; t *= 2)
+        {
+            options->threads[options->thread_count++] = t;
+        }
+        if (options->threads[options->thread_count - 1] != max_threads &&
+            options->thread_count < MAX_SWEEP_VALUES)
+        {
+            options->threads[options->thread_count++] = max_threads;
+        }
+    }
+
+    if (sizes_text)
+    {
+        options->size_count = parse_int_list(sizes_text, options->sizes, MAX_SWEEP_VALUES);
+    }
+    else
+    {
+        options->sizes[0] = S2_TILE_SIZE_20M / 2;
+        options->sizes[1] = S2_TILE_SIZE_20M;
+        options->sizes[2] = S2_TILE_SIZE_10M;
+        options->size_count = 3;
+    }
+
+    g_free(threads_text);
+    g_free(sizes_text);
+
+    if (options->thread_count <= 0 || options->size_count <= 0 || options->repeat < 1)
+    {
+        fprintf(stderr, "Nieprawidłowa lista wątków, rozmiarów lub liczba powtórzeń.\n");
+        return -1;
+    }
+
+    if (!options->work_dir)
+    {
+        options->work_dir = g_strdup("/tmp/ndindex_scaling");
+    }
+    if (!options->csv_path)
+    {
+        options->csv_path = g_strdup("scaling.csv");
+    }
+    return 0;
+}
+
+// Parsuje listę dodatnich liczb rozdzielonych przecinkami, zwraca liczbę wartości lub -1
+static int parse_int_list(const char* text, int* values, int max_values)
+{
+    gchar** parts = g_strsplit(text, ",", -1);
+    int count = 0;
+
+    for (int i = 0; parts[i] && count >= 0; i++)
+    {
+        char* end = NULL;
+        long value = strtol(parts[i], &end, 10);
+        if (end == parts[i] || *end != '\0' || value <= 0 || count >= max_values)
+        {
+            count = -1;
+            break;
+        }
+        values[count++] = (int)value;
+    }
+
+    g_strfreev(parts);
+    return count;
+}
+
+// Generuje scenę o danym rozmiarze, jeśli jej pliki nie istnieją jeszcze w katalogu roboczym
+static int prepare_scene_files(const HarnessOptions* options, int size, char paths[4][512])
+{
+    char directory[512];
+    snprintf(directory, sizeof(directory), "%s/scene_%d_c%02d", options->work_dir, size,
+             (int)lround(options->cloud_fraction * 100.0));
+
+    if (g_mkdir_with_parents(directory, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu %s.\n", get_timestamp(), directory);
+        return -1;
+    }
+
+    snprintf(paths[3], 512, "%s/synthetic_SCL_20m.tif", directory);
+    if (g_file_test(paths[3], G_FILE_TEST_EXISTS))
+    {
+        snprintf(paths[0], 512, "%s/synthetic_B04_10m.tif", directory);
+        snprintf(paths[1], 512, "%s/synthetic_B08_10m.tif", directory);
+        snprintf(paths[2], 512, "%s/synthetic_B11_20m.tif", directory);
+        return 0;
+    }
+
+    SyntheticScene scene;
+    if (synthetic_scene_generate(&scene, size, size, options->cloud_fraction, 2024) != 0)
+    {
+        return -1;
+    }
+
+    int status = synthetic_scene_write_gtiff(&scene, directory, paths);
+    synthetic_scene_free(&scene);
+    return status;
+}
+
+static int measure_configuration(char paths[4][512], int size, bool target_10m, int threads, int repeat,
+                                 Measurement* measurement)
+{
+    omp_set_num_threads(threads);
+
+    measurement->threads = threads;
+    measurement->size = size;
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+    {
+        measurement->wall_s[i] = -1.0;
+    }
+
+    for (int r = 0; r < repeat; r++)
+    {
+        metrics_begin_run(target_10m ? "10m" : "20m");
+        if (run_pipeline_once(paths, target_10m) != 0)
+        {
+            return -1;
+        }
+
+        // Najlepszy czas każdego etapu osobno - ogranicza wpływ szumu systemu
+        for (size_t i = 0; i < STAGE_COUNT; i++)
+        {
+            double wall_s = metrics_get_wall_time("pipeline", STAGES[i]);
+            if (wall_s >= 0.0 && (measurement->wall_s[i] < 0.0 || wall_s < measurement->wall_s[i]))
+            {
+                measurement->wall_s[i] = wall_s;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int run_pipeline_once(char paths[4][512], bool target_10m)
+{
+    PipelineContext* ctx = pipeline_context_new("harness");
+    if (!ctx)
+    {
+        return -1;
+    }
+
+    // Pliki sceny syntetycznej w kolejności B04, B08, B11, SCL (synthetic_scene_write_gtiff())
+    static const int SCENE_BANDS[4] = {B04, B08, B11, SCL};
+    for (int i = 0; i < 4; i++)
+    {
+        pipeline_context_set_band_path(ctx, SCENE_BANDS[i], paths[i]);
+    }
+    ctx->target_10m = target_10m;
+
+    ProcessingResult* result = pipeline_context_run(ctx);
+    pipeline_context_free(ctx);
+    if (!result)
+    {
+        fprintf(stderr, "[%s] Błąd przebiegu pipeline'u.\n", get_timestamp());
+        return -1;
+    }
+
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        raster_pool_release(result->index_data[k]);
+        block_index_free(&result->index_blocks[k]);
+    }
+    free(result);
+    return 0;
+}
+
+static void report_series(FILE* csv, const HarnessOptions* options, const char* resolution,
+                          const Measurement* series, int count)
+{
+    const char* mode = options->weak ? "weak" : "strong";
+    const Measurement* base = &series[0];
+
+    printf("\n=== Skalowanie %s, AOI %dx%d, rozdzielczość %s ===\n",
+           options->weak ? "słabe" : "silne", base->size, base->size, resolution);
+    printf("%-14s", "etap");
+    for (int t = 0; t < count; t++)
+    {
+        char header[32];
+        snprintf(header, sizeof(header), "p=%d  t[s] / S / E", series[t].threads);
+        printf("   %28s", header);
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+    {
+        printf("%-14s", STAGES[i]);
+        for (int t = 0; t < count; t++)
+        {
+            double wall_s = series[t].wall_s[i];
+            // Przy skalowaniu słabym idealny czas jest stały, więc efektywność to T1 / Tp
+            double ratio = wall_s > 0.0 ? base->wall_s[i] / wall_s : 0.0;
+            double speedup = options->weak ? ratio * series[t].threads / base->threads
+                                           : ratio;
+            double efficiency = options->weak ? ratio : ratio * base->threads / series[t].threads;
+
+            printf("   %10.3f / %5.2f / %4.2f", wall_s, speedup, efficiency);
+            fprintf(csv, "%s,%d,%s,%d,%s,%.6f,%.4f,%.4f\n", mode, series[t].size, resolution,
+                    series[t].threads, STAGES[i], wall_s, speedup, efficiency);
+        }
+        printf("\n");
+    }
+
+    // Oznaczenie etapów o słabej efektywności przy największej liczbie wątków
+    const Measurement* last = &series[count - 1];
+    int relative_threads = last->threads / base->threads;
+    if (relative_threads < 2)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+    {
+        double ratio = last->wall_s[i] > 0.0 ? base->wall_s[i] / last->wall_s[i] : 0.0;
+        double efficiency = options->weak ? ratio : ratio / relative_threads;
+        if (efficiency >= options->threshold)
+        {
+            continue;
+        }
+
+        double serial_fraction = karp_flatt_serial_fraction(ratio, relative_threads);
+        printf("  ! %s: efektywność %.2f przy %d wątkach (część sekwencyjna wg Karpa-Flatta: %.2f)\n",
+               STAGES[i], efficiency, last->threads, serial_fraction);
+        if (strcmp(STAGES[i], "wczytywanie") == 0)
+        {
+            printf("    pętla 4 pasm w load_bands_data: najwyżej 4 wątki mają pracę, "
+                   "a dekodowanie pojedynczego pasma jest sekwencyjne\n");
+        }
+    }
+}
+
+// Eksperymentalnie wyznaczona część sekwencyjna e = (1/S - 1/p) / (1 - 1/p)
+static double karp_flatt_serial_fraction(double speedup, int threads)
+{
+    if (speedup <= 0.0 || threads < 2)
+    {
+        return 0.0;
+    }
+    return (1.0 / speedup - 1.0 / threads) / (1.0 - 1.0 / threads);
+}
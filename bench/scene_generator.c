@@ -0,0 +1,306 @@
+#include "scene_generator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <gdal.h>
+
+#include "../src/utils/utils.h"
+
+// Wielkość oczka siatki szumu (w pikselach 20m) - rząd wielkości pól i chmur
+#define LAND_COVER_CELL 96
+#define CLOUD_CELL 160
+#define NOISE_HISTOGRAM_BINS 1024
+
+typedef struct
+{
+    float red;
+    float nir;
+    float swir;
+} Reflectance;
+
+// Typowe wartości DN dla klas SCL
+static const Reflectance WATER = {300.0f, 150.0f, 50.0f};
+static const Reflectance VEGETATION = {400.0f, 3500.0f, 1800.0f};
+static const Reflectance BARE_SOIL = {1500.0f, 2200.0f, 2800.0f};
+static const Reflectance CLOUD = {6000.0f, 6200.0f, 4500.0f};
+
+// ====== POMOCNICZE ======
+static uint32_t hash_coords(uint32_t x, uint32_t y, uint32_t seed);
+static float random_unit(uint32_t x, uint32_t y, uint32_t seed);
+static float value_noise(int x, int y, int cell, uint32_t seed);
+static float noise_threshold_for_fraction(const float* noise, size_t count, double fraction);
+static int scl_class_for_pixel(float land_noise, float cloud_noise, float cloud_threshold, float jitter);
+static Reflectance reflectance_for_class(int scl_class);
+static int write_band_gtiff(const char* path, const float* data, int width, int height, GDALDataType type);
+
+int synthetic_scene_generate(SyntheticScene* scene, int width_10m, int height_10m,
+                             double cloud_fraction, unsigned int seed)
+{
+    memset(scene, 0, sizeof(*scene));
+
+    if (width_10m < 2 || height_10m < 2 || cloud_fraction < 0.0 || cloud_fraction > 1.0)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowe parametry sceny syntetycznej.\n", get_timestamp());
+        return -1;
+    }
+
+    scene->width_10m = width_10m;
+    scene->height_10m = height_10m;
+    scene->width_20m = width_10m / 2;
+    scene->height_20m = height_10m / 2;
+    scene->cloud_fraction = cloud_fraction;
+
+    size_t pixels_10m = (size_t)width_10m * height_10m;
+    size_t pixels_20m = (size_t)scene->width_20m * scene->height_20m;
+
+    scene->b04 = malloc(pixels_10m * sizeof(float));
+    scene->b08 = malloc(pixels_10m * sizeof(float));
+    scene->b11 = malloc(pixels_20m * sizeof(float));
+    scene->scl = malloc(pixels_20m * sizeof(float));
+    float* cloud_noise = malloc(pixels_20m * sizeof(float));
+
+    if (!scene->b04 || !scene->b08 || !scene->b11 || !scene->scl || !cloud_noise)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla sceny syntetycznej.\n", get_timestamp());
+        free(cloud_noise);
+        synthetic_scene_free(scene);
+        return -1;
+    }
+
+    int w20 = scene->width_20m;
+    int h20 = scene->height_20m;
+
+    #pragma omp parallel for shared(cloud_noise)
+    for (int y = 0; y < h20; y++)
+    {
+        for (int x = 0; x < w20; x++)
+        {
+            cloud_noise[pixel_index(x, y, w20)] = value_noise(x, y, CLOUD_CELL, seed ^ 0x9e3779b9u);
+        }
+    }
+
+    // Próg dobrany z rozkładu szumu, aby chmury zajmowały zadany udział sceny
+    float cloud_threshold = noise_threshold_for_fraction(cloud_noise, pixels_20m, cloud_fraction);
+
+    // Klasy SCL i pasmo B11 w rozdzielczości 20m
+    #pragma omp parallel for shared(scene, cloud_noise)
+    for (int y = 0; y < h20; y++)
+    {
+        for (int x = 0; x < w20; x++)
+        {
+            size_t idx = pixel_index(x, y, w20);
+            float land = value_noise(x, y, LAND_COVER_CELL, seed);
+            int scl_class = scl_class_for_pixel(land, cloud_noise[idx], cloud_threshold,
+                                                random_unit(x, y, seed + 1));
+            Reflectance r = reflectance_for_class(scl_class);
+
+            scene->scl[idx] = (float)scl_class;
+            scene->b11[idx] = r.swir * (0.9f + 0.2f * random_unit(x, y, seed + 2));
+        }
+    }
+
+    // Pasma 10m dziedziczą klasę z piksela 20m, z własnym szumem na poziomie piksela
+    #pragma omp parallel for shared(scene)
+    for (int y = 0; y < height_10m; y++)
+    {
+        int y20 = clamp(y / 2, 0, h20 - 1);
+        for (int x = 0; x < width_10m; x++)
+        {
+            int x20 = clamp(x / 2, 0, w20 - 1);
+            Reflectance r = reflectance_for_class((int)scene->scl[pixel_index(x20, y20, w20)]);
+            size_t idx = pixel_index(x, y, width_10m);
+
+            scene->b04[idx] = r.red * (0.9f + 0.2f * random_unit(x, y, seed + 3));
+            scene->b08[idx] = r.nir * (0.9f + 0.2f * random_unit(x, y, seed + 4));
+        }
+    }
+
+    free(cloud_noise);
+
+    printf("[%s] Wygenerowano scenę syntetyczną %dx%d (10m), chmury %.0f%%.\n",
+           get_timestamp(), width_10m, height_10m, cloud_fraction * 100.0);
+    return 0;
+}
+
+void synthetic_scene_free(SyntheticScene* scene)
+{
+    free(scene->b04);
+    free(scene->b08);
+    free(scene->b11);
+    free(scene->scl);
+    scene->b04 = NULL;
+    scene->b08 = NULL;
+    scene->b11 = NULL;
+    scene->scl = NULL;
+}
+
+int synthetic_scene_write_gtiff(const SyntheticScene* scene, const char* directory,
+                                char paths_out[4][512])
+{
+    static const char* FILE_NAMES[4] = {
+        "synthetic_B04_10m.tif",
+        "synthetic_B08_10m.tif",
+        "synthetic_B11_20m.tif",
+        "synthetic_SCL_20m.tif"
+    };
+
+    GDALAllRegister();
+
+    for (int i = 0; i < 4; i++)
+    {
+        snprintf(paths_out[i], 512, "%s/%s", directory, FILE_NAMES[i]);
+    }
+
+    if (write_band_gtiff(paths_out[0], scene->b04, scene->width_10m, scene->height_10m, GDT_UInt16) != 0 ||
+        write_band_gtiff(paths_out[1], scene->b08, scene->width_10m, scene->height_10m, GDT_UInt16) != 0 ||
+        write_band_gtiff(paths_out[2], scene->b11, scene->width_20m, scene->height_20m, GDT_UInt16) != 0 ||
+        write_band_gtiff(paths_out[3], scene->scl, scene->width_20m, scene->height_20m, GDT_Byte) != 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Bezstanowy hash współrzędnych - pozwala generować piksele równolegle i deterministycznie
+static uint32_t hash_coords(uint32_t x, uint32_t y, uint32_t seed)
+{
+    uint32_t h = seed ^ (x * 0x27d4eb2du) ^ (y * 0x165667b1u);
+    h ^= h >> 15;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static float random_unit(uint32_t x, uint32_t y, uint32_t seed)
+{
+    return (hash_coords(x, y, seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Szum wartości: losowe wartości w węzłach siatki, interpolowane z wygładzeniem
+static float value_noise(int x, int y, int cell, uint32_t seed)
+{
+    int gx = x / cell;
+    int gy = y / cell;
+    float fx = (float)(x % cell) / cell;
+    float fy = (float)(y % cell) / cell;
+
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+
+    float v00 = random_unit(gx, gy, seed);
+    float v10 = random_unit(gx + 1, gy, seed);
+    float v01 = random_unit(gx, gy + 1, seed);
+    float v11 = random_unit(gx + 1, gy + 1, seed);
+
+    float top = v00 + (v10 - v00) * fx;
+    float bottom = v01 + (v11 - v01) * fx;
+    return top + (bottom - top) * fy;
+}
+
+// Zwraca próg, powyżej którego leży zadany udział wartości szumu (kwantyl z histogramu)
+static float noise_threshold_for_fraction(const float* noise, size_t count, double fraction)
+{
+    if (fraction <= 0.0)
+    {
+        return 2.0f;
+    }
+    if (fraction >= 1.0)
+    {
+        return -1.0f;
+    }
+
+    size_t histogram[NOISE_HISTOGRAM_BINS] = {0};
+    for (size_t i = 0; i < count; i++)
+    {
+        int bin = clamp((int)(noise[i] * NOISE_HISTOGRAM_BINS), 0, NOISE_HISTOGRAM_BINS - 1);
+        histogram[bin]++;
+    }
+
+    size_t target = (size_t)(fraction * count);
+    size_t above = 0;
+    for (int bin = NOISE_HISTOGRAM_BINS - 1; bin >= 0; bin--)
+    {
+        above += histogram[bin];
+        if (above >= target)
+        {
+            return (float)bin / NOISE_HISTOGRAM_BINS;
+        }
+    }
+    return 0.0f;
+}
+
+static int scl_class_for_pixel(float land_noise, float cloud_noise, float cloud_threshold, float jitter)
+{
+    if (cloud_noise >= cloud_threshold)
+    {
+        // Rdzeń chmury o wysokim prawdopodobieństwie, brzegi średnie i cirrus
+        float depth = cloud_noise - cloud_threshold;
+        if (depth > 0.08f) return 9;
+        return jitter < 0.7f ? 8 : 10;
+    }
+    if (cloud_noise >= cloud_threshold - 0.02f)
+    {
+        return 3;
+    }
+    if (land_noise < 0.12f) return 6;
+    if (land_noise < 0.60f) return 4;
+    if (jitter < 0.02f) return 7;
+    return 5;
+}
+
+static Reflectance reflectance_for_class(int scl_class)
+{
+    switch (scl_class)
+    {
+    case 6:
+        return WATER;
+    case 4:
+        return VEGETATION;
+    case 3:
+    {
+        // Cień chmury - przyciemniony grunt
+        Reflectance shadow = {BARE_SOIL.red * 0.3f, BARE_SOIL.nir * 0.3f, BARE_SOIL.swir * 0.3f};
+        return shadow;
+    }
+    case 8:
+    case 9:
+    case 10:
+        return CLOUD;
+    default:
+        return BARE_SOIL;
+    }
+}
+
+static int write_band_gtiff(const char* path, const float* data, int width, int height, GDALDataType type)
+{
+    GDALDriverH driver = GDALGetDriverByName("GTiff");
+    if (!driver)
+    {
+        fprintf(stderr, "[%s] Błąd: Sterownik GTiff niedostępny.\n", get_timestamp());
+        return -1;
+    }
+
+    char* options[] = {"TILED=YES", "BLOCKXSIZE=512", "BLOCKYSIZE=512", NULL};
+    GDALDatasetH dataset = GDALCreate(driver, path, width, height, 1, type, options);
+    if (!dataset)
+    {
+        fprintf(stderr, "[%s] Błąd tworzenia pliku %s: %s\n", get_timestamp(), path, CPLGetLastErrorMsg());
+        return -1;
+    }
+
+    GDALRasterBandH band = GDALGetRasterBand(dataset, 1);
+    CPLErr err = GDALRasterIO(band, GF_Write, 0, 0, width, height, (void*)data, width, height,
+                              GDT_Float32, 0, 0);
+    GDALClose(dataset);
+
+    if (err != CE_None)
+    {
+        fprintf(stderr, "[%s] Błąd zapisu pliku %s: %s\n", get_timestamp(), path, CPLGetLastErrorMsg());
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef SCENE_GENERATOR_H
+#define SCENE_GENERATOR_H
+
+// Rozmiary kafla Sentinel-2 (100 km x 100 km)
+#define S2_TILE_SIZE_10M 10980
+#define S2_TILE_SIZE_20M 5490
+
+/**
+ * @brief Syntetyczna scena Sentinel-2 w natywnych rozdzielczościach pasm
+ *
+ * B04 i B08 mają rozdzielczość 10m, B11 i SCL 20m (wymiary 10m / 2), tak jak w produktach L2A.
+ * Wartości odbicia są w jednostkach DN (jak w plikach JP2), a SCL zawiera klasy 0-11.
+ */
+typedef struct
+{
+    int width_10m;
+    int height_10m;
+    int width_20m;
+    int height_20m;
+    float* b04;
+    float* b08;
+    float* b11;
+    float* scl;
+    double cloud_fraction;
+} SyntheticScene;
+
+/**
+ * @brief Generuje deterministyczną scenę syntetyczną
+ *
+ * Pokrycie terenu (woda, roślinność, grunt odkryty) i chmury pochodzą z gładkiego szumu,
+ * dzięki czemu maska SCL tworzy spójne obszary jak na prawdziwych scenach, a nie losowe piksele.
+ *
+ * @param width_10m Szerokość sceny w rozdzielczości 10m (np. S2_TILE_SIZE_10M)
+ * @param height_10m Wysokość sceny w rozdzielczości 10m
+ * @param cloud_fraction Docelowy udział pikseli chmur w SCL (0.0 - 1.0)
+ * @param seed Ziarno generatora - ta sama wartość daje identyczną scenę
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu alokacji
+ */
+int synthetic_scene_generate(SyntheticScene* scene, int width_10m, int height_10m,
+                             double cloud_fraction, unsigned int seed);
+
+void synthetic_scene_free(SyntheticScene* scene);
+
+/**
+ * @brief Zapisuje pasma sceny jako pliki GeoTIFF (UInt16, SCL jako Byte)
+ *
+ * Nazwy plików zawierają oznaczenie pasma (np. "synthetic_B04_10m.tif"), więc są rozpoznawane
+ * przez detect_band_from_filename() i mogą być wczytane przez pipeline jak prawdziwe dane.
+ *
+ * @param directory Istniejący katalog docelowy
+ * @param paths_out [out] Ścieżki zapisanych plików w kolejności B04, B08, B11, SCL
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu GDAL
+ */
+int synthetic_scene_write_gtiff(const SyntheticScene* scene, const char* directory,
+                                char paths_out[4][512]);
+
+#endif // SCENE_GENERATOR_H
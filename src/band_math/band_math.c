@@ -0,0 +1,1051 @@
+#include "band_math.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <float.h>
+#include <glib.h>
+
+#include "../index_calculator/index_calculator.h"
+#include "../utils/utils.h"
+#include "../trace/trace.h"
+
+// Liczba pikseli bloku - stos roboczy programu (16 x 256 x 4 B) mieści się w L1 razem z wejściami
+#define BAND_MATH_BLOCK_PIXELS 256
+#define BAND_MATH_MAX_STACK 16
+// Ścieżka rzadka, gdy w próbce SCL pikseli ważnych jest mniej niż ten ułamek
+#define BAND_MATH_SPARSE_MAX_VALID_FRACTION 0.5
+// Liczba próbek SCL, z których szacowany jest ułamek pikseli ważnych
+#define BAND_MATH_SPARSE_SAMPLES 4096
+// Najwięcej odcinków ważnych w bloku ścieżki rzadkiej - bardziej poszarpany blok liczony jest gęsto
+#define BAND_MATH_SPARSE_MAX_SPANS 8
+
+typedef enum
+{
+    OP_LOAD_BAND,
+    OP_CONST,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_NEG,
+    OP_MIN,
+    OP_MAX,
+    OP_ABS,
+    OP_SQRT,
+    OP_CLAMP
+} BandMathOpcode;
+
+typedef struct
+{
+    BandMathOpcode opcode;
+    int band;
+    float value;
+} BandMathInstruction;
+
+struct BandMathProgram
+{
+    char* name;
+    BandMathInstruction* code;
+    int length;
+    int capacity;
+    uint32_t required_bands;
+};
+
+typedef struct
+{
+    const char* formula;
+    const char* pos;
+    BandMathProgram* program;
+    int depth;
+    bool failed;
+} FormulaParser;
+
+static const BandMathIndex BUILTIN_INDICES[] = {
+    {"NDVI", "clamp((B08 - B04) / (B08 + B04), -1, 1)"},
+    {"NDMI", "clamp((B08 - B11) / (B08 + B11), -1, 1)"},
+    {"NDWI", "clamp((B03 - B08) / (B03 + B08), -1, 1)"},
+    {"NBR", "clamp((B08 - B12) / (B08 + B12), -1, 1)"},
+    {"NDRE", "clamp((B08 - B05) / (B08 + B05), -1, 1)"},
+    {"EVI", "2.5 * (B08 - B04) / (B08 + 6 * B04 - 7.5 * B02 + 10000)"},
+    {"SAVI", "1.5 * (B08 - B04) / (B08 + B04 + 5000)"}
+};
+
+// ====== POMOCNICZE ======
+static void parse_expression(FormulaParser* parser);
+static void parse_term(FormulaParser* parser);
+static void parse_unary(FormulaParser* parser);
+static void parse_primary(FormulaParser* parser);
+static void parse_function_call(FormulaParser* parser, const char* name, size_t name_len);
+static void emit(FormulaParser* parser, BandMathOpcode opcode, int band, float value);
+static void parser_error(FormulaParser* parser, const char* message);
+static void skip_whitespace(FormulaParser* parser);
+static int evaluate_planar(BandMathProgram* const* programs, int program_count,
+                           const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                           size_t num_pixels, float* const outputs[], int16_t* const quantized[], IndexStats* stats);
+static int evaluate_tiled(BandMathProgram* const* programs, int program_count, const TiledBands* tiled,
+                          const int band_slots[BAND_MATH_BAND_COUNT], int scl_slot,
+                          float* const outputs[], int16_t* const quantized[], IndexStats* stats);
+static int validate_evaluation(BandMathProgram* const* programs, int program_count,
+                               const float* const bands[BAND_MATH_BAND_COUNT], float* const outputs[],
+                               int16_t* const quantized[]);
+static IndexStats* begin_local_stats(int program_count, IndexStats* stats, int* status);
+static void merge_local_stats(IndexStats* local_stats, int program_count, IndexStats* stats);
+static float* begin_quantize_buffer(int program_count, int16_t* const quantized[], int* status);
+static float* const* block_outputs(float* const outputs[], float* quantize_buffer, float** buffer_outputs,
+                                   int program_count);
+static void quantize_block(const float* quantize_buffer, int16_t* const quantized[], int program_count,
+                           size_t output_start, size_t count);
+static void sample_valid_pixels(const float* scl_band, size_t num_pixels, size_t max_samples,
+                                size_t* samples, size_t* valid);
+static void evaluate_block(BandMathProgram* const* programs, int program_count,
+                           const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                           size_t start, size_t count, float* const outputs[], size_t output_start,
+                           float scratch[][BAND_MATH_BLOCK_PIXELS], unsigned char* mask, IndexStats* local_stats,
+                           bool sparse);
+static bool evaluate_sparse_block(BandMathProgram* const* programs, int program_count,
+                                  const float* const bands[BAND_MATH_BAND_COUNT], size_t start, size_t count,
+                                  float* const outputs[], size_t output_start,
+                                  float scratch[][BAND_MATH_BLOCK_PIXELS], const unsigned char* mask,
+                                  IndexStats* local_stats);
+static void run_program_block(const BandMathProgram* program, const float* const bands[BAND_MATH_BAND_COUNT],
+                              size_t start, size_t count, float scratch[][BAND_MATH_BLOCK_PIXELS],
+                              const unsigned char* mask, float* output);
+
+const BandMathIndex* band_math_builtin_indices(int* count_out)
+{
+    if (count_out)
+    {
+        *count_out = (int)(sizeof(BUILTIN_INDICES) / sizeof(BUILTIN_INDICES[0]));
+    }
+    return BUILTIN_INDICES;
+}
+
+const BandMathIndex* band_math_find_builtin(const char* name)
+{
+    int count;
+    const BandMathIndex* indices = band_math_builtin_indices(&count);
+    for (int i = 0; name && i < count; i++)
+    {
+        if (g_ascii_strcasecmp(indices[i].name, name) == 0)
+        {
+            return &indices[i];
+        }
+    }
+    return NULL;
+}
+
+BandMathProgram* band_math_compile(const char* name, const char* formula)
+{
+    if (!name || !formula)
+    {
+        return NULL;
+    }
+
+    BandMathProgram* program = calloc(1, sizeof(BandMathProgram));
+    if (!program)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla programu wskaźnika %s.\n", get_timestamp(), name);
+        return NULL;
+    }
+    program->name = g_strdup(name);
+
+    FormulaParser parser = {formula, formula, program, 0, false};
+    parse_expression(&parser);
+    skip_whitespace(&parser);
+    if (!parser.failed && *parser.pos != '\0')
+    {
+        parser_error(&parser, "nieoczekiwany znak");
+    }
+    if (!parser.failed && program->length == 0)
+    {
+        parser_error(&parser, "pusta formuła");
+    }
+
+    if (parser.failed)
+    {
+        band_math_free(program);
+        return NULL;
+    }
+    return program;
+}
+
+BandMathProgram* band_math_compile_builtin(const char* name)
+{
+    const BandMathIndex* index = band_math_find_builtin(name);
+    if (!index)
+    {
+        fprintf(stderr, "[%s] Nieznany wskaźnik: %s\n", get_timestamp(), name ? name : "(null)");
+        return NULL;
+    }
+    return band_math_compile(index->name, index->formula);
+}
+
+void band_math_free(BandMathProgram* program)
+{
+    if (!program)
+    {
+        return;
+    }
+    g_free(program->name);
+    free(program->code);
+    free(program);
+}
+
+const char* band_math_program_name(const BandMathProgram* program)
+{
+    return program ? program->name : NULL;
+}
+
+uint32_t band_math_required_bands(const BandMathProgram* program)
+{
+    return program ? program->required_bands : 0;
+}
+
+int band_math_evaluate(BandMathProgram* const* programs, int program_count,
+                       const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                       size_t num_pixels, float* const outputs[])
+{
+    return band_math_evaluate_with_stats(programs, program_count, bands, scl_band, num_pixels, outputs, NULL);
+}
+
+int band_math_evaluate_with_stats(BandMathProgram* const* programs, int program_count,
+                                  const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                                  size_t num_pixels, float* const outputs[], IndexStats* stats)
+{
+    return evaluate_planar(programs, program_count, bands, scl_band, num_pixels, outputs, NULL, stats);
+}
+
+int band_math_evaluate_quantized(BandMathProgram* const* programs, int program_count,
+                                 const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                                 size_t num_pixels, int16_t* const outputs[], IndexStats* stats)
+{
+    return evaluate_planar(programs, program_count, bands, scl_band, num_pixels, NULL, outputs, stats);
+}
+
+int band_math_evaluate_tiled(BandMathProgram* const* programs, int program_count, const TiledBands* tiled,
+                             const int band_slots[BAND_MATH_BAND_COUNT], int scl_slot,
+                             float* const outputs[], IndexStats* stats)
+{
+    return evaluate_tiled(programs, program_count, tiled, band_slots, scl_slot, outputs, NULL, stats);
+}
+
+int band_math_evaluate_tiled_quantized(BandMathProgram* const* programs, int program_count, const TiledBands* tiled,
+                                       const int band_slots[BAND_MATH_BAND_COUNT], int scl_slot,
+                                       int16_t* const outputs[], IndexStats* stats)
+{
+    return evaluate_tiled(programs, program_count, tiled, band_slots, scl_slot, NULL, outputs, stats);
+}
+
+// Dokładnie jeden z outputs (float) i quantized (int16) jest różny od NULL
+static int evaluate_planar(BandMathProgram* const* programs, int program_count,
+                           const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                           size_t num_pixels, float* const outputs[], int16_t* const quantized[], IndexStats* stats)
+{
+    if (validate_evaluation(programs, program_count, bands, outputs, quantized) != 0)
+    {
+        return -1;
+    }
+
+    size_t num_blocks = (num_pixels + BAND_MATH_BLOCK_PIXELS - 1) / BAND_MATH_BLOCK_PIXELS;
+
+    // Gęsto czy rzadko - decyzja dla całego wywołania (pasa wierszy) z próbki maski SCL
+    size_t samples = 0;
+    size_t valid = 0;
+    if (scl_band)
+    {
+        sample_valid_pixels(scl_band, num_pixels, BAND_MATH_SPARSE_SAMPLES, &samples, &valid);
+    }
+    bool sparse = samples > 0 && valid < BAND_MATH_SPARSE_MAX_VALID_FRACTION * samples;
+
+    int status = 0;
+
+    #pragma omp parallel shared(programs, bands, scl_band, outputs, quantized, stats, status)
+    {
+        TraceSpan chunk_span = trace_begin("index", sparse ? "band_math_sparse" : "band_math");
+        float scratch[BAND_MATH_MAX_STACK][BAND_MATH_BLOCK_PIXELS];
+        unsigned char mask[BAND_MATH_BLOCK_PIXELS];
+        IndexStats* local_stats = begin_local_stats(program_count, stats, &status);
+        float* quantize_buffer = begin_quantize_buffer(program_count, quantized, &status);
+        float* buffer_outputs[program_count > 0 ? program_count : 1];
+        float* const* targets = block_outputs(outputs, quantize_buffer, buffer_outputs, program_count);
+
+        #pragma omp for schedule(static) nowait
+        for (size_t block = 0; block < num_blocks; block++)
+        {
+            size_t start = block * BAND_MATH_BLOCK_PIXELS;
+            size_t count = num_pixels - start < BAND_MATH_BLOCK_PIXELS ? num_pixels - start : BAND_MATH_BLOCK_PIXELS;
+            if (!targets)
+            {
+                continue;
+            }
+            evaluate_block(programs, program_count, bands, scl_band, start, count, targets,
+                           quantize_buffer ? 0 : start, scratch, mask, local_stats, sparse);
+            quantize_block(quantize_buffer, quantized, program_count, start, count);
+        }
+
+        free(quantize_buffer);
+        merge_local_stats(local_stats, program_count, stats);
+        trace_end(&chunk_span);
+    }
+
+    if (status != 0)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla statystyk lub kwantyzacji wskaźników.\n", get_timestamp());
+    }
+    return status;
+}
+
+static int evaluate_tiled(BandMathProgram* const* programs, int program_count, const TiledBands* tiled,
+                          const int band_slots[BAND_MATH_BAND_COUNT], int scl_slot,
+                          float* const outputs[], int16_t* const quantized[], IndexStats* stats)
+{
+    // Walidacja na wskaźnikach pierwszego kafla - ten sam zestaw pasm jest w każdym kaflu
+    const float* first_tile[BAND_MATH_BAND_COUNT] = {NULL};
+    for (int b = 0; b < BAND_MATH_BAND_COUNT; b++)
+    {
+        first_tile[b] = band_slots[b] >= 0 ? tiled_bands_tile(tiled, 0, band_slots[b]) : NULL;
+    }
+    if (validate_evaluation(programs, program_count, first_tile, outputs, quantized) != 0)
+    {
+        return -1;
+    }
+
+    // Próbka maski z kafli rozłożonych równomiernie po scenie
+    size_t samples = 0;
+    size_t valid = 0;
+    if (scl_slot >= 0)
+    {
+        size_t tile_step = tiled->tile_count > 64 ? tiled->tile_count / 64 : 1;
+        for (size_t tile = 0; tile < tiled->tile_count; tile += tile_step)
+        {
+            sample_valid_pixels(tiled_bands_tile(tiled, tile, scl_slot), tiled_bands_tile_length(tiled, tile),
+                                BAND_MATH_SPARSE_SAMPLES / 64, &samples, &valid);
+        }
+    }
+    bool sparse = samples > 0 && valid < BAND_MATH_SPARSE_MAX_VALID_FRACTION * samples;
+
+    int status = 0;
+
+    #pragma omp parallel shared(programs, tiled, band_slots, outputs, quantized, stats, status)
+    {
+        TraceSpan chunk_span = trace_begin("index", sparse ? "band_math_tiled_sparse" : "band_math_tiled");
+        float scratch[BAND_MATH_MAX_STACK][BAND_MATH_BLOCK_PIXELS];
+        unsigned char mask[BAND_MATH_BLOCK_PIXELS];
+        IndexStats* local_stats = begin_local_stats(program_count, stats, &status);
+        float* quantize_buffer = begin_quantize_buffer(program_count, quantized, &status);
+        float* buffer_outputs[program_count > 0 ? program_count : 1];
+        float* const* targets = block_outputs(outputs, quantize_buffer, buffer_outputs, program_count);
+
+        // Wątek dostaje całe kafle: wszystkie pasma kafla to jeden ciągły fragment pamięci
+        #pragma omp for schedule(static) nowait
+        for (size_t tile = 0; tile < tiled->tile_count; tile++)
+        {
+            if (!targets)
+            {
+                continue;
+            }
+            const float* tile_bands[BAND_MATH_BAND_COUNT] = {NULL};
+            for (int b = 0; b < BAND_MATH_BAND_COUNT; b++)
+            {
+                tile_bands[b] = band_slots[b] >= 0 ? tiled_bands_tile(tiled, tile, band_slots[b]) : NULL;
+            }
+            const float* tile_scl = scl_slot >= 0 ? tiled_bands_tile(tiled, tile, scl_slot) : NULL;
+
+            size_t tile_start = tile * tiled->tile_pixels;
+            size_t tile_length = tiled_bands_tile_length(tiled, tile);
+            for (size_t start = 0; start < tile_length; start += BAND_MATH_BLOCK_PIXELS)
+            {
+                size_t count = tile_length - start < BAND_MATH_BLOCK_PIXELS ? tile_length - start
+                                                                             : BAND_MATH_BLOCK_PIXELS;
+                evaluate_block(programs, program_count, tile_bands, tile_scl, start, count, targets,
+                               quantize_buffer ? 0 : tile_start + start, scratch, mask, local_stats, sparse);
+                quantize_block(quantize_buffer, quantized, program_count, tile_start + start, count);
+            }
+        }
+
+        free(quantize_buffer);
+        merge_local_stats(local_stats, program_count, stats);
+        trace_end(&chunk_span);
+    }
+
+    if (status != 0)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla statystyk lub kwantyzacji wskaźników.\n", get_timestamp());
+    }
+    return status;
+}
+
+static int validate_evaluation(BandMathProgram* const* programs, int program_count,
+                               const float* const bands[BAND_MATH_BAND_COUNT], float* const outputs[],
+                               int16_t* const quantized[])
+{
+    for (int p = 0; p < program_count; p++)
+    {
+        uint32_t missing = programs[p]->required_bands;
+        for (int b = 0; b < BAND_MATH_BAND_COUNT; b++)
+        {
+            if (bands[b])
+            {
+                missing &= ~(1u << b);
+            }
+        }
+        if (missing || (outputs ? !outputs[p] : !quantized[p]))
+        {
+            fprintf(stderr, "[%s] Brak pasma wejściowego lub bufora wyniku dla wskaźnika %s.\n",
+                    get_timestamp(), programs[p]->name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Statystyki lokalne wątku - bez synchronizacji w pętli po blokach
+static IndexStats* begin_local_stats(int program_count, IndexStats* stats, int* status)
+{
+    IndexStats* local_stats = stats ? malloc(program_count * sizeof(IndexStats)) : NULL;
+    if (stats && !local_stats)
+    {
+        #pragma omp atomic write
+        *status = -1;
+    }
+    for (int p = 0; local_stats && p < program_count; p++)
+    {
+        index_stats_reset(&local_stats[p]);
+    }
+    return local_stats;
+}
+
+static void merge_local_stats(IndexStats* local_stats, int program_count, IndexStats* stats)
+{
+    if (!local_stats)
+    {
+        return;
+    }
+
+    #pragma omp critical(band_math_stats)
+    for (int p = 0; p < program_count; p++)
+    {
+        index_stats_merge(&stats[p], &local_stats[p]);
+    }
+    free(local_stats);
+}
+
+// Bufor bloku wątku na wyniki float wszystkich programów - przy kwantyzacji wyniki bloku powstają
+// w nim (w L1) i od razu trafiają do rastrów int16, więc raster float nigdy nie powstaje
+static float* begin_quantize_buffer(int program_count, int16_t* const quantized[], int* status)
+{
+    if (!quantized)
+    {
+        return NULL;
+    }
+
+    float* buffer = malloc((size_t)program_count * BAND_MATH_BLOCK_PIXELS * sizeof(float));
+    if (!buffer)
+    {
+        #pragma omp atomic write
+        *status = -1;
+    }
+    return buffer;
+}
+
+// Cele evaluate_block(): rastry float albo wiersze bufora kwantyzacji (NULL, gdy bufora brakło)
+static float* const* block_outputs(float* const outputs[], float* quantize_buffer, float** buffer_outputs,
+                                   int program_count)
+{
+    if (outputs)
+    {
+        return outputs;
+    }
+    if (!quantize_buffer)
+    {
+        return NULL;
+    }
+    for (int p = 0; p < program_count; p++)
+    {
+        buffer_outputs[p] = quantize_buffer + (size_t)p * BAND_MATH_BLOCK_PIXELS;
+    }
+    return buffer_outputs;
+}
+
+static void quantize_block(const float* quantize_buffer, int16_t* const quantized[], int program_count,
+                           size_t output_start, size_t count)
+{
+    for (int p = 0; quantize_buffer && p < program_count; p++)
+    {
+        quantize_index_values(quantize_buffer + (size_t)p * BAND_MATH_BLOCK_PIXELS, count,
+                              quantized[p] + output_start);
+    }
+}
+
+// Zlicza piksele ważne w najwyżej max_samples próbkach SCL rozłożonych równomiernie po [0, num_pixels)
+static void sample_valid_pixels(const float* scl_band, size_t num_pixels, size_t max_samples,
+                                size_t* samples, size_t* valid)
+{
+    size_t stride = num_pixels > max_samples ? num_pixels / max_samples : 1;
+    for (size_t i = 0; i < num_pixels; i += stride)
+    {
+        unsigned char masked;
+        calculate_scl_mask(scl_band + i, 1, &masked);
+        *valid += !masked;
+        (*samples)++;
+    }
+}
+
+// Blok [start, start + count) wejść; wyniki trafiają od output_start w buforach wyników
+static void evaluate_block(BandMathProgram* const* programs, int program_count,
+                           const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                           size_t start, size_t count, float* const outputs[], size_t output_start,
+                           float scratch[][BAND_MATH_BLOCK_PIXELS], unsigned char* mask, IndexStats* local_stats,
+                           bool sparse)
+{
+    // Maska i pasma bloku trafiają do L1 raz - kolejne programy czytają je już z cache
+    if (scl_band)
+    {
+        calculate_scl_mask(scl_band + start, count, mask);
+        if (sparse && evaluate_sparse_block(programs, program_count, bands, start, count, outputs, output_start,
+                                            scratch, mask, local_stats))
+        {
+            return;
+        }
+    }
+    for (int p = 0; p < program_count; p++)
+    {
+        run_program_block(programs[p], bands, start, count, scratch,
+                          scl_band ? mask : NULL, outputs[p] + output_start);
+        if (local_stats)
+        {
+            index_stats_accumulate(&local_stats[p], outputs[p] + output_start, count);
+        }
+    }
+}
+
+// Blok jako odcinki ważne z maski (RLE): programy liczą tylko odcinki ważne, więc pasma nie są czytane
+// pod chmurą, a odcinki zamaskowane wypełniane są brakiem danych. Zwraca false, gdy maska jest zbyt
+// poszarpana (narzut programu na odcinek przewyższyłby zysk) - blok liczony jest wtedy gęsto.
+static bool evaluate_sparse_block(BandMathProgram* const* programs, int program_count,
+                                  const float* const bands[BAND_MATH_BAND_COUNT], size_t start, size_t count,
+                                  float* const outputs[], size_t output_start,
+                                  float scratch[][BAND_MATH_BLOCK_PIXELS], const unsigned char* mask,
+                                  IndexStats* local_stats)
+{
+    size_t span_start[BAND_MATH_SPARSE_MAX_SPANS];
+    size_t span_length[BAND_MATH_SPARSE_MAX_SPANS];
+    int span_count = 0;
+
+    const unsigned char* valid_pos;
+    for (size_t i = 0; i < count && (valid_pos = memchr(mask + i, 0, count - i)) != NULL;)
+    {
+        if (span_count == BAND_MATH_SPARSE_MAX_SPANS)
+        {
+            return false;
+        }
+        size_t first = (size_t)(valid_pos - mask);
+        const unsigned char* masked_pos = memchr(mask + first, 1, count - first);
+        size_t end = masked_pos ? (size_t)(masked_pos - mask) : count;
+
+        span_start[span_count] = first;
+        span_length[span_count] = end - first;
+        span_count++;
+        i = end;
+    }
+
+    for (int p = 0; p < program_count; p++)
+    {
+        float* output = outputs[p] + output_start;
+        if (span_count == 0)
+        {
+            // Cały blok pod maską - wypełnienie bez czytania pasm i bez przeglądania wyników
+            #pragma omp simd
+            for (size_t i = 0; i < count; i++)
+            {
+                output[i] = INDEX_NO_DATA_VALUE;
+            }
+            if (local_stats)
+            {
+                index_stats_add_masked(&local_stats[p], count);
+            }
+            continue;
+        }
+
+        size_t filled = 0;
+        for (int span = 0; span < span_count; span++)
+        {
+            for (size_t i = filled; i < span_start[span]; i++)
+            {
+                output[i] = INDEX_NO_DATA_VALUE;
+            }
+            run_program_block(programs[p], bands, start + span_start[span], span_length[span], scratch, NULL,
+                              output + span_start[span]);
+            filled = span_start[span] + span_length[span];
+        }
+        for (size_t i = filled; i < count; i++)
+        {
+            output[i] = INDEX_NO_DATA_VALUE;
+        }
+
+        if (local_stats)
+        {
+            index_stats_accumulate(&local_stats[p], output, count);
+        }
+    }
+    return true;
+}
+
+// Operand stosu: wskaźnik na wartości bloku albo stała, która nie jest rozpisywana na cały blok
+typedef struct
+{
+    const float* data;
+    float value;
+} BlockOperand;
+
+// Pętla operacji dwuargumentowej w wariantach wektor/stała - stałe nie zajmują przepustowości pamięci
+#define BINARY_BLOCK_LOOP(EXPR)                                                \
+    do                                                                         \
+    {                                                                          \
+        if (a.data && b.data)                                                  \
+        {                                                                      \
+            _Pragma("omp simd")                                                \
+            for (size_t i = 0; i < count; i++)                                 \
+            {                                                                  \
+                float x = a.data[i], y = b.data[i];                            \
+                out[i] = (EXPR);                                               \
+            }                                                                  \
+        }                                                                      \
+        else if (a.data)                                                       \
+        {                                                                      \
+            float y = b.value;                                                 \
+            _Pragma("omp simd")                                                \
+            for (size_t i = 0; i < count; i++)                                 \
+            {                                                                  \
+                float x = a.data[i];                                           \
+                out[i] = (EXPR);                                               \
+            }                                                                  \
+        }                                                                      \
+        else if (b.data)                                                       \
+        {                                                                      \
+            float x = a.value;                                                 \
+            _Pragma("omp simd")                                                \
+            for (size_t i = 0; i < count; i++)                                 \
+            {                                                                  \
+                float y = b.data[i];                                           \
+                out[i] = (EXPR);                                               \
+            }                                                                  \
+        }                                                                      \
+        else                                                                   \
+        {                                                                      \
+            float x = a.value, y = b.value;                                    \
+            result.data = NULL;                                                \
+            result.value = (EXPR);                                             \
+        }                                                                      \
+    } while (0)
+
+// Wykonuje program dla jednego bloku. Operand na głębokości d wskazuje na pasmo wejściowe
+// (bez kopiowania), na stałą albo na scratch[d], do którego operacje zapisują swoje wyniki.
+static void run_program_block(const BandMathProgram* program, const float* const bands[BAND_MATH_BAND_COUNT],
+                              size_t start, size_t count, float scratch[][BAND_MATH_BLOCK_PIXELS],
+                              const unsigned char* mask, float* output)
+{
+    BlockOperand operands[BAND_MATH_MAX_STACK];
+    int top = -1;
+
+    for (int pc = 0; pc < program->length; pc++)
+    {
+        const BandMathInstruction* instruction = &program->code[pc];
+        switch (instruction->opcode)
+        {
+        case OP_LOAD_BAND:
+            top++;
+            operands[top] = (BlockOperand){bands[instruction->band] + start, 0.0f};
+            break;
+        case OP_CONST:
+            top++;
+            operands[top] = (BlockOperand){NULL, instruction->value};
+            break;
+        case OP_NEG:
+        case OP_ABS:
+        case OP_SQRT:
+        {
+            // Jednoargumentowe jako dwuargumentowe ze stałą, żeby obsłużyć operand stały
+            BlockOperand a = operands[top];
+            BlockOperand b = {NULL, 0.0f};
+            float* out = scratch[top];
+            BlockOperand result = {out, 0.0f};
+            if (instruction->opcode == OP_NEG)
+            {
+                BINARY_BLOCK_LOOP(y - x);
+            }
+            else if (instruction->opcode == OP_ABS)
+            {
+                BINARY_BLOCK_LOOP(fabsf(x) + y);
+            }
+            else
+            {
+                BINARY_BLOCK_LOOP(x >= y ? sqrtf(x) : NAN);
+            }
+            operands[top] = result;
+            break;
+        }
+        case OP_CLAMP:
+        {
+            BlockOperand x = operands[top - 2];
+            BlockOperand lo = operands[top - 1];
+            BlockOperand hi = operands[top];
+            float* out = scratch[top - 2];
+            top -= 2;
+            if (!x.data)
+            {
+                // Stała wartość zaciskana do granic z bloku - rzadkie, rozpisywane na blok
+                #pragma omp simd
+                for (size_t i = 0; i < count; i++) out[i] = x.value;
+                x.data = out;
+            }
+            // Porównania zamiast fminf/fmaxf - NaN (brak danych) przechodzi bez zmian
+            if (!lo.data && !hi.data)
+            {
+                float lo_value = lo.value, hi_value = hi.value;
+                #pragma omp simd
+                for (size_t i = 0; i < count; i++)
+                {
+                    float v = x.data[i];
+                    v = v < lo_value ? lo_value : v;
+                    out[i] = v > hi_value ? hi_value : v;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    float l = lo.data ? lo.data[i] : lo.value;
+                    float h = hi.data ? hi.data[i] : hi.value;
+                    float v = x.data[i];
+                    v = v < l ? l : v;
+                    out[i] = v > h ? h : v;
+                }
+            }
+            operands[top] = (BlockOperand){out, 0.0f};
+            break;
+        }
+        default:
+        {
+            BlockOperand a = operands[top - 1];
+            BlockOperand b = operands[top];
+            float* out = scratch[top - 1];
+            BlockOperand result = {out, 0.0f};
+            switch (instruction->opcode)
+            {
+            case OP_ADD:
+                BINARY_BLOCK_LOOP(x + y);
+                break;
+            case OP_SUB:
+                BINARY_BLOCK_LOOP(x - y);
+                break;
+            case OP_MUL:
+                BINARY_BLOCK_LOOP(x * y);
+                break;
+            case OP_DIV:
+                // Mianownik bliski zeru daje brak danych, tak jak w calculate_index_base()
+                BINARY_BLOCK_LOOP(fabsf(y) < FLT_EPSILON ? NAN : x / y);
+                break;
+            case OP_MIN:
+                BINARY_BLOCK_LOOP((x < y || x != x) ? x : y);
+                break;
+            case OP_MAX:
+                BINARY_BLOCK_LOOP((x > y || x != x) ? x : y);
+                break;
+            default:
+                break;
+            }
+            top--;
+            operands[top] = result;
+            break;
+        }
+        }
+    }
+
+    BlockOperand value = operands[0];
+    if (!value.data)
+    {
+        float constant = isfinite(value.value) ? value.value : INDEX_NO_DATA_VALUE;
+        for (size_t i = 0; i < count; i++)
+        {
+            output[i] = (mask && mask[i]) ? INDEX_NO_DATA_VALUE : constant;
+        }
+        return;
+    }
+    if (mask)
+    {
+        #pragma omp simd
+        for (size_t i = 0; i < count; i++)
+        {
+            float v = value.data[i];
+            output[i] = (mask[i] || !isfinite(v)) ? INDEX_NO_DATA_VALUE : v;
+        }
+    }
+    else
+    {
+        #pragma omp simd
+        for (size_t i = 0; i < count; i++)
+        {
+            float v = value.data[i];
+            output[i] = isfinite(v) ? v : INDEX_NO_DATA_VALUE;
+        }
+    }
+}
+
+// ====== PARSER FORMUŁ ======
+// expression = term (('+' | '-') term)*
+// term       = unary (('*' | '/') unary)*
+// unary      = '-' unary | primary
+// primary    = liczba | pasmo | funkcja '(' argumenty ')' | '(' expression ')'
+
+static void parse_expression(FormulaParser* parser)
+{
+    parse_term(parser);
+    while (!parser->failed)
+    {
+        skip_whitespace(parser);
+        char op = *parser->pos;
+        if (op != '+' && op != '-')
+        {
+            return;
+        }
+        parser->pos++;
+        parse_term(parser);
+        emit(parser, op == '+' ? OP_ADD : OP_SUB, -1, 0.0f);
+    }
+}
+
+static void parse_term(FormulaParser* parser)
+{
+    parse_unary(parser);
+    while (!parser->failed)
+    {
+        skip_whitespace(parser);
+        char op = *parser->pos;
+        if (op != '*' && op != '/')
+        {
+            return;
+        }
+        parser->pos++;
+        parse_unary(parser);
+        emit(parser, op == '*' ? OP_MUL : OP_DIV, -1, 0.0f);
+    }
+}
+
+static void parse_unary(FormulaParser* parser)
+{
+    skip_whitespace(parser);
+    if (*parser->pos == '-')
+    {
+        parser->pos++;
+        parse_unary(parser);
+        emit(parser, OP_NEG, -1, 0.0f);
+        return;
+    }
+    parse_primary(parser);
+}
+
+static void parse_primary(FormulaParser* parser)
+{
+    if (parser->failed)
+    {
+        return;
+    }
+    skip_whitespace(parser);
+    const char* start = parser->pos;
+
+    if (*start == '(')
+    {
+        parser->pos++;
+        parse_expression(parser);
+        skip_whitespace(parser);
+        if (!parser->failed && *parser->pos != ')')
+        {
+            parser_error(parser, "oczekiwano ')'");
+            return;
+        }
+        parser->pos++;
+        return;
+    }
+
+    if (isdigit((unsigned char)*start) || *start == '.')
+    {
+        char* end;
+        float value = strtof(start, &end);
+        if (end == start)
+        {
+            parser_error(parser, "niepoprawna liczba");
+            return;
+        }
+        parser->pos = end;
+        emit(parser, OP_CONST, -1, value);
+        return;
+    }
+
+    if (isalpha((unsigned char)*start))
+    {
+        while (isalnum((unsigned char)*parser->pos) || *parser->pos == '_')
+        {
+            parser->pos++;
+        }
+        size_t name_len = (size_t)(parser->pos - start);
+        skip_whitespace(parser);
+        if (*parser->pos == '(')
+        {
+            parse_function_call(parser, start, name_len);
+            return;
+        }
+
+        char band_name[8];
+        if (name_len >= sizeof(band_name))
+        {
+            parser_error(parser, "nieznane pasmo");
+            return;
+        }
+        memcpy(band_name, start, name_len);
+        band_name[name_len] = '\0';
+        // Pasma klasyfikacyjne zawierają kody klas - maska SCL podawana jest osobno
+        int band = band_registry_find(band_name);
+        if (band < 0 || band_registry_is_categorical(band))
+        {
+            parser->pos = start;
+            parser_error(parser, "nieznane pasmo");
+            return;
+        }
+        emit(parser, OP_LOAD_BAND, band, 0.0f);
+        return;
+    }
+
+    parser_error(parser, "oczekiwano liczby, pasma lub '('");
+}
+
+static void parse_function_call(FormulaParser* parser, const char* name, size_t name_len)
+{
+    static const struct
+    {
+        const char* name;
+        BandMathOpcode opcode;
+        int arity;
+    } FUNCTIONS[] = {
+        {"min", OP_MIN, 2},
+        {"max", OP_MAX, 2},
+        {"abs", OP_ABS, 1},
+        {"sqrt", OP_SQRT, 1},
+        {"clamp", OP_CLAMP, 3}
+    };
+
+    int function = -1;
+    for (int i = 0; i < (int)(sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0])); i++)
+    {
+        if (strlen(FUNCTIONS[i].name) == name_len && g_ascii_strncasecmp(FUNCTIONS[i].name, name, name_len) == 0)
+        {
+            function = i;
+            break;
+        }
+    }
+    if (function < 0)
+    {
+        parser->pos = name;
+        parser_error(parser, "nieznana funkcja");
+        return;
+    }
+
+    parser->pos++; // '('
+    for (int arg = 0; arg < FUNCTIONS[function].arity && !parser->failed; arg++)
+    {
+        if (arg > 0)
+        {
+            skip_whitespace(parser);
+            if (*parser->pos != ',')
+            {
+                parser_error(parser, "oczekiwano ','");
+                return;
+            }
+            parser->pos++;
+        }
+        parse_expression(parser);
+    }
+    skip_whitespace(parser);
+    if (!parser->failed && *parser->pos != ')')
+    {
+        parser_error(parser, "oczekiwano ')' - zła liczba argumentów funkcji");
+        return;
+    }
+    parser->pos++;
+    emit(parser, FUNCTIONS[function].opcode, -1, 0.0f);
+}
+
+// Dopisuje instrukcję i śledzi głębokość stosu, który w czasie wykonania ma stały rozmiar
+static void emit(FormulaParser* parser, BandMathOpcode opcode, int band, float value)
+{
+    if (parser->failed)
+    {
+        return;
+    }
+
+    BandMathProgram* program = parser->program;
+    if (program->length == program->capacity)
+    {
+        int new_capacity = program->capacity ? program->capacity * 2 : 16;
+        BandMathInstruction* code = realloc(program->code, (size_t)new_capacity * sizeof(BandMathInstruction));
+        if (!code)
+        {
+            parser_error(parser, "brak pamięci");
+            return;
+        }
+        program->code = code;
+        program->capacity = new_capacity;
+    }
+
+    switch (opcode)
+    {
+    case OP_LOAD_BAND:
+    case OP_CONST:
+        parser->depth++;
+        break;
+    case OP_NEG:
+    case OP_ABS:
+    case OP_SQRT:
+        break;
+    case OP_CLAMP:
+        parser->depth -= 2;
+        break;
+    default:
+        parser->depth--;
+        break;
+    }
+    if (parser->depth > BAND_MATH_MAX_STACK)
+    {
+        parser_error(parser, "formuła zbyt głęboko zagnieżdżona");
+        return;
+    }
+
+    if (opcode == OP_LOAD_BAND)
+    {
+        program->required_bands |= 1u << band;
+    }
+    program->code[program->length++] = (BandMathInstruction){opcode, band, value};
+}
+
+static void parser_error(FormulaParser* parser, const char* message)
+{
+    if (parser->failed)
+    {
+        return;
+    }
+    parser->failed = true;
+    fprintf(stderr, "[%s] Błąd w formule wskaźnika %s (znak %d): %s\n    %s\n",
+            get_timestamp(), parser->program->name, (int)(parser->pos - parser->formula) + 1,
+            message, parser->formula);
+}
+
+static void skip_whitespace(FormulaParser* parser)
+{
+    while (isspace((unsigned char)*parser->pos))
+    {
+        parser->pos++;
+    }
+}
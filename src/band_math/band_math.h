@@ -0,0 +1,149 @@
+#ifndef BAND_MATH_H
+#define BAND_MATH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../band_registry/band_registry.h"
+#include "../index_stats/index_stats.h"
+#include "../tiled_bands/tiled_bands.h"
+
+// Pasma w formułach indeksowane są jak w rejestrze pasm (band_registry_find())
+#define BAND_MATH_BAND_COUNT BAND_REGISTRY_COUNT
+
+/**
+ * @brief Skompilowana formuła wskaźnika (program dla maszyny stosowej działającej na blokach pikseli)
+ */
+typedef struct BandMathProgram BandMathProgram;
+
+/**
+ * @brief Wbudowany wskaźnik spektralny
+ *
+ * Formuły działają na wartościach DN produktu L2A (reflektancja x 10000), dlatego stałe
+ * w EVI i SAVI są przeskalowane o 10000.
+ */
+typedef struct
+{
+    const char* name;
+    const char* formula;
+} BandMathIndex;
+
+/**
+ * @brief Zwraca tablicę wbudowanych wskaźników (NDVI, NDMI, NDWI, NBR, EVI, SAVI, NDRE)
+ */
+const BandMathIndex* band_math_builtin_indices(int* count_out);
+
+/**
+ * @brief Wyszukuje wbudowany wskaźnik po nazwie (bez rozróżniania wielkości liter)
+ *
+ * @return Wskaźnik do opisu lub NULL, gdy nazwa jest nieznana
+ */
+const BandMathIndex* band_math_find_builtin(const char* name);
+
+/**
+ * @brief Kompiluje formułę wskaźnika
+ *
+ * Składnia: liczby, nazwy pasm (B01-B12, B8A), operatory + - * / z nawiasami oraz funkcje
+ * min(a, b), max(a, b), clamp(x, lo, hi), abs(x), sqrt(x). Dzielenie przez wartość bliską
+ * zeru daje piksel bez danych (INDEX_NO_DATA_VALUE), podobnie jak każdy wynik nieskończony lub NaN.
+ *
+ * @param name Nazwa wskaźnika (do logów i metryk)
+ * @return Program do zwolnienia przez band_math_free() lub NULL przy błędzie składni (opis w stderr)
+ */
+BandMathProgram* band_math_compile(const char* name, const char* formula);
+
+/**
+ * @brief Kompiluje wbudowany wskaźnik o podanej nazwie
+ *
+ * @return Program lub NULL, gdy nazwa jest nieznana
+ */
+BandMathProgram* band_math_compile_builtin(const char* name);
+
+/**
+ * @brief Zwalnia skompilowany program (NULL nic nie robi)
+ */
+void band_math_free(BandMathProgram* program);
+
+/**
+ * @brief Zwraca nazwę wskaźnika podaną przy kompilacji
+ */
+const char* band_math_program_name(const BandMathProgram* program);
+
+/**
+ * @brief Zwraca maskę bitową pasm czytanych przez program (bit i = pasmo band_registry_find())
+ */
+uint32_t band_math_required_bands(const BandMathProgram* program);
+
+/**
+ * @brief Oblicza kilka wskaźników w jednym przebiegu po pikselach
+ *
+ * Piksele przetwarzane są blokami mieszczącymi się w cache L1: dla każdego bloku maska SCL
+ * liczona jest raz, a następnie wykonywane są wszystkie programy, więc każde pasmo wejściowe
+ * czytane jest z pamięci głównej tylko raz, niezależnie od liczby wskaźników. Operacje programu
+ * są pętlami po bloku, wektoryzowanymi przez kompilator. Bloki dzielone są między wątki OpenMP.
+ *
+ * Gdy w próbce maski SCL pikseli ważnych jest mniej niż połowa, wywołanie liczy blok rzadko:
+ * programy wykonywane są tylko na odcinkach ważnych maski, a odcinki zamaskowane wypełniane
+ * brakiem danych, więc koszt zależy od liczby pikseli ważnych. Wyniki nie zależą od ścieżki.
+ *
+ * @param programs Tablica program_count skompilowanych programów
+ * @param bands Wskaźniki na pasma indeksowane jak w rejestrze pasm - wymagane tylko
+ *              pasma z band_math_required_bands(), pozostałe mogą być NULL
+ * @param scl_band Maska SCL lub NULL (brak maskowania)
+ * @param outputs Tablica program_count buforów na num_pixels wartości
+ * @return 0 w przypadku sukcesu, -1 gdy brakuje pasma wymaganego przez któryś program
+ */
+int band_math_evaluate(BandMathProgram* const* programs, int program_count,
+                       const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                       size_t num_pixels, float* const outputs[]);
+
+/**
+ * @brief band_math_evaluate() zbierająca jednocześnie statystyki każdego wskaźnika
+ *
+ * Statystyki bloku liczone są zaraz po jego obliczeniu, gdy wyniki są jeszcze w L1, do
+ * statystyk lokalnych wątku łączonych na końcu - bez drugiego przejścia po rastrach wyników.
+ *
+ * @param stats Tablica program_count statystyk, do których wyniki są doliczane (nie są
+ *              zerowane, więc kolejne pasy wierszy sceny sumują się) lub NULL
+ */
+int band_math_evaluate_with_stats(BandMathProgram* const* programs, int program_count,
+                                  const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                                  size_t num_pixels, float* const outputs[], IndexStats* stats);
+
+/**
+ * @brief band_math_evaluate_with_stats() dla pasm spakowanych w kafle (tiled_bands_pack())
+ *
+ * Wątki dostają całe kafle, więc wejścia bloku są w jednym ciągłym fragmencie pamięci,
+ * a nie w kilku odległych tablicach. Wyniki zapisywane są w zwykłym układzie wierszowym.
+ *
+ * @param band_slots Slot kafla dla każdego pasma rejestru lub -1, gdy pasma nie ma
+ * @param scl_slot Slot maski SCL lub -1 (brak maskowania)
+ * @param outputs Tablica program_count buforów na tiled->num_pixels wartości
+ * @param stats Statystyki doliczane jak w band_math_evaluate_with_stats() lub NULL
+ * @return 0 w przypadku sukcesu, -1 gdy brakuje pasma wymaganego przez któryś program
+ */
+int band_math_evaluate_tiled(BandMathProgram* const* programs, int program_count, const TiledBands* tiled,
+                             const int band_slots[BAND_MATH_BAND_COUNT], int scl_slot,
+                             float* const outputs[], IndexStats* stats);
+
+/**
+ * @brief band_math_evaluate_with_stats() zapisująca wyniki jako int16 (quantize_index_values())
+ *
+ * Blok liczony jest do bufora float wątku (L1), z którego zbierane są statystyki i od razu
+ * kwantowany do outputs - raster float wyników nie powstaje, a pamięć wyników spada o połowę.
+ * Statystyki liczone są z wartości przed kwantyzacją.
+ *
+ * @param outputs Tablica program_count buforów na num_pixels wartości int16
+ */
+int band_math_evaluate_quantized(BandMathProgram* const* programs, int program_count,
+                                 const float* const bands[BAND_MATH_BAND_COUNT], const float* scl_band,
+                                 size_t num_pixels, int16_t* const outputs[], IndexStats* stats);
+
+/**
+ * @brief band_math_evaluate_tiled() z kwantyzacją wyników jak w band_math_evaluate_quantized()
+ */
+int band_math_evaluate_tiled_quantized(BandMathProgram* const* programs, int program_count, const TiledBands* tiled,
+                                       const int band_slots[BAND_MATH_BAND_COUNT], int scl_slot,
+                                       int16_t* const outputs[], IndexStats* stats);
+
+#endif // BAND_MATH_H
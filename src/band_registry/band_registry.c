@@ -0,0 +1,117 @@
+#include "band_registry.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * @brief Pasma produktu Sentinel-2 L2A (MSI), w kolejności numeracji pasm
+ *
+ * Rozdzielczość natywna to rozdzielczość, w której pasmo jest dostarczane bez resamplingu
+ * (w produkcie L2A pasma 20m i 60m są też dostępne w rozdzielczościach zmniejszonych).
+ * B10 (cirrus) występuje tylko w produkcie L1C.
+ */
+static const BandInfo BAND_REGISTRY[BAND_REGISTRY_COUNT] = {
+    {"B01", 60, 443, BAND_ROLE_ATMOSPHERIC},
+    {"B02", 10, 490, BAND_ROLE_VISIBLE},
+    {"B03", 10, 560, BAND_ROLE_VISIBLE},
+    {"B04", 10, 665, BAND_ROLE_VISIBLE},
+    {"B05", 20, 705, BAND_ROLE_RED_EDGE},
+    {"B06", 20, 740, BAND_ROLE_RED_EDGE},
+    {"B07", 20, 783, BAND_ROLE_RED_EDGE},
+    {"B08", 10, 842, BAND_ROLE_NIR},
+    {"B8A", 20, 865, BAND_ROLE_NIR},
+    {"B09", 60, 945, BAND_ROLE_ATMOSPHERIC},
+    {"B10", 60, 1375, BAND_ROLE_ATMOSPHERIC},
+    {"B11", 20, 1610, BAND_ROLE_SWIR},
+    {"B12", 20, 2190, BAND_ROLE_SWIR},
+    {"SCL", 20, 0, BAND_ROLE_CLASSIFICATION}
+};
+
+// Znaczniki rozdzielczości w nazwach plików produktu L2A (katalogi R10m/R20m/R60m, sufiksy "_20m")
+static const char* RESOLUTION_TOKENS[] = {"10m", "20m", "60m"};
+
+const BandInfo* band_registry_get(int band_index)
+{
+    if (band_index < 0 || band_index >= BAND_REGISTRY_COUNT)
+    {
+        return NULL;
+    }
+    return &BAND_REGISTRY[band_index];
+}
+
+int band_registry_find(const char* band_name)
+{
+    for (int i = 0; band_name && i < BAND_REGISTRY_COUNT; i++)
+    {
+        if (strcasecmp(BAND_REGISTRY[i].name, band_name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int band_registry_detect_filename(const char* filename)
+{
+    if (!filename)
+    {
+        return -1;
+    }
+
+    // Najpierw nazwa pasma jako osobny człon nazwy pliku
+    for (int i = 0; i < BAND_REGISTRY_COUNT; i++)
+    {
+        char delimited[8], with_extension[8];
+        snprintf(delimited, sizeof(delimited), "_%s_", BAND_REGISTRY[i].name);
+        snprintf(with_extension, sizeof(with_extension), "_%s.", BAND_REGISTRY[i].name);
+        if (strstr(filename, delimited) || strstr(filename, with_extension))
+        {
+            return i;
+        }
+    }
+
+    for (int i = 0; i < BAND_REGISTRY_COUNT; i++)
+    {
+        if (strstr(filename, BAND_REGISTRY[i].name))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool band_registry_is_native_filename(const char* filename, int band_index)
+{
+    const BandInfo* info = band_registry_get(band_index);
+    if (!filename || !info)
+    {
+        return false;
+    }
+
+    char native_token[16];
+    snprintf(native_token, sizeof(native_token), "%dm", info->native_resolution_m);
+    return strstr(filename, native_token) != NULL;
+}
+
+bool band_registry_has_foreign_resolution(const char* filename, int band_index)
+{
+    if (!filename || band_registry_is_native_filename(filename, band_index))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(RESOLUTION_TOKENS) / sizeof(RESOLUTION_TOKENS[0]); i++)
+    {
+        if (strstr(filename, RESOLUTION_TOKENS[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool band_registry_is_categorical(int band_index)
+{
+    const BandInfo* info = band_registry_get(band_index);
+    return info && info->role == BAND_ROLE_CLASSIFICATION;
+}
@@ -0,0 +1,73 @@
+#ifndef BAND_REGISTRY_H
+#define BAND_REGISTRY_H
+
+#include <stdbool.h>
+
+// Liczba pasm produktu Sentinel-2 L2A znanych programowi: B01-B12, B8A i SCL
+#define BAND_REGISTRY_COUNT 14
+
+/**
+ * @brief Rola pasma w przetwarzaniu
+ *
+ * Pasma klasyfikacyjne (SCL) przechowują kody klas, więc nie mogą być interpolowane,
+ * a w formułach wskaźników służą tylko jako maska.
+ */
+typedef enum
+{
+    BAND_ROLE_VISIBLE,
+    BAND_ROLE_RED_EDGE,
+    BAND_ROLE_NIR,
+    BAND_ROLE_SWIR,
+    BAND_ROLE_ATMOSPHERIC,
+    BAND_ROLE_CLASSIFICATION
+} BandRole;
+
+/**
+ * @brief Opis pasma w rejestrze
+ */
+typedef struct
+{
+    const char* name;
+    int native_resolution_m;
+    int central_wavelength_nm;
+    BandRole role;
+} BandInfo;
+
+/**
+ * @brief Zwraca opis pasma o podanym indeksie rejestru lub NULL
+ */
+const BandInfo* band_registry_get(int band_index);
+
+/**
+ * @brief Zwraca indeks rejestru pasma o podanej nazwie (bez rozróżniania wielkości liter) lub -1
+ */
+int band_registry_find(const char* band_name);
+
+/**
+ * @brief Rozpoznaje pasmo po nazwie pliku Sentinel-2 (np. "..._B8A_20m.jp2")
+ *
+ * Nazwa otoczona separatorami ("_B04_", "_B04.") ma pierwszeństwo przed samym wystąpieniem
+ * w nazwie, dzięki czemu fragmenty identyfikatorów produktu nie są mylone z pasmem.
+ *
+ * @return Indeks rejestru lub -1, gdy w nazwie nie ma żadnego pasma
+ */
+int band_registry_detect_filename(const char* filename);
+
+/**
+ * @brief Sprawdza, czy nazwa pliku zawiera znacznik natywnej rozdzielczości pasma (np. "20m" dla B11)
+ */
+bool band_registry_is_native_filename(const char* filename, int band_index);
+
+/**
+ * @brief Sprawdza, czy nazwa pliku ma znacznik rozdzielczości ("10m", "20m", "60m"), ale nie natywnej dla pasma
+ *
+ * Plik bez żadnego znacznika (np. pojedynczy GeoTIFF) nie jest uznawany za obcy.
+ */
+bool band_registry_has_foreign_resolution(const char* filename, int band_index);
+
+/**
+ * @brief Sprawdza, czy pasmo przechowuje kody klas (np. SCL), a nie reflektancję
+ */
+bool band_registry_is_categorical(int band_index);
+
+#endif // BAND_REGISTRY_H
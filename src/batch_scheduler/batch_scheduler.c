@@ -0,0 +1,675 @@
+#include "batch_scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <omp.h>
+
+#include "../pipeline_context/pipeline_context.h"
+#include "../visualization/visualization.h"
+#include "../data_saver/data_saver.h"
+#include "../utils/utils.h"
+#include "../metrics/metrics.h"
+#include "../raster_pool/raster_pool.h"
+#include "../band_registry/band_registry.h"
+#include "../data_loader/data_loader.h"
+#include "../zonal_stats/zonal_stats.h"
+#include "../chunk_store/chunk_store.h"
+#include "../index_calculator/index_calculator.h"
+
+
+/**
+ * @brief Scena w trakcie przetwarzania - bufory i konfigurację posiada jej kontekst pipeline'u
+ */
+typedef struct
+{
+    const BatchScene* scene;
+    PipelineContext* context;
+    bool loaded;
+    double load_s;
+} SceneJob;
+
+typedef struct
+{
+    const BatchScene* scenes;
+    int count;
+    const BatchConfig* config;
+    int threads_per_scene;
+    int loader_threads;
+    // Sceny wczytane przez wątek prefetch, gotowe do obliczeń
+    GAsyncQueue* ready_jobs;
+    // Żetony ograniczające liczbę scen wczytanych na zapas (pamięć)
+    GAsyncQueue* free_slots;
+    gint next_scene;
+    gint succeeded;
+    gint failed;
+} BatchState;
+
+// Znacznik końca kolejki - GAsyncQueue nie przyjmuje NULL
+static SceneJob BATCH_END_MARKER;
+
+// ====== WALIDACJA ======
+static int validate_batch_config(const BatchConfig* config);
+
+// ====== PAMIĘĆ ======
+static SceneJob* create_scene_job(const BatchScene* scene);
+static void free_scene_job(SceneJob* job);
+
+// ====== FUNKCJONALNOŚĆ ======
+static gpointer batch_loader_thread(gpointer data);
+static gpointer batch_worker_thread(gpointer data);
+static SceneJob* next_scene_job(BatchState* state);
+static void load_scene_job(SceneJob* job, int threads);
+static int process_scene_job(BatchState* state, SceneJob* job);
+static int save_index_pixbuf(GdkPixbuf* pixbuf, const char* output_dir, const char* scene_name,
+                             const char* index_name);
+
+// ====== POMOCNICZE ======
+static int parse_manifest_line(const char* line, BatchScene* scene, int* missing_band_out);
+static void assign_band_path(char* paths[PIPELINE_BAND_COUNT], const char* path);
+static void find_band_files(const char* directory, char* paths[PIPELINE_BAND_COUNT]);
+static char* scene_name_from_path(const char* path);
+
+int batch_load_manifest(const char* manifest_path, BatchScene** scenes_out, int* count_out)
+{
+    gchar* contents = NULL;
+    GError* error = NULL;
+
+    *scenes_out = NULL;
+    *count_out = 0;
+
+    if (!g_file_get_contents(manifest_path, &contents, NULL, &error))
+    {
+        fprintf(stderr, "[%s] Nie można wczytać manifestu %s: %s\n", get_timestamp(), manifest_path, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    gchar** lines = g_strsplit(contents, "\n", -1);
+    g_free(contents);
+
+    int line_count = g_strv_length(lines);
+    BatchScene* scenes = calloc(line_count > 0 ? line_count : 1, sizeof(BatchScene));
+    int count = 0;
+    int status = scenes ? 0 : -1;
+
+    for (int i = 0; i < line_count && status == 0; i++)
+    {
+        gchar* line = g_strstrip(lines[i]);
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            continue;
+        }
+
+        int missing_band = -1;
+        if (parse_manifest_line(line, &scenes[count], &missing_band) != 0)
+        {
+            fprintf(stderr, "[%s] Błąd w linii %d manifestu: brak pliku pasma %s potrzebnego wybranym wskaźnikom.\n",
+                    get_timestamp(), i + 1, pipeline_band_name(missing_band));
+            batch_free_scenes(&scenes[count], 1);
+            status = -1;
+            break;
+        }
+        count++;
+    }
+
+    g_strfreev(lines);
+
+    if (status != 0)
+    {
+        batch_free_scenes(scenes, count);
+        return -1;
+    }
+
+    *scenes_out = scenes;
+    *count_out = count;
+    return 0;
+}
+
+void batch_free_scenes(BatchScene* scenes, int count)
+{
+    if (!scenes)
+    {
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        g_free(scenes[i].name);
+        for (int b = 0; b < PIPELINE_BAND_COUNT; b++)
+        {
+            g_free(scenes[i].paths[b]);
+        }
+    }
+    free(scenes);
+}
+
+int run_batch(const BatchScene* scenes, int count, const BatchConfig* config)
+{
+    if (!validate_batch_config(config) || count <= 0)
+    {
+        return -1;
+    }
+
+    if (g_mkdir_with_parents(config->output_dir, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu wyjściowego %s.\n", get_timestamp(), config->output_dir);
+        return -1;
+    }
+
+    pipeline_global_init();
+    raster_pool_set_capacity(config->buffer_pool_bytes);
+
+    BatchState state;
+    memset(&state, 0, sizeof(state));
+    state.scenes = scenes;
+    state.count = count;
+    state.config = config;
+
+    int workers = config->scenes_in_flight < count ? config->scenes_in_flight : count;
+
+    // Podział budżetu: wątek prefetch dekoduje do 4 pasm naraz, resztę dzielą sceny w obliczeniach
+    if (config->prefetch)
+    {
+        int loader_share = config->total_threads / (workers + 1);
+        state.loader_threads = loader_share < 1 ? 1 : (loader_share > 4 ? 4 : loader_share);
+    }
+    int compute_threads = config->total_threads - state.loader_threads;
+    state.threads_per_scene = compute_threads / workers > 0 ? compute_threads / workers : 1;
+
+    printf("[%s] [WSAD] %d scen, %d jednocześnie po %d wątków, prefetch: %s (%d wątków)\n",
+           get_timestamp(), count, workers, state.threads_per_scene,
+           config->prefetch ? "tak" : "nie", state.loader_threads);
+
+    metrics_begin_run("batch");
+    gint64 start_us = g_get_monotonic_time();
+
+    GThread* loader = NULL;
+    if (config->prefetch)
+    {
+        state.ready_jobs = g_async_queue_new();
+        state.free_slots = g_async_queue_new();
+        for (int i = 0; i < workers; i++)
+        {
+            g_async_queue_push(state.free_slots, GINT_TO_POINTER(1));
+        }
+        loader = g_thread_new("batch-loader", batch_loader_thread, &state);
+    }
+
+    GThread** worker_threads = g_new(GThread*, workers);
+    for (int i = 0; i < workers; i++)
+    {
+        worker_threads[i] = g_thread_new("batch-worker", batch_worker_thread, &state);
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        g_thread_join(worker_threads[i]);
+    }
+    g_free(worker_threads);
+
+    if (loader)
+    {
+        g_thread_join(loader);
+        g_async_queue_unref(state.ready_jobs);
+        g_async_queue_unref(state.free_slots);
+    }
+
+    double elapsed_s = (g_get_monotonic_time() - start_us) / 1e6;
+    int succeeded = g_atomic_int_get(&state.succeeded);
+    int failed = g_atomic_int_get(&state.failed);
+
+    metrics_end_run(failed == 0 ? "ok" : "error");
+
+    printf("[%s] [WSAD] Zakończono: %d scen poprawnie, %d z błędem, czas %.1fs, przepustowość %.1f scen/h\n",
+           get_timestamp(), succeeded, failed, elapsed_s,
+           elapsed_s > 0.0 ? succeeded * 3600.0 / elapsed_s : 0.0);
+
+    raster_pool_set_capacity(0);
+    return failed == 0 ? 0 : -1;
+}
+
+static int validate_batch_config(const BatchConfig* config)
+{
+    if (!config || !config->output_dir)
+    {
+        fprintf(stderr, "[%s] Błąd: Brak katalogu wyjściowego wsadu.\n", get_timestamp());
+        return 0;
+    }
+    if (config->scenes_in_flight <= 0 || config->total_threads <= 0)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowa liczba scen jednocześnie lub wątków.\n", get_timestamp());
+        return 0;
+    }
+    return 1;
+}
+
+static SceneJob* create_scene_job(const BatchScene* scene)
+{
+    SceneJob* job = calloc(1, sizeof(SceneJob));
+    if (!job)
+    {
+        return NULL;
+    }
+
+    job->scene = scene;
+    job->context = pipeline_context_new(scene->name);
+    if (!job->context)
+    {
+        free(job);
+        return NULL;
+    }
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        pipeline_context_set_band_path(job->context, i, scene->paths[i]);
+    }
+    return job;
+}
+
+static void free_scene_job(SceneJob* job)
+{
+    pipeline_context_free(job->context);
+    free(job);
+}
+
+// Wczytuje pasma kolejnych scen z wyprzedzeniem, najwyżej scenes_in_flight scen na zapas
+static gpointer batch_loader_thread(gpointer data)
+{
+    BatchState* state = data;
+    int workers = state->config->scenes_in_flight < state->count ? state->config->scenes_in_flight : state->count;
+
+    for (int i = 0; i < state->count; i++)
+    {
+        g_async_queue_pop(state->free_slots);
+
+        SceneJob* job = create_scene_job(&state->scenes[i]);
+        if (!job)
+        {
+            g_atomic_int_inc(&state->failed);
+            g_async_queue_push(state->free_slots, GINT_TO_POINTER(1));
+            continue;
+        }
+
+        load_scene_job(job, state->loader_threads);
+        g_async_queue_push(state->ready_jobs, job);
+    }
+
+    for (int i = 0; i < workers; i++)
+    {
+        g_async_queue_push(state->ready_jobs, &BATCH_END_MARKER);
+    }
+    return NULL;
+}
+
+static gpointer batch_worker_thread(gpointer data)
+{
+    BatchState* state = data;
+
+    // Ustawienie dotyczy regionów równoległych uruchamianych z tego wątku
+    omp_set_num_threads(state->threads_per_scene);
+
+    SceneJob* job;
+    while ((job = next_scene_job(state)) != NULL)
+    {
+        if (process_scene_job(state, job) == 0)
+        {
+            g_atomic_int_inc(&state->succeeded);
+        }
+        else
+        {
+            g_atomic_int_inc(&state->failed);
+        }
+        free_scene_job(job);
+    }
+    return NULL;
+}
+
+// Następna scena do obliczeń: z kolejki prefetch albo wczytana na miejscu przez wątek roboczy
+static SceneJob* next_scene_job(BatchState* state)
+{
+    if (state->config->prefetch)
+    {
+        SceneJob* job = g_async_queue_pop(state->ready_jobs);
+        if (job == &BATCH_END_MARKER)
+        {
+            return NULL;
+        }
+        g_async_queue_push(state->free_slots, GINT_TO_POINTER(1));
+        return job;
+    }
+
+    while (1)
+    {
+        int index = g_atomic_int_add(&state->next_scene, 1);
+        if (index >= state->count)
+        {
+            return NULL;
+        }
+
+        SceneJob* job = create_scene_job(&state->scenes[index]);
+        if (job)
+        {
+            load_scene_job(job, state->threads_per_scene);
+            return job;
+        }
+        g_atomic_int_inc(&state->failed);
+    }
+}
+
+static void load_scene_job(SceneJob* job, int threads)
+{
+    gint64 start_us = g_get_monotonic_time();
+    job->loaded = pipeline_context_prefetch(job->context, threads < 4 ? threads : 4) == 0;
+    job->load_s = (g_get_monotonic_time() - start_us) / 1e6;
+}
+
+static int process_scene_job(BatchState* state, SceneJob* job)
+{
+    const char* name = job->scene->name;
+
+    if (!job->loaded)
+    {
+        fprintf(stderr, "[%s] [WSAD] Scena %s: błąd wczytywania pasm.\n", get_timestamp(), name);
+        return -1;
+    }
+
+    gint64 start_us = g_get_monotonic_time();
+    job->context->target_10m = state->config->target_10m;
+    job->context->value_type = state->config->value_type;
+    job->context->band_layout = state->config->band_layout;
+    ProcessingResult* result = pipeline_context_run(job->context);
+    if (!result)
+    {
+        fprintf(stderr, "[%s] [WSAD] Scena %s: błąd przetwarzania.\n", get_timestamp(), name);
+        return -1;
+    }
+
+    int status = batch_export_result(result, state->config->output_dir, name, state->config->export_formats);
+    if (status == 0 && state->config->zones.path)
+    {
+        status = batch_export_zonal_stats(result, job->scene->paths, &state->config->zones,
+                                          state->config->output_dir, name);
+    }
+
+    printf("[%s] [WSAD] Scena %s: wczytywanie %.2fs, obliczenia i eksport %.2fs\n",
+           get_timestamp(), name, job->load_s, (g_get_monotonic_time() - start_us) / 1e6);
+
+    free_processing_result(result);
+    return status;
+}
+
+int batch_export_index_png(const float* index_data, int width, int height,
+                           const char* output_dir, const char* scene_name, const char* index_name)
+{
+    return save_index_pixbuf(generate_pixbuf_from_index_data(index_data, width, height),
+                             output_dir, scene_name, index_name);
+}
+
+int batch_export_quantized_png(const int16_t* index_data, int width, int height,
+                               const char* output_dir, const char* scene_name, const char* index_name)
+{
+    return save_index_pixbuf(generate_pixbuf_from_quantized_index(index_data, width, height),
+                             output_dir, scene_name, index_name);
+}
+
+// Zapisuje mapę wskaźnika jako <scena>_<wskaźnik>.png i zwalnia pixbuf (NULL - błąd kolorowania)
+static int save_index_pixbuf(GdkPixbuf* pixbuf, const char* output_dir, const char* scene_name,
+                             const char* index_name)
+{
+    if (!pixbuf)
+    {
+        return -1;
+    }
+
+    gchar* filename = g_strdup_printf("%s/%s_%s.png", output_dir, scene_name, index_name);
+    gboolean saved = save_pixbuf_to_png(pixbuf, filename);
+
+    g_free(filename);
+    g_object_unref(pixbuf);
+    return saved ? 0 : -1;
+}
+
+int batch_export_result(const ProcessingResult* result, const char* output_dir, const char* scene_name,
+                        unsigned int formats)
+{
+    formats = formats ? formats : BATCH_EXPORT_PNG;
+
+    // Wskaźniki spoza wyboru mają NULL w wyniku i nie są eksportowane
+    for (int k = 0; (formats & BATCH_EXPORT_PNG) && k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (result->index_data[k] &&
+            batch_export_index_png(result->index_data[k], result->width, result->height,
+                                   output_dir, scene_name, pipeline_index_name(k)) != 0)
+        {
+            return -1;
+        }
+        if (result->index_int16[k] &&
+            batch_export_quantized_png(result->index_int16[k], result->width, result->height,
+                                       output_dir, scene_name, pipeline_index_name(k)) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if ((formats & BATCH_EXPORT_ZARR) && batch_export_index_chunks(result, output_dir, scene_name) != 0)
+    {
+        return -1;
+    }
+
+    // Statystyki policzone razem z wskaźnikami - zapis bez ponownego przejścia po rastrach
+    gchar* stats_filename = g_strdup_printf("%s/%s_stats.json", output_dir, scene_name);
+    int status = write_processing_stats_json(result, stats_filename);
+    g_free(stats_filename);
+
+    // Indeks bloków obok map - zapytania progowe i o pokrycie bez czytania rastrów
+    bool has_blocks = false;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        has_blocks = has_blocks || result->index_blocks[k].blocks;
+    }
+    if (status == 0 && has_blocks)
+    {
+        gchar* blocks_filename = g_strdup_printf("%s/%s_blocks.json", output_dir, scene_name);
+        status = write_processing_blocks_json(result, blocks_filename);
+        g_free(blocks_filename);
+    }
+    return status;
+}
+
+int batch_export_index_chunks(const ProcessingResult* result, const char* output_dir, const char* scene_name)
+{
+    gchar* group_path = g_strdup_printf("%s/%s.zarr", output_dir, scene_name);
+    int status = chunk_store_create_group(group_path);
+
+    // Wyniki int16 zapisywane są jako tablice <i2 - połowa danych do kompresji
+    for (int k = 0; status == 0 && k < PIPELINE_INDEX_COUNT; k++)
+    {
+        const void* values = result->index_int16[k] ? (const void*)result->index_int16[k]
+                                                    : (const void*)result->index_data[k];
+        if (!values)
+        {
+            continue;
+        }
+
+        gchar* array_path = g_build_filename(group_path, pipeline_index_name(k), NULL);
+        ChunkStore store;
+        status = chunk_store_create(&store, array_path, result->width, result->height, result->index_int16[k] != NULL,
+                                    0, 0);
+        if (status == 0)
+        {
+            status = chunk_store_write_rows(&store, values, 0, result->height);
+            if (chunk_store_close(&store) != 0)
+            {
+                status = -1;
+            }
+        }
+        g_free(array_path);
+    }
+
+    g_free(group_path);
+    return status;
+}
+
+int batch_export_zonal_stats(const ProcessingResult* result, char* const band_paths[PIPELINE_BAND_COUNT],
+                             const ZonalExportConfig* zones, const char* output_dir, const char* scene_name)
+{
+    const char* reference_path = NULL;
+    for (int b = 0; b < PIPELINE_BAND_COUNT && !reference_path; b++)
+    {
+        reference_path = band_paths[b];
+    }
+
+    uint32_t* labels = read_zone_labels(zones->path, zones->id_field, reference_path, result->width, result->height);
+    if (!labels)
+    {
+        return -1;
+    }
+
+    // Tylko wskaźniki obecne w wyniku, w kolejności PipelineIndex; wynik ma jedną reprezentację
+    // (float albo int16), a wartości int16 czytane są wprost, bez tymczasowych rastrów float
+    size_t num_pixels = (size_t)result->width * result->height;
+    const float* values[PIPELINE_INDEX_COUNT];
+    const int16_t* quantized[PIPELINE_INDEX_COUNT];
+    const char* names[PIPELINE_INDEX_COUNT];
+    int index_count = 0;
+    bool is_quantized = false;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (result->index_data[k] || result->index_int16[k])
+        {
+            values[index_count] = result->index_data[k];
+            quantized[index_count] = result->index_int16[k];
+            names[index_count] = pipeline_index_name(k);
+            is_quantized = is_quantized || result->index_int16[k];
+            index_count++;
+        }
+    }
+
+    gint64 start_us = g_get_monotonic_time();
+    ZonalStats* zonal = is_quantized ? zonal_stats_compute_quantized(labels, quantized, index_count, num_pixels)
+                                     : zonal_stats_compute(labels, values, index_count, num_pixels);
+    free(labels);
+    if (!zonal)
+    {
+        return -1;
+    }
+
+    gchar* filename = g_strdup_printf("%s/%s_zones.%s", output_dir, scene_name, zones->as_json ? "json" : "csv");
+    int status = zones->as_json ? zonal_stats_write_json(zonal, names, filename)
+                                : zonal_stats_write_csv(zonal, names, filename);
+    printf("[%s] Scena %s: statystyki %zu stref w %.2fs -> %s\n", get_timestamp(), scene_name,
+           zonal->zone_count, (g_get_monotonic_time() - start_us) / 1e6, filename);
+
+    g_free(filename);
+    zonal_stats_free(zonal);
+    return status;
+}
+
+static int parse_manifest_line(const char* line, BatchScene* scene, int* missing_band_out)
+{
+    gchar** tokens = g_strsplit_set(line, " \t", -1);
+    const char* first_token = NULL;
+    int token_count = 0;
+
+    memset(scene, 0, sizeof(*scene));
+
+    for (int i = 0; tokens[i]; i++)
+    {
+        if (tokens[i][0] == '\0')
+        {
+            continue;
+        }
+        if (!first_token)
+        {
+            first_token = tokens[i];
+        }
+        token_count++;
+        assign_band_path(scene->paths, tokens[i]);
+    }
+
+    if (token_count == 1 && g_file_test(first_token, G_FILE_TEST_IS_DIR))
+    {
+        find_band_files(first_token, scene->paths);
+    }
+
+    scene->name = first_token ? scene_name_from_path(first_token) : NULL;
+    g_strfreev(tokens);
+
+    // Wymagane są tylko pasma potrzebne wybranym wskaźnikom
+    unsigned int band_mask = pipeline_index_band_mask(get_pipeline_index_selection());
+    for (int b = 0; b < PIPELINE_BAND_COUNT; b++)
+    {
+        if ((band_mask & (1u << b)) && !scene->paths[b])
+        {
+            *missing_band_out = b;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Przypisuje plik do pasma; przy kilku kandydatach wygrywa plik w natywnej rozdzielczości pasma
+static void assign_band_path(char* paths[PIPELINE_BAND_COUNT], const char* path)
+{
+    gchar* basename = g_path_get_basename(path);
+    // Indeks rejestru pasm jest zarazem indeksem BandData (BandType)
+    int band = band_registry_detect_filename(basename);
+
+    if (band >= 0)
+    {
+        // Natywna rozdzielczość pasma z rejestru pasm - preferowana przy wyszukiwaniu plików w katalogu produktu
+        bool native = band_registry_is_native_filename(basename, band);
+        gchar* current_basename = paths[band] ? g_path_get_basename(paths[band]) : NULL;
+        bool current_native = current_basename && band_registry_is_native_filename(current_basename, band);
+
+        if (!paths[band] || (native && !current_native))
+        {
+            g_free(paths[band]);
+            paths[band] = g_strdup(path);
+        }
+        g_free(current_basename);
+    }
+
+    g_free(basename);
+}
+
+static void find_band_files(const char* directory, char* paths[PIPELINE_BAND_COUNT])
+{
+    GDir* dir = g_dir_open(directory, 0, NULL);
+    if (!dir)
+    {
+        return;
+    }
+
+    const gchar* entry;
+    while ((entry = g_dir_read_name(dir)) != NULL)
+    {
+        gchar* path = g_build_filename(directory, entry, NULL);
+
+        if (g_file_test(path, G_FILE_TEST_IS_DIR))
+        {
+            find_band_files(path, paths);
+        }
+        else if (g_str_has_suffix(entry, ".jp2") || g_str_has_suffix(entry, ".tif") ||
+                 g_str_has_suffix(entry, ".tiff"))
+        {
+            assign_band_path(paths, path);
+        }
+
+        g_free(path);
+    }
+
+    g_dir_close(dir);
+}
+
+// Nazwa sceny: nazwa katalogu lub pliku bez rozszerzenia
+static char* scene_name_from_path(const char* path)
+{
+    gchar* basename = g_path_get_basename(path);
+    char* dot = strchr(basename, '.');
+    if (dot && dot != basename)
+    {
+        *dot = '\0';
+    }
+    return basename;
+}
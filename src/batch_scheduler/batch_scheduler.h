@@ -0,0 +1,145 @@
+#ifndef BATCH_SCHEDULER_H
+#define BATCH_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../data_types/data_types.h"
+#include "../processing_pipeline/processing_pipeline.h"
+
+/**
+ * @brief Jedna scena wsadu - ścieżki plików pasm w kolejności BandType
+ *
+ * Pasma niepotrzebne wybranym wskaźnikom (get_pipeline_index_selection()) mogą mieć NULL.
+ */
+typedef struct
+{
+    char* name;
+    char* paths[PIPELINE_BAND_COUNT];
+} BatchScene;
+
+/**
+ * @brief Statystyki stref (działek) liczone dla każdej sceny
+ *
+ * Gdy path jest NULL, statystyki stref nie są liczone.
+ */
+typedef struct
+{
+    // Raster etykiet albo plik wielokątów (patrz read_zone_labels())
+    const char* path;
+    // Pole z identyfikatorem działki w pliku wektorowym
+    const char* id_field;
+    // true - <scena>_zones.json, false - <scena>_zones.csv
+    bool as_json;
+} ZonalExportConfig;
+
+/**
+ * @brief Formaty map wskaźników zapisywanych przez batch_export_result() (flagi bitowe)
+ */
+typedef enum
+{
+    // <scena>_<WSKAŹNIK>.png - mapa w kolorach
+    BATCH_EXPORT_PNG = 1 << 0,
+    // <scena>.zarr/<WSKAŹNIK> - wartości w niezależnie skompresowanych chunkach (patrz ChunkStore)
+    BATCH_EXPORT_ZARR = 1 << 1
+} BatchExportFormat;
+
+/**
+ * @brief Konfiguracja przetwarzania wsadowego
+ *
+ * Globalny budżet wątków dzielony jest między sceny przetwarzane jednocześnie i wątek
+ * wczytujący kolejne sceny z wyprzedzeniem (prefetch).
+ */
+typedef struct
+{
+    int scenes_in_flight;
+    int total_threads;
+    bool target_10m;
+    // Reprezentacja wskaźników w wynikach scen (PIPELINE_VALUES_INT16 - połowa pamięci)
+    PipelineValueType value_type;
+    // Układ pasm na etapie wskaźników (PIPELINE_LAYOUT_TILED - pasma spakowane w kafle)
+    PipelineBandLayout band_layout;
+    bool prefetch;
+    // Pojemność puli buforów rastrów współdzielonej przez sceny, 0 wyłącza ponowne użycie
+    size_t buffer_pool_bytes;
+    const char* output_dir;
+    // Suma flag BatchExportFormat, 0 - BATCH_EXPORT_PNG
+    unsigned int export_formats;
+    ZonalExportConfig zones;
+} BatchConfig;
+
+/**
+ * @brief Wczytuje manifest wsadu
+ *
+ * Każda niepusta linia (poza komentarzami zaczynającymi się od '#') opisuje jedną scenę:
+ * cztery ścieżki plików pasm rozdzielone białymi znakami (w dowolnej kolejności - pasmo
+ * rozpoznawane jest z nazwy pliku) albo jeden katalog, w którym pliki pasm są wyszukiwane
+ * rekurencyjnie (np. katalog .SAFE produktu L2A).
+ *
+ * @param scenes_out [out] Tablica scen do zwolnienia przez batch_free_scenes()
+ * @param count_out [out] Liczba scen
+ * @return 0 w przypadku sukcesu, -1 gdy manifest nie istnieje lub scena nie ma kompletu pasm
+ */
+int batch_load_manifest(const char* manifest_path, BatchScene** scenes_out, int* count_out);
+
+void batch_free_scenes(BatchScene* scenes, int count);
+
+/**
+ * @brief Przetwarza sceny wsadu i zapisuje mapy NDVI/NDMI jako PNG w katalogu wyjściowym
+ *
+ * Kilka scen przetwarzanych jest jednocześnie, każda z własną częścią budżetu wątków OpenMP,
+ * dzięki czemu jednowątkowe fazy jednej sceny (otwieranie plików, kodowanie PNG) nakładają się
+ * na obliczenia innych. Przy włączonym prefetch osobny wątek wczytuje pasma kolejnych scen,
+ * gdy bieżące są liczone. Na końcu wypisywana jest przepustowość w scenach na godzinę.
+ *
+ * @return 0 gdy wszystkie sceny zostały przetworzone, -1 gdy choć jedna zakończyła się błędem
+ */
+int run_batch(const BatchScene* scenes, int count, const BatchConfig* config);
+
+/**
+ * @brief Zapisuje mapę wskaźnika jako <output_dir>/<scene_name>_<index_name>.png
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int batch_export_index_png(const float* index_data, int width, int height,
+                           const char* output_dir, const char* scene_name, const char* index_name);
+
+/**
+ * @brief batch_export_index_png() dla wskaźnika skwantowanego do int16 (PIPELINE_VALUES_INT16)
+ */
+int batch_export_quantized_png(const int16_t* index_data, int width, int height,
+                               const char* output_dir, const char* scene_name, const char* index_name);
+
+/**
+ * @brief Zapisuje mapy wszystkich wskaźników obecnych w wyniku (pola różne od NULL),
+ *        raport statystyk <output_dir>/<scene_name>_stats.json oraz indeks bloków
+ *        <output_dir>/<scene_name>_blocks.json
+ *
+ * @param formats Suma flag BatchExportFormat, 0 - BATCH_EXPORT_PNG
+ * @return 0 w przypadku sukcesu, -1 gdy eksport któregoś pliku się nie powiódł
+ */
+int batch_export_result(const ProcessingResult* result, const char* output_dir, const char* scene_name,
+                        unsigned int formats);
+
+/**
+ * @brief Zapisuje wskaźniki obecne w wyniku jako tablice Zarr <output_dir>/<scene_name>.zarr/<WSKAŹNIK>
+ *
+ * Chunki CHUNK_STORE_DEFAULT_SIZE x CHUNK_STORE_DEFAULT_SIZE kompresowane są równolegle.
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu zapisu
+ */
+int batch_export_index_chunks(const ProcessingResult* result, const char* output_dir, const char* scene_name);
+
+/**
+ * @brief Liczy statystyki stref wskaźników wyniku i zapisuje <output_dir>/<scene_name>_zones.csv
+ *        (lub .json)
+ *
+ * Etykiety stref wczytywane są na siatkę wyniku; georeferencję dla pliku wektorowego daje
+ * pierwsze niepuste pasmo z band_paths.
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int batch_export_zonal_stats(const ProcessingResult* result, char* const band_paths[PIPELINE_BAND_COUNT],
+                             const ZonalExportConfig* zones, const char* output_dir, const char* scene_name);
+
+#endif // BATCH_SCHEDULER_H
@@ -0,0 +1,324 @@
+#include "block_index.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <omp.h>
+
+#include "../index_calculator/index_calculator.h"
+#include "../utils/utils.h"
+
+// Odcinek wiersza w jednym bloku - suma w float (najwyżej block_size wartości z [-1, 1])
+typedef struct
+{
+    float sum;
+    uint32_t valid;
+    float min;
+    float max;
+} SegmentSummary;
+
+static int build_index(BlockIndex* index, const float* values, const int16_t* quantized,
+                       int width, int height, int block_size);
+static void summarize_block_row(const BlockIndex* index, const float* values, const int16_t* quantized,
+                                int block_row, double* sums);
+static void summarize_segment(const float* values, int count, SegmentSummary* segment);
+static void summarize_quantized_segment(const int16_t* values, int count, SegmentSummary* segment);
+static bool block_matches(const BlockSummary* summary, float min_value, float max_value);
+static uint64_t count_in_range(const BlockIndex* index, const float* values, const int16_t* quantized,
+                               float min_value, float max_value);
+static uint64_t count_block_values(const BlockIndex* index, const float* values, int x_start, int y_start,
+                                   int x_end, int y_end, float min_value, float max_value);
+static uint64_t count_quantized_block_values(const BlockIndex* index, const int16_t* values, int x_start,
+                                             int y_start, int x_end, int y_end, float min_value, float max_value);
+
+// ====== BUDOWA ======
+
+int block_index_build(BlockIndex* index, const float* values, int width, int height, int block_size)
+{
+    return build_index(index, values, NULL, width, height, block_size);
+}
+
+int block_index_build_quantized(BlockIndex* index, const int16_t* values, int width, int height, int block_size)
+{
+    return build_index(index, NULL, values, width, height, block_size);
+}
+
+// Raster float (values) albo int16 (quantized) - drugi wskaźnik jest NULL
+static int build_index(BlockIndex* index, const float* values, const int16_t* quantized,
+                       int width, int height, int block_size)
+{
+    memset(index, 0, sizeof(*index));
+    if ((!values && !quantized) || width <= 0 || height <= 0 || block_size < 0)
+    {
+        fprintf(stderr, "[%s] Nieprawidłowe parametry indeksu bloków.\n", get_timestamp());
+        return -1;
+    }
+
+    index->width = width;
+    index->height = height;
+    index->block_size = block_size > 0 ? block_size : BLOCK_INDEX_DEFAULT_SIZE;
+    index->blocks_x = (width + index->block_size - 1) / index->block_size;
+    index->blocks_y = (height + index->block_size - 1) / index->block_size;
+    index->blocks = malloc(block_index_block_count(index) * sizeof(BlockSummary));
+    double* sums = malloc((size_t)index->blocks_x * index->blocks_y * sizeof(double));
+    if (!index->blocks || !sums)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla indeksu bloków.\n", get_timestamp());
+        free(sums);
+        block_index_free(index);
+        return -1;
+    }
+
+    #pragma omp parallel for schedule(dynamic) shared(index, values, quantized, sums)
+    for (int block_row = 0; block_row < index->blocks_y; block_row++)
+    {
+        summarize_block_row(index, values, quantized, block_row, sums + (size_t)block_row * index->blocks_x);
+    }
+
+    free(sums);
+    return 0;
+}
+
+// Pas block_size wierszy czytany wiersz po wierszu - każdy wiersz dokłada odcinek do blocks_x bloków
+static void summarize_block_row(const BlockIndex* index, const float* values, const int16_t* quantized,
+                                int block_row, double* sums)
+{
+    BlockSummary* summaries = index->blocks + (size_t)block_row * index->blocks_x;
+    for (int bx = 0; bx < index->blocks_x; bx++)
+    {
+        summaries[bx] = (BlockSummary){0, FLT_MAX, -FLT_MAX, 0.0f};
+        sums[bx] = 0.0;
+    }
+
+    int y_start = block_row * index->block_size;
+    int y_end = y_start + index->block_size < index->height ? y_start + index->block_size : index->height;
+    for (int y = y_start; y < y_end; y++)
+    {
+        size_t row_start = (size_t)y * index->width;
+        for (int bx = 0; bx < index->blocks_x; bx++)
+        {
+            int x_start = bx * index->block_size;
+            int x_end = x_start + index->block_size < index->width ? x_start + index->block_size : index->width;
+
+            // Suma odcinka w float, między wierszami w double
+            SegmentSummary segment = {0.0f, 0, summaries[bx].min, summaries[bx].max};
+            if (quantized)
+            {
+                summarize_quantized_segment(quantized + row_start + x_start, x_end - x_start, &segment);
+            }
+            else
+            {
+                summarize_segment(values + row_start + x_start, x_end - x_start, &segment);
+            }
+
+            summaries[bx].valid_pixels += segment.valid;
+            summaries[bx].min = segment.min;
+            summaries[bx].max = segment.max;
+            sums[bx] += segment.sum;
+        }
+    }
+
+    for (int bx = 0; bx < index->blocks_x; bx++)
+    {
+        if (summaries[bx].valid_pixels > 0)
+        {
+            summaries[bx].mean = (float)(sums[bx] / summaries[bx].valid_pixels);
+        }
+    }
+}
+
+static void summarize_segment(const float* values, int count, SegmentSummary* segment)
+{
+    float sum = 0.0f, min = segment->min, max = segment->max;
+    uint32_t valid = 0;
+    for (int x = 0; x < count; x++)
+    {
+        bool is_valid = values[x] != INDEX_NO_DATA_VALUE;
+        float v = is_valid ? values[x] : 0.0f;
+        sum += v;
+        valid += is_valid;
+        min = is_valid && v < min ? v : min;
+        max = is_valid && v > max ? v : max;
+    }
+    *segment = (SegmentSummary){sum, valid, min, max};
+}
+
+// Wartości int16 czytane wprost - skalowanie jak w dequantize_index_values()
+static void summarize_quantized_segment(const int16_t* values, int count, SegmentSummary* segment)
+{
+    const float inverse_scale = 1.0f / INDEX_INT16_SCALE;
+    float sum = 0.0f, min = segment->min, max = segment->max;
+    uint32_t valid = 0;
+    for (int x = 0; x < count; x++)
+    {
+        bool is_valid = values[x] != INDEX_INT16_NO_DATA;
+        float v = is_valid ? values[x] * inverse_scale : 0.0f;
+        sum += v;
+        valid += is_valid;
+        min = is_valid && v < min ? v : min;
+        max = is_valid && v > max ? v : max;
+    }
+    *segment = (SegmentSummary){sum, valid, min, max};
+}
+
+void block_index_free(BlockIndex* index)
+{
+    free(index->blocks);
+    memset(index, 0, sizeof(*index));
+}
+
+// ====== ZAPYTANIA ======
+
+size_t block_index_block_count(const BlockIndex* index)
+{
+    return (size_t)index->blocks_x * index->blocks_y;
+}
+
+void block_index_block_bounds(const BlockIndex* index, size_t block, int* x_start, int* y_start,
+                              int* x_end, int* y_end)
+{
+    int bx = (int)(block % index->blocks_x);
+    int by = (int)(block / index->blocks_x);
+    *x_start = bx * index->block_size;
+    *y_start = by * index->block_size;
+    *x_end = *x_start + index->block_size < index->width ? *x_start + index->block_size : index->width;
+    *y_end = *y_start + index->block_size < index->height ? *y_start + index->block_size : index->height;
+}
+
+static bool block_matches(const BlockSummary* summary, float min_value, float max_value)
+{
+    return summary->valid_pixels > 0 && summary->max >= min_value && summary->min <= max_value;
+}
+
+size_t block_index_select(const BlockIndex* index, float min_value, float max_value, double min_valid_fraction,
+                          size_t* selected)
+{
+    size_t count = 0;
+    for (size_t block = 0; block < block_index_block_count(index); block++)
+    {
+        int x_start, y_start, x_end, y_end;
+        block_index_block_bounds(index, block, &x_start, &y_start, &x_end, &y_end);
+        double block_pixels = (double)(x_end - x_start) * (y_end - y_start);
+
+        const BlockSummary* summary = &index->blocks[block];
+        if (block_matches(summary, min_value, max_value) &&
+            summary->valid_pixels >= min_valid_fraction * block_pixels)
+        {
+            if (selected)
+            {
+                selected[count] = block;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+uint64_t block_index_count_in_range(const BlockIndex* index, const float* values, float min_value, float max_value)
+{
+    return count_in_range(index, values, NULL, min_value, max_value);
+}
+
+uint64_t block_index_count_in_range_quantized(const BlockIndex* index, const int16_t* values, float min_value,
+                                              float max_value)
+{
+    return count_in_range(index, NULL, values, min_value, max_value);
+}
+
+// Raster float (values) albo int16 (quantized) - drugi wskaźnik jest NULL
+static uint64_t count_in_range(const BlockIndex* index, const float* values, const int16_t* quantized,
+                               float min_value, float max_value)
+{
+    uint64_t total = 0;
+    long long block_count = (long long)block_index_block_count(index);
+
+    #pragma omp parallel for schedule(dynamic) reduction(+:total) shared(index, values, quantized)
+    for (long long block = 0; block < block_count; block++)
+    {
+        const BlockSummary* summary = &index->blocks[block];
+        if (!block_matches(summary, min_value, max_value))
+        {
+            continue;
+        }
+        if (summary->min >= min_value && summary->max <= max_value)
+        {
+            total += summary->valid_pixels;
+            continue;
+        }
+
+        // Granica przedziału przecina blok - jedyny przypadek wymagający wartości
+        int x_start, y_start, x_end, y_end;
+        block_index_block_bounds(index, (size_t)block, &x_start, &y_start, &x_end, &y_end);
+        total += quantized ? count_quantized_block_values(index, quantized, x_start, y_start, x_end, y_end,
+                                                          min_value, max_value)
+                           : count_block_values(index, values, x_start, y_start, x_end, y_end, min_value, max_value);
+    }
+    return total;
+}
+
+static uint64_t count_block_values(const BlockIndex* index, const float* values, int x_start, int y_start,
+                                   int x_end, int y_end, float min_value, float max_value)
+{
+    uint64_t count = 0;
+    for (int y = y_start; y < y_end; y++)
+    {
+        const float* row = values + (size_t)y * index->width;
+        for (int x = x_start; x < x_end; x++)
+        {
+            count += row[x] != INDEX_NO_DATA_VALUE && row[x] >= min_value && row[x] <= max_value;
+        }
+    }
+    return count;
+}
+
+// Wartości int16 skalowane jak w summarize_quantized_segment(), więc granice przedziału porównywane
+// są z tymi samymi wartościami, z których powstały podsumowania
+static uint64_t count_quantized_block_values(const BlockIndex* index, const int16_t* values, int x_start,
+                                             int y_start, int x_end, int y_end, float min_value, float max_value)
+{
+    const float inverse_scale = 1.0f / INDEX_INT16_SCALE;
+    uint64_t count = 0;
+    for (int y = y_start; y < y_end; y++)
+    {
+        const int16_t* row = values + (size_t)y * index->width;
+        for (int x = x_start; x < x_end; x++)
+        {
+            float v = row[x] * inverse_scale;
+            count += row[x] != INDEX_INT16_NO_DATA && v >= min_value && v <= max_value;
+        }
+    }
+    return count;
+}
+
+// ====== ZAPIS ======
+
+void block_index_write_json(FILE* file, const BlockIndex* index)
+{
+    size_t count = block_index_block_count(index);
+
+    fputs("{\"valid\":[", file);
+    for (size_t b = 0; b < count; b++)
+    {
+        fprintf(file, "%s%u", b > 0 ? "," : "", (unsigned)index->blocks[b].valid_pixels);
+    }
+
+    static const char* const FIELDS[] = {"min", "max", "mean"};
+    for (int field = 0; field < 3; field++)
+    {
+        fprintf(file, "],\"%s\":[", FIELDS[field]);
+        for (size_t b = 0; b < count; b++)
+        {
+            const BlockSummary* summary = &index->blocks[b];
+            float value = field == 0 ? summary->min : (field == 1 ? summary->max : summary->mean);
+            if (summary->valid_pixels > 0)
+            {
+                fprintf(file, "%s%.4f", b > 0 ? "," : "", value);
+            }
+            else
+            {
+                fprintf(file, "%snull", b > 0 ? "," : "");
+            }
+        }
+    }
+    fputs("]}", file);
+}
@@ -0,0 +1,115 @@
+#ifndef BLOCK_INDEX_H
+#define BLOCK_INDEX_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Domyślny bok bloku w pikselach - blok 256x256 to 256 KiB wartości float
+#define BLOCK_INDEX_DEFAULT_SIZE 256
+
+/**
+ * @brief Podsumowanie jednego bloku rastra wskaźnika
+ *
+ * Piksele INDEX_NO_DATA_VALUE nie są wliczane. Dla bloku bez pikseli ważnych
+ * valid_pixels == 0, a min, max i mean są nieokreślone.
+ */
+typedef struct
+{
+    uint32_t valid_pixels;
+    float min;
+    float max;
+    float mean;
+} BlockSummary;
+
+/**
+ * @brief Indeks podsumowań bloków rastra wskaźnika
+ *
+ * Raster dzielony jest na bloki block_size x block_size (ostatni wiersz i kolumna bloków
+ * mogą być mniejsze). Zapytania progowe i o pokrycie sprawdzają najpierw podsumowania, więc
+ * czytają wartości tylko tych bloków, których zakres [min, max] przecina szukany przedział.
+ * Blok o indeksie b leży w wierszu b / blocks_x i kolumnie b % blocks_x siatki bloków.
+ */
+typedef struct
+{
+    int width;
+    int height;
+    int block_size;
+    int blocks_x;
+    int blocks_y;
+    BlockSummary* blocks;
+} BlockIndex;
+
+/**
+ * @brief Buduje indeks bloków rastra w jednym równoległym przejściu (OpenMP po wierszach bloków)
+ *
+ * Każdy wątek przechodzi pas block_size wierszy wiersz po wierszu, więc raster czytany jest
+ * sekwencyjnie. Poprzednia zawartość index nie jest zwalniana.
+ *
+ * @param block_size Bok bloku w pikselach, 0 - BLOCK_INDEX_DEFAULT_SIZE
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu parametrów lub alokacji
+ */
+int block_index_build(BlockIndex* index, const float* values, int width, int height, int block_size);
+
+/**
+ * @brief block_index_build() dla rastra skwantowanego do int16 (quantize_index_values())
+ *
+ * Wartości int16 czytane są wprost, bez rastra float; podsumowania są w jednostkach wskaźnika.
+ */
+int block_index_build_quantized(BlockIndex* index, const int16_t* values, int width, int height, int block_size);
+
+/**
+ * @brief Zwalnia podsumowania i zeruje indeks (bezpieczne dla wyzerowanego indeksu)
+ */
+void block_index_free(BlockIndex* index);
+
+size_t block_index_block_count(const BlockIndex* index);
+
+/**
+ * @brief Zakres pikseli bloku: kolumny [x_start, x_end) i wiersze [y_start, y_end)
+ */
+void block_index_block_bounds(const BlockIndex* index, size_t block, int* x_start, int* y_start,
+                              int* x_end, int* y_end);
+
+/**
+ * @brief Wybiera bloki, które mogą zawierać piksele ważne z [min_value, max_value]
+ *        i mają co najmniej min_valid_fraction pikseli ważnych
+ *
+ * Działa wyłącznie na podsumowaniach. Zapytanie o samo pokrycie to przedział
+ * [-FLT_MAX, FLT_MAX].
+ *
+ * @param selected Tablica na numery wybranych bloków (block_index_block_count() elementów) lub NULL
+ * @return Liczba wybranych bloków
+ */
+size_t block_index_select(const BlockIndex* index, float min_value, float max_value, double min_valid_fraction,
+                          size_t* selected);
+
+/**
+ * @brief Dokładna liczba pikseli ważnych z [min_value, max_value]
+ *
+ * Bloki rozłączne z przedziałem są pomijane, bloki w całości w przedziale liczone z podsumowania,
+ * a wartości czytane są tylko dla bloków przeciętych granicą przedziału.
+ *
+ * @param values Raster, z którego zbudowano indeks
+ */
+uint64_t block_index_count_in_range(const BlockIndex* index, const float* values, float min_value, float max_value);
+
+/**
+ * @brief block_index_count_in_range() dla indeksu z block_index_build_quantized()
+ *
+ * Granice przedziału podawane są w jednostkach wskaźnika; wartości int16 czytane są wprost.
+ *
+ * @param values Raster int16, z którego zbudowano indeks
+ */
+uint64_t block_index_count_in_range_quantized(const BlockIndex* index, const int16_t* values, float min_value,
+                                              float max_value);
+
+/**
+ * @brief Zapisuje podsumowania jako obiekt JSON (bez znaku nowej linii)
+ *
+ * Pola valid, min, max, mean to tablice w kolejności bloków; bloki bez pikseli ważnych
+ * mają null w min, max i mean.
+ */
+void block_index_write_json(FILE* file, const BlockIndex* index);
+
+#endif // BLOCK_INDEX_H
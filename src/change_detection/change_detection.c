@@ -0,0 +1,447 @@
+#include "change_detection.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib.h>
+#include <gdal.h>
+#include <omp.h>
+
+#include "../band_math/band_math.h"
+#include "../compositor/compositor.h"
+#include "../data_loader/data_loader.h"
+#include "../index_calculator/index_calculator.h"
+#include "../index_stats/index_stats.h"
+#include "../pipeline_context/pipeline_context.h"
+#include "../strip_indices/strip_indices.h"
+#include "../utils/utils.h"
+
+// Najwyższy pas - wyżej zysk z mniejszej liczby odczytów jest pomijalny
+#define CHANGE_MAX_STRIP_ROWS 1024
+// Blok różnicowania - różnice są jeszcze w L1, gdy trafiają do statystyk
+#define CHANGE_BLOCK_PIXELS 4096
+
+/**
+ * @brief Różnica jednego wskaźnika: program band_math, plik wyjściowy, bufory pasa i statystyki
+ */
+typedef struct
+{
+    const char* index_name;
+    BandMathProgram* program;
+    GDALDatasetH dataset;
+    // Wskaźnik wcześniejszej daty; po różnicowaniu - różnica zapisywana do pliku
+    float* before;
+    float* after;
+    IndexStats stats;
+    uint64_t decrease_pixels;
+    uint64_t increase_pixels;
+} ChangeLayer;
+
+typedef struct
+{
+    const BatchScene* before;
+    const BatchScene* after;
+    const ChangeConfig* config;
+    float threshold;
+    int width;
+    int height;
+    int reference_band;
+    int strip_rows;
+    // Źródła wskaźników obu dat - otwarte przez cały przebieg, czytane w jednym kroku
+    StripIndexSource sources[2];
+    bool source_open[2];
+    ChangeLayer layers[PIPELINE_INDEX_COUNT];
+    int layer_count;
+    // <output_dir>/change_<wcześniej>_<później>
+    gchar* prefix;
+} ChangePair;
+
+// ====== PARY ======
+static int process_pair(const BatchScene* first, const BatchScene* second, const ChangeConfig* config);
+static int prepare_grid(ChangePair* pair);
+static int open_layers(ChangePair* pair);
+static int choose_strip_rows(ChangePair* pair);
+static int open_sources(ChangePair* pair);
+static void close_pair(ChangePair* pair);
+// ====== PASY ======
+static int change_strip(ChangePair* pair, int y_start, int y_end);
+static void difference_strip(ChangePair* pair, ChangeLayer* layer, size_t strip_pixels);
+static int write_strip(const ChangePair* pair, int y_start, int y_end);
+// ====== RAPORT ======
+static int write_change_report(const ChangePair* pair);
+static void log_change_summary(const ChangePair* pair);
+
+int run_change_detection(const BatchScene* scenes, int count, const ChangeConfig* config)
+{
+    if (!scenes || count < 2 || !config || !config->output_dir)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Wykrywanie zmian wymaga par scen (co najmniej dwóch).\n", get_timestamp());
+        return -1;
+    }
+    if (count % 2 != 0)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Nieparzysta liczba scen - scena %s nie ma pary i zostanie pominięta.\n",
+                get_timestamp(), scenes[count - 1].name);
+    }
+    if (g_mkdir_with_parents(config->output_dir, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu wyjściowego %s.\n", get_timestamp(), config->output_dir);
+        return -1;
+    }
+
+    pipeline_global_init();
+
+    int failed = 0;
+    for (int s = 0; s + 1 < count; s += 2)
+    {
+        if (process_pair(&scenes[s], &scenes[s + 1], config) != 0)
+        {
+            fprintf(stderr, "[%s] [ZMIANY] Para %s / %s nie została przetworzona.\n",
+                    get_timestamp(), scenes[s].name, scenes[s + 1].name);
+            failed++;
+        }
+    }
+
+    printf("[%s] [ZMIANY] Przetworzono par: %d z %d\n", get_timestamp(), count / 2 - failed, count / 2);
+    return failed == 0 ? 0 : -1;
+}
+
+// ====== PARY ======
+
+static int process_pair(const BatchScene* first, const BatchScene* second, const ChangeConfig* config)
+{
+    // Data z nazwy ustala kolejność; bez dat zostaje kolejność z manifestu
+    uint32_t first_date = composite_scene_date(first->name);
+    uint32_t second_date = composite_scene_date(second->name);
+    bool swap = first_date && second_date && second_date < first_date;
+
+    ChangePair pair = {
+        .before = swap ? second : first,
+        .after = swap ? first : second,
+        .config = config,
+        .threshold = config->threshold > 0.0f ? config->threshold : CHANGE_DEFAULT_THRESHOLD
+    };
+    pair.prefix = g_strdup_printf("%s/change_%s_%s", config->output_dir, pair.before->name, pair.after->name);
+
+    printf("[%s] [ZMIANY] %s -> %s\n", get_timestamp(), pair.before->name, pair.after->name);
+
+    gint64 start_us = g_get_monotonic_time();
+    int status = prepare_grid(&pair);
+    if (status == 0)
+    {
+        status = open_layers(&pair);
+    }
+    if (status == 0)
+    {
+        status = choose_strip_rows(&pair);
+    }
+    if (status == 0)
+    {
+        status = open_sources(&pair);
+    }
+
+    for (int y = 0; status == 0 && y < pair.height; y += pair.strip_rows)
+    {
+        int y_end = y + pair.strip_rows < pair.height ? y + pair.strip_rows : pair.height;
+        status = change_strip(&pair, y, y_end);
+        if (status == 0)
+        {
+            printf("[%s] [ZMIANY] Wiersze %d-%d z %d gotowe\n", get_timestamp(), y, y_end, pair.height);
+        }
+    }
+
+    if (status == 0)
+    {
+        status = write_change_report(&pair);
+    }
+    if (status == 0)
+    {
+        log_change_summary(&pair);
+        printf("[%s] [ZMIANY] Para gotowa w %.2fs\n", get_timestamp(), (g_get_monotonic_time() - start_us) / 1e6);
+    }
+
+    close_pair(&pair);
+    return status;
+}
+
+static int prepare_grid(ChangePair* pair)
+{
+    const ChangeConfig* config = pair->config;
+    unsigned int band_mask = pipeline_index_band_mask(config->indices);
+    int width, height;
+
+    if (pipeline_target_grid(pair->before->paths, band_mask, config->target_10m,
+                             &pair->width, &pair->height, &pair->reference_band) != 0 ||
+        pipeline_target_grid(pair->after->paths, band_mask, config->target_10m, &width, &height, NULL) != 0)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Nie można odczytać siatki scen.\n", get_timestamp());
+        return -1;
+    }
+    if (width != pair->width || height != pair->height)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Sceny mają różne siatki (%dx%d i %dx%d).\n",
+                get_timestamp(), pair->width, pair->height, width, height);
+        return -1;
+    }
+    return 0;
+}
+
+static int open_layers(ChangePair* pair)
+{
+    for (int k = 0; pipeline_index_name(k); k++)
+    {
+        if (!(pair->config->indices & (1u << k)))
+        {
+            continue;
+        }
+
+        ChangeLayer* layer = &pair->layers[pair->layer_count++];
+        layer->index_name = pipeline_index_name(k);
+        layer->program = band_math_compile_builtin(layer->index_name);
+        index_stats_reset(&layer->stats);
+
+        // Różnica -2 wymagałaby zmiany z dokładnie 1 na dokładnie -1, więc może oznaczać brak danych
+        gchar* path = g_strdup_printf("%s_d%s.tif", pair->prefix, layer->index_name);
+        layer->dataset = create_georeferenced_geotiff(path, pair->width, pair->height, GDT_Float32,
+                                                      INDEX_NO_DATA_VALUE,
+                                                      pair->before->paths[pair->reference_band]);
+        if (layer->dataset)
+        {
+            printf("[%s] [ZMIANY] Zapis do %s\n", get_timestamp(), path);
+        }
+        g_free(path);
+
+        if (!layer->program || !layer->dataset)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Wysokość pasa mieszcząca w budżecie oba czytniki oraz wskaźniki obu dat
+static int choose_strip_rows(ChangePair* pair)
+{
+    const ChangeConfig* config = pair->config;
+    size_t budget = config->memory_budget > 0 ? config->memory_budget : CHANGE_DEFAULT_BUDGET_BYTES;
+
+    size_t reader_row_bytes = strip_index_source_row_bytes(pair->before->paths, config->indices,
+                                                           pair->width, pair->height) +
+                              strip_index_source_row_bytes(pair->after->paths, config->indices,
+                                                           pair->width, pair->height);
+    size_t row_bytes = reader_row_bytes + (size_t)pair->layer_count * pair->width * 2 * sizeof(float);
+
+    size_t rows = budget / row_bytes;
+    if (rows == 0)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Budżet pamięci %.1f MB nie mieści jednego wiersza (%.1f MB).\n",
+                get_timestamp(), budget / (1024.0 * 1024.0), row_bytes / (1024.0 * 1024.0));
+        return -1;
+    }
+    rows = rows < CHANGE_MAX_STRIP_ROWS ? rows : CHANGE_MAX_STRIP_ROWS;
+    pair->strip_rows = rows < (size_t)pair->height ? (int)rows : pair->height;
+
+    size_t strip_pixels = (size_t)pair->strip_rows * pair->width;
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        ChangeLayer* layer = &pair->layers[l];
+        layer->before = malloc(strip_pixels * sizeof(float));
+        layer->after = malloc(strip_pixels * sizeof(float));
+        if (!layer->before || !layer->after)
+        {
+            fprintf(stderr, "[%s] [ZMIANY] Błąd alokacji pamięci pasa.\n", get_timestamp());
+            return -1;
+        }
+    }
+
+    printf("[%s] [ZMIANY] Siatka %dx%d, pas %d wierszy (%.1f MB), próg %.3f\n", get_timestamp(), pair->width,
+           pair->height, pair->strip_rows, pair->strip_rows * row_bytes / (1024.0 * 1024.0), pair->threshold);
+    return 0;
+}
+
+static int open_sources(ChangePair* pair)
+{
+    const BatchScene* scenes[2] = {pair->before, pair->after};
+
+    for (int d = 0; d < 2; d++)
+    {
+        if (strip_index_source_open(&pair->sources[d], scenes[d]->paths, pair->config->indices, pair->width,
+                                    pair->height, pair->strip_rows) != 0)
+        {
+            fprintf(stderr, "[%s] [ZMIANY] Nie można otworzyć pasm sceny %s.\n", get_timestamp(), scenes[d]->name);
+            return -1;
+        }
+        pair->source_open[d] = true;
+    }
+    return 0;
+}
+
+static void close_pair(ChangePair* pair)
+{
+    for (int d = 0; d < 2; d++)
+    {
+        if (pair->source_open[d])
+        {
+            strip_index_source_close(&pair->sources[d]);
+        }
+    }
+
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        ChangeLayer* layer = &pair->layers[l];
+        band_math_free(layer->program);
+        if (layer->dataset)
+        {
+            GDALClose(layer->dataset);
+        }
+        free(layer->before);
+        free(layer->after);
+    }
+    pair->layer_count = 0;
+    g_free(pair->prefix);
+}
+
+// ====== PASY ======
+
+static int change_strip(ChangePair* pair, int y_start, int y_end)
+{
+    BandMathProgram* programs[PIPELINE_INDEX_COUNT];
+    float* before[PIPELINE_INDEX_COUNT];
+    float* after[PIPELINE_INDEX_COUNT];
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        programs[l] = pair->layers[l].program;
+        before[l] = pair->layers[l].before;
+        after[l] = pair->layers[l].after;
+    }
+
+    if (strip_index_source_evaluate(&pair->sources[0], programs, pair->layer_count, y_start, y_end, before) != 0 ||
+        strip_index_source_evaluate(&pair->sources[1], programs, pair->layer_count, y_start, y_end, after) != 0)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Błąd przetwarzania wierszy %d-%d.\n", get_timestamp(), y_start, y_end);
+        return -1;
+    }
+
+    size_t strip_pixels = (size_t)(y_end - y_start) * pair->width;
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        difference_strip(pair, &pair->layers[l], strip_pixels);
+    }
+    return write_strip(pair, y_start, y_end);
+}
+
+// Różnica w miejscu wskaźnika wcześniejszej daty; statystyki i klasy zmian zbierane blokami
+static void difference_strip(ChangePair* pair, ChangeLayer* layer, size_t strip_pixels)
+{
+    const float threshold = pair->threshold;
+    float* difference = layer->before;
+    const float* after = layer->after;
+    size_t block_count = (strip_pixels + CHANGE_BLOCK_PIXELS - 1) / CHANGE_BLOCK_PIXELS;
+
+    #pragma omp parallel
+    {
+        IndexStats local;
+        index_stats_reset(&local);
+        uint64_t decrease = 0;
+        uint64_t increase = 0;
+
+        #pragma omp for schedule(static)
+        for (size_t b = 0; b < block_count; b++)
+        {
+            size_t start = b * CHANGE_BLOCK_PIXELS;
+            size_t end = start + CHANGE_BLOCK_PIXELS < strip_pixels ? start + CHANGE_BLOCK_PIXELS : strip_pixels;
+
+            // Suma masek: brak danych w którejkolwiek dacie daje brak danych różnicy
+            #pragma omp simd reduction(+:decrease, increase)
+            for (size_t p = start; p < end; p++)
+            {
+                bool valid = difference[p] != INDEX_NO_DATA_VALUE && after[p] != INDEX_NO_DATA_VALUE;
+                float delta = after[p] - difference[p];
+                difference[p] = valid ? delta : INDEX_NO_DATA_VALUE;
+                decrease += valid && delta <= -threshold;
+                increase += valid && delta >= threshold;
+            }
+            index_stats_accumulate(&local, difference + start, end - start);
+        }
+
+        #pragma omp critical
+        {
+            index_stats_merge(&layer->stats, &local);
+            layer->decrease_pixels += decrease;
+            layer->increase_pixels += increase;
+        }
+    }
+}
+
+static int write_strip(const ChangePair* pair, int y_start, int y_end)
+{
+    int rows = y_end - y_start;
+
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        const ChangeLayer* layer = &pair->layers[l];
+        CPLErr err = GDALRasterIO(GDALGetRasterBand(layer->dataset, 1), GF_Write, 0, y_start, pair->width, rows,
+                                  layer->before, pair->width, rows, GDT_Float32, 0, 0);
+        if (err != CE_None)
+        {
+            fprintf(stderr, "[%s] [ZMIANY] Błąd zapisu wierszy %d-%d: %s\n", get_timestamp(), y_start, y_end,
+                    CPLGetLastErrorMsg());
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ====== RAPORT ======
+
+static int write_change_report(const ChangePair* pair)
+{
+    gchar* path = g_strdup_printf("%s_stats.json", pair->prefix);
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] [ZMIANY] Nie można zapisać pliku %s.\n", get_timestamp(), path);
+        g_free(path);
+        return -1;
+    }
+
+    fprintf(file, "{\"before\":\"%s\",\"after\":\"%s\",\"width\":%d,\"height\":%d,\"threshold\":%.4f,\"indices\":{",
+            pair->before->name, pair->after->name, pair->width, pair->height, pair->threshold);
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        const ChangeLayer* layer = &pair->layers[l];
+        uint64_t stable = layer->stats.valid_pixels - layer->decrease_pixels - layer->increase_pixels;
+        fprintf(file, "%s\"d%s\":{\"decrease_pixels\":%llu,\"stable_pixels\":%llu,\"increase_pixels\":%llu,"
+                "\"stats\":", l > 0 ? "," : "", layer->index_name, (unsigned long long)layer->decrease_pixels,
+                (unsigned long long)stable, (unsigned long long)layer->increase_pixels);
+        index_stats_write_json(file, &layer->stats);
+        fputs("}", file);
+    }
+    fputs("}}\n", file);
+
+    int status = fclose(file) == 0 ? 0 : -1;
+    if (status == 0)
+    {
+        printf("[%s] [ZMIANY] Statystyki zmian zapisane do %s\n", get_timestamp(), path);
+    }
+    g_free(path);
+    return status;
+}
+
+static void log_change_summary(const ChangePair* pair)
+{
+    for (int l = 0; l < pair->layer_count; l++)
+    {
+        const ChangeLayer* layer = &pair->layers[l];
+        gchar* name = g_strdup_printf("d%s", layer->index_name);
+        index_stats_log(name, &layer->stats);
+        g_free(name);
+
+        if (layer->stats.valid_pixels > 0)
+        {
+            printf("[%s] d%s: spadek %.1f%%, wzrost %.1f%% pikseli ważnych (próg %.3f)\n", get_timestamp(),
+                   layer->index_name, 100.0 * layer->decrease_pixels / layer->stats.valid_pixels,
+                   100.0 * layer->increase_pixels / layer->stats.valid_pixels, pair->threshold);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef CHANGE_DETECTION_H
+#define CHANGE_DETECTION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../batch_scheduler/batch_scheduler.h"
+
+/**
+ * @brief Konfiguracja trybu wykrywania zmian między dwiema datami
+ */
+typedef struct
+{
+    // Wskaźniki (flagi PipelineIndex) - dla każdego powstaje raster różnicy d<WSKAŹNIK>
+    unsigned int indices;
+    bool target_10m;
+    // Budżet pamięci pasów (dwa czytniki i bufory wskaźników), 0 - CHANGE_DEFAULT_BUDGET_BYTES
+    size_t memory_budget;
+    // Próg |różnicy| klasyfikujący piksel jako spadek lub wzrost, <= 0 - CHANGE_DEFAULT_THRESHOLD
+    float threshold;
+    const char* output_dir;
+} ChangeConfig;
+
+// Budżet pamięci wykrywania zmian, gdy nie podano --max-memory
+#define CHANGE_DEFAULT_BUDGET_BYTES ((size_t)1 << 30)
+// Domyślny próg istotnej zmiany wskaźnika
+#define CHANGE_DEFAULT_THRESHOLD 0.1f
+
+/**
+ * @brief Wykrywa zmiany wskaźników w kolejnych parach scen (1-2, 3-4, ...)
+ *
+ * Obie sceny pary przetwarzane są pasami wierszy w jednym kroku: dwa czytniki pasów są
+ * otwarte przez cały przebieg, dla każdego pasa wskaźniki obu dat liczone są silnikiem
+ * band_math, a różnica (później - wcześniej) od razu trafia do pliku i statystyk. Piksel
+ * zamaskowany przez SCL w którejkolwiek dacie nie ma danych (suma masek), a pełne rastry
+ * wskaźników żadnej z dat nigdy nie powstają. Kolejność w parze wynika z dat w nazwach scen;
+ * bez dat wcześniejsza jest scena wymieniona jako pierwsza.
+ *
+ * Dla pary zapisywane są:
+ * - <output_dir>/change_<wcześniej>_<później>_d<WSKAŹNIK>.tif - różnica (float32, brak danych -2)
+ * - <output_dir>/change_<wcześniej>_<później>_stats.json - statystyki różnic (jak IndexStats)
+ *   oraz liczby pikseli spadku, stabilnych i wzrostu względem progu
+ *
+ * Sceny pary muszą mieć tę samą siatkę; pary z inną siatką są pomijane z błędem.
+ *
+ * @return 0 gdy wszystkie pary zostały przetworzone, -1 w przypadku błędu
+ */
+int run_change_detection(const BatchScene* scenes, int count, const ChangeConfig* config);
+
+#endif // CHANGE_DETECTION_H
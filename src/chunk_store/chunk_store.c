@@ -0,0 +1,483 @@
+#include "chunk_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <glib.h>
+#include <omp.h>
+#include <zlib.h>
+
+#include "../index_calculator/index_calculator.h"
+#include "../utils/utils.h"
+
+// ====== ZAPIS ======
+static int write_text_file(const char* path, const char* text);
+static int write_chunk_row(ChunkStore* store, const unsigned char* rows, int chunk_y);
+static bool gather_chunk(const ChunkStore* store, const unsigned char* rows, int band_rows, int chunk_x,
+                         unsigned char* chunk);
+static int write_chunk(const ChunkStore* store, int chunk_x, int chunk_y, const unsigned char* chunk,
+                       unsigned char* shuffled, unsigned char* compressed, uLongf compressed_capacity);
+
+// ====== ODCZYT ======
+static int parse_int_pair(const char* json, const char* key, int* first, int* second);
+
+// ====== POMOCNICZE ======
+static bool any_valid_value(const ChunkStore* store, const unsigned char* values, size_t count);
+static void fill_no_data(const ChunkStore* store, unsigned char* values, size_t count);
+static void shuffle_bytes(const unsigned char* values, size_t count, size_t element_size, unsigned char* shuffled);
+static void unshuffle_bytes(const unsigned char* shuffled, size_t count, size_t element_size, unsigned char* values);
+static char* chunk_path(const ChunkStore* store, int chunk_x, int chunk_y);
+
+// ====== ZAPIS ======
+
+int chunk_store_create_group(const char* path)
+{
+    if (g_mkdir_with_parents(path, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    gchar* group_path = g_build_filename(path, ".zgroup", NULL);
+    int status = write_text_file(group_path, "{\"zarr_format\":2}\n");
+    g_free(group_path);
+    return status;
+}
+
+int chunk_store_create(ChunkStore* store, const char* path, int width, int height, bool quantized,
+                       int chunk_size, int level)
+{
+    memset(store, 0, sizeof(*store));
+    if (width <= 0 || height <= 0 || chunk_size < 0 || level < 0 || level > 9)
+    {
+        fprintf(stderr, "[%s] Nieprawidłowe parametry tablicy chunków.\n", get_timestamp());
+        return -1;
+    }
+    if (g_mkdir_with_parents(path, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    store->path = g_strdup(path);
+    store->width = width;
+    store->height = height;
+    store->chunk_size = chunk_size > 0 ? chunk_size : CHUNK_STORE_DEFAULT_SIZE;
+    store->chunks_x = (width + store->chunk_size - 1) / store->chunk_size;
+    store->chunks_y = (height + store->chunk_size - 1) / store->chunk_size;
+    store->level = level > 0 ? level : CHUNK_STORE_DEFAULT_LEVEL;
+    store->quantized = quantized;
+    store->element_size = quantized ? sizeof(int16_t) : sizeof(float);
+
+    // Manifest Zarr v2: filtr shuffle (numcodecs) przed kompresorem zlib
+    gchar* fill_value = quantized ? g_strdup_printf("%d", INDEX_INT16_NO_DATA)
+                                  : g_strdup_printf("%.1f", INDEX_NO_DATA_VALUE);
+    gchar* manifest = g_strdup_printf(
+        "{\"zarr_format\":2,\"shape\":[%d,%d],\"chunks\":[%d,%d],\"dtype\":\"%s\","
+        "\"compressor\":{\"id\":\"zlib\",\"level\":%d},\"fill_value\":%s,"
+        "\"filters\":[{\"id\":\"shuffle\",\"elementsize\":%d}],\"order\":\"C\",\"dimension_separator\":\".\"}\n",
+        height, width, store->chunk_size, store->chunk_size, quantized ? "<i2" : "<f4", store->level,
+        fill_value, (int)store->element_size);
+    // Nazwy wymiarów w konwencji xarray, dla int16 skala w konwencji CF
+    gchar* attrs = quantized ? g_strdup_printf("{\"_ARRAY_DIMENSIONS\":[\"y\",\"x\"],\"scale_factor\":%g,"
+                                               "\"add_offset\":0}\n", 1.0 / INDEX_INT16_SCALE)
+                             : g_strdup("{\"_ARRAY_DIMENSIONS\":[\"y\",\"x\"]}\n");
+    gchar* manifest_path = g_build_filename(path, ".zarray", NULL);
+    gchar* attrs_path = g_build_filename(path, ".zattrs", NULL);
+
+    int status = write_text_file(manifest_path, manifest);
+    if (status == 0)
+    {
+        status = write_text_file(attrs_path, attrs);
+    }
+
+    g_free(fill_value);
+    g_free(manifest);
+    g_free(attrs);
+    g_free(manifest_path);
+    g_free(attrs_path);
+    if (status != 0)
+    {
+        chunk_store_close(store);
+    }
+    return status;
+}
+
+static int write_text_file(const char* path, const char* text)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można zapisać pliku %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    fputs(text, file);
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0)
+    {
+        status = -1;
+    }
+    return status;
+}
+
+int chunk_store_write_rows(ChunkStore* store, const void* rows, int y_start, int y_end)
+{
+    if (y_start != store->next_row || y_end < y_start || y_end > store->height)
+    {
+        fprintf(stderr, "[%s] Nieprawidłowy pas wierszy [%d, %d) tablicy %s (oczekiwano wiersza %d).\n",
+                get_timestamp(), y_start, y_end, store->path, store->next_row);
+        return -1;
+    }
+
+    int chunk_size = store->chunk_size;
+    size_t row_bytes = (size_t)store->width * store->element_size;
+    int y = y_start;
+    while (y < y_end)
+    {
+        int chunk_y = y / chunk_size;
+        int band_start = chunk_y * chunk_size;
+        int band_end = band_start + chunk_size < store->height ? band_start + chunk_size : store->height;
+        const unsigned char* source = (const unsigned char*)rows + (size_t)(y - y_start) * row_bytes;
+
+        // Cały pas chunków w pasie wejściowym - kompresja wprost z niego, bez kopiowania
+        if (y == band_start && y_end >= band_end)
+        {
+            if (write_chunk_row(store, source, chunk_y) != 0)
+            {
+                return -1;
+            }
+            y = band_end;
+            continue;
+        }
+
+        if (!store->pending)
+        {
+            store->pending = malloc((size_t)chunk_size * row_bytes);
+            if (!store->pending)
+            {
+                fprintf(stderr, "[%s] Błąd alokacji bufora pasa chunków.\n", get_timestamp());
+                return -1;
+            }
+        }
+
+        int copy_end = y_end < band_end ? y_end : band_end;
+        memcpy(store->pending + (size_t)(y - band_start) * row_bytes, source, (size_t)(copy_end - y) * row_bytes);
+        y = copy_end;
+        if (y == band_end && write_chunk_row(store, store->pending, chunk_y) != 0)
+        {
+            return -1;
+        }
+    }
+
+    store->next_row = y_end;
+    return 0;
+}
+
+// Kompresuje i zapisuje wszystkie chunki pasa chunk_y; rows zaczyna się w pierwszym wierszu pasa
+static int write_chunk_row(ChunkStore* store, const unsigned char* rows, int chunk_y)
+{
+    int band_start = chunk_y * store->chunk_size;
+    int band_rows = store->height - band_start < store->chunk_size ? store->height - band_start : store->chunk_size;
+    size_t chunk_bytes = (size_t)store->chunk_size * store->chunk_size * store->element_size;
+    uLongf compressed_capacity = compressBound(chunk_bytes);
+    int status = 0;
+
+    #pragma omp parallel shared(store, rows, status)
+    {
+        unsigned char* chunk = malloc(chunk_bytes);
+        unsigned char* shuffled = malloc(chunk_bytes);
+        unsigned char* compressed = malloc(compressed_capacity);
+        bool buffers_ok = chunk && shuffled && compressed;
+
+        #pragma omp for schedule(dynamic)
+        for (int chunk_x = 0; chunk_x < store->chunks_x; chunk_x++)
+        {
+            if (!buffers_ok)
+            {
+                #pragma omp atomic write
+                status = -1;
+                continue;
+            }
+
+            // Chunk bez pikseli ważnych nie jest zapisywany (czytelnik zwraca fill_value);
+            // usunięcie pliku z poprzedniego eksportu tej samej sceny
+            if (!gather_chunk(store, rows, band_rows, chunk_x, chunk))
+            {
+                char* path = chunk_path(store, chunk_x, chunk_y);
+                remove(path);
+                g_free(path);
+                continue;
+            }
+
+            if (write_chunk(store, chunk_x, chunk_y, chunk, shuffled, compressed, compressed_capacity) != 0)
+            {
+                #pragma omp atomic write
+                status = -1;
+            }
+        }
+
+        free(chunk);
+        free(shuffled);
+        free(compressed);
+    }
+
+    if (status != 0)
+    {
+        fprintf(stderr, "[%s] Błąd zapisu pasa chunków %d tablicy %s.\n", get_timestamp(), chunk_y, store->path);
+    }
+    return status;
+}
+
+// Kopiuje chunk z pasa do pełnego kwadratu (dopełnienie brakiem danych); false gdy brak pikseli ważnych
+static bool gather_chunk(const ChunkStore* store, const unsigned char* rows, int band_rows, int chunk_x,
+                         unsigned char* chunk)
+{
+    int chunk_size = store->chunk_size;
+    size_t element_size = store->element_size;
+    int x_start = chunk_x * chunk_size;
+    int columns = store->width - x_start < chunk_size ? store->width - x_start : chunk_size;
+    bool any_valid = false;
+
+    for (int y = 0; y < chunk_size; y++)
+    {
+        unsigned char* target = chunk + (size_t)y * chunk_size * element_size;
+        int copied = 0;
+        if (y < band_rows)
+        {
+            const unsigned char* source = rows + ((size_t)y * store->width + x_start) * element_size;
+            memcpy(target, source, (size_t)columns * element_size);
+            any_valid = any_valid || any_valid_value(store, source, (size_t)columns);
+            copied = columns;
+        }
+        fill_no_data(store, target + (size_t)copied * element_size, (size_t)(chunk_size - copied));
+    }
+    return any_valid;
+}
+
+static int write_chunk(const ChunkStore* store, int chunk_x, int chunk_y, const unsigned char* chunk,
+                       unsigned char* shuffled, unsigned char* compressed, uLongf compressed_capacity)
+{
+    size_t chunk_pixels = (size_t)store->chunk_size * store->chunk_size;
+    shuffle_bytes(chunk, chunk_pixels, store->element_size, shuffled);
+
+    // Strategia Z_RLE: płaszczyzny znaku i wykładnika (float) lub starszych bajtów (int16) to głównie
+    // serie, a płaszczyzny młodszych bajtów są prawie niekompresowalne, więc dopasowania na odległość
+    // zysku prawie nie dają, a są ok. 2.5x wolniejsze
+    z_stream stream = {0};
+    if (deflateInit2(&stream, store->level, Z_DEFLATED, MAX_WBITS, 8, Z_RLE) != Z_OK)
+    {
+        return -1;
+    }
+    stream.next_in = (Bytef*)shuffled;
+    stream.avail_in = (uInt)(chunk_pixels * store->element_size);
+    stream.next_out = compressed;
+    stream.avail_out = (uInt)compressed_capacity;
+    int deflated = deflate(&stream, Z_FINISH);
+    size_t compressed_size = stream.total_out;
+    deflateEnd(&stream);
+    if (deflated != Z_STREAM_END)
+    {
+        return -1;
+    }
+
+    char* path = chunk_path(store, chunk_x, chunk_y);
+    FILE* file = fopen(path, "wb");
+    g_free(path);
+    if (!file)
+    {
+        return -1;
+    }
+
+    int status = fwrite(compressed, 1, compressed_size, file) == compressed_size ? 0 : -1;
+    if (fclose(file) != 0)
+    {
+        status = -1;
+    }
+    return status;
+}
+
+int chunk_store_close(ChunkStore* store)
+{
+    // Tablica otwarta do odczytu nie ma wierszy do zapisania
+    int status = store->next_row == 0 || store->next_row == store->height ? 0 : -1;
+    if (status != 0)
+    {
+        fprintf(stderr, "[%s] Tablica %s zamknięta po %d z %d wierszy.\n",
+                get_timestamp(), store->path, store->next_row, store->height);
+    }
+
+    free(store->pending);
+    g_free(store->path);
+    memset(store, 0, sizeof(*store));
+    return status;
+}
+
+// ====== ODCZYT ======
+
+int chunk_store_open(ChunkStore* store, const char* path)
+{
+    memset(store, 0, sizeof(*store));
+
+    gchar* manifest_path = g_build_filename(path, ".zarray", NULL);
+    gchar* manifest = NULL;
+    gboolean loaded = g_file_get_contents(manifest_path, &manifest, NULL, NULL);
+    g_free(manifest_path);
+    if (!loaded)
+    {
+        fprintf(stderr, "[%s] Nie można odczytać manifestu tablicy %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    int chunk_height = 0;
+    int status = 0;
+    const char* level = strstr(manifest, "\"level\":");
+    bool is_float = strstr(manifest, "\"dtype\":\"<f4\"") != NULL;
+    store->quantized = strstr(manifest, "\"dtype\":\"<i2\"") != NULL;
+    store->element_size = store->quantized ? sizeof(int16_t) : sizeof(float);
+    if (parse_int_pair(manifest, "\"shape\":[", &store->height, &store->width) != 0 ||
+        parse_int_pair(manifest, "\"chunks\":[", &chunk_height, &store->chunk_size) != 0 ||
+        chunk_height != store->chunk_size || store->chunk_size <= 0 ||
+        (!is_float && !store->quantized) || !strstr(manifest, "\"id\":\"shuffle\"") || !level)
+    {
+        fprintf(stderr, "[%s] Nieobsługiwany manifest tablicy %s.\n", get_timestamp(), path);
+        status = -1;
+    }
+    else
+    {
+        store->path = g_strdup(path);
+        store->level = atoi(level + strlen("\"level\":"));
+        store->chunks_x = (store->width + store->chunk_size - 1) / store->chunk_size;
+        store->chunks_y = (store->height + store->chunk_size - 1) / store->chunk_size;
+    }
+
+    g_free(manifest);
+    return status;
+}
+
+static int parse_int_pair(const char* json, const char* key, int* first, int* second)
+{
+    const char* position = strstr(json, key);
+    if (!position || sscanf(position + strlen(key), "%d,%d", first, second) != 2)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int chunk_store_read_chunk(const ChunkStore* store, int chunk_x, int chunk_y, void* values)
+{
+    size_t chunk_pixels = (size_t)store->chunk_size * store->chunk_size;
+    size_t chunk_bytes = chunk_pixels * store->element_size;
+    if (chunk_x < 0 || chunk_y < 0 || chunk_x >= store->chunks_x || chunk_y >= store->chunks_y)
+    {
+        return -1;
+    }
+
+    char* path = chunk_path(store, chunk_x, chunk_y);
+    gchar* compressed = NULL;
+    gsize compressed_size = 0;
+    gboolean exists = g_file_get_contents(path, &compressed, &compressed_size, NULL);
+    g_free(path);
+
+    // Chunk bez pliku nie ma pikseli ważnych
+    if (!exists)
+    {
+        fill_no_data(store, values, chunk_pixels);
+        return 0;
+    }
+
+    unsigned char* shuffled = malloc(chunk_bytes);
+    uLongf shuffled_size = chunk_bytes;
+    int status = -1;
+    if (shuffled && uncompress(shuffled, &shuffled_size, (const Bytef*)compressed, compressed_size) == Z_OK &&
+        shuffled_size == chunk_bytes)
+    {
+        unshuffle_bytes(shuffled, chunk_pixels, store->element_size, values);
+        status = 0;
+    }
+    else
+    {
+        fprintf(stderr, "[%s] Uszkodzony chunk %d.%d tablicy %s.\n", get_timestamp(), chunk_y, chunk_x, store->path);
+    }
+
+    free(shuffled);
+    g_free(compressed);
+    return status;
+}
+
+// ====== POMOCNICZE ======
+
+static bool any_valid_value(const ChunkStore* store, const unsigned char* values, size_t count)
+{
+    if (store->quantized)
+    {
+        const int16_t* quantized = (const int16_t*)values;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (quantized[i] != INDEX_INT16_NO_DATA)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const float* floats = (const float*)values;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (floats[i] != INDEX_NO_DATA_VALUE)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void fill_no_data(const ChunkStore* store, unsigned char* values, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (store->quantized)
+        {
+            ((int16_t*)values)[i] = INDEX_INT16_NO_DATA;
+        }
+        else
+        {
+            ((float*)values)[i] = INDEX_NO_DATA_VALUE;
+        }
+    }
+}
+
+// Bajt b każdej wartości trafia do płaszczyzny b - starsze bajty sąsiednich pikseli (wykładnik
+// i znak float, starszy bajt int16) są zwykle równe, więc płaszczyzny kompresują się znacznie
+// lepiej niż przeplecione wartości
+static void shuffle_bytes(const unsigned char* values, size_t count, size_t element_size, unsigned char* shuffled)
+{
+    for (size_t b = 0; b < element_size; b++)
+    {
+        unsigned char* plane = shuffled + b * count;
+        for (size_t i = 0; i < count; i++)
+        {
+            plane[i] = values[i * element_size + b];
+        }
+    }
+}
+
+static void unshuffle_bytes(const unsigned char* shuffled, size_t count, size_t element_size, unsigned char* values)
+{
+    for (size_t b = 0; b < element_size; b++)
+    {
+        const unsigned char* plane = shuffled + b * count;
+        for (size_t i = 0; i < count; i++)
+        {
+            values[i * element_size + b] = plane[i];
+        }
+    }
+}
+
+static char* chunk_path(const ChunkStore* store, int chunk_x, int chunk_y)
+{
+    return g_strdup_printf("%s/%d.%d", store->path, chunk_y, chunk_x);
+}
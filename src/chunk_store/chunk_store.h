@@ -0,0 +1,97 @@
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Domyślny bok chunka w pikselach - 256 KiB wartości float przed kompresją
+#define CHUNK_STORE_DEFAULT_SIZE 256
+// Poziom zlib: 1 to najszybsza kompresja, a przetasowane bajty float i tak kompresują się dobrze
+#define CHUNK_STORE_DEFAULT_LEVEL 1
+
+/**
+ * @brief Tablica rastra wskaźnika zapisana jako niezależnie skompresowane chunki (format Zarr v2)
+ *
+ * Katalog tablicy zawiera manifest .zarray (kształt, rozmiar chunka, typ <f4 lub <i2, filtr shuffle,
+ * kompresor zlib, fill_value = INDEX_NO_DATA_VALUE lub INDEX_INT16_NO_DATA) oraz pliki chunków
+ * "<wiersz>.<kolumna>". Tablica int16 ma w .zattrs scale_factor = 1 / INDEX_INT16_SCALE (konwencja CF),
+ * więc xarray odczytuje ją od razu jako wartości wskaźnika.
+ * Każdy chunk to pełny kwadrat chunk_size x chunk_size (brzegowe dopełnione brakiem danych),
+ * którego bajty przetasowane są według pozycji w wartości (najpierw bajty 0 wszystkich
+ * wartości, potem bajty 1 itd.) i skompresowane zlib. Chunki bez pikseli ważnych nie są
+ * zapisywane - czytelnik Zarr zwraca dla nich fill_value. Odczyt jednego pola z wielu dat
+ * to jeden mały plik na datę.
+ *
+ * Zapis przyjmuje kolejne pasy wierszy dowolnej wysokości: pas chunków obecny w całości
+ * w pasie wejściowym kompresowany jest wprost z niego, a niepełny buforowany do uzupełnienia.
+ */
+typedef struct
+{
+    char* path;
+    int width;
+    int height;
+    int chunk_size;
+    int chunks_x;
+    int chunks_y;
+    int level;
+    // true - wartości int16 (quantize_index_values()), false - float
+    bool quantized;
+    size_t element_size;
+    // Wiersz, od którego musi zaczynać się kolejny pas chunk_store_write_rows()
+    int next_row;
+    // Bufor niepełnego pasa chunków (chunk_size wierszy) lub NULL
+    unsigned char* pending;
+} ChunkStore;
+
+/**
+ * @brief Tworzy grupę Zarr (katalog z .zgroup), w której zapisywane są tablice wskaźników
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy katalogu lub manifestu nie można utworzyć
+ */
+int chunk_store_create_group(const char* path);
+
+/**
+ * @brief Tworzy tablicę width x height i zapisuje jej manifest
+ *
+ * @param quantized true - wartości int16 (<i2), false - float (<f4)
+ * @param chunk_size Bok chunka w pikselach, 0 - CHUNK_STORE_DEFAULT_SIZE
+ * @param level Poziom kompresji zlib (1-9), 0 - CHUNK_STORE_DEFAULT_LEVEL
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu parametrów lub zapisu
+ */
+int chunk_store_create(ChunkStore* store, const char* path, int width, int height, bool quantized,
+                       int chunk_size, int level);
+
+/**
+ * @brief Zapisuje pas wierszy [y_start, y_end) rastra
+ *
+ * Pasy muszą następować po sobie od wiersza 0. Chunki ukończonego pasa chunków kompresowane
+ * i zapisywane są równolegle (OpenMP po kolumnach chunków).
+ *
+ * @param rows Wartości pasa w typie tablicy (float lub int16): (y_end - y_start) * width pikseli
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu kolejności, kompresji lub zapisu
+ */
+int chunk_store_write_rows(ChunkStore* store, const void* rows, int y_start, int y_end);
+
+/**
+ * @brief Zamyka tablicę otwartą do zapisu lub odczytu
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy przy zapisie nie przekazano wszystkich wierszy
+ */
+int chunk_store_close(ChunkStore* store);
+
+/**
+ * @brief Otwiera do odczytu tablicę zapisaną przez chunk_store_create() (z manifestu .zarray)
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy manifestu nie ma lub opisuje inny format
+ */
+int chunk_store_open(ChunkStore* store, const char* path);
+
+/**
+ * @brief Czyta chunk (chunk_x, chunk_y) - dekompresja i odwrócenie przetasowania bajtów
+ *
+ * @param values Bufor na chunk_size * chunk_size wartości typu tablicy (chunki brzegowe z dopełnieniem)
+ * @return 0 w przypadku sukcesu (brak pliku chunka daje same wartości braku danych), -1 w przypadku błędu
+ */
+int chunk_store_read_chunk(const ChunkStore* store, int chunk_x, int chunk_y, void* values);
+
+#endif // CHUNK_STORE_H
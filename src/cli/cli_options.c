@@ -0,0 +1,494 @@
+#include "cli_options.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "../processing_pipeline/processing_pipeline.h"
+#include "../compositor/compositor.h"
+#include "../mosaic/mosaic.h"
+#include "../change_detection/change_detection.h"
+#include "../batch_scheduler/batch_scheduler.h"
+
+static int parse_index_list(const char* text, unsigned int* indices_out);
+static int parse_export_format_list(const char* text, unsigned int* formats_out);
+
+int parse_cli_options(int* argc, char*** argv, CliOptions* options)
+{
+    gchar* max_memory_text = NULL;
+    gchar* stage_cache_text = NULL;
+    gchar* indices_text = NULL;
+    gchar* zones_format_text = NULL;
+    gchar* composite_text = NULL;
+    gchar* band_layout_text = NULL;
+    gchar* export_format_text = NULL;
+    gchar* value_type_text = NULL;
+    gchar* mosaic_text = NULL;
+
+    options->max_memory_bytes = 0;
+    options->stage_cache_bytes = DEFAULT_STAGE_CACHE_BYTES;
+    options->metrics_json_path = NULL;
+    options->trace_path = NULL;
+    options->batch_manifest_path = NULL;
+    options->watch_dir = NULL;
+    options->output_dir = NULL;
+    options->scenes_in_flight = 2;
+    options->threads = 0;
+    options->resolution_m = 10;
+    options->no_prefetch = 0;
+    options->indices = PIPELINE_INDEX_DEFAULT;
+    options->zones_path = NULL;
+    options->zone_field = NULL;
+    options->zones_json = 0;
+    options->composite_method = -1;
+    options->mosaic_rule = -1;
+    options->change_detection = 0;
+    options->change_threshold = CHANGE_DEFAULT_THRESHOLD;
+    options->band_layout = PIPELINE_LAYOUT_PLANAR;
+    options->export_formats = BATCH_EXPORT_PNG;
+    options->value_type = PIPELINE_VALUES_FLOAT32;
+    options->scratch_dir = NULL;
+
+    GOptionEntry entries[] = {
+        {
+            "max-memory", 0, 0, G_OPTION_ARG_STRING, &max_memory_text,
+            "Budżet pamięci przebiegu (np. 512M, 4G); przy braku miejsca scena jest przetwarzana pasami",
+            "ROZMIAR"
+        },
+        {
+            "stage-cache", 0, 0, G_OPTION_ARG_STRING, &stage_cache_text,
+            "Pamięć podręczna wyników etapów w GUI (np. 2G, 0 wyłącza); zmiana rozdzielczości "
+            "lub ponowny eksport nie dekoduje pasm od nowa",
+            "ROZMIAR"
+        },
+        {
+            "metrics-json", 0, 0, G_OPTION_ARG_FILENAME, &options->metrics_json_path,
+            "Dopisuje metryki etapów każdego przebiegu (JSON Lines) do podanego pliku",
+            "PLIK"
+        },
+        {
+            "trace", 0, 0, G_OPTION_ARG_FILENAME, &options->trace_path,
+            "Zapisuje ślad wykonania w formacie Chrome trace (do otwarcia w Perfetto)",
+            "PLIK"
+        },
+        {
+            "batch", 0, 0, G_OPTION_ARG_FILENAME, &options->batch_manifest_path,
+            "Przetwarza sceny z manifestu w trybie wsadowym, bez GUI",
+            "MANIFEST"
+        },
+        {
+            "watch", 0, 0, G_OPTION_ARG_FILENAME, &options->watch_dir,
+            "Tryb demona: obserwuje katalog i przetwarza sceny z kompletem pasm wybranych wskaźników, bez GUI",
+            "KATALOG"
+        },
+        {
+            "output-dir", 0, 0, G_OPTION_ARG_FILENAME, &options->output_dir,
+            "Katalog na mapy PNG trybu wsadowego i demona (domyślnie bieżący)",
+            "KATALOG"
+        },
+        {
+            "scenes-in-flight", 0, 0, G_OPTION_ARG_INT, &options->scenes_in_flight,
+            "Liczba scen przetwarzanych jednocześnie w trybie wsadowym (domyślnie 2)",
+            "N"
+        },
+        {
+            "threads", 0, 0, G_OPTION_ARG_INT, &options->threads,
+            "Globalny budżet wątków trybu wsadowego (domyślnie liczba procesorów)",
+            "N"
+        },
+        {
+            "resolution", 0, 0, G_OPTION_ARG_INT, &options->resolution_m,
+            "Docelowa rozdzielczość trybu wsadowego w metrach: 10 lub 20",
+            "M"
+        },
+        {
+            "no-prefetch", 0, 0, G_OPTION_ARG_NONE, &options->no_prefetch,
+            "Wyłącza wczytywanie pasm kolejnych scen z wyprzedzeniem",
+            NULL
+        },
+        {
+            "indices", 0, 0, G_OPTION_ARG_STRING, &indices_text,
+            "Liczone wskaźniki rozdzielone przecinkami: NDVI, NDMI, NDWI, NBR, NDRE, EVI, SAVI "
+            "(domyślnie NDVI,NDMI); wczytywane są tylko potrzebne pasma",
+            "LISTA"
+        },
+        {
+            "zones", 0, 0, G_OPTION_ARG_FILENAME, &options->zones_path,
+            "Statystyki wskaźników w strefach (działkach): raster etykiet lub plik wielokątów",
+            "PLIK"
+        },
+        {
+            "zone-field", 0, 0, G_OPTION_ARG_STRING, &options->zone_field,
+            "Pole identyfikatora działki w pliku wielokątów (domyślnie id)",
+            "POLE"
+        },
+        {
+            "zones-format", 0, 0, G_OPTION_ARG_STRING, &zones_format_text,
+            "Format statystyk stref: csv lub json (domyślnie csv)",
+            "FORMAT"
+        },
+        {
+            "composite", 0, 0, G_OPTION_ARG_STRING, &composite_text,
+            "Łączy sceny z --batch (daty jednego kafla) w kompozycję: max, median lub mean",
+            "METODA"
+        },
+        {
+            "mosaic", 0, 0, G_OPTION_ARG_STRING, &mosaic_text,
+            "Łączy sąsiednie kafle z --batch w mozaikę regionu; nakładanie rozstrzyga least-cloud lub latest",
+            "REGUŁA"
+        },
+        {
+            "change", 0, 0, G_OPTION_ARG_NONE, &options->change_detection,
+            "Wykrywanie zmian: kolejne pary scen z --batch (dwie daty) dają rastry różnic i statystyki zmian",
+            NULL
+        },
+        {
+            "change-threshold", 0, 0, G_OPTION_ARG_DOUBLE, &options->change_threshold,
+            "Próg |różnicy| wskaźnika liczonej jako spadek lub wzrost (domyślnie 0.1)",
+            "T"
+        },
+        {
+            "band-layout", 0, 0, G_OPTION_ARG_STRING, &band_layout_text,
+            "Układ pasm na etapie wskaźników: planar (osobne rastry) lub tiled (pasma spakowane w kafle)",
+            "UKŁAD"
+        },
+        {
+            "export-format", 0, 0, G_OPTION_ARG_STRING, &export_format_text,
+            "Formaty map trybu wsadowego i demona rozdzielone przecinkami: png, zarr (domyślnie png)",
+            "LISTA"
+        },
+        {
+            "values", 0, 0, G_OPTION_ARG_STRING, &value_type_text,
+            "Wskaźniki trybu wsadowego i demona: float32 lub int16 (skala 10000, połowa pamięci i rozmiaru)",
+            "TYP"
+        },
+        {
+            "scratch-dir", 0, 0, G_OPTION_ARG_FILENAME, &options->scratch_dir,
+            "Pełne rastry pasm i wyników w plikach roboczych w tym katalogu (mapowanych do pamięci); "
+            "z --max-memory scena większa niż RAM ograniczona jest miejscem na dysku",
+            "KATALOG"
+        },
+        G_OPTION_ENTRY_NULL
+    };
+
+    GOptionContext* context = g_option_context_new(NULL);
+    g_option_context_add_main_entries(context, entries, NULL);
+    // Pozostałe argumenty obsługuje GtkApplication
+    g_option_context_set_ignore_unknown_options(context, TRUE);
+
+    GError* error = NULL;
+    gboolean parsed = g_option_context_parse(context, argc, argv, &error);
+    g_option_context_free(context);
+
+    int status = 0;
+
+    if (!parsed)
+    {
+        fprintf(stderr, "Błąd parsowania opcji: %s\n", error->message);
+        g_error_free(error);
+        status = -1;
+    }
+
+    if (status == 0 && mosaic_text)
+    {
+        MosaicRule rule;
+        if (mosaic_rule_from_name(mosaic_text, &rule) != 0)
+        {
+            fprintf(stderr, "Nieprawidłowa wartość --mosaic: '%s' (oczekiwano least-cloud lub latest).\n",
+                    mosaic_text);
+            status = -1;
+        }
+        else
+        {
+            options->mosaic_rule = (int)rule;
+        }
+    }
+
+    if (status == 0 && value_type_text)
+    {
+        if (strcmp(value_type_text, "float32") != 0 && strcmp(value_type_text, "int16") != 0)
+        {
+            fprintf(stderr, "Nieprawidłowa wartość --values: '%s' (oczekiwano float32 lub int16).\n",
+                    value_type_text);
+            status = -1;
+        }
+        options->value_type = strcmp(value_type_text, "int16") == 0 ? PIPELINE_VALUES_INT16
+                                                                    : PIPELINE_VALUES_FLOAT32;
+    }
+
+    if (status == 0 && export_format_text &&
+        parse_export_format_list(export_format_text, &options->export_formats) != 0)
+    {
+        fprintf(stderr, "Nieprawidłowa wartość --export-format: '%s' (oczekiwano png, zarr lub png,zarr).\n",
+                export_format_text);
+        status = -1;
+    }
+
+    if (status == 0 && band_layout_text)
+    {
+        if (strcmp(band_layout_text, "planar") != 0 && strcmp(band_layout_text, "tiled") != 0)
+        {
+            fprintf(stderr, "Nieprawidłowa wartość --band-layout: '%s' (oczekiwano planar lub tiled).\n",
+                    band_layout_text);
+            status = -1;
+        }
+        options->band_layout = strcmp(band_layout_text, "tiled") == 0 ? PIPELINE_LAYOUT_TILED
+                                                                       : PIPELINE_LAYOUT_PLANAR;
+    }
+
+    if (status == 0 && composite_text)
+    {
+        CompositeMethod method;
+        if (composite_method_from_name(composite_text, &method) != 0)
+        {
+            fprintf(stderr, "Nieprawidłowa wartość --composite: '%s' (oczekiwano max, median lub mean).\n",
+                    composite_text);
+            status = -1;
+        }
+        else
+        {
+            options->composite_method = (int)method;
+        }
+    }
+
+    if (status == 0 && zones_format_text)
+    {
+        if (strcmp(zones_format_text, "csv") != 0 && strcmp(zones_format_text, "json") != 0)
+        {
+            fprintf(stderr, "Nieprawidłowa wartość --zones-format: '%s' (oczekiwano csv lub json).\n",
+                    zones_format_text);
+            status = -1;
+        }
+        options->zones_json = strcmp(zones_format_text, "json") == 0;
+    }
+
+    if (status == 0 && indices_text && parse_index_list(indices_text, &options->indices) != 0)
+    {
+        fprintf(stderr, "Nieprawidłowa wartość --indices: '%s' (oczekiwano listy z NDVI, NDMI, NDWI, NBR, "
+                "NDRE, EVI, SAVI).\n", indices_text);
+        status = -1;
+    }
+
+    if (status == 0 && options->resolution_m != 10 && options->resolution_m != 20)
+    {
+        fprintf(stderr, "Nieprawidłowa wartość --resolution: %d (oczekiwano 10 lub 20).\n", options->resolution_m);
+        status = -1;
+    }
+
+    // --composite, --mosaic i --change to wzajemnie wykluczające się tryby scen z --batch
+    int batch_modes = (options->composite_method >= 0) + (options->mosaic_rule >= 0) + (options->change_detection != 0);
+    if (status == 0 && batch_modes > 1)
+    {
+        fprintf(stderr, "Opcje --composite, --mosaic i --change wykluczają się - wybierz jedną.\n");
+        status = -1;
+    }
+    if (status == 0 && batch_modes > 0 && !options->batch_manifest_path)
+    {
+        fprintf(stderr, "Opcje --composite, --mosaic i --change wymagają --batch=MANIFEST.\n");
+        status = -1;
+    }
+    // Kompozycje, mozaiki i rastry różnic zapisywane są zawsze jako float32
+    if (status == 0 && batch_modes > 0 && value_type_text)
+    {
+        fprintf(stderr, "Opcja --values dotyczy tylko map trybu wsadowego i demona - "
+                "nie można jej łączyć z --composite, --mosaic ani --change.\n");
+        status = -1;
+    }
+
+    if (status == 0 && options->change_threshold <= 0.0)
+    {
+        fprintf(stderr, "Nieprawidłowa wartość --change-threshold: %g (oczekiwano liczby dodatniej).\n",
+                options->change_threshold);
+        status = -1;
+    }
+
+    if (status == 0 && max_memory_text && parse_memory_size(max_memory_text, &options->max_memory_bytes) != 0)
+    {
+        fprintf(stderr, "Nieprawidłowa wartość --max-memory: '%s' (oczekiwano np. 512M, 4G).\n",
+                max_memory_text);
+        status = -1;
+    }
+
+    // Kafle pasm powstają tylko przy przetwarzaniu całej sceny w trybie wsadowym i demonie
+    if (status == 0 && options->band_layout == PIPELINE_LAYOUT_TILED)
+    {
+        if (!options->batch_manifest_path && !options->watch_dir)
+        {
+            fprintf(stderr, "Opcja --band-layout=tiled dotyczy tylko trybu wsadowego i demona - "
+                    "GUI liczy mapy pasami wierszy.\n");
+            status = -1;
+        }
+        else if (batch_modes > 0)
+        {
+            fprintf(stderr, "Opcja --band-layout=tiled nie może być łączona "
+                    "z --composite, --mosaic ani --change.\n");
+            status = -1;
+        }
+        else if (options->max_memory_bytes > 0)
+        {
+            fprintf(stderr, "Opcja --band-layout=tiled nie może być łączona z --max-memory - "
+                    "budżet pamięci może wymusić przetwarzanie pasami wierszy.\n");
+            status = -1;
+        }
+    }
+
+    if (status == 0 && stage_cache_text)
+    {
+        // "0" wyłącza pamięć podręczną - parse_memory_size() przyjmuje tylko dodatnie rozmiary
+        if (strcmp(stage_cache_text, "0") == 0)
+        {
+            options->stage_cache_bytes = 0;
+        }
+        else if (parse_memory_size(stage_cache_text, &options->stage_cache_bytes) != 0)
+        {
+            fprintf(stderr, "Nieprawidłowa wartość --stage-cache: '%s' (oczekiwano np. 2G, 0).\n",
+                    stage_cache_text);
+            status = -1;
+        }
+    }
+
+    // Jedyne wyjście po walidacji - napisy opcji zwalniane są tylko tutaj
+    g_free(mosaic_text);
+    g_free(max_memory_text);
+    g_free(stage_cache_text);
+    g_free(indices_text);
+    g_free(zones_format_text);
+    g_free(composite_text);
+    g_free(band_layout_text);
+    g_free(export_format_text);
+    g_free(value_type_text);
+    return status;
+}
+
+void free_cli_options(CliOptions* options)
+{
+    g_free(options->metrics_json_path);
+    options->metrics_json_path = NULL;
+    g_free(options->trace_path);
+    options->trace_path = NULL;
+    g_free(options->batch_manifest_path);
+    options->batch_manifest_path = NULL;
+    g_free(options->watch_dir);
+    options->watch_dir = NULL;
+    g_free(options->output_dir);
+    options->output_dir = NULL;
+    g_free(options->zones_path);
+    options->zones_path = NULL;
+    g_free(options->zone_field);
+    options->zone_field = NULL;
+    g_free(options->scratch_dir);
+    options->scratch_dir = NULL;
+}
+
+// Lista nazw wskaźników rozdzielonych przecinkami, np. "NDVI,NDMI" -> suma flag PipelineIndex
+static int parse_index_list(const char* text, unsigned int* indices_out)
+{
+    gchar** names = g_strsplit(text, ",", -1);
+    unsigned int indices = 0;
+    int status = 0;
+
+    for (int i = 0; names[i]; i++)
+    {
+        unsigned int index = pipeline_index_from_name(g_strstrip(names[i]));
+        if (index == 0)
+        {
+            status = -1;
+            break;
+        }
+        indices |= index;
+    }
+    g_strfreev(names);
+
+    if (status != 0 || indices == 0)
+    {
+        return -1;
+    }
+    *indices_out = indices;
+    return 0;
+}
+
+static int parse_export_format_list(const char* text, unsigned int* formats_out)
+{
+    gchar** names = g_strsplit(text, ",", -1);
+    unsigned int formats = 0;
+    int status = 0;
+
+    for (int i = 0; names[i]; i++)
+    {
+        const char* name = g_strstrip(names[i]);
+        if (g_ascii_strcasecmp(name, "png") == 0)
+        {
+            formats |= BATCH_EXPORT_PNG;
+        }
+        else if (g_ascii_strcasecmp(name, "zarr") == 0)
+        {
+            formats |= BATCH_EXPORT_ZARR;
+        }
+        else
+        {
+            status = -1;
+            break;
+        }
+    }
+    g_strfreev(names);
+
+    if (status != 0 || formats == 0)
+    {
+        return -1;
+    }
+    *formats_out = formats;
+    return 0;
+}
+
+int parse_memory_size(const char* text, size_t* bytes_out)
+{
+    if (!text || !isdigit((unsigned char)*text))
+    {
+        return -1;
+    }
+
+    char* end = NULL;
+    double value = strtod(text, &end);
+    size_t multiplier = 1;
+
+    switch (toupper((unsigned char)*end))
+    {
+    case 'K':
+        multiplier = (size_t)1 << 10;
+        end++;
+        break;
+    case 'M':
+        multiplier = (size_t)1 << 20;
+        end++;
+        break;
+    case 'G':
+        multiplier = (size_t)1 << 30;
+        end++;
+        break;
+    case 'T':
+        multiplier = (size_t)1 << 40;
+        end++;
+        break;
+    default:
+        break;
+    }
+
+    // Dopuszczalne zakończenia: "", "B", "iB" (np. 4G, 4GB, 4GiB)
+    if (*end == 'i')
+    {
+        end++;
+    }
+    if (toupper((unsigned char)*end) == 'B')
+    {
+        end++;
+    }
+    if (*end != '\0' || value <= 0.0 || value * multiplier >= (double)SIZE_MAX)
+    {
+        return -1;
+    }
+
+    *bytes_out = (size_t)(value * multiplier);
+    return 0;
+}
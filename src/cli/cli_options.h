@@ -0,0 +1,102 @@
+#ifndef CLI_OPTIONS_H
+#define CLI_OPTIONS_H
+
+#include <stddef.h>
+
+// Domyślna pojemność pamięci podręcznej etapów GUI - mieści wyniki pełnego kafla w obu rozdzielczościach
+#define DEFAULT_STAGE_CACHE_BYTES ((size_t)4 << 30)
+
+/**
+ * @brief Opcje wiersza poleceń obsługiwane przez program (poza opcjami GTK)
+ */
+typedef struct
+{
+    size_t max_memory_bytes;
+    size_t stage_cache_bytes;
+    char* metrics_json_path;
+    char* trace_path;
+    char* batch_manifest_path;
+    char* watch_dir;
+    char* output_dir;
+    int scenes_in_flight;
+    int threads;
+    int resolution_m;
+    int no_prefetch;
+    unsigned int indices;
+    char* zones_path;
+    char* zone_field;
+    int zones_json;
+    // Metoda kompozycji (CompositeMethod) albo -1, gdy tryb wsadowy zapisuje mapy każdej sceny
+    int composite_method;
+    // Reguła mozaiki kafli (MosaicRule) albo -1, gdy sceny z --batch nie są łączone w mozaikę
+    int mosaic_rule;
+    // Sceny z --batch przetwarzane parami jako dwie daty (patrz run_change_detection())
+    int change_detection;
+    double change_threshold;
+    // Układ pasm na etapie wskaźników (PipelineBandLayout)
+    int band_layout;
+    // Formaty map trybu wsadowego i demona (suma flag BatchExportFormat)
+    unsigned int export_formats;
+    // Reprezentacja wskaźników trybu wsadowego i demona (PipelineValueType)
+    int value_type;
+    // Katalog plików roboczych dużych rastrów (raster_pool_set_scratch()) lub NULL
+    char* scratch_dir;
+} CliOptions;
+
+/**
+ * @brief Parsuje opcje programu i usuwa je z argv
+ *
+ * Nierozpoznane argumenty zostają w argv, dzięki czemu mogą zostać przekazane do GtkApplication.
+ *
+ * Obsługiwane opcje:
+ * - --max-memory=ROZMIAR  budżet pamięci przebiegu, np. 512M, 4G (sufiksy K/M/G/T, podstawa 1024)
+ * - --stage-cache=ROZMIAR pojemność pamięci podręcznej etapów GUI (domyślnie 4G, 0 wyłącza)
+ * - --metrics-json=PLIK   dopisuje metryki każdego przebiegu jako linię JSON
+ * - --trace=PLIK          zapisuje ślad wykonania (format Chrome trace) przy zamknięciu programu
+ * - --batch=MANIFEST      przetwarza sceny z manifestu bez GUI (patrz batch_load_manifest())
+ * - --watch=KATALOG      tryb demona: przetwarza sceny pojawiające się w katalogu (patrz run_watch_daemon())
+ * - --output-dir=KATALOG  katalog na mapy PNG trybu wsadowego i demona (domyślnie bieżący)
+ * - --scenes-in-flight=N  liczba scen przetwarzanych jednocześnie (domyślnie 2)
+ * - --threads=N           globalny budżet wątków (domyślnie liczba procesorów)
+ * - --resolution=10|20    docelowa rozdzielczość w metrach (domyślnie 10)
+ * - --no-prefetch         wyłącza wczytywanie kolejnych scen z wyprzedzeniem
+ * - --indices=LISTA       liczone wskaźniki: NDVI, NDMI, NDWI, NBR, NDRE, EVI, SAVI (domyślnie NDVI,NDMI);
+ *                         pasma niepotrzebne wybranym wskaźnikom nie są wczytywane
+ * - --zones=PLIK          statystyki wskaźników w strefach (działkach) z rastra etykiet lub pliku wielokątów
+ * - --zone-field=POLE     pole identyfikatora działki w pliku wielokątów (domyślnie id)
+ * - --zones-format=csv|json format pliku <scena>_zones (domyślnie csv)
+ * - --composite=max|median|mean sceny z --batch łączone w jedną kompozycję (patrz run_composite())
+ * - --mosaic=least-cloud|latest sąsiednie kafle z --batch łączone w mozaikę regionu (patrz run_mosaic())
+ * - --change              kolejne pary scen z --batch (1-2, 3-4, ...) dają rastry różnic dNDVI/dNDMI
+ *                         (patrz run_change_detection())
+ * - --change-threshold=T  próg |różnicy| liczonej jako spadek lub wzrost (domyślnie 0.1)
+ * - --band-layout=planar|tiled układ pasm na etapie wskaźników (patrz PipelineBandLayout)
+ * - --export-format=LISTA formaty map trybu wsadowego i demona: png, zarr lub png,zarr (domyślnie png)
+ * - --values=float32|int16 reprezentacja wskaźników trybu wsadowego i demona (patrz PipelineValueType)
+ * - --scratch-dir=KATALOG pełne rastry pasm i wyników w plikach roboczych mapowanych do pamięci
+ *                         (patrz raster_pool_set_scratch()) - scena większa niż RAM ograniczona dyskiem
+ *
+ * Opcje --composite, --mosaic i --change wybierają tryb scen z --batch: można podać najwyżej jedną
+ * z nich i tylko razem z --batch. Ich wyniki są zawsze float32, więc nie przyjmują --values.
+ *
+ * --band-layout=tiled dotyczy tylko przetwarzania całej sceny w trybie wsadowym i demonie, więc jest
+ * odrzucane w GUI (pasy wierszy), z --max-memory (budżet może wymusić pasy wierszy) oraz z --composite,
+ * --mosaic i --change.
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy opcja ma nieprawidłową wartość lub opcje się wykluczają
+ */
+int parse_cli_options(int* argc, char*** argv, CliOptions* options);
+
+/**
+ * @brief Zwalnia napisy zaalokowane przez parse_cli_options()
+ */
+void free_cli_options(CliOptions* options);
+
+/**
+ * @brief Zamienia tekst rozmiaru pamięci (np. "2G", "750M", "1048576") na liczbę bajtów
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy tekst nie jest poprawnym rozmiarem
+ */
+int parse_memory_size(const char* text, size_t* bytes_out);
+
+#endif // CLI_OPTIONS_H
@@ -0,0 +1,62 @@
+#include "colormap.h"
+#include <math.h>
+
+#include "../index_calculator/index_calculator.h"
+
+// Linear interpolation
+static float lerp(float a, float b, float t)
+{
+    return a + t * (b - a);
+}
+
+void map_index_value_to_rgb(float value, unsigned char* r,
+                            unsigned char* g, unsigned char* b)
+{
+    if (value == INDEX_NO_DATA_VALUE || isnan(value) || isinf(value))
+    {
+        *r = 0;
+        *g = 0;
+        *b = 0;
+        return;
+    }
+
+    // EVI i SAVI wychodzą poza [-1, 1]; poza zakresem skali kolor się nasyca
+    value = fminf(fmaxf(value, -1.0f), 1.0f);
+
+    if (value < 0.0f)
+    {
+        // t rośnie od 0 (dla value = -1.0) do 1 (dla value = 0.0)
+        float t = (value - (-1.0f)) / (0.0f - (-1.0f));
+        *r = 255;
+        *g = (unsigned char)lerp(0.0f, 255.0f, t);
+        *b = 0;
+    }
+    else
+    {
+        // t rośnie od 0 (dla value = 0.0) do 1 (dla value = 1.0)
+        float t = (value - 0.0f) / (1.0f - 0.0f);
+        *r = (unsigned char)lerp(255.0f, 0.0f, t); // essa
+        *g = 255;
+        *b = 0;
+    }
+}
+
+void colorize_index_row(const float* index_row, int width, unsigned char* pixels_row, int n_channels)
+{
+    for (int x = 0; x < width; x++)
+    {
+        unsigned char* p = pixels_row + (size_t)x * n_channels;
+        map_index_value_to_rgb(index_row[x], &p[0], &p[1], &p[2]);
+    }
+}
+
+void colorize_quantized_index_row(const int16_t* index_row, int width, unsigned char* pixels_row, int n_channels)
+{
+    const float inverse_scale = 1.0f / INDEX_INT16_SCALE;
+    for (int x = 0; x < width; x++)
+    {
+        unsigned char* p = pixels_row + (size_t)x * n_channels;
+        float value = index_row[x] == INDEX_INT16_NO_DATA ? INDEX_NO_DATA_VALUE : index_row[x] * inverse_scale;
+        map_index_value_to_rgb(value, &p[0], &p[1], &p[2]);
+    }
+}
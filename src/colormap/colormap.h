@@ -0,0 +1,26 @@
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Mapuje wartość wskaźnika [-1, 1] na kolor: czerwony (-1) - żółty (0) - zielony (1)
+ *
+ * Piksele INDEX_NO_DATA_VALUE, NaN i nieskończoności mapowane są na czarny.
+ */
+void map_index_value_to_rgb(float value, unsigned char* r, unsigned char* g, unsigned char* b);
+
+/**
+ * @brief Koloruje jeden wiersz wskaźnika do wiersza obrazu o n_channels kanałach (RGB w pierwszych trzech)
+ */
+void colorize_index_row(const float* index_row, int width, unsigned char* pixels_row, int n_channels);
+
+/**
+ * @brief colorize_index_row() dla wiersza skwantowanego do int16 (quantize_index_values())
+ *
+ * Czyta wartości int16 wprost; INDEX_INT16_NO_DATA mapowany jest na czarny.
+ */
+void colorize_quantized_index_row(const int16_t* index_row, int width, unsigned char* pixels_row, int n_channels);
+
+#endif // COLORMAP_H
@@ -0,0 +1,624 @@
+#include "compositor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <glib.h>
+#include <gdal.h>
+#include <omp.h>
+
+#include "../band_math/band_math.h"
+#include "../data_loader/data_loader.h"
+#include "../pipeline_context/pipeline_context.h"
+#include "../index_calculator/index_calculator.h"
+#include "../strip_indices/strip_indices.h"
+#include "../utils/utils.h"
+
+// Najwyższy pas kompozycji - wyżej zysk z mniejszej liczby otwarć plików jest pomijalny
+#define COMPOSITE_MAX_STRIP_ROWS 1024
+
+/**
+ * @brief Kompozycja jednego wskaźnika: program band_math, pliki wyjściowe i stan pasa
+ */
+typedef struct
+{
+    BandMathProgram* program;
+    GDALDatasetH value_dataset;
+    GDALDatasetH source_dataset;
+    // Wynik pasa; w trakcie łączenia: max - najlepsza wartość, średnia - suma
+    float* values;
+    // Warstwa źródła pasa; w trakcie łączenia średniej - liczba obserwacji
+    uint32_t* sources;
+    // Mediana - wartości wszystkich scen pasa (scena s od s * piksele pasa), pozostałe - wynik bieżącej sceny
+    float* samples;
+} CompositeLayer;
+
+typedef struct
+{
+    const BatchScene* scenes;
+    int scene_count;
+    const CompositeConfig* config;
+    unsigned int band_mask;
+    int width;
+    int height;
+    int reference_band;
+    int strip_rows;
+    uint32_t* scene_dates;
+    bool* scene_usable;
+    int usable_count;
+    CompositeLayer* layers;
+    int layer_count;
+} CompositeState;
+
+static const char* COMPOSITE_METHOD_NAMES[] = {
+    [COMPOSITE_MAX] = "max",
+    [COMPOSITE_MEDIAN] = "median",
+    [COMPOSITE_MEAN] = "mean"
+};
+
+// ====== PRZYGOTOWANIE ======
+static int prepare_scenes(CompositeState* state);
+static int choose_strip_rows(CompositeState* state);
+static int open_layers(CompositeState* state);
+static GDALDatasetH create_output_dataset(const CompositeState* state, const char* index_name, bool source_layer);
+static void close_layers(CompositeState* state);
+// ====== PASY ======
+static int composite_strip(CompositeState* state, int y_start, int y_end);
+static int evaluate_scene_strip(CompositeState* state, int scene, int y_start, int y_end, float* const outputs[]);
+static void reset_strip_state(CompositeState* state, size_t strip_pixels);
+static void merge_scene_strip(CompositeState* state, int scene, size_t strip_pixels);
+static void finalize_strip(CompositeState* state, size_t strip_pixels);
+static void finalize_median(const CompositeState* state, CompositeLayer* layer, size_t strip_pixels);
+static void select_kth(float* values, int* scenes, int count, int k);
+static int write_strip(const CompositeState* state, int y_start, int y_end);
+
+int run_composite(const BatchScene* scenes, int count, const CompositeConfig* config)
+{
+    if (!scenes || count <= 0 || !config || !config->output_dir)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Brak scen do złożenia.\n", get_timestamp());
+        return -1;
+    }
+    if (g_mkdir_with_parents(config->output_dir, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu wyjściowego %s.\n", get_timestamp(), config->output_dir);
+        return -1;
+    }
+
+    pipeline_global_init();
+
+    CompositeState state = {
+        .scenes = scenes,
+        .scene_count = count,
+        .config = config,
+        .band_mask = pipeline_index_band_mask(config->indices)
+    };
+
+    gint64 start_us = g_get_monotonic_time();
+    int status = prepare_scenes(&state);
+    if (status == 0)
+    {
+        status = open_layers(&state);
+    }
+    if (status == 0)
+    {
+        status = choose_strip_rows(&state);
+    }
+
+    for (int y = 0; status == 0 && y < state.height; y += state.strip_rows)
+    {
+        int y_end = y + state.strip_rows < state.height ? y + state.strip_rows : state.height;
+        status = composite_strip(&state, y, y_end);
+        if (status == 0)
+        {
+            printf("[%s] [KOMPOZYCJA] Wiersze %d-%d z %d gotowe\n", get_timestamp(), y, y_end, state.height);
+        }
+    }
+
+    close_layers(&state);
+    free(state.scene_dates);
+    free(state.scene_usable);
+
+    if (status == 0)
+    {
+        printf("[%s] [KOMPOZYCJA] Gotowe: %d scen, metoda %s, %.2fs\n", get_timestamp(), state.usable_count,
+               composite_method_name(config->method), (g_get_monotonic_time() - start_us) / 1e6);
+    }
+    return status;
+}
+
+int composite_method_from_name(const char* name, CompositeMethod* method_out)
+{
+    for (int m = 0; m < (int)(sizeof(COMPOSITE_METHOD_NAMES) / sizeof(COMPOSITE_METHOD_NAMES[0])); m++)
+    {
+        if (name && g_ascii_strcasecmp(name, COMPOSITE_METHOD_NAMES[m]) == 0)
+        {
+            *method_out = (CompositeMethod)m;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* composite_method_name(CompositeMethod method)
+{
+    return COMPOSITE_METHOD_NAMES[method];
+}
+
+uint32_t composite_scene_date(const char* scene_name)
+{
+    // Pierwszy ciąg dokładnie 8 cyfr wyglądający na datę RRRRMMDD, np. z T34UDC_20230601T095031
+    // lub S2A_MSIL2A_20230601T095031_... - 'T' przed godziną kończy ciąg cyfr daty
+    const char* p = scene_name;
+    while (p && *p)
+    {
+        if (!isdigit((unsigned char)*p))
+        {
+            p++;
+            continue;
+        }
+
+        int digits = 0;
+        while (isdigit((unsigned char)p[digits]))
+        {
+            digits++;
+        }
+        if (digits == 8)
+        {
+            uint32_t date = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                date = date * 10 + (uint32_t)(p[i] - '0');
+            }
+            uint32_t month = date / 100 % 100;
+            uint32_t day = date % 100;
+            if (date / 10000 >= 1900 && month >= 1 && month <= 12 && day >= 1 && day <= 31)
+            {
+                return date;
+            }
+        }
+        p += digits;
+    }
+    return 0;
+}
+
+// ====== PRZYGOTOWANIE ======
+
+// Siatka z pierwszej sceny; sceny innego kafla lub rozdzielczości są pomijane
+static int prepare_scenes(CompositeState* state)
+{
+    const CompositeConfig* config = state->config;
+
+    state->scene_dates = calloc(state->scene_count, sizeof(uint32_t));
+    state->scene_usable = calloc(state->scene_count, sizeof(bool));
+    if (!state->scene_dates || !state->scene_usable)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Błąd alokacji pamięci.\n", get_timestamp());
+        return -1;
+    }
+
+    if (pipeline_target_grid(state->scenes[0].paths, state->band_mask, config->target_10m,
+                             &state->width, &state->height, &state->reference_band) != 0)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Nie można odczytać siatki sceny %s.\n",
+                get_timestamp(), state->scenes[0].name);
+        return -1;
+    }
+
+    for (int s = 0; s < state->scene_count; s++)
+    {
+        const BatchScene* scene = &state->scenes[s];
+        int width, height;
+        if (pipeline_target_grid(scene->paths, state->band_mask, config->target_10m, &width, &height, NULL) != 0 ||
+            width != state->width || height != state->height)
+        {
+            fprintf(stderr, "[%s] [KOMPOZYCJA] Scena %s pominięta: inna siatka niż %dx%d.\n",
+                    get_timestamp(), scene->name, state->width, state->height);
+            continue;
+        }
+
+        // Bez daty w nazwie warstwa źródła zawiera numer sceny w manifeście (od 1)
+        uint32_t date = composite_scene_date(scene->name);
+        state->scene_dates[s] = date ? date : (uint32_t)s + 1;
+        state->scene_usable[s] = true;
+        state->usable_count++;
+        printf("[%s] [KOMPOZYCJA] Scena %s, źródło %u\n", get_timestamp(), scene->name, state->scene_dates[s]);
+    }
+
+    if (state->usable_count == 0)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Brak scen o wspólnej siatce.\n", get_timestamp());
+        return -1;
+    }
+    return 0;
+}
+
+// Wysokość pasa mieszcząca w budżecie stan warstw i czytnik pasów jednej sceny
+static int choose_strip_rows(CompositeState* state)
+{
+    const CompositeConfig* config = state->config;
+    size_t budget = config->memory_budget > 0 ? config->memory_budget : COMPOSITE_DEFAULT_BUDGET_BYTES;
+
+    size_t reader_row_bytes = strip_index_source_row_bytes(state->scenes[0].paths, config->indices,
+                                                           state->width, state->height);
+
+    // Na piksel warstwy: wynik i źródło oraz wartości scen (mediana) albo wynik bieżącej sceny
+    size_t samples_per_pixel = config->method == COMPOSITE_MEDIAN ? (size_t)state->scene_count : 1;
+    size_t layer_row_bytes = (size_t)state->width * (samples_per_pixel * sizeof(float) + sizeof(float) +
+                                                    sizeof(uint32_t));
+    size_t row_bytes = reader_row_bytes + state->layer_count * layer_row_bytes;
+
+    size_t rows = budget / row_bytes;
+    if (rows == 0)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Budżet pamięci %.1f MB nie mieści jednego wiersza (%.1f MB).\n",
+                get_timestamp(), budget / (1024.0 * 1024.0), row_bytes / (1024.0 * 1024.0));
+        return -1;
+    }
+    rows = rows < COMPOSITE_MAX_STRIP_ROWS ? rows : COMPOSITE_MAX_STRIP_ROWS;
+    state->strip_rows = rows < (size_t)state->height ? (int)rows : state->height;
+
+    size_t strip_pixels = (size_t)state->strip_rows * state->width;
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        CompositeLayer* layer = &state->layers[l];
+        layer->values = malloc(strip_pixels * sizeof(float));
+        layer->sources = malloc(strip_pixels * sizeof(uint32_t));
+        layer->samples = malloc(strip_pixels * samples_per_pixel * sizeof(float));
+        if (!layer->values || !layer->sources || !layer->samples)
+        {
+            fprintf(stderr, "[%s] [KOMPOZYCJA] Błąd alokacji pamięci pasa.\n", get_timestamp());
+            return -1;
+        }
+    }
+
+    printf("[%s] [KOMPOZYCJA] %d scen, metoda %s, siatka %dx%d, pas %d wierszy (%.1f MB)\n",
+           get_timestamp(), state->usable_count, composite_method_name(config->method), state->width,
+           state->height, state->strip_rows, state->strip_rows * row_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+static int open_layers(CompositeState* state)
+{
+    for (int k = 0; pipeline_index_name(k); k++)
+    {
+        if (state->config->indices & (1u << k))
+        {
+            state->layer_count++;
+        }
+    }
+
+    state->layers = calloc(state->layer_count, sizeof(CompositeLayer));
+    if (!state->layers)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Błąd alokacji pamięci.\n", get_timestamp());
+        return -1;
+    }
+
+    for (int k = 0, l = 0; pipeline_index_name(k); k++)
+    {
+        if (!(state->config->indices & (1u << k)))
+        {
+            continue;
+        }
+        CompositeLayer* layer = &state->layers[l++];
+        layer->program = band_math_compile_builtin(pipeline_index_name(k));
+        layer->value_dataset = create_output_dataset(state, pipeline_index_name(k), false);
+        layer->source_dataset = create_output_dataset(state, pipeline_index_name(k), true);
+        if (!layer->program || !layer->value_dataset || !layer->source_dataset)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static GDALDatasetH create_output_dataset(const CompositeState* state, const char* index_name, bool source_layer)
+{
+    gchar* path = g_strdup_printf("%s/composite_%s_%s%s.tif", state->config->output_dir,
+                                  composite_method_name(state->config->method), index_name,
+                                  source_layer ? "_source" : "");
+
+    GDALDatasetH dataset = create_georeferenced_geotiff(path, state->width, state->height,
+                                                        source_layer ? GDT_UInt32 : GDT_Float32,
+                                                        source_layer ? 0.0 : INDEX_NO_DATA_VALUE,
+                                                        state->scenes[0].paths[state->reference_band]);
+    if (dataset)
+    {
+        printf("[%s] [KOMPOZYCJA] Zapis do %s\n", get_timestamp(), path);
+    }
+    g_free(path);
+    return dataset;
+}
+
+static void close_layers(CompositeState* state)
+{
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        CompositeLayer* layer = &state->layers[l];
+        band_math_free(layer->program);
+        if (layer->value_dataset)
+        {
+            GDALClose(layer->value_dataset);
+        }
+        if (layer->source_dataset)
+        {
+            GDALClose(layer->source_dataset);
+        }
+        free(layer->values);
+        free(layer->sources);
+        free(layer->samples);
+    }
+    free(state->layers);
+    state->layers = NULL;
+    state->layer_count = 0;
+}
+
+// ====== PASY ======
+
+static int composite_strip(CompositeState* state, int y_start, int y_end)
+{
+    size_t strip_pixels = (size_t)(y_end - y_start) * state->width;
+    reset_strip_state(state, strip_pixels);
+
+    float* outputs[PIPELINE_INDEX_COUNT] = {NULL};
+    for (int s = 0; s < state->scene_count; s++)
+    {
+        if (!state->scene_usable[s])
+        {
+            continue;
+        }
+
+        // Mediana zbiera wartości wszystkich scen, pozostałe metody łączą wynik sceny od razu
+        for (int l = 0; l < state->layer_count; l++)
+        {
+            CompositeLayer* layer = &state->layers[l];
+            outputs[l] = state->config->method == COMPOSITE_MEDIAN ? layer->samples + s * strip_pixels
+                                                                   : layer->samples;
+        }
+
+        if (evaluate_scene_strip(state, s, y_start, y_end, outputs) != 0)
+        {
+            fprintf(stderr, "[%s] [KOMPOZYCJA] Błąd przetwarzania sceny %s (wiersze %d-%d).\n",
+                    get_timestamp(), state->scenes[s].name, y_start, y_end);
+            return -1;
+        }
+        if (state->config->method != COMPOSITE_MEDIAN)
+        {
+            merge_scene_strip(state, s, strip_pixels);
+        }
+    }
+
+    finalize_strip(state, strip_pixels);
+    return write_strip(state, y_start, y_end);
+}
+
+// Czytnik pasów sceny jest otwierany tylko na czas pasa, więc pamięć nie rośnie z liczbą scen
+static int evaluate_scene_strip(CompositeState* state, int scene, int y_start, int y_end, float* const outputs[])
+{
+    StripIndexSource source;
+    if (strip_index_source_open(&source, state->scenes[scene].paths, state->config->indices, state->width,
+                                state->height, state->strip_rows) != 0)
+    {
+        return -1;
+    }
+
+    BandMathProgram* programs[PIPELINE_INDEX_COUNT];
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        programs[l] = state->layers[l].program;
+    }
+
+    int status = strip_index_source_evaluate(&source, programs, state->layer_count, y_start, y_end, outputs);
+    strip_index_source_close(&source);
+    return status;
+}
+
+static void reset_strip_state(CompositeState* state, size_t strip_pixels)
+{
+    // Max zaczyna od braku danych, średnia od zerowej sumy; mediana nadpisuje wynik w całości
+    float initial = state->config->method == COMPOSITE_MAX ? INDEX_NO_DATA_VALUE : 0.0f;
+
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        CompositeLayer* layer = &state->layers[l];
+        #pragma omp parallel for simd schedule(static)
+        for (size_t p = 0; p < strip_pixels; p++)
+        {
+            layer->values[p] = initial;
+            layer->sources[p] = 0;
+        }
+    }
+}
+
+static void merge_scene_strip(CompositeState* state, int scene, size_t strip_pixels)
+{
+    uint32_t date = state->scene_dates[scene];
+
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        CompositeLayer* layer = &state->layers[l];
+        const float* scene_values = layer->samples;
+        float* values = layer->values;
+        uint32_t* sources = layer->sources;
+
+        if (state->config->method == COMPOSITE_MAX)
+        {
+            // INDEX_NO_DATA_VALUE (-2) jest mniejsze od każdej wartości wskaźnika znormalizowanego,
+            // więc piksele zamaskowane nigdy nie wygrywają, a brak danych zostaje tylko bez obserwacji
+            #pragma omp parallel for simd schedule(static)
+            for (size_t p = 0; p < strip_pixels; p++)
+            {
+                bool better = scene_values[p] > values[p];
+                values[p] = better ? scene_values[p] : values[p];
+                sources[p] = better ? date : sources[p];
+            }
+        }
+        else
+        {
+            #pragma omp parallel for simd schedule(static)
+            for (size_t p = 0; p < strip_pixels; p++)
+            {
+                bool valid = scene_values[p] != INDEX_NO_DATA_VALUE;
+                values[p] += valid ? scene_values[p] : 0.0f;
+                sources[p] += valid;
+            }
+        }
+    }
+}
+
+static void finalize_strip(CompositeState* state, size_t strip_pixels)
+{
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        CompositeLayer* layer = &state->layers[l];
+
+        if (state->config->method == COMPOSITE_MEDIAN)
+        {
+            finalize_median(state, layer, strip_pixels);
+        }
+        else if (state->config->method == COMPOSITE_MEAN)
+        {
+            #pragma omp parallel for simd schedule(static)
+            for (size_t p = 0; p < strip_pixels; p++)
+            {
+                layer->values[p] = layer->sources[p] > 0 ? layer->values[p] / layer->sources[p]
+                                                         : INDEX_NO_DATA_VALUE;
+            }
+        }
+    }
+}
+
+// Dolna mediana wartości ważnych piksela; źródłem jest data sceny, z której pochodzi
+static void finalize_median(const CompositeState* state, CompositeLayer* layer, size_t strip_pixels)
+{
+    int error_flag = 0;
+
+    #pragma omp parallel shared(error_flag)
+    {
+        float* window = malloc(state->scene_count * sizeof(float));
+        int* window_scenes = malloc(state->scene_count * sizeof(int));
+        if (!window || !window_scenes)
+        {
+            #pragma omp atomic write
+            error_flag = 1;
+        }
+
+        #pragma omp for schedule(static)
+        for (size_t p = 0; p < strip_pixels; p++)
+        {
+            if (!window || !window_scenes)
+            {
+                layer->values[p] = INDEX_NO_DATA_VALUE;
+                layer->sources[p] = 0;
+                continue;
+            }
+
+            int count = 0;
+            for (int s = 0; s < state->scene_count; s++)
+            {
+                float value = layer->samples[s * strip_pixels + p];
+                if (state->scene_usable[s] && value != INDEX_NO_DATA_VALUE)
+                {
+                    window[count] = value;
+                    window_scenes[count] = s;
+                    count++;
+                }
+            }
+
+            if (count == 0)
+            {
+                layer->values[p] = INDEX_NO_DATA_VALUE;
+                layer->sources[p] = 0;
+                continue;
+            }
+
+            int middle = (count - 1) / 2;
+            select_kth(window, window_scenes, count, middle);
+            layer->values[p] = window[middle];
+            layer->sources[p] = state->scene_dates[window_scenes[middle]];
+        }
+
+        free(window);
+        free(window_scenes);
+    }
+
+    if (error_flag)
+    {
+        fprintf(stderr, "[%s] [KOMPOZYCJA] Błąd alokacji pamięci mediany - część pikseli bez danych.\n",
+                get_timestamp());
+    }
+}
+
+// Quickselect: po powrocie values[k] jest k-tą najmniejszą wartością, scenes przestawiane razem z nią
+static void select_kth(float* values, int* scenes, int count, int k)
+{
+    int left = 0;
+    int right = count - 1;
+
+    while (left < right)
+    {
+        float pivot = values[left + (right - left) / 2];
+        int i = left;
+        int j = right;
+        while (i <= j)
+        {
+            while (values[i] < pivot)
+            {
+                i++;
+            }
+            while (values[j] > pivot)
+            {
+                j--;
+            }
+            if (i <= j)
+            {
+                float value = values[i];
+                values[i] = values[j];
+                values[j] = value;
+                int scene = scenes[i];
+                scenes[i] = scenes[j];
+                scenes[j] = scene;
+                i++;
+                j--;
+            }
+        }
+
+        if (k <= j)
+        {
+            right = j;
+        }
+        else if (k >= i)
+        {
+            left = i;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+static int write_strip(const CompositeState* state, int y_start, int y_end)
+{
+    int rows = y_end - y_start;
+
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        const CompositeLayer* layer = &state->layers[l];
+        CPLErr err = GDALRasterIO(GDALGetRasterBand(layer->value_dataset, 1), GF_Write, 0, y_start, state->width,
+                                  rows, layer->values, state->width, rows, GDT_Float32, 0, 0);
+        if (err == CE_None)
+        {
+            err = GDALRasterIO(GDALGetRasterBand(layer->source_dataset, 1), GF_Write, 0, y_start, state->width,
+                               rows, layer->sources, state->width, rows, GDT_UInt32, 0, 0);
+        }
+        if (err != CE_None)
+        {
+            fprintf(stderr, "[%s] [KOMPOZYCJA] Błąd zapisu wierszy %d-%d: %s\n", get_timestamp(), y_start, y_end,
+                    CPLGetLastErrorMsg());
+            return -1;
+        }
+    }
+    return 0;
+}
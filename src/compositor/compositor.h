@@ -0,0 +1,76 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../batch_scheduler/batch_scheduler.h"
+
+/**
+ * @brief Metoda łączenia wartości wskaźnika z wielu dat w jeden piksel kompozycji
+ */
+typedef enum
+{
+    // Największa wartość (np. max-NDVI - najmniej zachmurzona, najbujniejsza roślinność)
+    COMPOSITE_MAX,
+    // Mediana wartości ważnych (dolna przy parzystej liczbie, więc zawsze jedna z obserwacji)
+    COMPOSITE_MEDIAN,
+    // Średnia wartości ważnych
+    COMPOSITE_MEAN
+} CompositeMethod;
+
+/**
+ * @brief Konfiguracja trybu kompozycji wieloczasowej
+ */
+typedef struct
+{
+    CompositeMethod method;
+    // Wskaźniki (flagi PipelineIndex) - każdy ma własną kompozycję
+    unsigned int indices;
+    bool target_10m;
+    // Budżet pamięci pasów (akumulatory i czytnik), 0 - COMPOSITE_DEFAULT_BUDGET_BYTES
+    size_t memory_budget;
+    const char* output_dir;
+} CompositeConfig;
+
+// Budżet pamięci kompozycji, gdy nie podano --max-memory
+#define COMPOSITE_DEFAULT_BUDGET_BYTES ((size_t)1 << 30)
+
+/**
+ * @brief Buduje kompozycje wskaźników z wielu scen (dat) tego samego kafla
+ *
+ * Sceny przetwarzane są pasami wierszy: dla każdego pasa kolejne sceny są otwierane
+ * czytnikiem pasów, ich wskaźniki liczone silnikiem band_math (z maskowaniem SCL), a wynik
+ * od razu łączony ze stanem pasa. Stan to dla max - najlepsza wartość i jej data, dla
+ * średniej - suma i liczba obserwacji, dla mediany - wartości wszystkich scen w pasie.
+ * Gotowy pas trafia od razu do plików wyjściowych, więc pamięć zależy od wysokości pasa,
+ * a nie od rozmiaru kafla; wysokość pasa dobierana jest do budżetu (dla mediany maleje
+ * z liczbą scen).
+ *
+ * Dla każdego wskaźnika zapisywane są GeoTIFF-y:
+ * - <output_dir>/composite_<metoda>_<WSKAŹNIK>.tif - wartości kompozycji (float32, brak danych -2)
+ * - <output_dir>/composite_<metoda>_<WSKAŹNIK>_source.tif - warstwa źródła (uint32, brak danych 0):
+ *   data RRRRMMDD sceny, z której pochodzi wartość (dla średniej - liczba obserwacji)
+ *
+ * Sceny muszą mieć tę samą siatkę co pierwsza scena (ten sam kafel); pozostałe są pomijane.
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int run_composite(const BatchScene* scenes, int count, const CompositeConfig* config);
+
+/**
+ * @brief Metoda kompozycji dla nazwy "max", "median" lub "mean"
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy nazwa jest nieznana
+ */
+int composite_method_from_name(const char* name, CompositeMethod* method_out);
+
+const char* composite_method_name(CompositeMethod method);
+
+/**
+ * @brief Data akwizycji RRRRMMDD z nazwy sceny (np. T34UDC_20230601T095031), 0 gdy brak
+ */
+uint32_t composite_scene_date(const char* scene_name);
+
+#endif // COMPOSITOR_H
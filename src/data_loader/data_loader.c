@@ -1,13 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
-#include <sys/time.h>
+#include <sys/stat.h>
 #include <gdal.h>
+#include <gdal_alg.h>
+#include <ogr_api.h>
+#include <cpl_string.h>
 #include "data_loader.h"
 
 #include <glib.h>
 
 #include "../utils/utils.h"
+#include "../metrics/metrics.h"
+#include "../raster_pool/raster_pool.h"
 
 // ====== WALIDACJA ======
 int validate_filename(const char* filename);
@@ -21,17 +25,27 @@ void cleanup_gdal_resources(GDALDatasetH dataset, float* buffer);
 // ====== FUNKCJONALNOŚĆ ======
 CPLErr perform_raster_read(GDALRasterBandH band, float* buffer, int width, int height);
 void set_output_dimensions(int* output_width, int* output_height, int width, int height);
+size_t get_file_size(const char* filename);
+int read_zone_raster(const char* zones_path, uint32_t* labels, int width, int height);
+int rasterize_zone_polygons(GDALDatasetH vector, const char* id_field, const char* reference_path,
+                            uint32_t* labels, int width, int height);
 
-int load_all_bands_data(BandData bands[4])
+int load_bands_data(BandData* bands, int band_count, unsigned int band_mask, int max_concurrency)
 {
     int error_flag = 0;
 
-    // Równoległe wczytywanie pasm
-    #pragma omp parallel for shared(bands, error_flag)
-    for (int i = 0; i < 4; i++)
+    if (max_concurrency <= 0 || max_concurrency > band_count)
     {
-        // Wyjdź z pętli, jeżeli jedno z pasm napotkało błąd
-        if (error_flag)
+        max_concurrency = band_count;
+    }
+
+    // Równoległe wczytywanie pasm - potrzebne pasma są rozrzucone po tablicy, więc przydział dynamiczny
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(max_concurrency) shared(bands, error_flag)
+    for (int i = 0; i < band_count; i++)
+    {
+        // Wyjdź z pętli, jeżeli jedno z pasm napotkało błąd; pasma niepotrzebne
+        // i pasma już w pamięci są pomijane
+        if (error_flag || !(band_mask & (1u << i)) || *(bands[i].raw_data))
         {
             continue;
         }
@@ -66,11 +80,11 @@ int load_all_bands_data(BandData bands[4])
     // Jeśli wystąpił błąd, zwolnij już wczytane dane
     if (error_flag)
     {
-        for (int i = 0; i < 4; i++)
+        for (int i = 0; i < band_count; i++)
         {
             if (*(bands[i].raw_data))
             {
-                free(*(bands[i].raw_data));
+                raster_pool_release(*(bands[i].raw_data));
                 *(bands[i].raw_data) = NULL;
                 *(bands[i].processed_data) = NULL;
             }
@@ -84,8 +98,7 @@ int load_all_bands_data(BandData bands[4])
 float* LoadBandData(const char* pszFilename, int* pnXSize, int* pnYSize)
 {
     const char* band_name = detect_band_from_filename(pszFilename);
-    struct timeval start_time, end_time;
-    gettimeofday(&start_time, NULL);
+    MetricsScope metrics_scope = metrics_stage_begin("load", band_name);
 
     printf("[%s] [%s] Rozpoczynam wczytywanie pliku\n", get_timestamp(), band_name);
 
@@ -153,9 +166,10 @@ float* LoadBandData(const char* pszFilename, int* pnXSize, int* pnYSize)
     // Cleanup (zachowujemy buffer, zamykamy dataset)
     GDALClose(hDataset);
 
-    // Oblicz czas wykonania
-    gettimeofday(&end_time, NULL);
-    double elapsed_time = get_time_diff(start_time, end_time);
+    // Rejestracja metryk etapu (bajty wejściowe to rozmiar skompresowanego pliku)
+    size_t num_pixels = (size_t)nXSize * nYSize;
+    double elapsed_time = metrics_stage_end(&metrics_scope, get_file_size(pszFilename),
+                                            num_pixels * sizeof(float), num_pixels);
 
     printf("[%s] [%s] Zakończono (czas: %.2fs)\n",
            get_timestamp(), band_name, elapsed_time);
@@ -163,6 +177,330 @@ float* LoadBandData(const char* pszFilename, int* pnXSize, int* pnYSize)
     return pafScanline;
 }
 
+int read_band_dimensions(const char* pszFilename, int* pnXSize, int* pnYSize, int* pnBlockYSize)
+{
+    if (!validate_filename(pszFilename))
+    {
+        return -1;
+    }
+
+    GDALDatasetH hDataset = GDALOpen(pszFilename, GA_ReadOnly);
+    if (!validate_gdal_dataset(hDataset, pszFilename))
+    {
+        return -1;
+    }
+
+    int nXSize = GDALGetRasterXSize(hDataset);
+    int nYSize = GDALGetRasterYSize(hDataset);
+    if (!validate_raster_dimensions(nXSize, nYSize, pszFilename))
+    {
+        cleanup_gdal_resources(hDataset, NULL);
+        return -1;
+    }
+    set_output_dimensions(pnXSize, pnYSize, nXSize, nYSize);
+
+    if (pnBlockYSize != NULL)
+    {
+        int nBlockXSize = 0;
+        *pnBlockYSize = 1;
+        GDALRasterBandH hBand = GDALGetRasterBand(hDataset, 1);
+        if (hBand != NULL)
+        {
+            GDALGetBlockSize(hBand, &nBlockXSize, pnBlockYSize);
+        }
+    }
+
+    GDALClose(hDataset);
+    return 0;
+}
+
+int read_band_into_buffer(const char* pszFilename, void* buffer, int width, int height,
+                          bool as_uint16, size_t line_stride)
+{
+    if (!validate_filename(pszFilename) || buffer == NULL)
+    {
+        return -1;
+    }
+
+    GDALDatasetH hDataset = GDALOpen(pszFilename, GA_ReadOnly);
+    if (!validate_gdal_dataset(hDataset, pszFilename))
+    {
+        return -1;
+    }
+
+    if (GDALGetRasterXSize(hDataset) != width || GDALGetRasterYSize(hDataset) != height)
+    {
+        fprintf(stderr, "Błąd: Wymiary bufora %dx%d nie odpowiadają rastrowi %s.\n", width, height, pszFilename);
+        cleanup_gdal_resources(hDataset, NULL);
+        return -1;
+    }
+
+    GDALRasterBandH hBand = GDALGetRasterBand(hDataset, 1);
+    if (!validate_raster_band(hBand, pszFilename))
+    {
+        cleanup_gdal_resources(hDataset, NULL);
+        return -1;
+    }
+
+    GDALDataType type = as_uint16 ? GDT_UInt16 : GDT_Float32;
+    int pixel_space = as_uint16 ? (int)sizeof(unsigned short) : (int)sizeof(float);
+    CPLErr eErr = GDALRasterIO(hBand, GF_Read, 0, 0, width, height, buffer, width, height, type,
+                               pixel_space, (int)line_stride);
+    if (eErr != CE_None)
+    {
+        fprintf(stderr, "Błąd podczas wczytywania danych rastrowych z %s: %s\n",
+                pszFilename, CPLGetLastErrorMsg());
+    }
+
+    GDALClose(hDataset);
+    return eErr == CE_None ? 0 : -1;
+}
+
+int read_band_overview(const char* pszFilename, float* buffer, int width, int height)
+{
+    if (!validate_filename(pszFilename) || buffer == NULL || width <= 0 || height <= 0)
+    {
+        return -1;
+    }
+
+    GDALDatasetH hDataset = GDALOpen(pszFilename, GA_ReadOnly);
+    if (!validate_gdal_dataset(hDataset, pszFilename))
+    {
+        return -1;
+    }
+
+    GDALRasterBandH hBand = GDALGetRasterBand(hDataset, 1);
+    if (!validate_raster_band(hBand, pszFilename))
+    {
+        cleanup_gdal_resources(hDataset, NULL);
+        return -1;
+    }
+
+    // Cały raster do mniejszego bufora - GDAL czyta z najbliższego poziomu rozdzielczości JPEG2000
+    int nXSize = GDALGetRasterXSize(hDataset);
+    int nYSize = GDALGetRasterYSize(hDataset);
+    CPLErr eErr = GDALRasterIO(hBand, GF_Read, 0, 0, nXSize, nYSize, buffer, width, height, GDT_Float32, 0, 0);
+    if (eErr != CE_None)
+    {
+        fprintf(stderr, "Błąd podczas wczytywania podglądu z %s: %s\n", pszFilename, CPLGetLastErrorMsg());
+    }
+
+    GDALClose(hDataset);
+    return eErr == CE_None ? 0 : -1;
+}
+
+uint32_t* read_zone_labels(const char* zones_path, const char* id_field, const char* reference_path,
+                           int width, int height)
+{
+    if (!validate_filename(zones_path) || width <= 0 || height <= 0)
+    {
+        return NULL;
+    }
+
+    uint32_t* labels = calloc((size_t)width * height, sizeof(uint32_t));
+    if (!labels)
+    {
+        fprintf(stderr, "Błąd: Nie można zaalokować pamięci dla etykiet stref %s.\n", zones_path);
+        return NULL;
+    }
+
+    int status;
+    GDALDatasetH vector = GDALOpenEx(zones_path, GDAL_OF_VECTOR | GDAL_OF_READONLY, NULL, NULL, NULL);
+    if (vector)
+    {
+        status = rasterize_zone_polygons(vector, id_field, reference_path, labels, width, height);
+        GDALClose(vector);
+    }
+    else
+    {
+        status = read_zone_raster(zones_path, labels, width, height);
+    }
+
+    if (status != 0)
+    {
+        free(labels);
+        return NULL;
+    }
+
+    printf("[%s] Wczytano etykiety stref z %s (%dx%d)\n", get_timestamp(), zones_path, width, height);
+    return labels;
+}
+
+int read_zone_raster(const char* zones_path, uint32_t* labels, int width, int height)
+{
+    GDALDatasetH hDataset = GDALOpen(zones_path, GA_ReadOnly);
+    if (!validate_gdal_dataset(hDataset, zones_path))
+    {
+        return -1;
+    }
+
+    GDALRasterBandH hBand = GDALGetRasterBand(hDataset, 1);
+    if (!validate_raster_band(hBand, zones_path))
+    {
+        cleanup_gdal_resources(hDataset, NULL);
+        return -1;
+    }
+
+    // Cały raster stref na siatkę wyniku - domyślne próbkowanie GDAL to najbliższy sąsiad,
+    // więc etykiety nie są uśredniane
+    CPLErr eErr = GDALRasterIO(hBand, GF_Read, 0, 0, GDALGetRasterXSize(hDataset), GDALGetRasterYSize(hDataset),
+                               labels, width, height, GDT_UInt32, 0, 0);
+    if (eErr != CE_None)
+    {
+        fprintf(stderr, "Błąd podczas wczytywania etykiet stref z %s: %s\n", zones_path, CPLGetLastErrorMsg());
+    }
+
+    GDALClose(hDataset);
+    return eErr == CE_None ? 0 : -1;
+}
+
+int rasterize_zone_polygons(GDALDatasetH vector, const char* id_field, const char* reference_path,
+                            uint32_t* labels, int width, int height)
+{
+    if (!validate_filename(reference_path))
+    {
+        return -1;
+    }
+
+    GDALDriverH driver = GDALGetDriverByName("MEM");
+    GDALDatasetH grid = driver ? GDALCreate(driver, "", width, height, 1, GDT_UInt32, NULL) : NULL;
+    if (!grid)
+    {
+        fprintf(stderr, "Błąd: Nie można utworzyć siatki stref: %s\n", CPLGetLastErrorMsg());
+        return -1;
+    }
+    if (apply_scaled_georeference(grid, reference_path, width, height) != 0)
+    {
+        GDALClose(grid);
+        return -1;
+    }
+
+    int layer_count = GDALDatasetGetLayerCount(vector);
+    OGRLayerH* layers = malloc((layer_count > 0 ? layer_count : 1) * sizeof(OGRLayerH));
+    if (!layers)
+    {
+        GDALClose(grid);
+        return -1;
+    }
+    for (int i = 0; i < layer_count; i++)
+    {
+        layers[i] = GDALDatasetGetLayer(vector, i);
+    }
+
+    int band_list[] = {1};
+    char** options = CSLSetNameValue(NULL, "ATTRIBUTE", id_field ? id_field : "id");
+    CPLErr eErr = GDALRasterizeLayers(grid, 1, band_list, layer_count, layers, NULL, NULL, NULL,
+                                      options, NULL, NULL);
+    CSLDestroy(options);
+    free(layers);
+
+    if (eErr == CE_None)
+    {
+        eErr = GDALRasterIO(GDALGetRasterBand(grid, 1), GF_Read, 0, 0, width, height,
+                            labels, width, height, GDT_UInt32, 0, 0);
+    }
+    if (eErr != CE_None)
+    {
+        fprintf(stderr, "Błąd podczas rasteryzacji stref (pole %s): %s\n", id_field ? id_field : "id",
+                CPLGetLastErrorMsg());
+    }
+
+    GDALClose(grid);
+    return eErr == CE_None ? 0 : -1;
+}
+
+int read_scaled_georeference(const char* reference_path, int width, int height, double geo_transform[6],
+                             char** projection_out)
+{
+    if (!validate_filename(reference_path))
+    {
+        return -1;
+    }
+
+    GDALDatasetH reference = GDALOpen(reference_path, GA_ReadOnly);
+    if (!validate_gdal_dataset(reference, reference_path))
+    {
+        return -1;
+    }
+
+    if (GDALGetGeoTransform(reference, geo_transform) != CE_None)
+    {
+        fprintf(stderr, "Błąd: Pasmo %s nie ma georeferencji.\n", reference_path);
+        GDALClose(reference);
+        return -1;
+    }
+
+    // Ten sam zasięg co pasmo odniesienia, piksel przeskalowany do siatki width x height
+    double scale_x = (double)GDALGetRasterXSize(reference) / width;
+    double scale_y = (double)GDALGetRasterYSize(reference) / height;
+    geo_transform[1] *= scale_x;
+    geo_transform[2] *= scale_y;
+    geo_transform[4] *= scale_x;
+    geo_transform[5] *= scale_y;
+
+    if (projection_out)
+    {
+        *projection_out = g_strdup(GDALGetProjectionRef(reference));
+    }
+    GDALClose(reference);
+    return 0;
+}
+
+int apply_scaled_georeference(GDALDatasetH dataset, const char* reference_path, int width, int height)
+{
+    double geo_transform[6];
+    char* projection = NULL;
+    if (read_scaled_georeference(reference_path, width, height, geo_transform, &projection) != 0)
+    {
+        return -1;
+    }
+
+    GDALSetGeoTransform(dataset, geo_transform);
+    GDALSetProjection(dataset, projection);
+    g_free(projection);
+    return 0;
+}
+
+GDALDatasetH create_georeferenced_geotiff(const char* path, int width, int height, GDALDataType data_type,
+                                          double no_data, const char* reference_path)
+{
+    GDALDatasetH dataset = create_geotiff(path, width, height, data_type, no_data, NULL, NULL);
+    if (dataset && apply_scaled_georeference(dataset, reference_path, width, height) != 0)
+    {
+        fprintf(stderr, "Plik %s zostanie zapisany bez georeferencji.\n", path);
+    }
+    return dataset;
+}
+
+GDALDatasetH create_geotiff(const char* path, int width, int height, GDALDataType data_type, double no_data,
+                            const double geo_transform[6], const char* projection)
+{
+    GDALDriverH driver = GDALGetDriverByName("GTiff");
+    char** options = CSLSetNameValue(NULL, "TILED", "YES");
+    options = CSLSetNameValue(options, "COMPRESS", "DEFLATE");
+    // Mozaika kilku kafli może przekroczyć 4 GB
+    options = CSLSetNameValue(options, "BIGTIFF", "IF_SAFER");
+    GDALDatasetH dataset = driver ? GDALCreate(driver, path, width, height, 1, data_type, options) : NULL;
+    CSLDestroy(options);
+
+    if (!dataset)
+    {
+        fprintf(stderr, "Nie można utworzyć pliku %s: %s\n", path, CPLGetLastErrorMsg());
+        return NULL;
+    }
+
+    if (geo_transform)
+    {
+        GDALSetGeoTransform(dataset, (double*)geo_transform);
+    }
+    if (projection)
+    {
+        GDALSetProjection(dataset, projection);
+    }
+    GDALSetRasterNoDataValue(GDALGetRasterBand(dataset, 1), no_data);
+    return dataset;
+}
+
 int validate_filename(const char* filename)
 {
     if (filename == NULL)
@@ -217,7 +555,7 @@ float* allocate_band_buffer(int width, int height, const char* filename)
 {
     size_t num_pixels = (size_t)width * height;
 
-    float* buffer = malloc(sizeof(float) * num_pixels);
+    float* buffer = raster_pool_acquire(num_pixels);
 
     if (!validate_buffer_allocation(buffer, num_pixels, filename))
     {
@@ -229,10 +567,7 @@ float* allocate_band_buffer(int width, int height, const char* filename)
 
 void cleanup_gdal_resources(GDALDatasetH dataset, float* buffer)
 {
-    if (buffer != NULL)
-    {
-        free(buffer);
-    }
+    raster_pool_release(buffer);
     if (dataset != NULL)
     {
         GDALClose(dataset);
@@ -246,6 +581,16 @@ CPLErr perform_raster_read(GDALRasterBandH band, float* buffer, int width, int h
                         0, 0);
 }
 
+size_t get_file_size(const char* filename)
+{
+    struct stat file_stat;
+    if (stat(filename, &file_stat) != 0)
+    {
+        return 0;
+    }
+    return (size_t)file_stat.st_size;
+}
+
 void set_output_dimensions(int* output_width, int* output_height, int width, int height)
 {
     if (output_width != NULL)
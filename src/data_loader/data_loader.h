@@ -1,5 +1,9 @@
 #ifndef DATA_LOADER_H
 #define DATA_LOADER_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <gdal.h>
 #include "../data_types/data_types.h"
 
 /**
@@ -15,29 +19,125 @@
  * @return Wskaźnik do zaalokowanej tablicy float zawierającej dane pikseli pasma,
  *         lub NULL w przypadku błędu (nieprawidłowy plik, błąd alokacji pamięci itp.)
  *
- * @note Zwrócona pamięć musi zostać zwolniona przez wywołującego przy użyciu free()
+ * @note Zwrócona pamięć musi zostać zwolniona przez wywołującego przy użyciu raster_pool_release()
  * @note Funkcja automatycznie wykrywa typ pasma na podstawie nazwy pliku i loguje postęp
  */
 float* LoadBandData(const char* pszFilename, int* pnXSize, int* pnYSize);
 /**
- * @brief Wczytuje dane dla wszystkich czterech pasm satelitarnych Sentinel-2
+ * @brief Wczytuje dane wybranych pasm satelitarnych Sentinel-2
  *
- * Funkcja iteruje przez tablicę struktur BandData i wczytuje dane dla każdego pasma
- * przy użyciu funkcji LoadBandData(). W przypadku błędu dla któregokolwiek pasma,
- * automatycznie zwalnia już wczytane dane i zwraca błąd.
+ * Funkcja wczytuje równolegle każde pasmo z band_mask przy użyciu funkcji LoadBandData().
+ * Pasma spoza maski nie są otwierane ani dekodowane, więc zbiór pasm wymaganych przez
+ * wybrane wskaźniki (pipeline_index_band_mask()) bezpośrednio ogranicza I/O i dekodowanie.
+ * W przypadku błędu dla któregokolwiek pasma, automatycznie zwalnia już wczytane dane i zwraca błąd.
  *
- * @param bands Tablica 4 struktur BandData zawierających informacje o pasmach do wczytania.
- *              Każda struktura musi zawierać:
+ * @param bands Tablica band_count struktur BandData. Każda wczytywana struktura musi zawierać:
  *              - Wskaźnik do ścieżki pliku (path)
  *              - Wskaźniki do zmiennych wymiarów (width, height)
  *              - Wskaźniki do buforów danych (raw_data, processed_data)
  *              - Nazwę pasma (band_name) do logowania
+ * @param band_mask Maska bitowa pasm do wczytania (bit i - bands[i])
+ * @param max_concurrency Maksymalna liczba pasm dekodowanych jednocześnie (1-band_count),
+ *                        ogranicza szczytową pamięć roboczą dekoderów JP2
  *
- * @return 0 w przypadku sukcesu (wszystkie pasma wczytane pomyślnie),
+ * Pasma, które mają już raw_data (np. z pamięci podręcznej etapów), nie są wczytywane ponownie.
+ *
+ * @return 0 w przypadku sukcesu (wszystkie pasma z maski wczytane pomyślnie),
  *         - -1 w przypadku błędu (brak ścieżki, błąd wczytywania lub alokacji pamięci)
+ */
+int load_bands_data(BandData* bands, int band_count, unsigned int band_mask, int max_concurrency);
+/**
+ * @brief Odczytuje wymiary rastra bez wczytywania danych pikseli
+ *
+ * Otwiera plik tylko po to, by pobrać GDALGetRasterXSize/YSize oraz wysokość bloku
+ * pierwszego pasma - używane do szacowania zapotrzebowania na pamięć przed przetwarzaniem.
+ *
+ * @param pnBlockYSize Wskaźnik na wysokość bloku (może być NULL)
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int read_band_dimensions(const char* pszFilename, int* pnXSize, int* pnYSize, int* pnBlockYSize);
+
+/**
+ * @brief Wczytuje pierwsze pasmo pliku bezpośrednio do bufora wywołującego
+ *
+ * Konwersję typu i krok wierszy obsługuje GDAL, więc dane nie są kopiowane przez bufor
+ * pośredni. Wymiary bufora muszą być równe wymiarom rastra (read_band_dimensions()).
+ *
+ * @param as_uint16 true - piksele uint16, false - float
+ * @param line_stride Odstęp w bajtach między początkami wierszy bufora
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int read_band_into_buffer(const char* pszFilename, void* buffer, int width, int height,
+                          bool as_uint16, size_t line_stride);
+
+/**
+ * @brief Wczytuje pierwsze pasmo pliku w zmniejszonej rozdzielczości (podgląd)
+ *
+ * Cały raster jest próbkowany do bufora width x height. Dla plików JPEG2000 GDAL dekoduje
+ * tylko najbliższy poziom rozdzielczości (overview), więc odczyt trwa ułamek pełnego dekodowania.
+ *
+ * @param buffer Bufor float na width * height pikseli
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int read_band_overview(const char* pszFilename, float* buffer, int width, int height);
+
+/**
+ * @brief Wczytuje etykiety stref (działek) na siatkę wyniku width x height
+ *
+ * Plik wektorowy (np. GeoPackage, Shapefile) jest rasteryzowany przez GDAL na siatkę
+ * wyniku: georeferencja brana jest z pasma reference_path i skalowana do width x height,
+ * a etykietą piksela jest wartość pola id_field wielokąta (warstwy w innym układzie
+ * współrzędnych są przeliczane). Plik rastrowy musi obejmować ten sam zasięg co scena;
+ * pierwsze pasmo jest próbkowane metodą najbliższego sąsiada do width x height jako uint32.
+ * Piksele poza wielokątami mają etykietę 0.
+ *
+ * @param reference_path Pasmo sceny z georeferencją (wymagane tylko dla pliku wektorowego)
+ * @return Bufor width * height etykiet do zwolnienia przez free() lub NULL w przypadku błędu
+ */
+uint32_t* read_zone_labels(const char* zones_path, const char* id_field, const char* reference_path,
+                           int width, int height);
+
+/**
+ * @brief Nadaje zbiorowi danych width x height georeferencję pasma reference_path
+ *
+ * Zasięg jest ten sam co pasma odniesienia, a rozmiar piksela przeskalowany do width x height
+ * (np. siatka 10m dla pasma 20m).
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy pasma nie można otworzyć lub nie ma georeferencji
+ */
+int apply_scaled_georeference(GDALDatasetH dataset, const char* reference_path, int width, int height);
+
+/**
+ * @brief Odczytuje georeferencję, którą apply_scaled_georeference() nadaje siatce width x height
+ *
+ * @param geo_transform Geotransformacja GDAL siatki (rozmiar piksela przeskalowany do width x height)
+ * @param projection_out Projekcja pasma (WKT) do zwolnienia przez g_free() lub NULL, gdy niepotrzebna
+ * @return 0 w przypadku sukcesu, -1 gdy pasma nie można otworzyć lub nie ma georeferencji
+ */
+int read_scaled_georeference(const char* reference_path, int width, int height, double geo_transform[6],
+                             char** projection_out);
+
+/**
+ * @brief Tworzy jednopasmowy GeoTIFF (kafelkowany, DEFLATE) do zapisu wyniku pasami wierszy
+ *
+ * Georeferencja pochodzi z pasma reference_path (apply_scaled_georeference()); gdy jej brak,
+ * plik powstaje bez niej, a błąd jest tylko zgłaszany.
+ *
+ * @param no_data Wartość brak danych pierwszego pasma
+ * @return Uchwyt zbioru danych do zamknięcia przez GDALClose() lub NULL w przypadku błędu
+ */
+GDALDatasetH create_georeferenced_geotiff(const char* path, int width, int height, GDALDataType data_type,
+                                          double no_data, const char* reference_path);
+
+/**
+ * @brief Tworzy jednopasmowy GeoTIFF jak create_georeferenced_geotiff(), z podaną georeferencją
+ *
+ * Dla siatek, które nie pokrywają się z żadnym pasmem (np. mozaika kilku kafli).
  *
- * @warning Zakłada, że tablica bands ma dokładnie 4 elementy
+ * @param geo_transform Geotransformacja GDAL lub NULL (plik bez georeferencji)
+ * @param projection Projekcja (WKT) lub NULL
  */
-int load_all_bands_data(BandData bands[4]);
+GDALDatasetH create_geotiff(const char* path, int width, int height, GDALDataType data_type, double no_data,
+                            const double geo_transform[6], const char* projection);
 
 #endif
@@ -1,6 +1,7 @@
 #include <gtk/gtk.h>
 #include <stdio.h>
 #include "data_saver.h"
+#include "../metrics/metrics.h"
 
 /**
  * @brief Saves a GdkPixbuf to a PNG file.
@@ -21,9 +22,14 @@ gboolean save_pixbuf_to_png(GdkPixbuf* pixbuf, const char* filename)
 
     g_print("Saving to file: %s\n", filename);
 
+    size_t num_pixels = (size_t)gdk_pixbuf_get_width(pixbuf) * gdk_pixbuf_get_height(pixbuf);
+    MetricsScope metrics_scope = metrics_stage_begin("export", "png");
+
     // Save the pixbuf to a PNG file
     gboolean result = gdk_pixbuf_save(pixbuf, filename, "png", &error, NULL);
 
+    metrics_stage_end(&metrics_scope, num_pixels * gdk_pixbuf_get_n_channels(pixbuf), 0, num_pixels);
+
     if (!result)
     {
         fprintf(stderr, "Error saving PNG '%s': %s\n", filename, error->message);
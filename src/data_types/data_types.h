@@ -11,12 +11,26 @@ typedef struct
     const char* band_name;
 } BandData;
 
+// Pozycje pasm w tablicach BandData - kolejność rejestru pasm (band_registry), SCL jako ostatnie
 enum BandType
 {
+    B01,
+    B02,
+    B03,
     B04,
+    B05,
+    B06,
+    B07,
     B08,
+    B8A,
+    B09,
+    B10,
     B11,
+    B12,
     SCL
 };
 
+// Liczba pasm produktu przetwarzanego przez pipeline (pozycje BandType, równa BAND_REGISTRY_COUNT)
+#define PIPELINE_BAND_COUNT 14
+
 #endif // DATA_TYPES_H
@@ -1,5 +1,4 @@
 #include <gtk/gtk.h>
-#include <gdal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -11,73 +10,117 @@
 #include "../resampler/resampler.h"
 #include "../utils/utils.h"
 #include "../processing_pipeline/processing_pipeline.h"
+#include "../pipeline_context/pipeline_context.h"
 #include "../visualization/visualization.h"
 #include "../data_saver/data_saver.h"
+#include "../metrics/metrics.h"
+#include "../raster_pool/raster_pool.h"
+#include "../stage_cache/stage_cache.h"
 
 #define DEFAULT_WINDOW_WIDTH 900
 #define DEFAULT_WINDOW_HEIGHT 750
 
+// Dłuższy bok podglądu - kilka poziomów rozdzielczości JPEG2000 poniżej pełnej sceny
+#define QUICKLOOK_MAX_DIMENSION 1024
+// Wysokość pasa, po którym mapa pełnej rozdzielczości jest odświeżana
+#define REFINE_STRIP_ROWS 512
+
+typedef struct RefineJob RefineJob;
+
 typedef struct
 {
     GtkApplication* app;
     ProcessingResult* map_data;
     GdkPixbuf* ndvi_pixbuf;
     GdkPixbuf* ndmi_pixbuf;
+    GdkPixbuf* ndvi_preview;
+    GdkPixbuf* ndmi_preview;
+    GtkWidget* drawing_area;
+    const char* map_type;
+    int width;
+    int height;
+    int refined_rows;
+    RefineJob* refine;
 } MapWindowData;
 
+/**
+ * @brief Dopracowanie mapy pełnej rozdzielczości w wątku roboczym
+ *
+ * Współdzielone przez wątek, okno mapy i oczekujące zdarzenia bezczynności - zwalniane przy
+ * ostatniej referencji, zawsze w wątku głównym. Wątek ma własny kontekst pipeline'u, więc nowe
+ * okno konfiguracji może działać, zanim przerwany wątek się zakończy.
+ */
+struct RefineJob
+{
+    gint refs;
+    gint cancelled;
+    PipelineContext* context;
+    GdkPixbuf* ndvi_pixbuf;
+    GdkPixbuf* ndmi_pixbuf;
+    char* save_filename_ndvi;
+    char* save_filename_ndmi;
+    ProcessingResult* result;
+    MapWindowData* window_data; // NULL po zamknięciu okna - dostęp tylko w wątku głównym
+};
+
+typedef struct
+{
+    RefineJob* job;
+    int y_end;
+} RefineRowsUpdate;
+
+// Stan okna konfiguracji - należy do okna i jest zwalniany razem z nim
+typedef struct
+{
+    GtkWindow* window;
+    PipelineContext* context;
+    gboolean save_results_to_file;
+    GtkWidget* entry_ndvi_filename;
+    GtkWidget* entry_ndmi_filename;
+} ConfigWindowState;
+
 typedef struct
 {
     const char* suffix;
     const char* prefix;
     const char* default_text;
+    int band;
 } BandConfig;
 
-// Dane pasma wyświetlane w GUI
+// Dane pasma wyświetlane w GUI - pasma NDVI i NDMI (pozycja BandType w polu band)
 const BandConfig band_configs[] = {
-    {"pasma B04", "B04: ", "Wczytaj pasmo B04"},
-    {"pasma B08", "B08: ", "Wczytaj pasmo B08"},
-    {"pasma B11", "B11: ", "Wczytaj pasmo B11"},
-    {"pasma SCL", "SCL: ", "Wczytaj pasmo SCL"},
-    {NULL, "Plik: ", "Wybierz plik"} // default
+    {"pasma B04", "B04: ", "Wczytaj pasmo B04", B04},
+    {"pasma B08", "B08: ", "Wczytaj pasmo B08", B08},
+    {"pasma B11", "B11: ", "Wczytaj pasmo B11", B11},
+    {"pasma SCL", "SCL: ", "Wczytaj pasmo SCL", SCL},
+    {NULL, "Plik: ", "Wybierz plik", -1} // default
 };
 
-// Zmienne globalne
-static char* path_b04 = NULL;
-static char* path_b08 = NULL;
-static char* path_b11 = NULL;
-static char* path_scl = NULL;
-static gboolean res_10m_selected = TRUE;
-char current_map_type[10] = "NDVI";
-
-static char* save_filename_ndvi = NULL;
-static char* save_filename_ndmi = NULL;
-static gboolean save_results_to_file = FALSE;
-
-static GtkWidget* btn_load_b04_widget = NULL;
-static GtkWidget* btn_load_b08_widget = NULL;
-static GtkWidget* btn_load_b11_widget = NULL;
-static GtkWidget* btn_load_scl_widget = NULL;
-
-static GtkWidget* entry_ndvi_filename_widget = NULL;
-static GtkWidget* entry_ndmi_filename_widget = NULL;
-static GtkWidget* check_save_results_widget = NULL;
-
 // Statyczny wskaźnik do okna konfiguracji
 static GtkWidget* the_config_window = NULL;
 
 // ====== GUI - GŁÓWNE FUNKCJE ======
 static void activate_config_window(GtkApplication* app);
-static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_data);
+static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_data,
+                                    const PipelineContext* context);
+static GtkWidget* build_map_window(GtkApplication* app, MapWindowData* window_data);
 static gboolean on_draw_map_area(GtkWidget* widget, cairo_t* cr, gpointer user_data);
 
+// ====== GUI - PODGLĄD I DOPRACOWANIE ======
+static GtkWidget* start_progressive_run(GtkApplication* app, const PipelineContext* context,
+                                        const char* save_filename_ndvi, const char* save_filename_ndmi);
+static gpointer refine_thread_main(gpointer data);
+static bool on_refine_strip_done(const ProcessingResult* partial, int y_start, int y_end, void* user_data);
+static gboolean on_refine_rows_ready(gpointer data);
+static gboolean on_refine_finished(gpointer data);
+static RefineJob* refine_job_ref(RefineJob* job);
+static void refine_job_unref(RefineJob* job);
+
 // ====== GUI - OBSŁUGA ZDARZEŃ ======
 static void on_config_window_destroy(GtkWidget* widget);
-static void on_load_b04_clicked(GtkWidget* widget, gpointer data);
-static void on_load_b08_clicked(GtkWidget* widget, gpointer data);
-static void on_load_b11_clicked(GtkWidget* widget, gpointer data);
-static void on_load_scl_clicked(GtkWidget* widget, gpointer data);
+static void on_load_band_clicked(GtkWidget* widget, gpointer user_data);
 static void on_rozpocznij_clicked(GtkWidget* widget, gpointer user_data);
-static void on_config_radio_resolution_toggled(GtkToggleButton* togglebutton);
+static void on_config_radio_resolution_toggled(GtkToggleButton* togglebutton, gpointer user_data);
 static void on_map_type_radio_toggled(GtkToggleButton* togglebutton, gpointer user_data);
 static void on_save_results_toggled(GtkToggleButton* toggle_button, gpointer user_data);
 
@@ -87,11 +130,18 @@ void update_file_selection(char** target_path_variable, GtkButton* button_to_upd
                            GtkFileChooser* file_chooser, const BandConfig* config);
 void handle_file_selection(GtkWindow* parent_window, const gchar* dialog_title_suffix,
                            char** target_path_variable, GtkButton* button_to_update);
+static PipelineContext* get_application_context(GtkApplication* app);
+static GdkPixbuf* render_index_map(const PipelineContext* context, const char* index_name,
+                                   const float* index_data, int width, int height);
+static char* map_cache_key(const PipelineContext* context, const char* index_name);
+static void cache_rendered_map(const PipelineContext* context, const char* index_name, GdkPixbuf* pixbuf);
 
 // ====== WALIDACJA ======
-static int validate_band_paths(BandData bands[], int band_count, GtkWindow* parent_window);
+static int validate_band_paths(BandData bands[], unsigned int band_mask, GtkWindow* parent_window);
 
 // ====== PAMIĘĆ ======
+static void config_window_state_destroy(gpointer data);
+static void pipeline_context_destroy(gpointer data);
 static void free_index_map_data(gpointer data);
 static void map_window_data_destroy(gpointer data);
 
@@ -118,6 +168,7 @@ static void activate_config_window(GtkApplication* app)
     GtkWidget* radio_hbox_config;
     GtkWidget* load_buttons_hbox;
     GtkWidget *radio_10m, *radio_20m;
+    GtkWidget* check_save_results;
     GtkWidget* btn_rozpocznij;
     GtkWidget* save_options_grid;
     GtkWidget* label_ndvi_filename;
@@ -131,6 +182,13 @@ static void activate_config_window(GtkApplication* app)
     the_config_window = config_window_local;
     g_signal_connect(the_config_window, "destroy", G_CALLBACK(on_config_window_destroy), NULL);
 
+    // Kontekst pipeline'u należy do aplikacji - nowe okno zachowuje wybrane pasma i rozdzielczość,
+    // więc kolejny przebieg liczy tylko etapy zależne od zmienionych opcji (pamięć podręczna etapów)
+    ConfigWindowState* state = g_new0(ConfigWindowState, 1);
+    state->window = GTK_WINDOW(config_window_local);
+    state->context = get_application_context(app);
+    g_object_set_data_full(G_OBJECT(config_window_local), "config_state", state, config_window_state_destroy);
+
     main_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
     gtk_container_add(GTK_CONTAINER(config_window_local), main_vbox);
 
@@ -139,39 +197,38 @@ static void activate_config_window(GtkApplication* app)
     gtk_box_pack_start(GTK_BOX(main_vbox), radio_hbox_config, FALSE, FALSE, 0);
 
     radio_10m = gtk_radio_button_new_with_label(NULL, "upscaling do 10m");
-    g_signal_connect(radio_10m, "toggled", G_CALLBACK(on_config_radio_resolution_toggled), NULL);
+    g_signal_connect(radio_10m, "toggled", G_CALLBACK(on_config_radio_resolution_toggled), state);
     gtk_box_pack_start(GTK_BOX(radio_hbox_config), radio_10m, FALSE, FALSE, 0);
 
     radio_20m = gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(radio_10m), "downscaling do 20m");
-    g_signal_connect(radio_20m, "toggled", G_CALLBACK(on_config_radio_resolution_toggled), NULL);
+    g_signal_connect(radio_20m, "toggled", G_CALLBACK(on_config_radio_resolution_toggled), state);
     gtk_box_pack_start(GTK_BOX(radio_hbox_config), radio_20m, FALSE, FALSE, 0);
-    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(radio_10m), TRUE);
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(state->context && !state->context->target_10m ? radio_20m : radio_10m),
+                                 TRUE);
 
     load_buttons_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
     gtk_box_set_homogeneous(GTK_BOX(load_buttons_hbox), TRUE);
     gtk_box_pack_start(GTK_BOX(main_vbox), load_buttons_hbox, FALSE, FALSE, 0);
 
-    btn_load_b04_widget = create_button_with_ellipsis("Wczytaj pasmo B04");
-    g_signal_connect(btn_load_b04_widget, "clicked", G_CALLBACK(on_load_b04_clicked), config_window_local);
-    gtk_box_pack_start(GTK_BOX(load_buttons_hbox), btn_load_b04_widget, TRUE, TRUE, 0);
-
-    btn_load_b08_widget = create_button_with_ellipsis("Wczytaj pasmo B08");
-    g_signal_connect(btn_load_b08_widget, "clicked", G_CALLBACK(on_load_b08_clicked), config_window_local);
-    gtk_box_pack_start(GTK_BOX(load_buttons_hbox), btn_load_b08_widget, TRUE, TRUE, 0);
-
-    btn_load_b11_widget = create_button_with_ellipsis("Wczytaj pasmo B11");
-    g_signal_connect(btn_load_b11_widget, "clicked", G_CALLBACK(on_load_b11_clicked), config_window_local);
-    gtk_box_pack_start(GTK_BOX(load_buttons_hbox), btn_load_b11_widget, TRUE, TRUE, 0);
-
-    btn_load_scl_widget = create_button_with_ellipsis("Wczytaj pasmo SCL");
-    g_signal_connect(btn_load_scl_widget, "clicked", G_CALLBACK(on_load_scl_clicked), config_window_local);
-    gtk_box_pack_start(GTK_BOX(load_buttons_hbox), btn_load_scl_widget, TRUE, TRUE, 0);
+    // Przyciski pasm w kolejności B04, B08, B11, SCL - indeks w band_configs zapisany w danych przycisku
+    for (int i = 0; band_configs[i].suffix != NULL; i++)
+    {
+        int band = band_configs[i].band;
+        GtkWidget* btn_load_band = create_button_with_ellipsis(band_configs[i].default_text);
+        g_object_set_data(G_OBJECT(btn_load_band), "band_config", GINT_TO_POINTER(i));
+        g_signal_connect(btn_load_band, "clicked", G_CALLBACK(on_load_band_clicked), state);
+        if (state->context && state->context->paths[band])
+        {
+            update_button_label(GTK_BUTTON(btn_load_band), state->context->paths[band], band_configs[i].prefix);
+        }
+        gtk_box_pack_start(GTK_BOX(load_buttons_hbox), btn_load_band, TRUE, TRUE, 0);
+    }
 
     // Checkbox do włączenia zapisu
-    check_save_results_widget = gtk_check_button_new_with_label("Zapisz wyniki do plików PNG");
-    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(check_save_results_widget), save_results_to_file);
-    g_signal_connect(check_save_results_widget, "toggled", G_CALLBACK(on_save_results_toggled), NULL);
-    gtk_box_pack_start(GTK_BOX(main_vbox), check_save_results_widget, FALSE, FALSE, 5);
+    check_save_results = gtk_check_button_new_with_label("Zapisz wyniki do plików PNG");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(check_save_results), state->save_results_to_file);
+    g_signal_connect(check_save_results, "toggled", G_CALLBACK(on_save_results_toggled), state);
+    gtk_box_pack_start(GTK_BOX(main_vbox), check_save_results, FALSE, FALSE, 5);
 
     // Użyjemy GtkGrid dla lepszego wyrównania etykiet i pól tekstowych
     save_options_grid = gtk_grid_new();
@@ -184,24 +241,24 @@ static void activate_config_window(GtkApplication* app)
     gtk_widget_set_halign(label_ndvi_filename, GTK_ALIGN_START);
     gtk_grid_attach(GTK_GRID(save_options_grid), label_ndvi_filename, 0, 0, 1, 1);
 
-    entry_ndvi_filename_widget = gtk_entry_new();
-    gtk_entry_set_text(GTK_ENTRY(entry_ndvi_filename_widget), "ndvi_output.png");
-    gtk_widget_set_hexpand(entry_ndvi_filename_widget, TRUE);
-    gtk_grid_attach(GTK_GRID(save_options_grid), entry_ndvi_filename_widget, 1, 0, 1, 1);
+    state->entry_ndvi_filename = gtk_entry_new();
+    gtk_entry_set_text(GTK_ENTRY(state->entry_ndvi_filename), "ndvi_output.png");
+    gtk_widget_set_hexpand(state->entry_ndvi_filename, TRUE);
+    gtk_grid_attach(GTK_GRID(save_options_grid), state->entry_ndvi_filename, 1, 0, 1, 1);
 
     // Pole na nazwę pliku NDMI
     label_ndmi_filename = gtk_label_new("Nazwa pliku NDMI:");
     gtk_widget_set_halign(label_ndmi_filename, GTK_ALIGN_START);
     gtk_grid_attach(GTK_GRID(save_options_grid), label_ndmi_filename, 0, 1, 1, 1);
 
-    entry_ndmi_filename_widget = gtk_entry_new();
-    gtk_entry_set_text(GTK_ENTRY(entry_ndmi_filename_widget), "ndmi_output.png");
-    gtk_widget_set_hexpand(entry_ndmi_filename_widget, TRUE);
-    gtk_grid_attach(GTK_GRID(save_options_grid), entry_ndmi_filename_widget, 1, 1, 1, 1);
+    state->entry_ndmi_filename = gtk_entry_new();
+    gtk_entry_set_text(GTK_ENTRY(state->entry_ndmi_filename), "ndmi_output.png");
+    gtk_widget_set_hexpand(state->entry_ndmi_filename, TRUE);
+    gtk_grid_attach(GTK_GRID(save_options_grid), state->entry_ndmi_filename, 1, 1, 1, 1);
 
     // Ustawienie początkowej czułości pól tekstowych
-    gtk_widget_set_sensitive(entry_ndvi_filename_widget, save_results_to_file);
-    gtk_widget_set_sensitive(entry_ndmi_filename_widget, save_results_to_file);
+    gtk_widget_set_sensitive(state->entry_ndvi_filename, state->save_results_to_file);
+    gtk_widget_set_sensitive(state->entry_ndmi_filename, state->save_results_to_file);
 
     btn_rozpocznij = gtk_button_new_with_label("Rozpocznij");
     g_signal_connect(btn_rozpocznij, "clicked", G_CALLBACK(on_rozpocznij_clicked), config_window_local);
@@ -211,28 +268,24 @@ static void activate_config_window(GtkApplication* app)
     gtk_widget_show_all(config_window_local);
 }
 
-static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_data)
+static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_data,
+                                    const PipelineContext* context)
 {
-    // Tworzenie okna
-    GtkWidget* map_window = gtk_application_window_new(app);
-    gtk_window_set_title(GTK_WINDOW(map_window), "Wynikowa Mapa Wskaźników");
-    gtk_window_set_default_size(GTK_WINDOW(map_window), DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
-    gtk_container_set_border_width(GTK_CONTAINER(map_window), 10);
-
     // Enkapsulacja danych okna z automatycznym cleanup
     MapWindowData* window_data = g_new0(MapWindowData, 1);
     window_data->app = app;
     window_data->map_data = map_data;
+    window_data->map_type = "NDVI";
 
-    if (map_data && map_data->ndvi_data)
+    if (map_data && map_data->index_data[NDVI])
     {
-        window_data->ndvi_pixbuf = generate_pixbuf_from_index_data(map_data->ndvi_data, map_data->width,
-                                                                   map_data->height);
+        window_data->ndvi_pixbuf = render_index_map(context, "NDVI", map_data->index_data[NDVI], map_data->width,
+                                                    map_data->height);
     }
-    if (map_data && map_data->ndmi_data)
+    if (map_data && map_data->index_data[NDMI])
     {
-        window_data->ndmi_pixbuf = generate_pixbuf_from_index_data(map_data->ndmi_data, map_data->width,
-                                                                   map_data->height);
+        window_data->ndmi_pixbuf = render_index_map(context, "NDMI", map_data->index_data[NDMI], map_data->width,
+                                                    map_data->height);
     }
 
     if (!window_data->ndvi_pixbuf || !window_data->ndmi_pixbuf)
@@ -241,10 +294,25 @@ static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_d
         if (window_data->ndvi_pixbuf) g_object_unref(window_data->ndvi_pixbuf);
         if (window_data->ndmi_pixbuf) g_object_unref(window_data->ndmi_pixbuf);
         g_free(window_data);
-        gtk_widget_destroy(map_window);
         return NULL;
     }
 
+    window_data->width = map_data->width;
+    window_data->height = map_data->height;
+    window_data->refined_rows = map_data->height;
+
+    return build_map_window(app, window_data);
+}
+
+// Tworzy okno mapy dla przygotowanych danych - okno przejmuje window_data
+static GtkWidget* build_map_window(GtkApplication* app, MapWindowData* window_data)
+{
+    // Tworzenie okna
+    GtkWidget* map_window = gtk_application_window_new(app);
+    gtk_window_set_title(GTK_WINDOW(map_window), "Wynikowa Mapa Wskaźników");
+    gtk_window_set_default_size(GTK_WINDOW(map_window), DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+    gtk_container_set_border_width(GTK_CONTAINER(map_window), 10);
+
     g_object_set_data_full(G_OBJECT(map_window), "window_data",
                            window_data, map_window_data_destroy);
 
@@ -263,7 +331,8 @@ static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_d
 
     // Drawing area
     GtkWidget* drawing_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(drawing_area, map_data->width, map_data->height);
+    gtk_widget_set_size_request(drawing_area, window_data->width, window_data->height);
+    window_data->drawing_area = drawing_area;
 
     // Przypisanie danych do drawing_area (dla funkcji rysowania)
     g_signal_connect(drawing_area, "draw", G_CALLBACK(on_draw_map_area), window_data);
@@ -271,14 +340,14 @@ static GtkWidget* create_map_window(GtkApplication* app, ProcessingResult* map_d
     // Radio buttons
     GtkWidget* radio_ndmi = gtk_radio_button_new_with_label(NULL, "NDMI");
     gtk_box_pack_start(GTK_BOX(radio_hbox), radio_ndmi, FALSE, FALSE, 0);
-    g_signal_connect(radio_ndmi, "toggled", G_CALLBACK(on_map_type_radio_toggled), drawing_area);
+    g_signal_connect(radio_ndmi, "toggled", G_CALLBACK(on_map_type_radio_toggled), window_data);
 
     GtkWidget* radio_ndvi = gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(radio_ndmi), "NDVI");
     gtk_box_pack_start(GTK_BOX(radio_hbox), radio_ndvi, FALSE, FALSE, 0);
-    g_signal_connect(radio_ndvi, "toggled", G_CALLBACK(on_map_type_radio_toggled), drawing_area);
+    g_signal_connect(radio_ndvi, "toggled", G_CALLBACK(on_map_type_radio_toggled), window_data);
 
     // Ustawienie domyślnego wyboru
-    if (strcmp(current_map_type, "NDVI") == 0)
+    if (strcmp(window_data->map_type, "NDVI") == 0)
     {
         gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(radio_ndvi), TRUE);
     }
@@ -303,7 +372,7 @@ static gboolean on_draw_map_area(GtkWidget* widget, cairo_t* cr, gpointer user_d
 {
     MapWindowData* win_data = (MapWindowData*)user_data;
 
-    if (!win_data || !win_data->map_data)
+    if (!win_data || (!win_data->map_data && !win_data->refine))
     {
         g_printerr("[%s] Błąd krytyczny w on_draw_map_area: brak danych okna lub mapy.\n", get_timestamp());
         cairo_set_source_rgb(cr, 0.5, 0.0, 0.5);
@@ -312,19 +381,35 @@ static gboolean on_draw_map_area(GtkWidget* widget, cairo_t* cr, gpointer user_d
     }
 
     GdkPixbuf* pixbuf_to_draw = NULL;
-    if (strcmp(current_map_type, "NDVI") == 0)
+    GdkPixbuf* preview_to_draw = NULL;
+    if (strcmp(win_data->map_type, "NDVI") == 0)
     {
         pixbuf_to_draw = win_data->ndvi_pixbuf;
+        preview_to_draw = win_data->ndvi_preview;
     }
     else
     {
         pixbuf_to_draw = win_data->ndmi_pixbuf;
+        preview_to_draw = win_data->ndmi_preview;
     }
 
-    if (pixbuf_to_draw)
+    // Podgląd rozciągnięty do wymiarów sceny pod jeszcze niedopracowanymi wierszami
+    if (preview_to_draw && win_data->refined_rows < win_data->height)
     {
-        gdk_cairo_set_source_pixbuf(cr, pixbuf_to_draw, 0, 0);
+        cairo_save(cr);
+        cairo_scale(cr, (double)win_data->width / gdk_pixbuf_get_width(preview_to_draw),
+                    (double)win_data->height / gdk_pixbuf_get_height(preview_to_draw));
+        gdk_cairo_set_source_pixbuf(cr, preview_to_draw, 0, 0);
         cairo_paint(cr);
+        cairo_restore(cr);
+    }
+
+    // Wiersze poniżej refined_rows mogą być w trakcie zapisu przez wątek roboczy - rysowany jest tylko gotowy pas
+    if (pixbuf_to_draw && win_data->refined_rows > 0)
+    {
+        gdk_cairo_set_source_pixbuf(cr, pixbuf_to_draw, 0, 0);
+        cairo_rectangle(cr, 0, 0, win_data->width, win_data->refined_rows);
+        cairo_fill(cr);
     }
     return TRUE;
 }
@@ -334,62 +419,238 @@ int run_gui(int argc, char* argv[])
     GtkApplication* app;
     int status;
 
-    GDALAllRegister();
+    pipeline_global_init();
 
     app = gtk_application_new("org.projekt.sentinelgui", G_APPLICATION_FLAGS_NONE);
     g_signal_connect(app, "activate", G_CALLBACK(activate_config_window), NULL);
     status = g_application_run(G_APPLICATION(app), argc, argv);
     g_object_unref(app);
-    GDALDestroyDriverManager();
-
-    if (path_b04) g_free(path_b04);
-    if (path_b08) g_free(path_b08);
-    if (path_b11) g_free(path_b11);
-    if (path_scl) g_free(path_scl);
 
     g_print("Aplikacja zakończona, status: %d\n", status);
     return status;
 }
 
-// ====== IMPLEMENTACJE - OBSŁUGA ZDARZEŃ ======
+// ====== IMPLEMENTACJE - PODGLĄD I DOPRACOWANIE ======
 
-static void on_config_window_destroy(GtkWidget* widget)
+// Pokazuje podgląd ze zmniejszonych poziomów rozdzielczości i uruchamia wątek liczący pełną rozdzielczość pasami
+static GtkWidget* start_progressive_run(GtkApplication* app, const PipelineContext* context,
+                                        const char* save_filename_ndvi, const char* save_filename_ndmi)
 {
-    if (the_config_window == widget)
+    RefineJob* job = g_new0(RefineJob, 1);
+    job->refs = 1;
+    job->context = pipeline_context_new("GUI");
+    if (!job->context)
     {
-        the_config_window = NULL;
+        refine_job_unref(job);
+        return NULL;
     }
+    job->context->target_10m = context->target_10m;
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        pipeline_context_set_band_path(job->context, i, context->paths[i]);
+    }
+    job->save_filename_ndvi = g_strdup(save_filename_ndvi);
+    job->save_filename_ndmi = g_strdup(save_filename_ndmi);
+
+    int width = 0, height = 0;
+    ProcessingResult* preview = process_bands_quicklook(job->context->bands, job->context->target_10m,
+                                                        QUICKLOOK_MAX_DIMENSION, &width, &height);
+    if (!preview)
+    {
+        refine_job_unref(job);
+        return NULL;
+    }
+
+    // Mapy pełnej rozdzielczości wypełniane pasami przez wątek roboczy
+    job->ndvi_pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+    job->ndmi_pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+
+    MapWindowData* window_data = g_new0(MapWindowData, 1);
+    window_data->app = app;
+    window_data->map_type = "NDVI";
+    window_data->width = width;
+    window_data->height = height;
+    window_data->ndvi_preview = generate_pixbuf_from_index_data(preview->index_data[NDVI], preview->width,
+                                                               preview->height);
+    window_data->ndmi_preview = generate_pixbuf_from_index_data(preview->index_data[NDMI], preview->width,
+                                                               preview->height);
+    free_index_map_data(preview);
+
+    if (!job->ndvi_pixbuf || !job->ndmi_pixbuf || !window_data->ndvi_preview || !window_data->ndmi_preview)
+    {
+        g_printerr("[%s] Nie udało się utworzyć pixbufów podglądu.\n", get_timestamp());
+        map_window_data_destroy(window_data);
+        refine_job_unref(job);
+        return NULL;
+    }
+
+    window_data->ndvi_pixbuf = g_object_ref(job->ndvi_pixbuf);
+    window_data->ndmi_pixbuf = g_object_ref(job->ndmi_pixbuf);
+    window_data->refine = refine_job_ref(job);
+    job->window_data = window_data;
+
+    GtkWidget* map_window = build_map_window(app, window_data);
+
+    // Referencja wywołującego przechodzi na wątek roboczy
+    GThread* thread = g_thread_new("dopracowanie-mapy", refine_thread_main, job);
+    g_thread_unref(thread);
+    return map_window;
 }
 
-static void on_load_b04_clicked(GtkWidget* widget, gpointer data)
+static gpointer refine_thread_main(gpointer data)
 {
-    handle_file_selection(GTK_WINDOW(data), "pasma B04", &path_b04, GTK_BUTTON(widget));
+    RefineJob* job = data;
+
+    job->result = process_bands_progressive(job->context->bands, job->context->target_10m, REFINE_STRIP_ROWS,
+                                            on_refine_strip_done, job);
+
+    // Zakończenie obsługuje wątek główny - przejmuje referencję wątku roboczego
+    g_idle_add(on_refine_finished, job);
+    return NULL;
+}
+
+// Wątek roboczy: koloruje ukończony pas i zgłasza go wątkowi głównemu
+static bool on_refine_strip_done(const ProcessingResult* partial, int y_start, int y_end, void* user_data)
+{
+    RefineJob* job = user_data;
+    if (g_atomic_int_get(&job->cancelled))
+    {
+        return false;
+    }
+
+    render_index_rows_to_pixbuf(job->ndvi_pixbuf, partial->index_data[NDVI], y_start, y_end);
+    render_index_rows_to_pixbuf(job->ndmi_pixbuf, partial->index_data[NDMI], y_start, y_end);
+
+    RefineRowsUpdate* update = g_new0(RefineRowsUpdate, 1);
+    update->job = refine_job_ref(job);
+    update->y_end = y_end;
+    g_idle_add(on_refine_rows_ready, update);
+    return true;
 }
 
-static void on_load_b08_clicked(GtkWidget* widget, gpointer data)
+static gboolean on_refine_rows_ready(gpointer data)
 {
-    handle_file_selection(GTK_WINDOW(data), "pasma B08", &path_b08, GTK_BUTTON(widget));
+    RefineRowsUpdate* update = data;
+    MapWindowData* window_data = update->job->window_data;
+
+    if (window_data && update->y_end > window_data->refined_rows)
+    {
+        window_data->refined_rows = update->y_end;
+        gtk_widget_queue_draw(window_data->drawing_area);
+    }
+
+    refine_job_unref(update->job);
+    g_free(update);
+    return G_SOURCE_REMOVE;
 }
 
-static void on_load_b11_clicked(GtkWidget* widget, gpointer data)
+static gboolean on_refine_finished(gpointer data)
 {
-    handle_file_selection(GTK_WINDOW(data), "pasma B11", &path_b11, GTK_BUTTON(widget));
+    RefineJob* job = data;
+    MapWindowData* window_data = job->window_data;
+
+    if (!job->result)
+    {
+        metrics_end_run(g_atomic_int_get(&job->cancelled) ? "cancelled" : "error");
+        if (window_data)
+        {
+            g_printerr("[%s] Wystąpił błąd podczas przetwarzania pełnej rozdzielczości.\n", get_timestamp());
+            show_error_dialog(GTK_WINDOW(gtk_widget_get_toplevel(window_data->drawing_area)),
+                              "Błąd podczas przetwarzania danych. Widoczny jest tylko podgląd.");
+        }
+        refine_job_unref(job);
+        return G_SOURCE_REMOVE;
+    }
+
+    cache_rendered_map(job->context, "NDVI", job->ndvi_pixbuf);
+    cache_rendered_map(job->context, "NDMI", job->ndmi_pixbuf);
+
+    if (window_data)
+    {
+        // Okno przejmuje pełny wynik, podgląd nie jest już potrzebny
+        window_data->map_data = job->result;
+        job->result = NULL;
+        window_data->refined_rows = window_data->height;
+        g_clear_object(&window_data->ndvi_preview);
+        g_clear_object(&window_data->ndmi_preview);
+        gtk_widget_queue_draw(window_data->drawing_area);
+
+        if (job->save_filename_ndvi && job->save_filename_ndmi)
+        {
+            save_pixbuf_to_png(job->ndvi_pixbuf, job->save_filename_ndvi);
+            save_pixbuf_to_png(job->ndmi_pixbuf, job->save_filename_ndmi);
+        }
+    }
+
+    metrics_end_run("ok");
+    g_print("[%s] Mapa pełnej rozdzielczości gotowa.\n", get_timestamp());
+    refine_job_unref(job);
+    return G_SOURCE_REMOVE;
 }
 
-static void on_load_scl_clicked(GtkWidget* widget, gpointer data)
+static RefineJob* refine_job_ref(RefineJob* job)
 {
-    handle_file_selection(GTK_WINDOW(data), "pasma SCL", &path_scl, GTK_BUTTON(widget));
+    g_atomic_int_inc(&job->refs);
+    return job;
+}
+
+static void refine_job_unref(RefineJob* job)
+{
+    if (!job || !g_atomic_int_dec_and_test(&job->refs))
+    {
+        return;
+    }
+
+    if (job->result)
+    {
+        free_index_map_data(job->result);
+    }
+    if (job->ndvi_pixbuf) g_object_unref(job->ndvi_pixbuf);
+    if (job->ndmi_pixbuf) g_object_unref(job->ndmi_pixbuf);
+    pipeline_context_free(job->context);
+    g_free(job->save_filename_ndvi);
+    g_free(job->save_filename_ndmi);
+    g_free(job);
+}
+
+// ====== IMPLEMENTACJE - OBSŁUGA ZDARZEŃ ======
+
+static void on_config_window_destroy(GtkWidget* widget)
+{
+    if (the_config_window == widget)
+    {
+        the_config_window = NULL;
+    }
+}
+
+static void on_load_band_clicked(GtkWidget* widget, gpointer user_data)
+{
+    ConfigWindowState* state = user_data;
+    const BandConfig* config = &band_configs[GPOINTER_TO_INT(g_object_get_data(G_OBJECT(widget), "band_config"))];
+
+    handle_file_selection(state->window, config->suffix, &state->context->paths[config->band],
+                          GTK_BUTTON(widget));
 }
 
 static void on_rozpocznij_clicked(GtkWidget* widget, gpointer user_data)
 {
     GtkWidget* config_window_widget = GTK_WIDGET(user_data);
     GtkWindow* parent_gtk_window = GTK_WINDOW(user_data);
+    ConfigWindowState* state = g_object_get_data(G_OBJECT(config_window_widget), "config_state");
+    PipelineContext* context = state->context;
+    char* save_filename_ndvi = NULL;
+    char* save_filename_ndmi = NULL;
+
+    if (!context)
+    {
+        show_error_dialog(parent_gtk_window, "Błąd: Nie można zaalokować kontekstu przetwarzania.");
+        return;
+    }
 
-    if (save_results_to_file)
+    if (state->save_results_to_file)
     {
-        const char* ndvi_filename_text = gtk_entry_get_text(GTK_ENTRY(entry_ndvi_filename_widget));
-        const char* ndmi_filename_text = gtk_entry_get_text(GTK_ENTRY(entry_ndmi_filename_widget));
+        const char* ndvi_filename_text = gtk_entry_get_text(GTK_ENTRY(state->entry_ndvi_filename));
+        const char* ndmi_filename_text = gtk_entry_get_text(GTK_ENTRY(state->entry_ndmi_filename));
 
         if (strlen(ndvi_filename_text) == 0 || strlen(ndmi_filename_text) == 0)
         {
@@ -397,59 +658,60 @@ static void on_rozpocznij_clicked(GtkWidget* widget, gpointer user_data)
                               "Jeśli zaznaczono opcję zapisu, nazwy plików NDVI i NDMI nie mogą być puste.");
             return;
         }
-        // Zwolnij stare nazwy, jeśli istnieją
-        if (save_filename_ndvi) g_free(save_filename_ndvi);
         save_filename_ndvi = g_strdup(ndvi_filename_text);
-
-        if (save_filename_ndmi) g_free(save_filename_ndmi);
         save_filename_ndmi = g_strdup(ndmi_filename_text);
     }
-    else
-    {
-        // Jeśli zapis nie jest włączony, upewnij się, że wskaźniki są NULL
-        if (save_filename_ndvi) g_free(save_filename_ndvi);
-        save_filename_ndvi = NULL;
-        if (save_filename_ndmi) g_free(save_filename_ndmi);
-        save_filename_ndmi = NULL;
-    }
-
-    // Przygotowanie danych pasm
-    int widths[4], heights[4];
-    float* raw_data[4] = {NULL};
-    float* processed_data[4] = {NULL};
-
-    BandData bands[4] = {
-        {&path_b04, &raw_data[0], &processed_data[0], &widths[0], &heights[0], "B04"},
-        {&path_b08, &raw_data[1], &processed_data[1], &widths[1], &heights[1], "B08"},
-        {&path_b11, &raw_data[2], &processed_data[2], &widths[2], &heights[2], "B11"},
-        {&path_scl, &raw_data[3], &processed_data[3], &widths[3], &heights[3], "SCL"}
-    };
 
     // Walidacja ścieżek plików
-    if (!validate_band_paths(bands, 4, parent_gtk_window))
+    if (!validate_band_paths(context->bands, pipeline_index_band_mask(context->indices), parent_gtk_window))
     {
+        g_free(save_filename_ndvi);
+        g_free(save_filename_ndmi);
         return;
     }
 
     g_print("[%s] Rozpoczynanie przetwarzania danych pasm.\n", get_timestamp());
+    metrics_begin_run(context->target_10m ? "10m" : "20m");
+    GtkApplication* app = gtk_window_get_application(GTK_WINDOW(config_window_widget));
+
+    // Bez wyników w pamięci podręcznej: od razu podgląd, pełna rozdzielczość dopracowywana w tle
+    if (!pipeline_indices_cached(context->bands, context->target_10m))
+    {
+        GtkWidget* progressive_window = start_progressive_run(app, context, save_filename_ndvi, save_filename_ndmi);
+        if (progressive_window)
+        {
+            gtk_widget_show_all(progressive_window);
+            gtk_widget_destroy(config_window_widget);
+        }
+        else
+        {
+            metrics_end_run("error");
+            show_error_dialog(parent_gtk_window, "Błąd podczas tworzenia podglądu. Sprawdź konsolę dla szczegółów.");
+        }
+        g_free(save_filename_ndvi);
+        g_free(save_filename_ndmi);
+        return;
+    }
 
     // Przetwarzanie przez pipeline
-    ProcessingResult* processing_result = process_bands_and_calculate_indices(bands, res_10m_selected);
+    ProcessingResult* processing_result = pipeline_context_run(context);
 
     if (!processing_result)
     {
+        metrics_end_run("error");
         g_printerr("[%s] Wystąpił błąd podczas przetwarzania danych.\n", get_timestamp());
         show_error_dialog(parent_gtk_window, "Błąd podczas przetwarzania danych. Sprawdź konsolę dla szczegółów.");
+        g_free(save_filename_ndvi);
+        g_free(save_filename_ndmi);
         return;
     }
 
     // Tworzenie okna mapy
-    GtkApplication* app = gtk_window_get_application(GTK_WINDOW(config_window_widget));
-    GtkWidget* map_window = create_map_window(app, processing_result);
+    GtkWidget* map_window = create_map_window(app, processing_result, context);
 
     if (map_window)
     {
-        if (save_results_to_file && save_filename_ndvi && save_filename_ndmi)
+        if (save_filename_ndvi && save_filename_ndmi)
         {
             MapWindowData* window_data = g_object_get_data(G_OBJECT(map_window), "window_data");
             if (window_data)
@@ -462,24 +724,31 @@ static void on_rozpocznij_clicked(GtkWidget* widget, gpointer user_data)
                 g_printerr("[%s] Nie można pobrać window_data do zapisu pixbufów.\n", get_timestamp());
             }
         }
+        metrics_end_run("ok");
         g_print("[%s] Pomyślnie utworzono okno mapy.\n", get_timestamp());
         gtk_widget_show_all(map_window);
         gtk_widget_destroy(config_window_widget);
     }
     else
     {
+        metrics_end_run("error");
         g_printerr("[%s] Błąd podczas tworzenia okna mapy.\n", get_timestamp());
         show_error_dialog(parent_gtk_window, "Błąd podczas tworzenia okna mapy.");
         free_index_map_data(processing_result);
     }
+
+    g_free(save_filename_ndvi);
+    g_free(save_filename_ndmi);
 }
 
-static void on_config_radio_resolution_toggled(GtkToggleButton* togglebutton)
+static void on_config_radio_resolution_toggled(GtkToggleButton* togglebutton, gpointer user_data)
 {
-    if (gtk_toggle_button_get_active(togglebutton))
+    ConfigWindowState* state = user_data;
+
+    if (gtk_toggle_button_get_active(togglebutton) && state->context)
     {
         const gchar* label = gtk_button_get_label(GTK_BUTTON(togglebutton));
-        res_10m_selected = g_str_has_prefix(label, "upscaling") ? TRUE : FALSE;
+        state->context->target_10m = g_str_has_prefix(label, "upscaling");
     }
 }
 
@@ -487,17 +756,11 @@ static void on_map_type_radio_toggled(GtkToggleButton* togglebutton, gpointer us
 {
     if (gtk_toggle_button_get_active(togglebutton))
     {
-        GtkWidget* drawing_area = GTK_WIDGET(user_data);
+        MapWindowData* window_data = user_data;
+        GtkWidget* drawing_area = window_data->drawing_area;
         const gchar* label = gtk_button_get_label(GTK_BUTTON(togglebutton));
 
-        if (g_strcmp0(label, "NDVI") == 0)
-        {
-            strcpy(current_map_type, "NDVI");
-        }
-        else
-        {
-            strcpy(current_map_type, "NDMI");
-        }
+        window_data->map_type = g_strcmp0(label, "NDVI") == 0 ? "NDVI" : "NDMI";
 
         if (GTK_IS_WIDGET(drawing_area) && gtk_widget_get_realized(drawing_area) &&
             gtk_widget_get_visible(drawing_area))
@@ -509,11 +772,12 @@ static void on_map_type_radio_toggled(GtkToggleButton* togglebutton, gpointer us
 
 static void on_save_results_toggled(GtkToggleButton* toggle_button, gpointer user_data)
 {
-    save_results_to_file = gtk_toggle_button_get_active(toggle_button);
+    ConfigWindowState* state = user_data;
+    state->save_results_to_file = gtk_toggle_button_get_active(toggle_button);
 
     // Włącz lub wyłącz pola tekstowe nazw plików w zależności od stanu checkboxa
-    gtk_widget_set_sensitive(entry_ndvi_filename_widget, save_results_to_file);
-    gtk_widget_set_sensitive(entry_ndmi_filename_widget, save_results_to_file);
+    gtk_widget_set_sensitive(state->entry_ndvi_filename, state->save_results_to_file);
+    gtk_widget_set_sensitive(state->entry_ndmi_filename, state->save_results_to_file);
 }
 
 // ====== IMPLEMENTACJE - POMOCNICZE ======
@@ -577,13 +841,75 @@ void handle_file_selection(GtkWindow* parent_window, const gchar* dialog_title_s
 }
 
 
+// Kontekst pipeline'u wspólny dla kolejnych okien konfiguracji, zwalniany razem z aplikacją
+static PipelineContext* get_application_context(GtkApplication* app)
+{
+    PipelineContext* context = g_object_get_data(G_OBJECT(app), "pipeline_context");
+    if (!context)
+    {
+        context = pipeline_context_new("GUI");
+        if (context)
+        {
+            // Okno map pokazuje NDVI i NDMI niezależnie od --indices
+            context->indices = PIPELINE_INDEX_DEFAULT;
+            g_object_set_data_full(G_OBJECT(app), "pipeline_context", context, pipeline_context_destroy);
+        }
+    }
+    return context;
+}
+
+// Mapa wskaźnika z pamięci podręcznej etapów, a przy jej braku wygenerowana i zapamiętana
+static GdkPixbuf* render_index_map(const PipelineContext* context, const char* index_name,
+                                   const float* index_data, int width, int height)
+{
+    char* map_key = map_cache_key(context, index_name);
+    GdkPixbuf* pixbuf = map_key ? stage_cache_lookup_object(map_key) : NULL;
+    if (pixbuf)
+    {
+        g_print("[%s] Mapa %s z pamięci podręcznej etapów.\n", get_timestamp(), index_name);
+    }
+    else
+    {
+        pixbuf = generate_pixbuf_from_index_data(index_data, width, height);
+        if (pixbuf)
+        {
+            cache_rendered_map(context, index_name, pixbuf);
+        }
+    }
+
+    g_free(map_key);
+    return pixbuf;
+}
+
+// Klucz wyrenderowanej mapy: klucz wskaźnika z prefiksem etapu, NULL przy wyłączonej pamięci podręcznej
+static char* map_cache_key(const PipelineContext* context, const char* index_name)
+{
+    char* index_key = context ? pipeline_index_cache_key(context->bands, context->target_10m, index_name) : NULL;
+    char* map_key = index_key ? g_strconcat("map|", index_key, NULL) : NULL;
+    g_free(index_key);
+    return map_key;
+}
+
+static void cache_rendered_map(const PipelineContext* context, const char* index_name, GdkPixbuf* pixbuf)
+{
+    char* map_key = map_cache_key(context, index_name);
+    if (map_key)
+    {
+        stage_cache_store_object(map_key, pixbuf,
+                                 (size_t)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf),
+                                 g_object_ref, g_object_unref);
+        g_free(map_key);
+    }
+}
+
 // ====== IMPLEMENTACJE - WALIDACJA ======
 
-static int validate_band_paths(BandData bands[], int band_count, GtkWindow* parent_window)
+// GUI zawsze liczy NDVI i NDMI - sprawdzane są pasma z maski tych wskaźników
+static int validate_band_paths(BandData bands[], unsigned int band_mask, GtkWindow* parent_window)
 {
-    for (int i = 0; i < band_count; i++)
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
     {
-        if (!*(bands[i].path))
+        if ((band_mask & (1u << i)) && !*(bands[i].path))
         {
             GtkWidget* error_dialog = gtk_message_dialog_new(parent_window, GTK_DIALOG_DESTROY_WITH_PARENT,
                                                              GTK_MESSAGE_ERROR, GTK_BUTTONS_CLOSE,
@@ -599,6 +925,17 @@ static int validate_band_paths(BandData bands[], int band_count, GtkWindow* pare
 
 // ====== IMPLEMENTACJE - PAMIĘĆ ======
 
+static void config_window_state_destroy(gpointer data)
+{
+    // Kontekst należy do aplikacji (get_application_context())
+    g_free(data);
+}
+
+static void pipeline_context_destroy(gpointer data)
+{
+    pipeline_context_free(data);
+}
+
 static void free_index_map_data(gpointer data)
 {
     g_print("[%s] Rozpoczęto zwalnianie danych mapy.\n", get_timestamp());
@@ -610,18 +947,12 @@ static void free_index_map_data(gpointer data)
 
     ProcessingResult* map_data = data;
 
-    if (map_data->ndvi_data)
-    {
-        free(map_data->ndvi_data);
-        map_data->ndvi_data = NULL;
-    }
-
-    if (map_data->ndmi_data)
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
     {
-        free(map_data->ndmi_data);
-        map_data->ndmi_data = NULL;
+        raster_pool_release(map_data->index_data[k]);
+        map_data->index_data[k] = NULL;
+        block_index_free(&map_data->index_blocks[k]);
     }
-
     g_free(map_data);
     g_print("[%s] Zakończono zwalnianie danych mapy.\n", get_timestamp());
 }
@@ -645,6 +976,17 @@ static void map_window_data_destroy(gpointer data)
         g_object_unref(window_data->ndmi_pixbuf);
         window_data->ndmi_pixbuf = NULL;
     }
+    g_clear_object(&window_data->ndvi_preview);
+    g_clear_object(&window_data->ndmi_preview);
+
+    // Zamknięcie okna przerywa dopracowanie po bieżącym pasie
+    if (window_data->refine)
+    {
+        g_atomic_int_set(&window_data->refine->cancelled, 1);
+        window_data->refine->window_data = NULL;
+        refine_job_unref(window_data->refine);
+        window_data->refine = NULL;
+    }
 
     if (window_data->map_data)
     {
@@ -654,22 +996,4 @@ static void map_window_data_destroy(gpointer data)
 
     g_free(window_data);
     g_print("[%s] Zwalnianie danych zakończone.\n", get_timestamp());
-
-    // Resetowanie ustawień domyślnych
-    path_b04 = NULL;
-    path_b08 = NULL;
-    path_b11 = NULL;
-    path_scl = NULL;
-    res_10m_selected = TRUE;
-
-    if (save_filename_ndvi)
-    {
-        g_free(save_filename_ndvi);
-        save_filename_ndvi = NULL;
-    }
-    if (save_filename_ndmi)
-    {
-        g_free(save_filename_ndmi);
-        save_filename_ndmi = NULL;
-    }
 }
@@ -1,10 +1,72 @@
 #ifndef INDEX_CALCULATOR_H
 #define INDEX_CALCULATOR_H
 
-#include <gtk/gtk.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #define INDEX_NO_DATA_VALUE -2.0f
 
+// Wskaźniki skwantowane do int16: wartość całkowita = round(wskaźnik * INDEX_INT16_SCALE),
+// co daje rozdzielczość 1e-4 w zakresie [-3.2767, 3.2767]
+#define INDEX_INT16_SCALE 10000.0f
+#define INDEX_INT16_NO_DATA INT16_MIN
+
+/**
+ * @brief Oblicza (A - B) / (A + B) z maską SCL do istniejącego bufora
+ *
+ * Wersja bez alokacji, używana przy przetwarzaniu pasami - output może wskazywać
+ * na fragment większej tablicy wynikowej.
+ *
+ * @param num_pixels Liczba kolejnych pikseli do obliczenia
+ * @param output Bufor na num_pixels wartości (INDEX_NO_DATA_VALUE dla pikseli zamaskowanych)
+ */
+void calculate_normalized_difference_into(const float* band_a, const float* band_b,
+                                          const float* scl_band, size_t num_pixels,
+                                          float* output);
+
+/**
+ * @brief Jednowątkowa wersja calculate_normalized_difference_into() dla jednego wiersza
+ *
+ * Przeznaczona do wywoływania z pętli równoległych po wierszach (np. rastry z krokiem
+ * wierszy w API libndindex).
+ *
+ * @param scl_row Wiersz maski SCL lub NULL - wtedy żaden piksel nie jest maskowany
+ */
+void calculate_normalized_difference_row(const float* band_a, const float* band_b,
+                                         const float* scl_row, size_t num_pixels,
+                                         float* output);
+
+/**
+ * @brief Wypełnia maskę pikseli wykluczonych przez klasyfikację SCL (1 = wykluczony)
+ *
+ * Używana przez silnik band_math, który liczy maskę raz na blok pikseli dla wszystkich wskaźników.
+ */
+void calculate_scl_mask(const float* scl_band, size_t num_pixels, unsigned char* mask);
+
+/**
+ * @brief Alokuje raster wyniku i oblicza (A - B) / (A + B) z maską SCL dla całej sceny
+ *
+ * @param index_name Nazwa wskaźnika do logów i metryk
+ * @return Nowy bufor width * height wartości lub NULL w przypadku błędu
+ */
+float* calculate_index_base(const float* band_a, const float* band_b,
+                            int width, int height,
+                            const float* scl_band,
+                            const char* index_name);
+
+/**
+ * @brief Kwantuje wartości wskaźnika do int16 (INDEX_INT16_SCALE, zaokrąglenie do najbliższej)
+ *
+ * INDEX_NO_DATA_VALUE, NaN i nieskończoności dają INDEX_INT16_NO_DATA, wartości spoza
+ * zakresu int16 są obcinane do [-32767, 32767].
+ */
+void quantize_index_values(const float* values, size_t count, int16_t* output);
+
+/**
+ * @brief Odwrotność quantize_index_values() - INDEX_INT16_NO_DATA daje INDEX_NO_DATA_VALUE
+ */
+void dequantize_index_values(const int16_t* values, size_t count, float* output);
+
 float* calculate_ndvi(const float* nir_band, const float* red_band,
                       int width, int height,
                       const float* scl_band);
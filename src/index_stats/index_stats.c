@@ -0,0 +1,240 @@
+#include "index_stats.h"
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <omp.h>
+
+#include "../index_calculator/index_calculator.h"
+#include "../utils/utils.h"
+
+// Porcja pikseli akumulacji - jak blok silnika band_math, mieści się w L1
+#define INDEX_STATS_BLOCK_PIXELS 256
+#define NO_DATA_BIN 255
+
+static const double REPORTED_PERCENTILES[] = {5.0, 25.0, 50.0, 75.0, 95.0};
+
+static void merge_moments(IndexStats* dst, uint64_t valid_pixels, double mean, double m2, float min, float max);
+
+// ====== AKUMULACJA ======
+
+void index_stats_reset(IndexStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min = FLT_MAX;
+    stats->max = -FLT_MAX;
+}
+
+void index_stats_accumulate(IndexStats* stats, const float* values, size_t count)
+{
+    const float bin_scale = INDEX_STATS_BINS / (INDEX_STATS_MAX_VALUE - INDEX_STATS_MIN_VALUE);
+    unsigned char bins[INDEX_STATS_BLOCK_PIXELS];
+
+    for (size_t offset = 0; offset < count; offset += INDEX_STATS_BLOCK_PIXELS)
+    {
+        const float* block = values + offset;
+        size_t block_count = count - offset < INDEX_STATS_BLOCK_PIXELS ? count - offset : INDEX_STATS_BLOCK_PIXELS;
+
+        // Przedziały histogramu - pętla wektorowa; NO_DATA_BIN oznacza piksel bez danych
+        #pragma omp simd
+        for (size_t i = 0; i < block_count; i++)
+        {
+            float position = (block[i] - INDEX_STATS_MIN_VALUE) * bin_scale;
+            position = position < 0.0f ? 0.0f : (position > INDEX_STATS_BINS - 1 ? INDEX_STATS_BINS - 1 : position);
+            bins[i] = block[i] == INDEX_NO_DATA_VALUE ? NO_DATA_BIN : (unsigned char)(int)position;
+        }
+
+        // Suma bloku, min/max i histogram w pierwszym przejściu
+        float sum = 0.0f;
+        unsigned int valid = 0;
+        float min = stats->min;
+        float max = stats->max;
+        for (size_t i = 0; i < block_count; i++)
+        {
+            bool is_valid = bins[i] != NO_DATA_BIN;
+            float v = is_valid ? block[i] : 0.0f;
+            sum += v;
+            valid += is_valid;
+            min = is_valid && v < min ? v : min;
+            max = is_valid && v > max ? v : max;
+            if (is_valid)
+            {
+                stats->histogram[bins[i]]++;
+            }
+        }
+
+        stats->total_pixels += block_count;
+        if (valid > 0)
+        {
+            // Drugie przejście po bloku (wciąż w L1): suma kwadratów odchyleń od średniej bloku w double.
+            // Wzór suma_kwadratów - średnia * suma traci wszystkie cyfry znaczące przy małej wariancji
+            // (woda, zwarta roślinność), a poprawka (suma odchyleń)^2 / n usuwa błąd średniej z float
+            double block_mean = (double)sum / valid;
+            double deviation_sum = 0.0;
+            double block_m2 = 0.0;
+            for (size_t i = 0; i < block_count; i++)
+            {
+                double deviation = bins[i] != NO_DATA_BIN ? block[i] - block_mean : 0.0;
+                deviation_sum += deviation;
+                block_m2 += deviation * deviation;
+            }
+            block_mean += deviation_sum / valid;
+            block_m2 -= deviation_sum * deviation_sum / valid;
+            merge_moments(stats, valid, block_mean, block_m2 > 0.0 ? block_m2 : 0.0, min, max);
+        }
+    }
+}
+
+void index_stats_add_masked(IndexStats* stats, size_t count)
+{
+    stats->total_pixels += count;
+}
+
+void index_stats_merge(IndexStats* dst, const IndexStats* src)
+{
+    dst->total_pixels += src->total_pixels;
+    for (int b = 0; b < INDEX_STATS_BINS; b++)
+    {
+        dst->histogram[b] += src->histogram[b];
+    }
+
+    merge_moments(dst, src->valid_pixels, src->mean, src->m2, src->min, src->max);
+}
+
+// Łączenie średnich i sum kwadratów odchyleń dwóch zbiorów (Chan i in.)
+static void merge_moments(IndexStats* dst, uint64_t valid_pixels, double mean, double m2, float min, float max)
+{
+    if (valid_pixels == 0)
+    {
+        return;
+    }
+
+    double n_a = (double)dst->valid_pixels;
+    double n_b = (double)valid_pixels;
+    double n = n_a + n_b;
+    double delta = mean - dst->mean;
+
+    dst->mean += delta * n_b / n;
+    dst->m2 += m2 + delta * delta * n_a * n_b / n;
+    dst->valid_pixels += valid_pixels;
+    dst->min = min < dst->min ? min : dst->min;
+    dst->max = max > dst->max ? max : dst->max;
+}
+
+void index_stats_compute(IndexStats* stats, const float* values, size_t count)
+{
+    index_stats_reset(stats);
+    size_t num_blocks = (count + INDEX_STATS_BLOCK_PIXELS - 1) / INDEX_STATS_BLOCK_PIXELS;
+
+    #pragma omp parallel shared(stats, values)
+    {
+        IndexStats local;
+        index_stats_reset(&local);
+
+        #pragma omp for schedule(static) nowait
+        for (size_t block = 0; block < num_blocks; block++)
+        {
+            size_t start = block * INDEX_STATS_BLOCK_PIXELS;
+            size_t block_count = count - start < INDEX_STATS_BLOCK_PIXELS ? count - start : INDEX_STATS_BLOCK_PIXELS;
+            index_stats_accumulate(&local, values + start, block_count);
+        }
+
+        #pragma omp critical(index_stats_merge)
+        index_stats_merge(stats, &local);
+    }
+}
+
+// ====== WYNIKI ======
+
+double index_stats_stddev(const IndexStats* stats)
+{
+    return stats->valid_pixels > 0 ? sqrt(stats->m2 / stats->valid_pixels) : 0.0;
+}
+
+double index_stats_masked_fraction(const IndexStats* stats)
+{
+    if (stats->total_pixels == 0)
+    {
+        return 0.0;
+    }
+    return (double)(stats->total_pixels - stats->valid_pixels) / stats->total_pixels;
+}
+
+float index_stats_percentile(const IndexStats* stats, double percent)
+{
+    if (stats->valid_pixels == 0)
+    {
+        return INDEX_NO_DATA_VALUE;
+    }
+
+    const double bin_width = (double)(INDEX_STATS_MAX_VALUE - INDEX_STATS_MIN_VALUE) / INDEX_STATS_BINS;
+    double target = percent / 100.0 * stats->valid_pixels;
+    double cumulative = 0.0;
+    double value = stats->max;
+
+    for (int b = 0; b < INDEX_STATS_BINS; b++)
+    {
+        if (stats->histogram[b] == 0)
+        {
+            continue;
+        }
+        if (cumulative + stats->histogram[b] >= target)
+        {
+            double fraction = (target - cumulative) / stats->histogram[b];
+            value = INDEX_STATS_MIN_VALUE + (b + fraction) * bin_width;
+            break;
+        }
+        cumulative += stats->histogram[b];
+    }
+
+    // Skrajne przedziały histogramu zbierają też wartości spoza [-1, 1]
+    value = value < stats->min ? stats->min : value;
+    value = value > stats->max ? stats->max : value;
+    return (float)value;
+}
+
+void index_stats_write_json(FILE* file, const IndexStats* stats)
+{
+    fprintf(file, "{\"total_pixels\":%llu,\"valid_pixels\":%llu,\"masked_fraction\":%.6f",
+            (unsigned long long)stats->total_pixels, (unsigned long long)stats->valid_pixels,
+            index_stats_masked_fraction(stats));
+
+    if (stats->valid_pixels > 0)
+    {
+        fprintf(file, ",\"mean\":%.6f,\"stddev\":%.6f,\"min\":%.6f,\"max\":%.6f,\"percentiles\":{",
+                stats->mean, index_stats_stddev(stats), stats->min, stats->max);
+        for (size_t i = 0; i < sizeof(REPORTED_PERCENTILES) / sizeof(REPORTED_PERCENTILES[0]); i++)
+        {
+            fprintf(file, "%s\"p%.0f\":%.4f", i > 0 ? "," : "", REPORTED_PERCENTILES[i],
+                    index_stats_percentile(stats, REPORTED_PERCENTILES[i]));
+        }
+        fputs("}", file);
+    }
+    else
+    {
+        fputs(",\"mean\":null,\"stddev\":null,\"min\":null,\"max\":null,\"percentiles\":null", file);
+    }
+
+    fprintf(file, ",\"histogram\":{\"min\":%.2f,\"max\":%.2f,\"counts\":[",
+            INDEX_STATS_MIN_VALUE, INDEX_STATS_MAX_VALUE);
+    for (int b = 0; b < INDEX_STATS_BINS; b++)
+    {
+        fprintf(file, "%s%llu", b > 0 ? "," : "", (unsigned long long)stats->histogram[b]);
+    }
+    fputs("]}}", file);
+}
+
+void index_stats_log(const char* index_name, const IndexStats* stats)
+{
+    if (stats->valid_pixels == 0)
+    {
+        printf("[%s] %s: brak pikseli ważnych (%llu zamaskowanych).\n",
+               get_timestamp(), index_name, (unsigned long long)stats->total_pixels);
+        return;
+    }
+
+    printf("[%s] %s: średnia %.4f, odch. std. %.4f, mediana %.3f, zakres [%.3f, %.3f], zamaskowane %.1f%%\n",
+           get_timestamp(), index_name, stats->mean, index_stats_stddev(stats),
+           index_stats_percentile(stats, 50.0), stats->min, stats->max,
+           100.0 * index_stats_masked_fraction(stats));
+}
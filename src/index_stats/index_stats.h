@@ -0,0 +1,98 @@
+#ifndef INDEX_STATS_H
+#define INDEX_STATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Histogram na przedziale [-1, 1] z krokiem 0.01 - rozdzielczość percentyli
+#define INDEX_STATS_BINS 200
+#define INDEX_STATS_MIN_VALUE -1.0f
+#define INDEX_STATS_MAX_VALUE 1.0f
+
+/**
+ * @brief Statystyki rastra wskaźnika zbierane w trakcie jego obliczania
+ *
+ * W bloku 256 pikseli średnia i suma kwadratów odchyleń liczone są dwuprzebiegowo (odchylenia
+ * od średniej bloku w double), a momenty bloków łączone są wg Chana, więc częściowe wyniki wątków i pasów wierszy można łączyć bez ponownego przejścia po
+ * rastrze i bez utraty dokładności przy dużych scenach. Piksele INDEX_NO_DATA_VALUE
+ * liczone są jako zamaskowane. Wartości spoza [-1, 1] trafiają do skrajnych przedziałów
+ * histogramu, a min/max są dokładne.
+ */
+typedef struct
+{
+    uint64_t total_pixels;
+    uint64_t valid_pixels;
+    double mean;
+    double m2;
+    float min;
+    float max;
+    uint64_t histogram[INDEX_STATS_BINS];
+} IndexStats;
+
+/**
+ * @brief Zeruje statystyki
+ */
+void index_stats_reset(IndexStats* stats);
+
+/**
+ * @brief Dolicza blok kolejnych wartości wskaźnika
+ *
+ * Przeznaczona do wywoływania zaraz po obliczeniu bloku, gdy jego wartości są jeszcze w L1.
+ * Nie jest bezpieczna wątkowo - każdy wątek zbiera własne statystyki i łączy je przez
+ * index_stats_merge().
+ */
+void index_stats_accumulate(IndexStats* stats, const float* values, size_t count);
+
+/**
+ * @brief Dolicza count pikseli zamaskowanych bez przeglądania wartości
+ *
+ * Dla bloków, o których wiadomo, że nie zawierają danych (np. pominiętych w całości przez maskę SCL).
+ */
+void index_stats_add_masked(IndexStats* stats, size_t count);
+
+/**
+ * @brief Dołącza statystyki src do dst
+ */
+void index_stats_merge(IndexStats* dst, const IndexStats* src);
+
+/**
+ * @brief Liczy statystyki gotowego rastra równolegle (OpenMP)
+ *
+ * Zapasowa ścieżka dla wyników, które nie powstały w jądrze wskaźników (np. odczytanych
+ * z pamięci podręcznej etapów).
+ */
+void index_stats_compute(IndexStats* stats, const float* values, size_t count);
+
+/**
+ * @brief Odchylenie standardowe (populacji) pikseli ważnych, 0 gdy brak danych
+ */
+double index_stats_stddev(const IndexStats* stats);
+
+/**
+ * @brief Udział pikseli zamaskowanych w [0, 1]
+ */
+double index_stats_masked_fraction(const IndexStats* stats);
+
+/**
+ * @brief Percentyl wyznaczony z histogramu (interpolacja liniowa w przedziale)
+ *
+ * @param percent Percentyl w [0, 100]
+ * @return Wartość percentyla lub INDEX_NO_DATA_VALUE, gdy brak pikseli ważnych
+ */
+float index_stats_percentile(const IndexStats* stats, double percent);
+
+/**
+ * @brief Zapisuje statystyki jako obiekt JSON (bez znaku nowej linii)
+ *
+ * Pola: total_pixels, valid_pixels, masked_fraction, mean, stddev, min, max,
+ * percentiles (p5, p25, p50, p75, p95) oraz histogram (min, max, counts).
+ */
+void index_stats_write_json(FILE* file, const IndexStats* stats);
+
+/**
+ * @brief Wypisuje jednoliniowe podsumowanie statystyk wskaźnika na stdout
+ */
+void index_stats_log(const char* index_name, const IndexStats* stats);
+
+#endif // INDEX_STATS_H
@@ -1,6 +1,210 @@
+#include <omp.h>
+
 #include "gui/gui.h"
+#include "cli/cli_options.h"
+#include "processing_pipeline/processing_pipeline.h"
+#include "pipeline_context/pipeline_context.h"
+#include "batch_scheduler/batch_scheduler.h"
+#include "watch_daemon/watch_daemon.h"
+#include "compositor/compositor.h"
+#include "mosaic/mosaic.h"
+#include "change_detection/change_detection.h"
+#include "stage_cache/stage_cache.h"
+#include "raster_pool/raster_pool.h"
+#include "metrics/metrics.h"
+#include "trace/trace.h"
+
+// Pojemność puli buforów w trybie wsadowym - mieści bufory kilku scen pełnego kafla
+#define BATCH_BUFFER_POOL_BYTES ((size_t)1 << 30)
+
+static int run_batch_mode(const CliOptions* options);
+static int run_watch_mode(const CliOptions* options);
+static int run_composite_mode(const CliOptions* options);
+static int run_mosaic_mode(const CliOptions* options);
+static int run_change_mode(const CliOptions* options);
 
 int main(int argc, char* argv[])
 {
-    return run_gui(argc, argv);
+    CliOptions options;
+    if (parse_cli_options(&argc, &argv, &options) != 0)
+    {
+        return 1;
+    }
+
+    set_pipeline_memory_budget(options.max_memory_bytes);
+    set_pipeline_index_selection(options.indices);
+    if (options.scratch_dir && raster_pool_set_scratch(options.scratch_dir, RASTER_POOL_SCRATCH_MIN_BYTES) != 0)
+    {
+        free_cli_options(&options);
+        return 1;
+    }
+    metrics_set_output_path(options.metrics_json_path);
+    if (options.trace_path)
+    {
+        trace_start();
+    }
+
+    int status;
+    if (options.watch_dir)
+    {
+        status = run_watch_mode(&options);
+    }
+    else if (options.batch_manifest_path && options.composite_method >= 0)
+    {
+        status = run_composite_mode(&options);
+    }
+    else if (options.batch_manifest_path && options.mosaic_rule >= 0)
+    {
+        status = run_mosaic_mode(&options);
+    }
+    else if (options.batch_manifest_path && options.change_detection)
+    {
+        status = run_change_mode(&options);
+    }
+    else if (options.batch_manifest_path)
+    {
+        status = run_batch_mode(&options);
+    }
+    else
+    {
+        // Pamięć podręczna etapów trzyma bufory poza budżetem pamięci, więc budżet ją wyłącza
+        stage_cache_set_capacity(options.max_memory_bytes == 0 ? options.stage_cache_bytes : 0);
+        status = run_gui(argc, argv);
+    }
+
+    if (options.trace_path)
+    {
+        trace_write_chrome_json(options.trace_path);
+    }
+
+    pipeline_global_shutdown();
+    metrics_set_output_path(NULL);
+    free_cli_options(&options);
+    return status;
+}
+
+// Tryb wsadowy: sceny z manifestu, mapy PNG do katalogu wyjściowego, bez GUI
+static int run_batch_mode(const CliOptions* options)
+{
+    BatchScene* scenes = NULL;
+    int scene_count = 0;
+
+    if (batch_load_manifest(options->batch_manifest_path, &scenes, &scene_count) != 0)
+    {
+        return 1;
+    }
+
+    // Wyniki int16 dotyczą tylko eksportu bez GUI - mapy w GUI zawsze liczone są jako float
+    BatchConfig config = {
+        .scenes_in_flight = options->scenes_in_flight,
+        .total_threads = options->threads > 0 ? options->threads : omp_get_num_procs(),
+        .target_10m = options->resolution_m == 10,
+        .value_type = (PipelineValueType)options->value_type,
+        .band_layout = (PipelineBandLayout)options->band_layout,
+        // Prefetch trzyma w pamięci dodatkowe sceny, więc przy budżecie pamięci jest wyłączony
+        .prefetch = !options->no_prefetch && options->max_memory_bytes == 0,
+        // Z tego samego powodu przy budżecie pamięci pula nie przetrzymuje zwolnionych buforów
+        .buffer_pool_bytes = options->max_memory_bytes == 0 ? BATCH_BUFFER_POOL_BYTES : 0,
+        .output_dir = options->output_dir ? options->output_dir : ".",
+        .export_formats = options->export_formats,
+        .zones = {options->zones_path, options->zone_field, options->zones_json}
+    };
+
+    int status = run_batch(scenes, scene_count, &config);
+    batch_free_scenes(scenes, scene_count);
+    return status == 0 ? 0 : 1;
+}
+
+// Tryb demona: ciepły proces przetwarzający sceny pojawiające się w obserwowanym katalogu
+static int run_watch_mode(const CliOptions* options)
+{
+    int total_threads = options->threads > 0 ? options->threads : omp_get_num_procs();
+    int workers = options->scenes_in_flight > 0 ? options->scenes_in_flight : 1;
+
+    WatchConfig config = {
+        .watch_dir = options->watch_dir,
+        .output_dir = options->output_dir ? options->output_dir : ".",
+        .workers = workers,
+        .threads_per_scene = total_threads / workers > 0 ? total_threads / workers : 1,
+        .target_10m = options->resolution_m == 10,
+        .value_type = (PipelineValueType)options->value_type,
+        .band_layout = (PipelineBandLayout)options->band_layout,
+        .buffer_pool_bytes = options->max_memory_bytes == 0 ? BATCH_BUFFER_POOL_BYTES : 0,
+        .export_formats = options->export_formats,
+        .zones = {options->zones_path, options->zone_field, options->zones_json}
+    };
+
+    return run_watch_daemon(&config) == 0 ? 0 : 1;
+}
+
+// Tryb kompozycji: sceny z manifestu (daty jednego kafla) łączone pasami w jedną kompozycję
+static int run_composite_mode(const CliOptions* options)
+{
+    BatchScene* scenes = NULL;
+    int scene_count = 0;
+
+    if (batch_load_manifest(options->batch_manifest_path, &scenes, &scene_count) != 0)
+    {
+        return 1;
+    }
+
+    CompositeConfig config = {
+        .method = (CompositeMethod)options->composite_method,
+        .indices = options->indices,
+        .target_10m = options->resolution_m == 10,
+        .memory_budget = options->max_memory_bytes,
+        .output_dir = options->output_dir ? options->output_dir : "."
+    };
+
+    int status = run_composite(scenes, scene_count, &config);
+    batch_free_scenes(scenes, scene_count);
+    return status == 0 ? 0 : 1;
+}
+
+// Tryb mozaiki: sąsiednie kafle z manifestu łączone pasami w jedną mapę regionu
+static int run_mosaic_mode(const CliOptions* options)
+{
+    BatchScene* scenes = NULL;
+    int scene_count = 0;
+
+    if (batch_load_manifest(options->batch_manifest_path, &scenes, &scene_count) != 0)
+    {
+        return 1;
+    }
+
+    MosaicConfig config = {
+        .rule = (MosaicRule)options->mosaic_rule,
+        .indices = options->indices,
+        .target_10m = options->resolution_m == 10,
+        .memory_budget = options->max_memory_bytes,
+        .output_dir = options->output_dir ? options->output_dir : "."
+    };
+
+    int status = run_mosaic(scenes, scene_count, &config);
+    batch_free_scenes(scenes, scene_count);
+    return status == 0 ? 0 : 1;
+}
+
+// Tryb wykrywania zmian: pary scen z manifestu (dwie daty) przetwarzane pasami w jednym kroku
+static int run_change_mode(const CliOptions* options)
+{
+    BatchScene* scenes = NULL;
+    int scene_count = 0;
+
+    if (batch_load_manifest(options->batch_manifest_path, &scenes, &scene_count) != 0)
+    {
+        return 1;
+    }
+
+    ChangeConfig config = {
+        .indices = options->indices,
+        .target_10m = options->resolution_m == 10,
+        .memory_budget = options->max_memory_bytes,
+        .threshold = (float)options->change_threshold,
+        .output_dir = options->output_dir ? options->output_dir : "."
+    };
+
+    int status = run_change_detection(scenes, scene_count, &config);
+    batch_free_scenes(scenes, scene_count);
+    return status == 0 ? 0 : 1;
 }
@@ -0,0 +1,175 @@
+#include "memory_planner.h"
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../utils/utils.h"
+
+#define BYTES_PER_MB (1024.0 * 1024.0)
+
+static const char* STAGE_NAMES[PIPELINE_STAGE_COUNT] = {
+    "wczytywanie",
+    "resampling",
+    "wskaźniki"
+};
+
+// Liczba przebiegów pipeline'u trwających w procesie (memory_planner_run_started())
+static gint active_runs = 0;
+
+// ====== POMOCNICZE ======
+static size_t read_proc_status_kb(const char* field);
+static void reset_peak_rss(void);
+
+void memory_planner_run_started(void)
+{
+    g_atomic_int_inc(&active_runs);
+}
+
+void memory_planner_run_finished(void)
+{
+    g_atomic_int_add(&active_runs, -1);
+}
+
+void memory_planner_init(MemoryPlanner* planner, const char* label)
+{
+    memset(planner, 0, sizeof(*planner));
+    planner->current_stage = PIPELINE_STAGE_LOAD;
+    planner->label = label;
+}
+
+void memory_planner_begin_stage(MemoryPlanner* planner, PipelineStage stage)
+{
+    planner->current_stage = stage;
+    planner->peak_live_bytes[stage] = planner->live_bytes;
+
+    // Raz wspólny szczyt pozostaje wspólny - inny przebieg mógł już podnieść VmHWM
+    if (g_atomic_int_get(&active_runs) > 1)
+    {
+        planner->rss_process_wide = true;
+    }
+    else
+    {
+        reset_peak_rss();
+    }
+}
+
+void memory_planner_end_stage(MemoryPlanner* planner)
+{
+    PipelineStage stage = planner->current_stage;
+    planner->peak_rss_kb[stage] = read_proc_status_kb("VmHWM:");
+    if (g_atomic_int_get(&active_runs) > 1)
+    {
+        planner->rss_process_wide = true;
+    }
+
+    log_labeled(stdout, planner->label,
+                "[PAMIĘĆ] Etap %s: szczyt buforów %.1f MB, po etapie %.1f MB, szczytowy RSS %s%.1f MB\n",
+                memory_planner_stage_name(stage),
+                planner->peak_live_bytes[stage] / BYTES_PER_MB,
+                planner->live_bytes / BYTES_PER_MB,
+                planner->rss_process_wide ? "procesu (kilka przebiegów naraz) " : "",
+                planner->peak_rss_kb[stage] / 1024.0);
+}
+
+void memory_planner_track_alloc(MemoryPlanner* planner, size_t bytes)
+{
+    planner->live_bytes += bytes;
+    if (planner->live_bytes > planner->peak_live_bytes[planner->current_stage])
+    {
+        planner->peak_live_bytes[planner->current_stage] = planner->live_bytes;
+    }
+}
+
+void memory_planner_track_free(MemoryPlanner* planner, size_t bytes)
+{
+    planner->live_bytes = bytes > planner->live_bytes ? 0 : planner->live_bytes - bytes;
+}
+
+void memory_planner_report(const MemoryPlanner* planner)
+{
+    size_t overall_peak = 0;
+
+    log_labeled(stdout, planner->label, "[PAMIĘĆ] Podsumowanie przebiegu:\n");
+    for (int i = 0; i < PIPELINE_STAGE_COUNT; i++)
+    {
+        printf(planner->rss_process_wide ? "    %-12s bufory: %8.1f MB   RSS procesu: %8.1f MB\n"
+                                         : "    %-12s bufory: %8.1f MB   RSS: %8.1f MB\n",
+               memory_planner_stage_name(i),
+               planner->peak_live_bytes[i] / BYTES_PER_MB,
+               planner->peak_rss_kb[i] / 1024.0);
+        if (planner->peak_live_bytes[i] > overall_peak)
+        {
+            overall_peak = planner->peak_live_bytes[i];
+        }
+    }
+    printf("    Szczyt buforów całego przebiegu: %.1f MB\n", overall_peak / BYTES_PER_MB);
+    if (planner->rss_process_wide)
+    {
+        printf("    RSS obejmuje przebiegi innych scen działające w tym samym czasie\n");
+    }
+}
+
+const char* memory_planner_stage_name(PipelineStage stage)
+{
+    if (stage < 0 || stage >= PIPELINE_STAGE_COUNT)
+    {
+        return "UNKNOWN";
+    }
+    return STAGE_NAMES[stage];
+}
+
+void memory_planner_log_plan(const MemoryBudgetPlan* plan, size_t budget_bytes, const char* label)
+{
+    if (plan->mode == PROCESSING_MODE_WHOLE_SCENE)
+    {
+        log_labeled(stdout, label,
+                    "[PAMIĘĆ] Budżet %.0f MB: cała scena, dekodowanie %d pasm naraz, szacowany szczyt %.0f MB\n",
+                    budget_bytes / BYTES_PER_MB, plan->decode_concurrency,
+                    plan->estimated_peak_bytes / BYTES_PER_MB);
+    }
+    else
+    {
+        log_labeled(stdout, label,
+                    "[PAMIĘĆ] Budżet %.0f MB: pasy po %d wierszy, dekodowanie %d pasm naraz, szacowany szczyt %.0f MB\n",
+                    budget_bytes / BYTES_PER_MB, plan->strip_rows, plan->decode_concurrency,
+                    plan->estimated_peak_bytes / BYTES_PER_MB);
+    }
+}
+
+// Odczytuje pole w kB (np. "VmHWM:") z /proc/self/status, 0 gdy niedostępne
+static size_t read_proc_status_kb(const char* field)
+{
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status)
+    {
+        return 0;
+    }
+
+    char line[256];
+    size_t value_kb = 0;
+    size_t field_len = strlen(field);
+
+    while (fgets(line, sizeof(line), status))
+    {
+        if (strncmp(line, field, field_len) == 0)
+        {
+            sscanf(line + field_len, "%zu", &value_kb);
+            break;
+        }
+    }
+
+    fclose(status);
+    return value_kb;
+}
+
+// Zeruje VmHWM, dzięki czemu szczyt RSS odnosi się tylko do bieżącego etapu
+static void reset_peak_rss(void)
+{
+    FILE* clear_refs = fopen("/proc/self/clear_refs", "w");
+    if (!clear_refs)
+    {
+        return;
+    }
+    fputs("5", clear_refs);
+    fclose(clear_refs);
+}
@@ -0,0 +1,100 @@
+#ifndef MEMORY_PLANNER_H
+#define MEMORY_PLANNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef enum
+{
+    PIPELINE_STAGE_LOAD,
+    PIPELINE_STAGE_RESAMPLE,
+    PIPELINE_STAGE_INDICES,
+    PIPELINE_STAGE_COUNT
+} PipelineStage;
+
+typedef enum
+{
+    PROCESSING_MODE_WHOLE_SCENE,
+    PROCESSING_MODE_STRIPS
+} ProcessingMode;
+
+/**
+ * @brief Wynik planowania przebiegu pod budżet pamięci
+ *
+ * Określa, czy scena mieści się w pamięci w całości, czy musi być przetwarzana pasami
+ * wierszy, oraz ile pasm można dekodować jednocześnie.
+ */
+typedef struct
+{
+    ProcessingMode mode;
+    int strip_rows;
+    int decode_concurrency;
+    size_t estimated_peak_bytes;
+} MemoryBudgetPlan;
+
+/**
+ * @brief Stan planera czasu życia buforów jednego przebiegu pipeline'u
+ *
+ * Planer liczy bajty buforów pasm i wyników, które w danej chwili żyją w pamięci,
+ * oraz zapamiętuje szczyt tej wartości i szczytową pamięć rezydentną procesu
+ * (VmHWM) osobno dla każdego etapu przetwarzania.
+ *
+ * VmHWM jest wspólny dla całego procesu. Gdy w trakcie przebiegu działa też inny przebieg
+ * (memory_planner_run_started()), planer nie zeruje licznika między etapami, a RSS raportowany
+ * jest jako szczyt całego procesu (rss_process_wide).
+ */
+typedef struct
+{
+    PipelineStage current_stage;
+    size_t live_bytes;
+    size_t peak_live_bytes[PIPELINE_STAGE_COUNT];
+    size_t peak_rss_kb[PIPELINE_STAGE_COUNT];
+    bool rss_process_wide;
+    // Etykieta sceny w raportach (może być NULL), nie jest kopiowana
+    const char* label;
+} MemoryPlanner;
+
+/**
+ * @brief Zgłasza początek przebiegu pipeline'u w procesie (np. jednej sceny trybu wsadowego)
+ *
+ * @note Każde wywołanie musi mieć parę w memory_planner_run_finished()
+ */
+void memory_planner_run_started(void);
+
+void memory_planner_run_finished(void);
+
+void memory_planner_init(MemoryPlanner* planner, const char* label);
+
+/**
+ * @brief Rozpoczyna nowy etap i zeruje licznik szczytowego RSS procesu, jeśli przebieg jest jedyny
+ *
+ * @note Zerowanie VmHWM odbywa się przez zapis "5" do /proc/self/clear_refs.
+ *       Jeśli jądro tego nie obsługuje, raportowany RSS jest szczytem od startu procesu.
+ * @note Przy kilku przebiegach naraz zerowanie zafałszowałoby szczyty pozostałych przebiegów,
+ *       więc jest pomijane, a RSS etapu jest szczytem procesu od ostatniego zerowania.
+ */
+void memory_planner_begin_stage(MemoryPlanner* planner, PipelineStage stage);
+
+/**
+ * @brief Kończy bieżący etap, zapisuje szczytowy RSS i wypisuje raport etapu
+ */
+void memory_planner_end_stage(MemoryPlanner* planner);
+
+void memory_planner_track_alloc(MemoryPlanner* planner, size_t bytes);
+void memory_planner_track_free(MemoryPlanner* planner, size_t bytes);
+
+/**
+ * @brief Wypisuje podsumowanie szczytowej pamięci wszystkich etapów przebiegu
+ */
+void memory_planner_report(const MemoryPlanner* planner);
+
+const char* memory_planner_stage_name(PipelineStage stage);
+
+/**
+ * @brief Wypisuje wybrany plan budżetu pamięci
+ *
+ * @param label Etykieta sceny w logu (może być NULL)
+ */
+void memory_planner_log_plan(const MemoryBudgetPlan* plan, size_t budget_bytes, const char* label);
+
+#endif // MEMORY_PLANNER_H
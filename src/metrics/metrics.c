@@ -0,0 +1,210 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "../utils/utils.h"
+
+#define METRICS_MAX_ENTRIES 128
+#define METRICS_NAME_LENGTH 32
+
+typedef struct
+{
+    char stage[METRICS_NAME_LENGTH];
+    char name[METRICS_NAME_LENGTH];
+    int calls;
+    int max_threads;
+    double wall_s;
+    double thread_cpu_s;
+    double process_cpu_s;
+    size_t bytes_in;
+    size_t bytes_out;
+    size_t pixels;
+} MetricsEntry;
+
+// Metryki bieżącego przebiegu - dostęp tylko w sekcji krytycznej "metrics"
+static MetricsEntry entries[METRICS_MAX_ENTRIES];
+static int entry_count = 0;
+static char run_label[METRICS_NAME_LENGTH] = "";
+static struct timespec run_wall_start;
+static struct timespec run_process_cpu_start;
+static char* output_path = NULL;
+
+// ====== POMOCNICZE ======
+static double timespec_diff(struct timespec start, struct timespec end);
+static MetricsEntry* find_or_add_entry(const char* stage, const char* name);
+
+void metrics_begin_run(const char* label)
+{
+    #pragma omp critical(metrics)
+    {
+        entry_count = 0;
+        snprintf(run_label, sizeof(run_label), "%s", label ? label : "");
+        clock_gettime(CLOCK_MONOTONIC, &run_wall_start);
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &run_process_cpu_start);
+    }
+}
+
+MetricsScope metrics_stage_begin(const char* stage, const char* name)
+{
+    MetricsScope scope;
+    scope.stage = stage;
+    scope.name = name ? name : "";
+    // Etap wywołany wewnątrz regionu równoległego wykonuje się na jednym wątku
+    scope.threads = omp_in_parallel() ? 1 : omp_get_max_threads();
+    clock_gettime(CLOCK_MONOTONIC, &scope.wall_start);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &scope.thread_cpu_start);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &scope.process_cpu_start);
+    scope.trace = trace_begin(stage, scope.name);
+    return scope;
+}
+
+double metrics_stage_end(MetricsScope* scope, size_t bytes_in, size_t bytes_out, size_t pixels)
+{
+    struct timespec wall_end, thread_cpu_end, process_cpu_end;
+    trace_end(&scope->trace);
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &thread_cpu_end);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &process_cpu_end);
+
+    double wall_s = timespec_diff(scope->wall_start, wall_end);
+    double thread_cpu_s = timespec_diff(scope->thread_cpu_start, thread_cpu_end);
+    double process_cpu_s = timespec_diff(scope->process_cpu_start, process_cpu_end);
+
+    #pragma omp critical(metrics)
+    {
+        MetricsEntry* entry = find_or_add_entry(scope->stage, scope->name);
+        if (entry)
+        {
+            entry->calls++;
+            entry->wall_s += wall_s;
+            entry->thread_cpu_s += thread_cpu_s;
+            entry->process_cpu_s += process_cpu_s;
+            entry->bytes_in += bytes_in;
+            entry->bytes_out += bytes_out;
+            entry->pixels += pixels;
+            if (scope->threads > entry->max_threads)
+            {
+                entry->max_threads = scope->threads;
+            }
+        }
+    }
+
+    return wall_s;
+}
+
+double metrics_get_wall_time(const char* stage, const char* name)
+{
+    double wall_s = -1.0;
+
+    #pragma omp critical(metrics)
+    {
+        for (int i = 0; i < entry_count; i++)
+        {
+            if (strcmp(entries[i].stage, stage) == 0 && strcmp(entries[i].name, name) == 0)
+            {
+                wall_s = entries[i].wall_s;
+                break;
+            }
+        }
+    }
+
+    return wall_s;
+}
+
+void metrics_set_output_path(const char* path)
+{
+    free(output_path);
+    output_path = path ? strdup(path) : NULL;
+}
+
+void metrics_end_run(const char* status)
+{
+    if (output_path && metrics_write_json(output_path, status) == 0)
+    {
+        printf("[%s] Zapisano metryki przebiegu do %s.\n", get_timestamp(), output_path);
+    }
+}
+
+int metrics_write_json(const char* path, const char* status)
+{
+    if (!path)
+    {
+        return -1;
+    }
+
+    FILE* file = fopen(path, "a");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można otworzyć pliku metryk %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    struct timespec wall_end, process_cpu_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &process_cpu_end);
+
+    #pragma omp critical(metrics)
+    {
+        fprintf(file, "{\"run\":{\"label\":");
+        write_json_string(file, run_label);
+        fprintf(file, ",\"status\":");
+        write_json_string(file, status ? status : "ok");
+        fprintf(file, ",\"timestamp\":%ld,\"wall_s\":%.6f,\"process_cpu_s\":%.6f,\"max_threads\":%d},\"stages\":[",
+                (long)time(NULL), timespec_diff(run_wall_start, wall_end),
+                timespec_diff(run_process_cpu_start, process_cpu_end), omp_get_max_threads());
+
+        for (int i = 0; i < entry_count; i++)
+        {
+            const MetricsEntry* entry = &entries[i];
+            double mpix_per_s = entry->wall_s > 0.0 ? entry->pixels / entry->wall_s / 1e6 : 0.0;
+            double gb_per_s = entry->wall_s > 0.0 ? (entry->bytes_in + entry->bytes_out) / entry->wall_s / 1e9 : 0.0;
+
+            fprintf(file, "%s{\"stage\":", i > 0 ? "," : "");
+            write_json_string(file, entry->stage);
+            fprintf(file, ",\"name\":");
+            write_json_string(file, entry->name);
+            fprintf(file, ",\"calls\":%d,\"threads\":%d,\"wall_s\":%.6f,\"thread_cpu_s\":%.6f,"
+                    "\"process_cpu_s\":%.6f,\"bytes_in\":%zu,\"bytes_out\":%zu,\"pixels\":%zu,"
+                    "\"mpix_per_s\":%.3f,\"gb_per_s\":%.3f}",
+                    entry->calls, entry->max_threads, entry->wall_s, entry->thread_cpu_s,
+                    entry->process_cpu_s, entry->bytes_in, entry->bytes_out, entry->pixels,
+                    mpix_per_s, gb_per_s);
+        }
+        fprintf(file, "]}\n");
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static double timespec_diff(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Wywoływana tylko w sekcji krytycznej "metrics"
+static MetricsEntry* find_or_add_entry(const char* stage, const char* name)
+{
+    for (int i = 0; i < entry_count; i++)
+    {
+        if (strcmp(entries[i].stage, stage) == 0 && strcmp(entries[i].name, name) == 0)
+        {
+            return &entries[i];
+        }
+    }
+
+    if (entry_count >= METRICS_MAX_ENTRIES)
+    {
+        return NULL;
+    }
+
+    MetricsEntry* entry = &entries[entry_count++];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->stage, sizeof(entry->stage), "%s", stage);
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    return entry;
+}
@@ -0,0 +1,86 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "../trace/trace.h"
+
+/**
+ * @brief Pomiar jednego wykonania etapu (np. wczytanie pasma, resampling, obliczenie wskaźnika)
+ *
+ * Tworzony przez metrics_stage_begin() na stosie wątku wykonującego etap, więc może być
+ * używany równolegle z wielu wątków (także wewnątrz regionów OpenMP). Każdy pomiar jest
+ * jednocześnie odcinkiem śladu (trace), gdy śledzenie jest włączone.
+ */
+typedef struct
+{
+    const char* stage;
+    const char* name;
+    struct timespec wall_start;
+    struct timespec thread_cpu_start;
+    struct timespec process_cpu_start;
+    int threads;
+    TraceSpan trace;
+} MetricsScope;
+
+/**
+ * @brief Rozpoczyna nowy przebieg - zeruje zebrane metryki
+ *
+ * @param label Etykieta przebiegu zapisywana w raporcie JSON (np. "10m")
+ */
+void metrics_begin_run(const char* label);
+
+/**
+ * @brief Rozpoczyna pomiar etapu
+ *
+ * @param stage Nazwa etapu ("load", "resample", "index", "visualize", "export", ...)
+ * @param name Nazwa pasma lub wskaźnika, którego dotyczy pomiar
+ */
+MetricsScope metrics_stage_begin(const char* stage, const char* name);
+
+/**
+ * @brief Kończy pomiar etapu i dodaje go do metryk przebiegu
+ *
+ * Pomiary z tym samym etapem i nazwą są sumowane (np. kolejne pasy wierszy).
+ *
+ * @param bytes_in Bajty przeczytane przez etap
+ * @param bytes_out Bajty zapisane przez etap
+ * @param pixels Liczba przetworzonych pikseli
+ * @return Czas rzeczywisty etapu w sekundach (do logów)
+ */
+double metrics_stage_end(MetricsScope* scope, size_t bytes_in, size_t bytes_out, size_t pixels);
+
+/**
+ * @brief Zwraca sumaryczny czas rzeczywisty etapu w bieżącym przebiegu
+ *
+ * @return Czas w sekundach lub -1.0, gdy etap nie został zmierzony
+ */
+double metrics_get_wall_time(const char* stage, const char* name);
+
+/**
+ * @brief Ustawia plik, do którego metrics_end_run() dopisuje raport przebiegu
+ *
+ * @param path Ścieżka pliku JSON Lines lub NULL, aby wyłączyć zapis
+ */
+void metrics_set_output_path(const char* path);
+
+/**
+ * @brief Kończy przebieg i dopisuje jego metryki do pliku ustawionego przez metrics_set_output_path()
+ *
+ * Gdy plik nie został ustawiony, funkcja nic nie robi.
+ */
+void metrics_end_run(const char* status);
+
+/**
+ * @brief Dopisuje metryki bieżącego przebiegu jako jedną linię JSON do pliku
+ *
+ * Format JSON Lines - każdy przebieg to jeden obiekt w osobnej linii, dzięki czemu
+ * plik może zbierać historię wielu przebiegów do śledzenia regresji przepustowości.
+ *
+ * @param status Wynik przebiegu ("ok" lub "error")
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu zapisu
+ */
+int metrics_write_json(const char* path, const char* status);
+
+#endif // METRICS_H
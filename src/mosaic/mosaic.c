@@ -0,0 +1,654 @@
+#include "mosaic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include <gdal.h>
+#include <omp.h>
+
+#include "../band_math/band_math.h"
+#include "../compositor/compositor.h"
+#include "../data_loader/data_loader.h"
+#include "../pipeline_context/pipeline_context.h"
+#include "../index_calculator/index_calculator.h"
+#include "../strip_indices/strip_indices.h"
+#include "../utils/utils.h"
+
+// Najwyższy pas mozaiki - wyżej zysk z mniejszej liczby otwarć plików jest pomijalny
+#define MOSAIC_MAX_STRIP_ROWS 1024
+// Dłuższy bok SCL czytanego do oceny zachmurzenia - GDAL czyta wtedy zmniejszony poziom JPEG2000
+#define MOSAIC_CLOUD_SAMPLE_SIZE 1024
+// Dopuszczalne odchylenie przesunięcia kafla od całkowitej liczby pikseli
+#define MOSAIC_ALIGNMENT_TOLERANCE 0.01
+// Klasy SCL liczone jako zachmurzenie: cienie chmur (3), chmury średnie i wysokie (8, 9), cirrus (10)
+#define MOSAIC_CLOUD_CLASSES ((1u << 3) | (1u << 8) | (1u << 9) | (1u << 10))
+
+/**
+ * @brief Kafel mozaiki: siatka w docelowej rozdzielczości i jej położenie w siatce mozaiki
+ */
+typedef struct
+{
+    int scene;
+    int width;
+    int height;
+    int x_offset;
+    int y_offset;
+    uint32_t date;
+    // Udział pikseli zachmurzonych wśród pikseli z danymi (tylko MOSAIC_LEAST_CLOUD)
+    float cloud_fraction;
+    size_t reader_row_bytes;
+} MosaicTile;
+
+/**
+ * @brief Mozaika jednego wskaźnika: pliki wyjściowe i stan pasa
+ */
+typedef struct
+{
+    BandMathProgram* program;
+    GDALDatasetH value_dataset;
+    GDALDatasetH source_dataset;
+    // Pas mozaiki i numer sceny (od 1) źródła każdego piksela
+    float* values;
+    uint32_t* sources;
+    // Wynik bieżącego kafla w pasie (szerokość kafla)
+    float* tile_values;
+} MosaicLayer;
+
+typedef struct
+{
+    const BatchScene* scenes;
+    const MosaicConfig* config;
+    unsigned int band_mask;
+    // Kafle w kolejności pierwszeństwa reguły
+    MosaicTile* tiles;
+    int tile_count;
+    int width;
+    int height;
+    int max_tile_width;
+    double geo_transform[6];
+    char* projection;
+    int strip_rows;
+    MosaicLayer* layers;
+    int layer_count;
+    // Fragmenty pasów kafli pominięte, bo lepsze kafle wypełniły je w całości
+    int skipped_tile_strips;
+} MosaicState;
+
+static const char* MOSAIC_RULE_NAMES[] = {
+    [MOSAIC_LEAST_CLOUD] = "least-cloud",
+    [MOSAIC_LATEST] = "latest"
+};
+
+// ====== PRZYGOTOWANIE ======
+static int prepare_tiles(MosaicState* state, int scene_count);
+static int place_tile(MosaicState* state, MosaicTile* tile, const double geo_transform[6], const char* projection);
+static int estimate_cloud_fraction(const char* scl_path, float* fraction_out);
+static void order_tiles(MosaicState* state);
+static int compare_least_cloud(const void* a, const void* b);
+static int compare_latest(const void* a, const void* b);
+static int open_layers(MosaicState* state);
+static int choose_strip_rows(MosaicState* state);
+static void close_layers(MosaicState* state);
+// ====== PASY ======
+static int mosaic_strip(MosaicState* state, int y_start, int y_end);
+static bool tile_has_gaps(const MosaicState* state, const MosaicTile* tile, int y_start, int y_end, int strip_y);
+static int evaluate_tile_strip(MosaicState* state, const MosaicTile* tile, int y_start, int y_end);
+static void merge_tile_strip(MosaicState* state, const MosaicTile* tile, int y_start, int y_end, int strip_y);
+static int write_strip(const MosaicState* state, int y_start, int y_end);
+
+int run_mosaic(const BatchScene* scenes, int count, const MosaicConfig* config)
+{
+    if (!scenes || count <= 0 || !config || !config->output_dir)
+    {
+        fprintf(stderr, "[%s] [MOZAIKA] Brak kafli do złożenia.\n", get_timestamp());
+        return -1;
+    }
+    if (g_mkdir_with_parents(config->output_dir, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu wyjściowego %s.\n", get_timestamp(), config->output_dir);
+        return -1;
+    }
+
+    pipeline_global_init();
+
+    MosaicState state = {
+        .scenes = scenes,
+        .config = config,
+        .band_mask = pipeline_index_band_mask(config->indices)
+    };
+
+    gint64 start_us = g_get_monotonic_time();
+    int status = prepare_tiles(&state, count);
+    if (status == 0)
+    {
+        order_tiles(&state);
+        status = open_layers(&state);
+    }
+    if (status == 0)
+    {
+        status = choose_strip_rows(&state);
+    }
+
+    for (int y = 0; status == 0 && y < state.height; y += state.strip_rows)
+    {
+        int y_end = y + state.strip_rows < state.height ? y + state.strip_rows : state.height;
+        status = mosaic_strip(&state, y, y_end);
+        if (status == 0)
+        {
+            printf("[%s] [MOZAIKA] Wiersze %d-%d z %d gotowe\n", get_timestamp(), y, y_end, state.height);
+        }
+    }
+
+    close_layers(&state);
+    g_free(state.projection);
+    free(state.tiles);
+
+    if (status == 0)
+    {
+        printf("[%s] [MOZAIKA] Gotowe: %d kafli, reguła %s, pominięte fragmenty pasów: %d, %.2fs\n",
+               get_timestamp(), state.tile_count, mosaic_rule_name(config->rule), state.skipped_tile_strips,
+               (g_get_monotonic_time() - start_us) / 1e6);
+    }
+    return status;
+}
+
+int mosaic_rule_from_name(const char* name, MosaicRule* rule_out)
+{
+    for (int r = 0; r < (int)(sizeof(MOSAIC_RULE_NAMES) / sizeof(MOSAIC_RULE_NAMES[0])); r++)
+    {
+        if (name && g_ascii_strcasecmp(name, MOSAIC_RULE_NAMES[r]) == 0)
+        {
+            *rule_out = (MosaicRule)r;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* mosaic_rule_name(MosaicRule rule)
+{
+    return MOSAIC_RULE_NAMES[rule];
+}
+
+// ====== PRZYGOTOWANIE ======
+
+// Siatka i georeferencja każdego kafla z nagłówków pasm; kafle niepasujące do pierwszego są pomijane
+static int prepare_tiles(MosaicState* state, int scene_count)
+{
+    const MosaicConfig* config = state->config;
+
+    state->tiles = calloc(scene_count, sizeof(MosaicTile));
+    if (!state->tiles)
+    {
+        fprintf(stderr, "[%s] [MOZAIKA] Błąd alokacji pamięci.\n", get_timestamp());
+        return -1;
+    }
+
+    for (int s = 0; s < scene_count; s++)
+    {
+        const BatchScene* scene = &state->scenes[s];
+        MosaicTile* tile = &state->tiles[state->tile_count];
+        *tile = (MosaicTile){.scene = s, .date = composite_scene_date(scene->name)};
+
+        int reference;
+        double geo_transform[6];
+        char* projection = NULL;
+        if (pipeline_target_grid(scene->paths, state->band_mask, config->target_10m, &tile->width, &tile->height,
+                                 &reference) != 0 ||
+            read_scaled_georeference(scene->paths[reference], tile->width, tile->height, geo_transform,
+                                     &projection) != 0)
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Kafel %s pominięty: brak siatki lub georeferencji.\n",
+                    get_timestamp(), scene->name);
+            g_free(projection);
+            continue;
+        }
+
+        // Odczyt sprawdzany przed place_tile(), żeby odrzucony kafel nie wyznaczył siatki mozaiki
+        tile->reader_row_bytes = strip_index_source_row_bytes(scene->paths, config->indices, tile->width,
+                                                              tile->height);
+        if (tile->reader_row_bytes == 0 ||
+            (config->rule == MOSAIC_LEAST_CLOUD &&
+             estimate_cloud_fraction(scene->paths[SCL], &tile->cloud_fraction) != 0))
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Kafel %s pominięty: nie można odczytać pasm.\n",
+                    get_timestamp(), scene->name);
+            g_free(projection);
+            continue;
+        }
+
+        int placed = place_tile(state, tile, geo_transform, projection);
+        g_free(projection);
+        if (placed != 0)
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Kafel %s pominięty: inna projekcja, rozmiar piksela "
+                    "lub przesunięcie o niecałkowitą liczbę pikseli.\n", get_timestamp(), scene->name);
+            continue;
+        }
+        if (config->rule == MOSAIC_LATEST && tile->date == 0)
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Kafel %s bez daty w nazwie - najniższe pierwszeństwo.\n",
+                    get_timestamp(), scene->name);
+        }
+
+        state->max_tile_width = tile->width > state->max_tile_width ? tile->width : state->max_tile_width;
+        state->tile_count++;
+        printf("[%s] [MOZAIKA] Kafel %s: %dx%d od (%d, %d), data %u", get_timestamp(), scene->name,
+               tile->width, tile->height, tile->x_offset, tile->y_offset, tile->date);
+        if (config->rule == MOSAIC_LEAST_CLOUD)
+        {
+            printf(", zachmurzenie %.1f%%", tile->cloud_fraction * 100.0f);
+        }
+        printf("\n");
+    }
+
+    if (state->tile_count == 0)
+    {
+        fprintf(stderr, "[%s] [MOZAIKA] Brak kafli o wspólnej siatce.\n", get_timestamp());
+        return -1;
+    }
+
+    // Przesunięcia względem pierwszego kafla -> względem lewego górnego rogu sumy zasięgów
+    int min_x = state->tiles[0].x_offset;
+    int min_y = state->tiles[0].y_offset;
+    int max_x = min_x + state->tiles[0].width;
+    int max_y = min_y + state->tiles[0].height;
+    for (int t = 1; t < state->tile_count; t++)
+    {
+        const MosaicTile* tile = &state->tiles[t];
+        min_x = tile->x_offset < min_x ? tile->x_offset : min_x;
+        min_y = tile->y_offset < min_y ? tile->y_offset : min_y;
+        max_x = tile->x_offset + tile->width > max_x ? tile->x_offset + tile->width : max_x;
+        max_y = tile->y_offset + tile->height > max_y ? tile->y_offset + tile->height : max_y;
+    }
+    for (int t = 0; t < state->tile_count; t++)
+    {
+        state->tiles[t].x_offset -= min_x;
+        state->tiles[t].y_offset -= min_y;
+    }
+    state->width = max_x - min_x;
+    state->height = max_y - min_y;
+    state->geo_transform[0] += min_x * state->geo_transform[1];
+    state->geo_transform[3] += min_y * state->geo_transform[5];
+    return 0;
+}
+
+// Położenie kafla w pikselach względem pierwszego kafla; pierwszy wyznacza projekcję i rozmiar piksela
+static int place_tile(MosaicState* state, MosaicTile* tile, const double geo_transform[6], const char* projection)
+{
+    // Siatki obrócone nie są obsługiwane
+    if (geo_transform[2] != 0.0 || geo_transform[4] != 0.0)
+    {
+        return -1;
+    }
+
+    if (!state->projection)
+    {
+        memcpy(state->geo_transform, geo_transform, sizeof(state->geo_transform));
+        state->projection = g_strdup(projection);
+        tile->x_offset = 0;
+        tile->y_offset = 0;
+        return 0;
+    }
+
+    const double* base = state->geo_transform;
+    if (strcmp(projection, state->projection) != 0 ||
+        fabs(geo_transform[1] - base[1]) > 1e-6 * fabs(base[1]) ||
+        fabs(geo_transform[5] - base[5]) > 1e-6 * fabs(base[5]))
+    {
+        return -1;
+    }
+
+    double x_offset = (geo_transform[0] - base[0]) / base[1];
+    double y_offset = (geo_transform[3] - base[3]) / base[5];
+    if (fabs(x_offset - round(x_offset)) > MOSAIC_ALIGNMENT_TOLERANCE ||
+        fabs(y_offset - round(y_offset)) > MOSAIC_ALIGNMENT_TOLERANCE)
+    {
+        return -1;
+    }
+    tile->x_offset = (int)round(x_offset);
+    tile->y_offset = (int)round(y_offset);
+    return 0;
+}
+
+// Udział chmur z SCL czytanego w zmniejszonej rozdzielczości (bez dekodowania pełnego pasma)
+static int estimate_cloud_fraction(const char* scl_path, float* fraction_out)
+{
+    GDALDatasetH dataset = GDALOpen(scl_path, GA_ReadOnly);
+    if (!dataset)
+    {
+        fprintf(stderr, "Nie można otworzyć pliku %s: %s\n", scl_path, CPLGetLastErrorMsg());
+        return -1;
+    }
+
+    int width = GDALGetRasterXSize(dataset);
+    int height = GDALGetRasterYSize(dataset);
+    int longest = width > height ? width : height;
+    double scale = longest > MOSAIC_CLOUD_SAMPLE_SIZE ? (double)MOSAIC_CLOUD_SAMPLE_SIZE / longest : 1.0;
+    int sample_width = width * scale >= 1.0 ? (int)(width * scale) : 1;
+    int sample_height = height * scale >= 1.0 ? (int)(height * scale) : 1;
+
+    unsigned char* classes = malloc((size_t)sample_width * sample_height);
+    CPLErr err = classes ? GDALRasterIO(GDALGetRasterBand(dataset, 1), GF_Read, 0, 0, width, height, classes,
+                                        sample_width, sample_height, GDT_Byte, 0, 0) : CE_Failure;
+    GDALClose(dataset);
+    if (err != CE_None)
+    {
+        fprintf(stderr, "Błąd odczytu SCL %s: %s\n", scl_path, CPLGetLastErrorMsg());
+        free(classes);
+        return -1;
+    }
+
+    // Piksele bez danych (klasa 0, np. poza pasem przelotu) nie wpływają na ocenę kafla
+    size_t with_data = 0, cloudy = 0;
+    for (size_t p = 0; p < (size_t)sample_width * sample_height; p++)
+    {
+        unsigned int scl_class = classes[p] < 32 ? classes[p] : 0;
+        with_data += scl_class != 0;
+        cloudy += (MOSAIC_CLOUD_CLASSES >> scl_class) & 1u;
+    }
+    free(classes);
+
+    // Kafel bez danych trafia na koniec kolejności
+    *fraction_out = with_data > 0 ? (float)cloudy / with_data : 1.0f;
+    return 0;
+}
+
+static void order_tiles(MosaicState* state)
+{
+    qsort(state->tiles, state->tile_count, sizeof(MosaicTile),
+          state->config->rule == MOSAIC_LEAST_CLOUD ? compare_least_cloud : compare_latest);
+
+    for (int t = 0; t < state->tile_count; t++)
+    {
+        printf("[%s] [MOZAIKA] Pierwszeństwo %d: %s\n", get_timestamp(), t + 1,
+               state->scenes[state->tiles[t].scene].name);
+    }
+}
+
+// Mniej chmur wygrywa; przy remisie późniejsza data, potem kolejność w manifeście
+static int compare_least_cloud(const void* a, const void* b)
+{
+    const MosaicTile* tile_a = a;
+    const MosaicTile* tile_b = b;
+    if (tile_a->cloud_fraction != tile_b->cloud_fraction)
+    {
+        return tile_a->cloud_fraction < tile_b->cloud_fraction ? -1 : 1;
+    }
+    return compare_latest(a, b);
+}
+
+// Późniejsza data wygrywa (brak daty to 0); przy remisie kolejność w manifeście
+static int compare_latest(const void* a, const void* b)
+{
+    const MosaicTile* tile_a = a;
+    const MosaicTile* tile_b = b;
+    if (tile_a->date != tile_b->date)
+    {
+        return tile_a->date > tile_b->date ? -1 : 1;
+    }
+    return tile_a->scene - tile_b->scene;
+}
+
+static int open_layers(MosaicState* state)
+{
+    for (int k = 0; pipeline_index_name(k); k++)
+    {
+        if (state->config->indices & (1u << k))
+        {
+            state->layer_count++;
+        }
+    }
+
+    state->layers = calloc(state->layer_count, sizeof(MosaicLayer));
+    if (!state->layers)
+    {
+        fprintf(stderr, "[%s] [MOZAIKA] Błąd alokacji pamięci.\n", get_timestamp());
+        return -1;
+    }
+
+    for (int k = 0, l = 0; pipeline_index_name(k); k++)
+    {
+        if (!(state->config->indices & (1u << k)))
+        {
+            continue;
+        }
+        MosaicLayer* layer = &state->layers[l++];
+        layer->program = band_math_compile_builtin(pipeline_index_name(k));
+
+        for (int source_layer = 0; source_layer < 2; source_layer++)
+        {
+            gchar* path = g_strdup_printf("%s/mosaic_%s_%s%s.tif", state->config->output_dir,
+                                          mosaic_rule_name(state->config->rule), pipeline_index_name(k),
+                                          source_layer ? "_source" : "");
+            GDALDatasetH dataset = create_geotiff(path, state->width, state->height,
+                                                  source_layer ? GDT_UInt32 : GDT_Float32,
+                                                  source_layer ? 0.0 : INDEX_NO_DATA_VALUE,
+                                                  state->geo_transform, state->projection);
+            if (dataset)
+            {
+                printf("[%s] [MOZAIKA] Zapis do %s\n", get_timestamp(), path);
+            }
+            g_free(path);
+            *(source_layer ? &layer->source_dataset : &layer->value_dataset) = dataset;
+        }
+
+        if (!layer->program || !layer->value_dataset || !layer->source_dataset)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Wysokość pasa mieszcząca w budżecie pas mozaiki i czytnik pasów najbardziej wymagającego kafla
+static int choose_strip_rows(MosaicState* state)
+{
+    const MosaicConfig* config = state->config;
+    size_t budget = config->memory_budget > 0 ? config->memory_budget : MOSAIC_DEFAULT_BUDGET_BYTES;
+
+    // Kafle czytane są po kolei, więc w pamięci jest czytnik tylko jednego z nich
+    size_t reader_row_bytes = 0;
+    for (int t = 0; t < state->tile_count; t++)
+    {
+        reader_row_bytes = state->tiles[t].reader_row_bytes > reader_row_bytes ? state->tiles[t].reader_row_bytes
+                                                                               : reader_row_bytes;
+    }
+
+    // Na warstwę: wartość i źródło piksela mozaiki oraz wynik kafla
+    size_t layer_row_bytes = (size_t)state->width * (sizeof(float) + sizeof(uint32_t)) +
+                             (size_t)state->max_tile_width * sizeof(float);
+    size_t row_bytes = reader_row_bytes + state->layer_count * layer_row_bytes;
+
+    size_t rows = budget / row_bytes;
+    if (rows == 0)
+    {
+        fprintf(stderr, "[%s] [MOZAIKA] Budżet pamięci %.1f MB nie mieści jednego wiersza (%.1f MB).\n",
+                get_timestamp(), budget / (1024.0 * 1024.0), row_bytes / (1024.0 * 1024.0));
+        return -1;
+    }
+    rows = rows < MOSAIC_MAX_STRIP_ROWS ? rows : MOSAIC_MAX_STRIP_ROWS;
+    state->strip_rows = rows < (size_t)state->height ? (int)rows : state->height;
+
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        MosaicLayer* layer = &state->layers[l];
+        layer->values = malloc((size_t)state->strip_rows * state->width * sizeof(float));
+        layer->sources = malloc((size_t)state->strip_rows * state->width * sizeof(uint32_t));
+        layer->tile_values = malloc((size_t)state->strip_rows * state->max_tile_width * sizeof(float));
+        if (!layer->values || !layer->sources || !layer->tile_values)
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Błąd alokacji pamięci pasa.\n", get_timestamp());
+            return -1;
+        }
+    }
+
+    printf("[%s] [MOZAIKA] %d kafli, reguła %s, siatka %dx%d, pas %d wierszy (%.1f MB)\n",
+           get_timestamp(), state->tile_count, mosaic_rule_name(config->rule), state->width, state->height,
+           state->strip_rows, state->strip_rows * row_bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+static void close_layers(MosaicState* state)
+{
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        MosaicLayer* layer = &state->layers[l];
+        band_math_free(layer->program);
+        if (layer->value_dataset)
+        {
+            GDALClose(layer->value_dataset);
+        }
+        if (layer->source_dataset)
+        {
+            GDALClose(layer->source_dataset);
+        }
+        free(layer->values);
+        free(layer->sources);
+        free(layer->tile_values);
+    }
+    free(state->layers);
+    state->layers = NULL;
+    state->layer_count = 0;
+}
+
+// ====== PASY ======
+
+// Kafle w kolejności pierwszeństwa wypełniają tylko piksele pasa, które nie mają jeszcze wartości
+static int mosaic_strip(MosaicState* state, int y_start, int y_end)
+{
+    size_t strip_pixels = (size_t)(y_end - y_start) * state->width;
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        MosaicLayer* layer = &state->layers[l];
+        #pragma omp parallel for simd schedule(static)
+        for (size_t p = 0; p < strip_pixels; p++)
+        {
+            layer->values[p] = INDEX_NO_DATA_VALUE;
+            layer->sources[p] = 0;
+        }
+    }
+
+    for (int t = 0; t < state->tile_count; t++)
+    {
+        const MosaicTile* tile = &state->tiles[t];
+        int tile_y_start = y_start > tile->y_offset ? y_start : tile->y_offset;
+        int tile_y_end = y_end < tile->y_offset + tile->height ? y_end : tile->y_offset + tile->height;
+        if (tile_y_start >= tile_y_end)
+        {
+            continue;
+        }
+        if (!tile_has_gaps(state, tile, tile_y_start, tile_y_end, y_start))
+        {
+            state->skipped_tile_strips++;
+            continue;
+        }
+
+        if (evaluate_tile_strip(state, tile, tile_y_start, tile_y_end) != 0)
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Błąd przetwarzania kafla %s (wiersze %d-%d).\n",
+                    get_timestamp(), state->scenes[tile->scene].name, tile_y_start, tile_y_end);
+            return -1;
+        }
+        merge_tile_strip(state, tile, tile_y_start, tile_y_end, y_start);
+    }
+
+    return write_strip(state, y_start, y_end);
+}
+
+// Czy w obszarze kafla w pasie został piksel bez wartości w którejkolwiek warstwie
+static bool tile_has_gaps(const MosaicState* state, const MosaicTile* tile, int y_start, int y_end, int strip_y)
+{
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        for (int y = y_start; y < y_end; y++)
+        {
+            const float* row = state->layers[l].values + (size_t)(y - strip_y) * state->width + tile->x_offset;
+            for (int x = 0; x < tile->width; x++)
+            {
+                if (row[x] == INDEX_NO_DATA_VALUE)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Czytnik pasów kafla jest otwierany tylko na czas pasa, więc pamięć nie rośnie z liczbą kafli
+static int evaluate_tile_strip(MosaicState* state, const MosaicTile* tile, int y_start, int y_end)
+{
+    StripIndexSource source;
+    if (strip_index_source_open(&source, state->scenes[tile->scene].paths, state->config->indices, tile->width,
+                                tile->height, state->strip_rows) != 0)
+    {
+        return -1;
+    }
+
+    BandMathProgram* programs[PIPELINE_INDEX_COUNT];
+    float* outputs[PIPELINE_INDEX_COUNT];
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        programs[l] = state->layers[l].program;
+        outputs[l] = state->layers[l].tile_values;
+    }
+
+    int status = strip_index_source_evaluate(&source, programs, state->layer_count, y_start - tile->y_offset,
+                                             y_end - tile->y_offset, outputs);
+    strip_index_source_close(&source);
+    return status;
+}
+
+static void merge_tile_strip(MosaicState* state, const MosaicTile* tile, int y_start, int y_end, int strip_y)
+{
+    uint32_t source = (uint32_t)tile->scene + 1;
+
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        MosaicLayer* layer = &state->layers[l];
+
+        #pragma omp parallel for schedule(static)
+        for (int y = y_start; y < y_end; y++)
+        {
+            const float* tile_row = layer->tile_values + (size_t)(y - y_start) * tile->width;
+            size_t row_start = (size_t)(y - strip_y) * state->width + tile->x_offset;
+            float* values = layer->values + row_start;
+            uint32_t* sources = layer->sources + row_start;
+
+            #pragma omp simd
+            for (int x = 0; x < tile->width; x++)
+            {
+                bool fill = values[x] == INDEX_NO_DATA_VALUE && tile_row[x] != INDEX_NO_DATA_VALUE;
+                values[x] = fill ? tile_row[x] : values[x];
+                sources[x] = fill ? source : sources[x];
+            }
+        }
+    }
+}
+
+static int write_strip(const MosaicState* state, int y_start, int y_end)
+{
+    int rows = y_end - y_start;
+
+    for (int l = 0; l < state->layer_count; l++)
+    {
+        const MosaicLayer* layer = &state->layers[l];
+        CPLErr err = GDALRasterIO(GDALGetRasterBand(layer->value_dataset, 1), GF_Write, 0, y_start, state->width,
+                                  rows, layer->values, state->width, rows, GDT_Float32, 0, 0);
+        if (err == CE_None)
+        {
+            err = GDALRasterIO(GDALGetRasterBand(layer->source_dataset, 1), GF_Write, 0, y_start, state->width,
+                               rows, layer->sources, state->width, rows, GDT_UInt32, 0, 0);
+        }
+        if (err != CE_None)
+        {
+            fprintf(stderr, "[%s] [MOZAIKA] Błąd zapisu wierszy %d-%d: %s\n", get_timestamp(), y_start, y_end,
+                    CPLGetLastErrorMsg());
+            return -1;
+        }
+    }
+    return 0;
+}
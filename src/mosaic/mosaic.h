@@ -0,0 +1,71 @@
+#ifndef MOSAIC_H
+#define MOSAIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../batch_scheduler/batch_scheduler.h"
+
+/**
+ * @brief Reguła wyboru kafla tam, gdzie sąsiednie kafle się nakładają
+ */
+typedef enum
+{
+    // Kafel o najmniejszym udziale chmur i cieni chmur w SCL
+    MOSAIC_LEAST_CLOUD,
+    // Kafel o najpóźniejszej dacie akwizycji (z nazwy sceny)
+    MOSAIC_LATEST
+} MosaicRule;
+
+/**
+ * @brief Konfiguracja trybu mozaiki wielu kafli
+ */
+typedef struct
+{
+    MosaicRule rule;
+    // Wskaźniki (flagi PipelineIndex) - każdy ma własną mozaikę
+    unsigned int indices;
+    bool target_10m;
+    // Budżet pamięci pasów (pas mozaiki i czytnik jednego kafla), 0 - MOSAIC_DEFAULT_BUDGET_BYTES
+    size_t memory_budget;
+    const char* output_dir;
+} MosaicConfig;
+
+// Budżet pamięci mozaiki, gdy nie podano --max-memory
+#define MOSAIC_DEFAULT_BUDGET_BYTES ((size_t)1 << 30)
+
+/**
+ * @brief Składa wskaźniki sąsiednich kafli (np. Sentinel-2 nakładających się o ~10 km) w jedną mapę regionu
+ *
+ * Położenie kafli wyznaczają geotransformacje GDAL ich pasm odniesienia: siatka mozaiki to suma
+ * zasięgów kafli z rozmiarem piksela pierwszego kafla. Kafle muszą mieć tę samą projekcję i rozmiar
+ * piksela, a ich przesunięcia muszą być całkowitą liczbą pikseli (kafle jednej strefy UTM);
+ * pozostałe są pomijane.
+ *
+ * Kafle są szeregowane według reguły (udział chmur z SCL albo data), a mozaika liczona jest pasami
+ * wierszy: dla każdego pasa kolejne kafle, które go przecinają, otwierane są czytnikiem pasów,
+ * ich wskaźniki liczone silnikiem band_math (z maskowaniem SCL), a piksel mozaiki dostaje wartość
+ * pierwszego kafla, w którym jest ważny. Piksel zasłonięty chmurą w lepszym kaflu wypełnia więc
+ * następny kafel, a kafel, którego fragment pasa jest już w całości wypełniony, nie jest czytany.
+ * Gotowy pas trafia od razu do plików, więc pamięć zależy od szerokości mozaiki i wysokości pasa,
+ * a nie od liczby kafli.
+ *
+ * Dla każdego wskaźnika zapisywane są GeoTIFF-y:
+ * - <output_dir>/mosaic_<reguła>_<WSKAŹNIK>.tif - wartości mozaiki (float32, brak danych -2)
+ * - <output_dir>/mosaic_<reguła>_<WSKAŹNIK>_source.tif - warstwa źródła (uint32, brak danych 0):
+ *   numer sceny kafla w manifeście (od 1), z której pochodzi wartość
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int run_mosaic(const BatchScene* scenes, int count, const MosaicConfig* config);
+
+/**
+ * @brief Reguła mozaiki dla nazwy "least-cloud" lub "latest"
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy nazwa jest nieznana
+ */
+int mosaic_rule_from_name(const char* name, MosaicRule* rule_out);
+
+const char* mosaic_rule_name(MosaicRule rule);
+
+#endif // MOSAIC_H
@@ -0,0 +1,376 @@
+#include "ndindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <glib.h>
+#include <gdal.h>
+
+#include "../index_calculator/index_calculator.h"
+#include "../resampler/resampler.h"
+#include "../data_loader/data_loader.h"
+#include "../colormap/colormap.h"
+
+// Wysokość pasa wierszy wyjściowych, gdy resampling nie może działać wprost na buforach wywołującego
+#define NDINDEX_RESAMPLE_STRIP_ROWS 256
+
+// Stan jednorazowej rejestracji sterowników GDAL
+static gsize gdal_initialized = 0;
+
+// ====== WALIDACJA ======
+static int validate_raster(const NdIndexRaster* raster);
+static int validate_same_size(const NdIndexRaster* a, const NdIndexRaster* b);
+
+// ====== POMOCNICZE ======
+static size_t dtype_size(NdIndexDataType dtype);
+static size_t raster_stride(const NdIndexRaster* raster);
+static bool is_packed_float(const NdIndexRaster* raster);
+static const void* raster_row(const NdIndexRaster* raster, int y);
+static const float* row_as_float(const NdIndexRaster* raster, int y, float* scratch);
+static void convert_rows_to_float(const NdIndexRaster* raster, int y_start, int y_end, float* output);
+static ResampleMethod to_resample_method(NdIndexResampleMethod method);
+
+int ndindex_api_version(void)
+{
+    return NDINDEX_API_VERSION;
+}
+
+const char* ndindex_status_message(int status)
+{
+    switch (status)
+    {
+    case NDINDEX_OK:
+        return "ok";
+    case NDINDEX_ERROR_INVALID_ARGUMENT:
+        return "invalid argument";
+    case NDINDEX_ERROR_SIZE_MISMATCH:
+        return "raster size mismatch";
+    case NDINDEX_ERROR_OUT_OF_MEMORY:
+        return "out of memory";
+    case NDINDEX_ERROR_IO:
+        return "raster I/O error";
+    default:
+        return "unknown status";
+    }
+}
+
+void ndindex_init(void)
+{
+    if (g_once_init_enter(&gdal_initialized))
+    {
+        GDALAllRegister();
+        g_once_init_leave(&gdal_initialized, 1);
+    }
+}
+
+int ndindex_band_size(const char* path, int* width, int* height)
+{
+    if (!path || !width || !height)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+
+    ndindex_init();
+    return read_band_dimensions(path, width, height, NULL) == 0 ? NDINDEX_OK : NDINDEX_ERROR_IO;
+}
+
+int ndindex_read_band(const char* path, NdIndexRaster* output)
+{
+    int status = validate_raster(output);
+    if (!path || status != NDINDEX_OK)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+
+    ndindex_init();
+
+    int width = 0, height = 0;
+    if (read_band_dimensions(path, &width, &height, NULL) != 0)
+    {
+        return NDINDEX_ERROR_IO;
+    }
+    if (width != output->width || height != output->height)
+    {
+        return NDINDEX_ERROR_SIZE_MISMATCH;
+    }
+
+    return read_band_into_buffer(path, output->data, width, height, output->dtype == NDINDEX_DTYPE_UINT16,
+                                 raster_stride(output)) == 0 ? NDINDEX_OK : NDINDEX_ERROR_IO;
+}
+
+int ndindex_resample(const NdIndexRaster* input, NdIndexResampleMethod method, NdIndexRaster* output)
+{
+    if (validate_raster(input) != NDINDEX_OK || validate_raster(output) != NDINDEX_OK ||
+        output->dtype != NDINDEX_DTYPE_FLOAT32 || method < NDINDEX_RESAMPLE_NEAREST ||
+        method > NDINDEX_RESAMPLE_AVERAGE)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+
+    ResampleMethod resample_method = to_resample_method(method);
+    bool input_direct = is_packed_float(input);
+    bool output_direct = is_packed_float(output);
+
+    // Przy ciasnych buforach float jedno wywołanie jądra dla całego obrazu, bez buforów roboczych
+    int strip_rows = input_direct && output_direct ? output->height : NDINDEX_RESAMPLE_STRIP_ROWS;
+    float* input_scratch = NULL;
+    float* output_scratch = NULL;
+
+    if (!input_direct)
+    {
+        int max_input_rows = 0;
+        for (int y = 0; y < output->height; y += strip_rows)
+        {
+            int y_end = y + strip_rows < output->height ? y + strip_rows : output->height;
+            int y_in_start, y_in_end;
+            resample_input_row_range(resample_method, input->height, output->height, y, y_end,
+                                     &y_in_start, &y_in_end);
+            if (y_in_end - y_in_start > max_input_rows)
+            {
+                max_input_rows = y_in_end - y_in_start;
+            }
+        }
+        input_scratch = malloc((size_t)max_input_rows * input->width * sizeof(float));
+    }
+    if (!output_direct)
+    {
+        output_scratch = malloc((size_t)strip_rows * output->width * sizeof(float));
+    }
+    if ((!input_direct && !input_scratch) || (!output_direct && !output_scratch))
+    {
+        free(input_scratch);
+        free(output_scratch);
+        return NDINDEX_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (int y = 0; y < output->height; y += strip_rows)
+    {
+        int y_end = y + strip_rows < output->height ? y + strip_rows : output->height;
+        int y_in_start, y_in_end;
+        resample_input_row_range(resample_method, input->height, output->height, y, y_end,
+                                 &y_in_start, &y_in_end);
+
+        const float* input_rows = (const float*)input->data + (size_t)y_in_start * input->width;
+        if (!input_direct)
+        {
+            convert_rows_to_float(input, y_in_start, y_in_end, input_scratch);
+            input_rows = input_scratch;
+        }
+        float* output_rows = output_direct ? (float*)output->data + (size_t)y * output->width : output_scratch;
+
+        resample_rows(resample_method, input_rows, y_in_start, output_rows,
+                      input->width, input->height, output->width, output->height, y, y_end);
+
+        if (!output_direct)
+        {
+            for (int row = y; row < y_end; row++)
+            {
+                memcpy((char*)output->data + (size_t)row * raster_stride(output),
+                       output_scratch + (size_t)(row - y) * output->width, output->width * sizeof(float));
+            }
+        }
+    }
+
+    free(input_scratch);
+    free(output_scratch);
+    return NDINDEX_OK;
+}
+
+int ndindex_normalized_difference(const NdIndexRaster* band_a, const NdIndexRaster* band_b,
+                                  const NdIndexRaster* scl, NdIndexRaster* output)
+{
+    if (validate_raster(band_a) != NDINDEX_OK || validate_raster(band_b) != NDINDEX_OK ||
+        (scl && validate_raster(scl) != NDINDEX_OK) || validate_raster(output) != NDINDEX_OK ||
+        output->dtype != NDINDEX_DTYPE_FLOAT32)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+    if (validate_same_size(band_a, output) != NDINDEX_OK || validate_same_size(band_b, output) != NDINDEX_OK ||
+        (scl && validate_same_size(scl, output) != NDINDEX_OK))
+    {
+        return NDINDEX_ERROR_SIZE_MISMATCH;
+    }
+
+    int width = output->width;
+    int height = output->height;
+    bool needs_scratch = band_a->dtype != NDINDEX_DTYPE_FLOAT32 || band_b->dtype != NDINDEX_DTYPE_FLOAT32 ||
+                         (scl && scl->dtype != NDINDEX_DTYPE_FLOAT32);
+    int status = NDINDEX_OK;
+
+    #pragma omp parallel shared(status)
+    {
+        // Po trzy wiersze na wątek na konwersję uint16 - pełne rastry nie są kopiowane
+        float* scratch = needs_scratch ? malloc(3 * (size_t)width * sizeof(float)) : NULL;
+        if (needs_scratch && !scratch)
+        {
+            #pragma omp atomic write
+            status = NDINDEX_ERROR_OUT_OF_MEMORY;
+        }
+
+        #pragma omp for
+        for (int y = 0; y < height; y++)
+        {
+            if (needs_scratch && !scratch)
+            {
+                continue;
+            }
+
+            const float* a_row = row_as_float(band_a, y, scratch);
+            const float* b_row = row_as_float(band_b, y, scratch ? scratch + width : NULL);
+            const float* scl_row = scl ? row_as_float(scl, y, scratch ? scratch + 2 * (size_t)width : NULL) : NULL;
+            float* output_row = (float*)((char*)output->data + (size_t)y * raster_stride(output));
+
+            calculate_normalized_difference_row(a_row, b_row, scl_row, width, output_row);
+        }
+
+        free(scratch);
+    }
+
+    return status;
+}
+
+int ndindex_ndvi(const NdIndexRaster* nir, const NdIndexRaster* red,
+                 const NdIndexRaster* scl, NdIndexRaster* output)
+{
+    return ndindex_normalized_difference(nir, red, scl, output);
+}
+
+int ndindex_ndmi(const NdIndexRaster* nir, const NdIndexRaster* swir1,
+                 const NdIndexRaster* scl, NdIndexRaster* output)
+{
+    return ndindex_normalized_difference(nir, swir1, scl, output);
+}
+
+int ndindex_colorize(const NdIndexRaster* index, unsigned char* rgb, size_t rgb_stride)
+{
+    if (validate_raster(index) != NDINDEX_OK || index->dtype != NDINDEX_DTYPE_FLOAT32 || !rgb ||
+        rgb_stride < 3 * (size_t)index->width)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+
+    #pragma omp parallel for
+    for (int y = 0; y < index->height; y++)
+    {
+        colorize_index_row(raster_row(index, y), index->width, rgb + (size_t)y * rgb_stride, 3);
+    }
+
+    return NDINDEX_OK;
+}
+
+int ndindex_write_geotiff(const char* path, const NdIndexRaster* raster)
+{
+    if (!path || validate_raster(raster) != NDINDEX_OK)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+
+    ndindex_init();
+
+    GDALDriverH driver = GDALGetDriverByName("GTiff");
+    GDALDataType type = raster->dtype == NDINDEX_DTYPE_UINT16 ? GDT_UInt16 : GDT_Float32;
+    GDALDatasetH dataset = driver ? GDALCreate(driver, path, raster->width, raster->height, 1, type, NULL) : NULL;
+    if (!dataset)
+    {
+        fprintf(stderr, "Błąd: Nie można utworzyć pliku %s: %s\n", path, CPLGetLastErrorMsg());
+        return NDINDEX_ERROR_IO;
+    }
+
+    // Zapis wprost z bufora wywołującego - krok wierszy przekazywany do GDAL
+    CPLErr err = GDALRasterIO(GDALGetRasterBand(dataset, 1), GF_Write, 0, 0, raster->width, raster->height,
+                              raster->data, raster->width, raster->height, type,
+                              (int)dtype_size(raster->dtype), (int)raster_stride(raster));
+    GDALClose(dataset);
+
+    return err == CE_None ? NDINDEX_OK : NDINDEX_ERROR_IO;
+}
+
+static int validate_raster(const NdIndexRaster* raster)
+{
+    if (!raster || !raster->data || raster->width <= 0 || raster->height <= 0 ||
+        (raster->dtype != NDINDEX_DTYPE_UINT16 && raster->dtype != NDINDEX_DTYPE_FLOAT32))
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+    // Wiersze czytane są jako tablice pikseli, więc stride i data muszą być wyrównane do rozmiaru piksela
+    size_t pixel_size = dtype_size(raster->dtype);
+    if (raster->stride != 0 &&
+        (raster->stride < (size_t)raster->width * pixel_size || raster->stride % pixel_size != 0))
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+    if ((uintptr_t)raster->data % pixel_size != 0)
+    {
+        return NDINDEX_ERROR_INVALID_ARGUMENT;
+    }
+    return NDINDEX_OK;
+}
+
+static int validate_same_size(const NdIndexRaster* a, const NdIndexRaster* b)
+{
+    return a->width == b->width && a->height == b->height ? NDINDEX_OK : NDINDEX_ERROR_SIZE_MISMATCH;
+}
+
+static size_t dtype_size(NdIndexDataType dtype)
+{
+    return dtype == NDINDEX_DTYPE_UINT16 ? sizeof(uint16_t) : sizeof(float);
+}
+
+static size_t raster_stride(const NdIndexRaster* raster)
+{
+    return raster->stride ? raster->stride : (size_t)raster->width * dtype_size(raster->dtype);
+}
+
+static bool is_packed_float(const NdIndexRaster* raster)
+{
+    return raster->dtype == NDINDEX_DTYPE_FLOAT32 && raster_stride(raster) == (size_t)raster->width * sizeof(float);
+}
+
+static const void* raster_row(const NdIndexRaster* raster, int y)
+{
+    return (const char*)raster->data + (size_t)y * raster_stride(raster);
+}
+
+// Wiersz jako float: wprost z bufora dla float32, po konwersji do scratch dla uint16
+static const float* row_as_float(const NdIndexRaster* raster, int y, float* scratch)
+{
+    if (raster->dtype == NDINDEX_DTYPE_FLOAT32)
+    {
+        return raster_row(raster, y);
+    }
+
+    const uint16_t* row = raster_row(raster, y);
+    for (int x = 0; x < raster->width; x++)
+    {
+        scratch[x] = (float)row[x];
+    }
+    return scratch;
+}
+
+static void convert_rows_to_float(const NdIndexRaster* raster, int y_start, int y_end, float* output)
+{
+    #pragma omp parallel for
+    for (int y = y_start; y < y_end; y++)
+    {
+        float* output_row = output + (size_t)(y - y_start) * raster->width;
+        const float* row = row_as_float(raster, y, output_row);
+        if (row != output_row)
+        {
+            memcpy(output_row, row, raster->width * sizeof(float));
+        }
+    }
+}
+
+static ResampleMethod to_resample_method(NdIndexResampleMethod method)
+{
+    switch (method)
+    {
+    case NDINDEX_RESAMPLE_BILINEAR:
+        return RESAMPLE_BILINEAR;
+    case NDINDEX_RESAMPLE_AVERAGE:
+        return RESAMPLE_AVERAGE;
+    default:
+        return RESAMPLE_NEAREST;
+    }
+}
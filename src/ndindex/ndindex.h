@@ -0,0 +1,129 @@
+#ifndef NDINDEX_H
+#define NDINDEX_H
+
+/**
+ * @file ndindex.h
+ * @brief Stabilne C API silnika wskaźników (biblioteka libndindex.so)
+ *
+ * API działa na buforach wywołującego opisanych przez NdIndexRaster (wskaźnik, wymiary,
+ * krok wierszy, typ piksela) i nie zależy od GTK. Dane wejściowe nie są kopiowane: jądra
+ * czytają wiersze bezpośrednio z buforów wywołującego, a piksele uint16 konwertowane są
+ * w buforach roboczych o rozmiarze kilku wierszy na wątek. Wyniki zapisywane są wprost
+ * do bufora wyjściowego z jego krokiem wierszy.
+ *
+ * Nagłówek nie dołącza żadnych nagłówków wewnętrznych projektu. Zmiany niezgodne wstecz
+ * zwiększają NDINDEX_API_VERSION.
+ */
+
+#include <stddef.h>
+
+#define NDINDEX_API_VERSION 1
+
+#if defined(__GNUC__)
+#define NDINDEX_API __attribute__((visibility("default")))
+#else
+#define NDINDEX_API
+#endif
+
+/**
+ * @brief Wartość wskaźnika dla pikseli zamaskowanych lub nieobliczalnych
+ */
+#define NDINDEX_NO_DATA -2.0f
+
+typedef enum
+{
+    NDINDEX_OK = 0,
+    NDINDEX_ERROR_INVALID_ARGUMENT = -1,
+    NDINDEX_ERROR_SIZE_MISMATCH = -2,
+    NDINDEX_ERROR_OUT_OF_MEMORY = -3,
+    NDINDEX_ERROR_IO = -4
+} NdIndexStatus;
+
+typedef enum
+{
+    NDINDEX_DTYPE_UINT16 = 0,
+    NDINDEX_DTYPE_FLOAT32 = 1
+} NdIndexDataType;
+
+typedef enum
+{
+    NDINDEX_RESAMPLE_NEAREST = 0,
+    NDINDEX_RESAMPLE_BILINEAR = 1,
+    NDINDEX_RESAMPLE_AVERAGE = 2
+} NdIndexResampleMethod;
+
+/**
+ * @brief Widok rastra w pamięci wywołującego
+ *
+ * stride to odstęp w bajtach między początkami kolejnych wierszy; 0 oznacza wiersze
+ * ułożone ciasno (width * rozmiar piksela). stride i adres data muszą być wielokrotnością
+ * rozmiaru piksela (w przeciwnym razie NDINDEX_ERROR_INVALID_ARGUMENT). Biblioteka nigdy nie zwalnia data.
+ */
+typedef struct
+{
+    void* data;
+    int width;
+    int height;
+    size_t stride;
+    NdIndexDataType dtype;
+} NdIndexRaster;
+
+NDINDEX_API int ndindex_api_version(void);
+
+NDINDEX_API const char* ndindex_status_message(int status);
+
+/**
+ * @brief Rejestruje sterowniki GDAL używane przez funkcje plikowe
+ *
+ * Wywoływana automatycznie przez ndindex_band_size(), ndindex_read_band() i ndindex_write_geotiff().
+ * Bezpieczna przy wielokrotnych wywołaniach z wielu wątków.
+ */
+NDINDEX_API void ndindex_init(void);
+
+/**
+ * @brief Odczytuje wymiary pierwszego pasma pliku rastrowego (np. .jp2, GeoTIFF)
+ */
+NDINDEX_API int ndindex_band_size(const char* path, int* width, int* height);
+
+/**
+ * @brief Wczytuje pierwsze pasmo pliku do bufora wywołującego (uint16 lub float32, z krokiem)
+ */
+NDINDEX_API int ndindex_read_band(const char* path, NdIndexRaster* output);
+
+/**
+ * @brief Resampluje raster do wymiarów bufora wyjściowego (wyjście float32)
+ *
+ * Dla wejścia float32 z ciasnymi wierszami i ciasnego wyjścia jądro działa bezpośrednio
+ * na buforach wywołującego; w pozostałych przypadkach przetwarza pasy wierszy przez
+ * bufory robocze.
+ */
+NDINDEX_API int ndindex_resample(const NdIndexRaster* input, NdIndexResampleMethod method,
+                                 NdIndexRaster* output);
+
+/**
+ * @brief Oblicza (A - B) / (A + B) z opcjonalną maską SCL do bufora wyjściowego float32
+ *
+ * @param scl Warstwa klasyfikacji sceny o tych samych wymiarach lub NULL (bez maski)
+ */
+NDINDEX_API int ndindex_normalized_difference(const NdIndexRaster* band_a, const NdIndexRaster* band_b,
+                                              const NdIndexRaster* scl, NdIndexRaster* output);
+
+NDINDEX_API int ndindex_ndvi(const NdIndexRaster* nir, const NdIndexRaster* red,
+                             const NdIndexRaster* scl, NdIndexRaster* output);
+
+NDINDEX_API int ndindex_ndmi(const NdIndexRaster* nir, const NdIndexRaster* swir1,
+                             const NdIndexRaster* scl, NdIndexRaster* output);
+
+/**
+ * @brief Koloruje wskaźnik (float32) do bufora RGB 8-bit wywołującego
+ *
+ * @param rgb Bufor index->height wierszy po rgb_stride bajtów (co najmniej 3 * width)
+ */
+NDINDEX_API int ndindex_colorize(const NdIndexRaster* index, unsigned char* rgb, size_t rgb_stride);
+
+/**
+ * @brief Zapisuje raster jako jednopasmowy GeoTIFF (typ piksela jak w rastrze)
+ */
+NDINDEX_API int ndindex_write_geotiff(const char* path, const NdIndexRaster* raster);
+
+#endif // NDINDEX_H
@@ -0,0 +1,159 @@
+#include "pipeline_context.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <glib.h>
+#include <gdal.h>
+
+#include "../data_loader/data_loader.h"
+#include "../utils/utils.h"
+#include "../raster_pool/raster_pool.h"
+#include "../stage_cache/stage_cache.h"
+
+// Stan jednorazowej rejestracji sterowników GDAL, wspólny dla wszystkich kontekstów
+static gsize gdal_initialized = 0;
+
+void pipeline_global_init(void)
+{
+    if (g_once_init_enter(&gdal_initialized))
+    {
+        GDALAllRegister();
+        g_once_init_leave(&gdal_initialized, 1);
+    }
+}
+
+void pipeline_global_shutdown(void)
+{
+    // Pamięć podręczna etapów trzyma referencje do buforów puli - zwalniana jako pierwsza
+    stage_cache_clear();
+    raster_pool_trim();
+    if (gdal_initialized)
+    {
+        GDALDestroyDriverManager();
+    }
+}
+
+PipelineContext* pipeline_context_new(const char* label)
+{
+    PipelineContext* ctx = calloc(1, sizeof(PipelineContext));
+    if (!ctx)
+    {
+        fprintf(stderr, "[%s] Błąd: Nie można zaalokować kontekstu pipeline'u.\n", get_timestamp());
+        return NULL;
+    }
+
+    ctx->label = g_strdup(label ? label : "scena");
+    ctx->target_10m = true;
+    ctx->memory_budget = get_pipeline_memory_budget();
+    ctx->indices = get_pipeline_index_selection();
+    ctx->value_type = PIPELINE_VALUES_FLOAT32;
+    ctx->band_layout = PIPELINE_LAYOUT_PLANAR;
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        ctx->bands[i].path = &ctx->paths[i];
+        ctx->bands[i].raw_data = &ctx->raw_data[i];
+        ctx->bands[i].processed_data = &ctx->processed_data[i];
+        ctx->bands[i].width = &ctx->widths[i];
+        ctx->bands[i].height = &ctx->heights[i];
+        ctx->bands[i].band_name = pipeline_band_name(i);
+    }
+    return ctx;
+}
+
+void pipeline_context_free(PipelineContext* ctx)
+{
+    if (!ctx)
+    {
+        return;
+    }
+
+    pipeline_context_release_buffers(ctx);
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        g_free(ctx->paths[i]);
+    }
+    g_free(ctx->label);
+    free(ctx);
+}
+
+int pipeline_context_set_band_path(PipelineContext* ctx, int band, const char* path)
+{
+    if (band < 0 || band >= PIPELINE_BAND_COUNT)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowy indeks pasma %d.\n", get_timestamp(), band);
+        return -1;
+    }
+
+    g_free(ctx->paths[band]);
+    ctx->paths[band] = g_strdup(path);
+    return 0;
+}
+
+bool pipeline_context_has_all_paths(const PipelineContext* ctx)
+{
+    unsigned int band_mask = pipeline_index_band_mask(ctx->indices);
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if ((band_mask & (1u << i)) && !ctx->paths[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int pipeline_context_prefetch(PipelineContext* ctx, int concurrency)
+{
+    if (!pipeline_context_has_all_paths(ctx))
+    {
+        fprintf(stderr, "[%s] [%s] Błąd: Nie wszystkie pasma mają ścieżki plików.\n", get_timestamp(), ctx->label);
+        return -1;
+    }
+    return load_bands_data(ctx->bands, PIPELINE_BAND_COUNT, pipeline_index_band_mask(ctx->indices), concurrency);
+}
+
+ProcessingResult* pipeline_context_run(PipelineContext* ctx)
+{
+    if (!pipeline_context_has_all_paths(ctx))
+    {
+        fprintf(stderr, "[%s] [%s] Błąd: Nie wszystkie pasma mają ścieżki plików.\n", get_timestamp(), ctx->label);
+        return NULL;
+    }
+
+    pipeline_context_log(ctx, "Przetwarzanie do %s.", ctx->target_10m ? "10m" : "20m");
+    ProcessingResult* result = process_bands_with_budget(ctx->bands, ctx->target_10m, ctx->memory_budget,
+                                                         ctx->indices, ctx->value_type, ctx->band_layout,
+                                                         ctx->label);
+
+    // Po błędzie pipeline mógł zostawić część buforów - kontekst nadaje się do ponownego użycia
+    pipeline_context_release_buffers(ctx);
+    return result;
+}
+
+// Pipeline zeruje wskaźniki buforów, które zwolnił - zostają tylko porzucone po błędzie
+void pipeline_context_release_buffers(PipelineContext* ctx)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (ctx->processed_data[i] && ctx->processed_data[i] != ctx->raw_data[i])
+        {
+            raster_pool_release(ctx->processed_data[i]);
+        }
+        raster_pool_release(ctx->raw_data[i]);
+        ctx->processed_data[i] = NULL;
+        ctx->raw_data[i] = NULL;
+    }
+}
+
+void pipeline_context_log(const PipelineContext* ctx, const char* format, ...)
+{
+    char message[512];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    printf("[%s] [%s] %s\n", get_timestamp(), ctx->label, message);
+}
@@ -0,0 +1,102 @@
+#ifndef PIPELINE_CONTEXT_H
+#define PIPELINE_CONTEXT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../data_types/data_types.h"
+#include "../processing_pipeline/processing_pipeline.h"
+
+/**
+ * @brief Samodzielny kontekst jednego przebiegu pipeline'u dla jednej sceny
+ *
+ * Kontekst jest właścicielem konfiguracji (ścieżki pasm, rozdzielczość docelowa, budżet
+ * pamięci, wybór i reprezentacja wskaźników, układ pasm), buforów pasm, na które wskazują struktury bands, oraz etykiety używanej
+ * w logach. Konfiguracja przekazywana jest do pipeline'u jawnie, więc niezależne sceny mogą być
+ * przetwarzane jednocześnie w wątkach jednego procesu - wspólne są tylko rejestracja
+ * sterowników GDAL (pipeline_global_init()) i pula buforów rastrów (raster_pool).
+ *
+ * @note Ścieżki w paths są alokowane przez g_strdup() i zwalniane przez kontekst
+ */
+typedef struct
+{
+    char* label;
+    char* paths[PIPELINE_BAND_COUNT];
+    bool target_10m;
+    size_t memory_budget;
+    unsigned int indices;
+    // Wyniki int16 dotyczą tylko eksportu bez GUI - podgląd i mapy w GUI zawsze są float
+    PipelineValueType value_type;
+    PipelineBandLayout band_layout;
+
+    int widths[PIPELINE_BAND_COUNT];
+    int heights[PIPELINE_BAND_COUNT];
+    float* raw_data[PIPELINE_BAND_COUNT];
+    float* processed_data[PIPELINE_BAND_COUNT];
+    BandData bands[PIPELINE_BAND_COUNT];
+} PipelineContext;
+
+/**
+ * @brief Jednorazowo rejestruje sterowniki GDAL, bezpieczne przy wywołaniach z wielu wątków
+ */
+void pipeline_global_init(void);
+
+/**
+ * @brief Zwalnia menedżera sterowników GDAL i bufory puli - wywoływane raz przy zamykaniu procesu
+ */
+void pipeline_global_shutdown(void);
+
+/**
+ * @brief Tworzy kontekst z rozdzielczością docelową 10m, domyślnym budżetem pamięci,
+ *        domyślnym wyborem wskaźników (get_pipeline_index_selection()), wynikami float
+ *        i układem pasm PIPELINE_LAYOUT_PLANAR
+ *
+ * @param label Etykieta sceny w logach (kopiowana), może być NULL
+ * @return Nowy kontekst lub NULL w przypadku błędu alokacji
+ */
+PipelineContext* pipeline_context_new(const char* label);
+
+/**
+ * @brief Zwalnia kontekst wraz z pozostałymi buforami pasm i ścieżkami
+ */
+void pipeline_context_free(PipelineContext* ctx);
+
+/**
+ * @brief Ustawia ścieżkę pliku pasma na pozycji BandType (np. B04, SCL)
+ *
+ * @return 0 w przypadku sukcesu, -1 dla nieprawidłowego indeksu pasma
+ */
+int pipeline_context_set_band_path(PipelineContext* ctx, int band, const char* path);
+
+/**
+ * @brief Sprawdza, czy ustawione są ścieżki wszystkich pasm potrzebnych wybranym wskaźnikom
+ */
+bool pipeline_context_has_all_paths(const PipelineContext* ctx);
+
+/**
+ * @brief Wczytuje potrzebne pasma z wyprzedzeniem, dekodując najwyżej concurrency pasm naraz
+ *
+ * Kolejne pipeline_context_run() pominie etap wczytywania.
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int pipeline_context_prefetch(PipelineContext* ctx, int concurrency);
+
+/**
+ * @brief Przetwarza scenę kontekstu i oblicza wskaźniki wybrane w ctx->indices
+ *
+ * @return Wynik do zwolnienia przez wywołującego lub NULL w przypadku błędu
+ */
+ProcessingResult* pipeline_context_run(PipelineContext* ctx);
+
+/**
+ * @brief Oddaje do puli bufory pasm pozostawione przez przerwany lub niewykonany przebieg
+ */
+void pipeline_context_release_buffers(PipelineContext* ctx);
+
+/**
+ * @brief Wypisuje komunikat poprzedzony znacznikiem czasu i etykietą kontekstu
+ */
+void pipeline_context_log(const PipelineContext* ctx, const char* format, ...);
+
+#endif // PIPELINE_CONTEXT_H
@@ -4,180 +4,1787 @@
 #include "../index_calculator/index_calculator.h"
 #include "../utils/utils.h"
 #include "../data_types/data_types.h"
+#include "../memory_planner/memory_planner.h"
+#include "../strip_reader/strip_reader.h"
+#include "../metrics/metrics.h"
+#include "../trace/trace.h"
+#include "../raster_pool/raster_pool.h"
+#include "../stage_cache/stage_cache.h"
+#include "../band_math/band_math.h"
+#include "../band_registry/band_registry.h"
+#include "../tiled_bands/tiled_bands.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <glib.h>
 
 // ====== GŁÓWNA FUNKCJA ======
-ProcessingResult* process_bands_and_calculate_indices(BandData bands[4], bool target_10m);
+ProcessingResult* process_bands_and_calculate_indices(BandData bands[PIPELINE_BAND_COUNT], bool target_10m);
 
 // ====== FUNKCJE POMOCNICZE ======
-static void get_target_resolution_dimensions(const BandData* bands, bool target_10m,
-                                             int* width_out, int* height_out);
+static ProcessingResult* run_processing_stages(BandData bands[PIPELINE_BAND_COUNT], bool target_10m,
+                                               size_t memory_budget, unsigned int indices,
+                                               PipelineValueType value_type, PipelineBandLayout band_layout,
+                                               const char* label);
+static int target_reference_band(unsigned int band_mask, bool target_10m);
+static void get_target_resolution_dimensions(const BandData* bands, unsigned int band_mask, bool target_10m,
+                                             int* width_out, int* height_out, const char* label);
+static int resample_bands_releasing_raw(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                        int target_width, int target_height, MemoryPlanner* planner);
+static ProcessingResult* process_bands_in_strips(BandData bands[PIPELINE_BAND_COUNT], unsigned int indices,
+                                                 ProcessingResult* result, const MemoryBudgetPlan* plan,
+                                                 PipelineValueType value_type, const char* label,
+                                                 PipelineProgressCallback on_progress, void* user_data);
+static ProcessingResult* run_progressive_stages(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, int strip_rows,
+                                                PipelineProgressCallback on_progress, void* user_data);
+static void get_preview_dimensions(int target_width, int target_height, int max_dimension,
+                                   int* width_out, int* height_out);
+static void begin_pipeline_stage(MemoryPlanner* planner, PipelineStage stage, MetricsScope* scope);
+static bool bands_already_loaded(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask);
+static void end_pipeline_stage(MemoryPlanner* planner, MetricsScope* scope);
+static ProcessingResult* new_processing_result(void);
+static int index_count(unsigned int indices);
+static const char* index_metrics_name(unsigned int indices);
+static int selected_band_count(unsigned int band_mask);
+
+// ====== PAMIĘĆ PODRĘCZNA ETAPÓW ======
+static bool restore_cached_indices(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, unsigned int indices,
+                                   ProcessingResult* result);
+static void restore_cached_bands(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask);
+static void cache_decoded_bands(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask);
+static bool restore_cached_resampled_band(BandData* band, int target_width, int target_height);
+static void cache_resampled_band(const BandData* band, int target_width, int target_height);
+static void cache_indices(const BandData bands[PIPELINE_BAND_COUNT], bool target_10m, unsigned int indices,
+                          const ProcessingResult* result);
+static char* band_stage_key(const BandData* band, const char* stage, int width, int height);
+
+// ====== BUDŻET PAMIĘCI ======
+static int plan_memory_budget(BandData bands[PIPELINE_BAND_COUNT], unsigned int indices, bool target_10m,
+                              PipelineValueType value_type, size_t budget_bytes, const char* label,
+                              MemoryBudgetPlan* plan);
+static size_t estimate_whole_scene_peak(const BandData bands[PIPELINE_BAND_COUNT], unsigned int indices,
+                                        PipelineValueType value_type, int target_width, int target_height,
+                                        int decode_concurrency);
+static int find_strip_rows(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                           int target_width, int target_height,
+                           size_t available_bytes, int decode_concurrency, int block_rows);
+static int selected_band_dimensions(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                    int widths[PIPELINE_BAND_COUNT], int heights[PIPELINE_BAND_COUNT]);
 
 // ====== PAMIĘĆ ======
-static void free_processing_result(ProcessingResult* result);
-static void free_band_data(BandData bands[4]);
+static void free_band_data(BandData bands[PIPELINE_BAND_COUNT]);
+static size_t band_buffer_bytes(int width, int height);
+static size_t result_buffers_bytes(unsigned int indices, PipelineValueType value_type, int width, int height);
+static void release_raw_buffer(BandData* band, MemoryPlanner* planner);
+static void release_band_buffers(BandData* band, int target_width, int target_height, MemoryPlanner* planner);
+static void release_expired_buffers(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                    PipelineStage completed_stage,
+                                    int target_width, int target_height, MemoryPlanner* planner);
+
+// ====== WSKAŹNIKI ======
+static int calculate_pipeline_indices(unsigned int indices, const float* const inputs[PIPELINE_BAND_COUNT],
+                                      size_t num_pixels, ProcessingResult* result, size_t offset,
+                                      const TiledBands* tiled);
+static bool rasters_on_scratch(const float* const inputs[PIPELINE_BAND_COUNT], ProcessingResult* result,
+                               unsigned int indices);
+static int calculate_indices_in_windows(unsigned int indices, const float* const inputs[PIPELINE_BAND_COUNT],
+                                        ProcessingResult* result, const char* label);
+static void advise_raster_rows(const float* const inputs[PIPELINE_BAND_COUNT], ProcessingResult* result,
+                               unsigned int indices, int width, int y_start, int y_end, RasterAccess access);
+static int pack_bands_into_tiles(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                 int width, int height, TiledBands* tiled, MemoryPlanner* planner);
+static int band_tile_slot(unsigned int band_mask, int band);
+static float** result_index_slot(ProcessingResult* result, int index);
+static int16_t** result_quantized_slot(ProcessingResult* result, int index);
+static bool result_is_quantized(const ProcessingResult* result);
+static void acquire_result_rasters(ProcessingResult* result, unsigned int indices, PipelineValueType value_type);
+static IndexStats* result_stats_slot(ProcessingResult* result, int index);
+static void log_index_stats(ProcessingResult* result, unsigned int indices, const char* label);
+static BlockIndex* result_blocks_slot(ProcessingResult* result, int index);
+static void build_result_block_indices(ProcessingResult* result, unsigned int indices, const char* label);
+
+// ====== WALIDACJA ======
+static int validate_processing_inputs(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask);
+static int validate_processing_result(const ProcessingResult* result, unsigned int indices);
+
+// Pozycja BandType jest numerem pasma w rejestrze, więc maski pasm band_math i pipeline'u są zgodne
+_Static_assert(PIPELINE_BAND_COUNT == BAND_REGISTRY_COUNT, "BandType musi odpowiadać rejestrowi pasm");
+
+// Wskaźniki w kolejności IndexType - nazwy wbudowanych formuł band_math
+static const char* PIPELINE_INDEX_NAMES[PIPELINE_INDEX_COUNT] = {"NDVI", "NDMI", "NDWI", "NBR", "NDRE", "EVI", "SAVI"};
+
+/**
+ * @brief Ostatni etap, w którym dane pasma są czytane
+ *
+ * Po zakończeniu tego etapu bufory pasma są zwalniane. Wybrane wskaźniki liczone są w jednym
+ * przebiegu, więc wszystkie pasma żyją do końca etapu wskaźników. Surowe dane pasm
+ * resamplowanych zwalniane są zaraz po resamplingu.
+ */
+static const PipelineStage BAND_LAST_USE[PIPELINE_BAND_COUNT] = {
+    [B01] = PIPELINE_STAGE_INDICES,
+    [B02] = PIPELINE_STAGE_INDICES,
+    [B03] = PIPELINE_STAGE_INDICES,
+    [B04] = PIPELINE_STAGE_INDICES,
+    [B05] = PIPELINE_STAGE_INDICES,
+    [B06] = PIPELINE_STAGE_INDICES,
+    [B07] = PIPELINE_STAGE_INDICES,
+    [B08] = PIPELINE_STAGE_INDICES,
+    [B8A] = PIPELINE_STAGE_INDICES,
+    [B09] = PIPELINE_STAGE_INDICES,
+    [B10] = PIPELINE_STAGE_INDICES,
+    [B11] = PIPELINE_STAGE_INDICES,
+    [B12] = PIPELINE_STAGE_INDICES,
+    [SCL] = PIPELINE_STAGE_INDICES
+};
+
+// Najmniejszy sensowny pas - poniżej narzut odczytu pasami dominuje nad obliczeniami
+#define MIN_STRIP_ROWS 16
+
+// Dekoder JP2 trzyma w przybliżeniu jedną dodatkową kopię dekodowanego pasma
+#define DECODE_WORKSPACE_FACTOR 1
+
+// Okno wierszy przy przechodzeniu rastrów w plikach roboczych - ~20 MB na pasmo w kaflu 10 m
+#define SCRATCH_WINDOW_ROWS 512
+
+// Domyślny budżet pamięci przebiegu w bajtach, 0 oznacza brak limitu (tylko do odczytu w trakcie przebiegów)
+static size_t pipeline_memory_budget = 0;
+
+// Domyślnie liczone wskaźniki (tylko do odczytu w trakcie przebiegów)
+static unsigned int pipeline_index_selection = PIPELINE_INDEX_DEFAULT;
+
+void set_pipeline_memory_budget(size_t budget_bytes)
+{
+    pipeline_memory_budget = budget_bytes;
+}
+
+size_t get_pipeline_memory_budget(void)
+{
+    return pipeline_memory_budget;
+}
+
+void set_pipeline_index_selection(unsigned int indices)
+{
+    pipeline_index_selection = indices & PIPELINE_INDEX_ALL ? indices & PIPELINE_INDEX_ALL : PIPELINE_INDEX_DEFAULT;
+}
+
+unsigned int get_pipeline_index_selection(void)
+{
+    return pipeline_index_selection;
+}
+
+const char* pipeline_band_name(int band)
+{
+    const BandInfo* info = band_registry_get(band);
+    return info ? info->name : NULL;
+}
+
+const char* pipeline_index_name(int index)
+{
+    if (index < 0 || index >= PIPELINE_INDEX_COUNT)
+    {
+        return NULL;
+    }
+    return PIPELINE_INDEX_NAMES[index];
+}
+
+unsigned int pipeline_index_from_name(const char* name)
+{
+    for (int k = 0; name && k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (g_ascii_strcasecmp(PIPELINE_INDEX_NAMES[k], name) == 0)
+        {
+            return 1u << k;
+        }
+    }
+    return 0;
+}
+
+unsigned int pipeline_index_band_mask(unsigned int indices)
+{
+    // Maska SCL jest stosowana przez każdy wskaźnik
+    unsigned int band_mask = 1u << SCL;
+
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (!(indices & (1u << k)))
+        {
+            continue;
+        }
+
+        // Bity required_bands to numery pasm w rejestrze, czyli pozycje BandType
+        BandMathProgram* program = band_math_compile_builtin(PIPELINE_INDEX_NAMES[k]);
+        band_mask |= band_math_required_bands(program);
+        band_math_free(program);
+    }
+    return band_mask;
+}
+
+ProcessingResult* process_bands_and_calculate_indices(BandData bands[PIPELINE_BAND_COUNT], bool target_10m)
+{
+    return process_bands_with_budget(bands, target_10m, pipeline_memory_budget, pipeline_index_selection,
+                                     PIPELINE_VALUES_FLOAT32, PIPELINE_LAYOUT_PLANAR, NULL);
+}
+
+ProcessingResult* process_bands_with_budget(BandData bands[PIPELINE_BAND_COUNT], bool target_10m,
+                                            size_t memory_budget, unsigned int indices,
+                                            PipelineValueType value_type, PipelineBandLayout band_layout,
+                                            const char* label)
+{
+    MetricsScope metrics_scope = metrics_stage_begin("pipeline", "total");
+
+    memory_planner_run_started();
+    ProcessingResult* result = run_processing_stages(bands, target_10m, memory_budget, indices, value_type,
+                                                     band_layout, label);
+    memory_planner_run_finished();
+
+    size_t num_pixels = result ? (size_t)result->width * result->height : 0;
+    size_t value_bytes = result && result_is_quantized(result) ? sizeof(int16_t) : sizeof(float);
+    metrics_stage_end(&metrics_scope, 0, index_count(indices) * num_pixels * value_bytes, num_pixels);
+    return result;
+}
+
+ProcessingResult* process_bands_progressive(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, int strip_rows,
+                                            PipelineProgressCallback on_progress, void* user_data)
+{
+    MetricsScope metrics_scope = metrics_stage_begin("pipeline", "total");
+
+    memory_planner_run_started();
+    ProcessingResult* result = run_progressive_stages(bands, target_10m, strip_rows, on_progress, user_data);
+    memory_planner_run_finished();
+
+    size_t num_pixels = result ? (size_t)result->width * result->height : 0;
+    metrics_stage_end(&metrics_scope, 0, index_count(PIPELINE_INDEX_DEFAULT) * num_pixels * sizeof(float),
+                      num_pixels);
+    return result;
+}
+
+ProcessingResult* process_bands_quicklook(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, int max_dimension,
+                                          int* target_width_out, int* target_height_out)
+{
+    MetricsScope metrics_scope = metrics_stage_begin("pipeline", "quicklook");
+
+    // Wymiary pełnej sceny z nagłówka pasma wyznaczającego docelową rozdzielczość
+    unsigned int band_mask = pipeline_index_band_mask(PIPELINE_INDEX_DEFAULT);
+    int target_width, target_height;
+    int reference = target_reference_band(band_mask, target_10m);
+    if (read_band_dimensions(*bands[reference].path, &target_width, &target_height, NULL) != 0)
+    {
+        fprintf(stderr, "[%s] Błąd odczytu wymiarów sceny dla podglądu.\n", get_timestamp());
+        return NULL;
+    }
+
+    int width, height;
+    get_preview_dimensions(target_width, target_height, max_dimension, &width, &height);
+    size_t num_pixels = (size_t)width * height;
+
+    // Potrzebne pasma próbkowane do wymiarów podglądu - resampling wykonuje GDAL przy odczycie
+    float* preview_bands[PIPELINE_BAND_COUNT] = {NULL};
+    int band_count = selected_band_count(band_mask);
+    int error_flag = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(band_count) shared(preview_bands, error_flag)
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        preview_bands[i] = raster_pool_acquire(num_pixels);
+        if (!preview_bands[i] || read_band_overview(*bands[i].path, preview_bands[i], width, height) != 0)
+        {
+            #pragma omp atomic write
+            error_flag = 1;
+        }
+    }
+
+    ProcessingResult* result = NULL;
+    if (!error_flag)
+    {
+        result = new_processing_result();
+    }
+    if (result)
+    {
+        result->width = width;
+        result->height = height;
+        acquire_result_rasters(result, PIPELINE_INDEX_DEFAULT, PIPELINE_VALUES_FLOAT32);
+        // Na zmniejszonych poziomach JPEG2000 klasy SCL na granicach obszarów są przybliżone
+        if (!validate_processing_result(result, PIPELINE_INDEX_DEFAULT) ||
+            calculate_pipeline_indices(PIPELINE_INDEX_DEFAULT, (const float* const*)preview_bands,
+                                       num_pixels, result, 0, NULL) != 0)
+        {
+            free_processing_result(result);
+            result = NULL;
+        }
+    }
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        raster_pool_release(preview_bands[i]);
+    }
+
+    size_t result_bytes = result ? index_count(PIPELINE_INDEX_DEFAULT) * num_pixels * sizeof(float) : 0;
+    double elapsed_time = metrics_stage_end(&metrics_scope, band_count * num_pixels * sizeof(float), result_bytes,
+                                            num_pixels);
+    if (!result)
+    {
+        fprintf(stderr, "[%s] Błąd tworzenia podglądu wskaźników.\n", get_timestamp());
+        return NULL;
+    }
+
+    if (target_width_out) *target_width_out = target_width;
+    if (target_height_out) *target_height_out = target_height;
+    printf("[%s] Podgląd NDVI/NDMI %dx%d dla sceny %dx%d gotowy (czas: %.2fs)\n",
+           get_timestamp(), width, height, target_width, target_height, elapsed_time);
+    return result;
+}
+
+bool pipeline_indices_cached(BandData bands[PIPELINE_BAND_COUNT], bool target_10m)
+{
+    ProcessingResult cached = {0};
+    if (!restore_cached_indices(bands, target_10m, PIPELINE_INDEX_DEFAULT, &cached))
+    {
+        return false;
+    }
+
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        raster_pool_release(cached.index_data[k]);
+    }
+    return true;
+}
+
+static ProcessingResult* run_progressive_stages(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, int strip_rows,
+                                                PipelineProgressCallback on_progress, void* user_data)
+{
+    // Podgląd w GUI zawsze pokazuje NDVI i NDMI
+    unsigned int indices = PIPELINE_INDEX_DEFAULT;
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    if (!validate_processing_inputs(bands, band_mask))
+    {
+        fprintf(stderr, "[%s] Błąd walidacji danych wejściowych.\n", get_timestamp());
+        return NULL;
+    }
+
+    // Wyniki lub wszystkie zdekodowane pasma w pamięci podręcznej - pełny przebieg jest krótszy
+    // od pierwszego pasa, więc wynik zgłaszany jest od razu w całości
+    bool from_cache = pipeline_indices_cached(bands, target_10m);
+    if (!from_cache)
+    {
+        restore_cached_bands(bands, band_mask);
+        from_cache = bands_already_loaded(bands, band_mask);
+        if (!from_cache)
+        {
+            free_band_data(bands);
+        }
+    }
+
+    if (from_cache)
+    {
+        ProcessingResult* result = run_processing_stages(bands, target_10m, 0, indices, PIPELINE_VALUES_FLOAT32,
+                                                         PIPELINE_LAYOUT_PLANAR, NULL);
+        if (result && on_progress && !on_progress(result, 0, result->height, user_data))
+        {
+            free_processing_result(result);
+            return NULL;
+        }
+        return result;
+    }
+
+    // Wymiary z nagłówków plików, pasy wyrównane do wysokości bloku pliku
+    int block_rows = 1;
+    int reference = target_reference_band(band_mask, target_10m);
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if ((band_mask & (1u << i)) &&
+            read_band_dimensions(*(bands[i].path), bands[i].width, bands[i].height,
+                                 i == reference ? &block_rows : NULL) != 0)
+        {
+            return NULL;
+        }
+    }
+    if (block_rows > 1)
+    {
+        strip_rows = (strip_rows + block_rows - 1) / block_rows * block_rows;
+    }
+
+    MemoryBudgetPlan plan = {
+        .mode = PROCESSING_MODE_STRIPS,
+        .strip_rows = strip_rows > 0 ? strip_rows : MIN_STRIP_ROWS,
+        .decode_concurrency = selected_band_count(band_mask),
+        .estimated_peak_bytes = 0
+    };
+
+    ProcessingResult* result = new_processing_result();
+    if (!result)
+    {
+        return NULL;
+    }
+    get_target_resolution_dimensions(bands, band_mask, target_10m, &result->width, &result->height, NULL);
+
+    result = process_bands_in_strips(bands, indices, result, &plan, PIPELINE_VALUES_FLOAT32, NULL,
+                                     on_progress, user_data);
+    if (result)
+    {
+        cache_indices(bands, target_10m, indices, result);
+    }
+    return result;
+}
+
+// Wymiary podglądu z zachowaniem proporcji sceny, dłuższy bok nie większy niż max_dimension
+static void get_preview_dimensions(int target_width, int target_height, int max_dimension,
+                                   int* width_out, int* height_out)
+{
+    int longest = target_width > target_height ? target_width : target_height;
+    double scale = max_dimension > 0 && longest > max_dimension ? (double)max_dimension / longest : 1.0;
+
+    *width_out = (int)(target_width * scale + 0.5);
+    *height_out = (int)(target_height * scale + 0.5);
+    if (*width_out < 1) *width_out = 1;
+    if (*height_out < 1) *height_out = 1;
+}
+
+static ProcessingResult* run_processing_stages(BandData bands[PIPELINE_BAND_COUNT], bool target_10m,
+                                               size_t memory_budget, unsigned int indices,
+                                               PipelineValueType value_type, PipelineBandLayout band_layout,
+                                               const char* label)
+{
+    // Dekodowane są tylko pasma, od których zależą wybrane wskaźniki
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    if (!validate_processing_inputs(bands, band_mask))
+    {
+        log_labeled(stderr, label, "Błąd walidacji danych wejściowych.\n");
+        return NULL;
+    }
+
+    // Pasma wczytane z wyprzedzeniem są już w pamięci - budżet nie może zmienić trybu przetwarzania
+    bool prefetched = bands_already_loaded(bands, band_mask);
+
+    MemoryBudgetPlan plan;
+    if (plan_memory_budget(bands, indices, target_10m, value_type, prefetched ? 0 : memory_budget, label,
+                           &plan) != 0)
+    {
+        log_labeled(stderr, label, "Przetwarzanie przerwane przed startem - przekroczony budżet pamięci.\n");
+        return NULL;
+    }
+
+    ProcessingResult* result = new_processing_result();
+    if (!result)
+    {
+        return NULL;
+    }
+
+    if (plan.mode == PROCESSING_MODE_STRIPS)
+    {
+        get_target_resolution_dimensions(bands, band_mask, target_10m, &result->width, &result->height, label);
+        return process_bands_in_strips(bands, indices, result, &plan, value_type, label, NULL, NULL);
+    }
+
+    // Wybrane wskaźniki dla tych plików i rozdzielczości są już policzone - bez wczytywania pasm
+    // (pamięć podręczna przechowuje rastry float, więc wyniki int16 zawsze są liczone)
+    bool quantized = value_type == PIPELINE_VALUES_INT16;
+    if (!quantized && restore_cached_indices(bands, target_10m, indices, result))
+    {
+        if (prefetched)
+        {
+            free_band_data(bands);
+        }
+        log_labeled(stdout, label, "Wyniki wskaźników z pamięci podręcznej etapów. Wymiary: %dx%d\n",
+                    result->width, result->height);
+
+        // Wyniki z pamięci podręcznej nie przechodzą przez jądro wskaźników - statystyki osobnym przebiegiem
+        for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+        {
+            if (indices & (1u << k))
+            {
+                index_stats_compute(result_stats_slot(result, k), *result_index_slot(result, k),
+                                    (size_t)result->width * result->height);
+            }
+        }
+        build_result_block_indices(result, indices, label);
+        log_index_stats(result, indices, label);
+        return result;
+    }
+
+    MemoryPlanner planner;
+    MetricsScope stage_scope;
+    memory_planner_init(&planner, label);
+
+    // Ładowanie danych pasm - dekodowane są tylko potrzebne pasma spoza pamięci podręcznej
+    begin_pipeline_stage(&planner, PIPELINE_STAGE_LOAD, &stage_scope);
+    restore_cached_bands(bands, band_mask);
+    if (!bands_already_loaded(bands, band_mask) &&
+        load_bands_data(bands, PIPELINE_BAND_COUNT, band_mask, plan.decode_concurrency) != 0)
+    {
+        log_labeled(stderr, label, "Błąd ładowania danych pasm.\n");
+        free(result);
+        return NULL;
+    }
+    cache_decoded_bands(bands, band_mask);
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (band_mask & (1u << i))
+        {
+            memory_planner_track_alloc(&planner, band_buffer_bytes(*bands[i].width, *bands[i].height));
+        }
+    }
+    end_pipeline_stage(&planner, &stage_scope);
+
+    // Określenie docelowych wymiarów
+    get_target_resolution_dimensions(bands, band_mask, target_10m, &result->width, &result->height, label);
+
+    // Resampling pasm do docelowej rozdzielczości
+    begin_pipeline_stage(&planner, PIPELINE_STAGE_RESAMPLE, &stage_scope);
+    if (resample_bands_releasing_raw(bands, band_mask, result->width, result->height, &planner) != 0)
+    {
+        log_labeled(stderr, label, "Błąd resamplingu pasm.\n");
+        free_band_data(bands);
+        free(result);
+        return NULL;
+    }
+    end_pipeline_stage(&planner, &stage_scope);
+
+    // Obliczanie wybranych wskaźników w jednym przebiegu po pasmach
+    begin_pipeline_stage(&planner, PIPELINE_STAGE_INDICES, &stage_scope);
+    log_labeled(stdout, label, "Rozpoczynanie obliczania wskaźników (%d) w jednym przebiegu.\n", index_count(indices));
+    size_t num_pixels = (size_t)result->width * result->height;
+
+    // Układ kafli zastępuje rastry wierszowe pasm, więc powstaje przed buforami wyników
+    TiledBands tiled = {0};
+    bool use_tiles = band_layout == PIPELINE_LAYOUT_TILED;
+    if (use_tiles && pack_bands_into_tiles(bands, band_mask, result->width, result->height, &tiled, &planner) != 0)
+    {
+        log_labeled(stderr, label, "Błąd pakowania pasm w kafle.\n");
+        free_band_data(bands);
+        free(result);
+        return NULL;
+    }
+
+    const float* inputs[PIPELINE_BAND_COUNT] = {NULL};
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (band_mask & (1u << i))
+        {
+            inputs[i] = *bands[i].processed_data;
+        }
+    }
+    acquire_result_rasters(result, indices, value_type);
+    int status = -1;
+    if (validate_processing_result(result, indices))
+    {
+        // Rastry w plikach roboczych przechodzone są oknami wierszy zamiast jednym przebiegiem po całości
+        status = !use_tiles && rasters_on_scratch(inputs, result, indices) ?
+                 calculate_indices_in_windows(indices, inputs, result, label) :
+                 calculate_pipeline_indices(indices, inputs, num_pixels, result, 0,
+                                            use_tiles ? &tiled : NULL);
+    }
+    if (use_tiles)
+    {
+        memory_planner_track_free(&planner, tiled.band_count * band_buffer_bytes(result->width, result->height));
+        tiled_bands_free(&tiled);
+    }
+    if (status != 0)
+    {
+        log_labeled(stderr, label, "Błąd podczas obliczania wskaźników.\n");
+        free_band_data(bands);
+        free_processing_result(result);
+        return NULL;
+    }
+    if (!quantized)
+    {
+        cache_indices(bands, target_10m, indices, result);
+    }
+    memory_planner_track_alloc(&planner, result_buffers_bytes(indices, value_type, result->width, result->height));
+    release_expired_buffers(bands, band_mask, PIPELINE_STAGE_INDICES, result->width, result->height, &planner);
+    end_pipeline_stage(&planner, &stage_scope);
+
+    memory_planner_report(&planner);
+
+    if (!validate_processing_result(result, indices))
+    {
+        log_labeled(stderr, label, "Błąd walidacji wyników przetwarzania.\n");
+        free_processing_result(result);
+        return NULL;
+    }
+
+    log_labeled(stdout, label, "Przetwarzanie zakończone pomyślnie. Wymiary: %dx%d\n", result->width, result->height);
+    build_result_block_indices(result, indices, label);
+    log_index_stats(result, indices, label);
+
+    return result;
+}
+
+// Pasmo wyznaczające siatkę wyniku: pierwsze potrzebne pasmo o natywnej rozdzielczości celu
+static int target_reference_band(unsigned int band_mask, bool target_10m)
+{
+    int target_resolution = target_10m ? 10 : 20;
+    int fallback = -1;
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        const BandInfo* info = band_registry_get(i);
+        if (info && info->native_resolution_m == target_resolution)
+        {
+            return i;
+        }
+        if (fallback < 0)
+        {
+            fallback = i;
+        }
+    }
+    return fallback >= 0 ? fallback : SCL;
+}
+
+int pipeline_target_grid(char* const paths[PIPELINE_BAND_COUNT], unsigned int band_mask, bool target_10m,
+                         int* width_out, int* height_out, int* reference_out)
+{
+    int reference = target_reference_band(band_mask, target_10m);
+    int width, height;
+    if (read_band_dimensions(paths[reference], &width, &height, NULL) != 0)
+    {
+        return -1;
+    }
+
+    int target_resolution = target_10m ? 10 : 20;
+    const BandInfo* info = band_registry_get(reference);
+    int native_resolution = info ? info->native_resolution_m : target_resolution;
+
+    *width_out = (int)((long long)width * native_resolution / target_resolution);
+    *height_out = (int)((long long)height * native_resolution / target_resolution);
+    if (reference_out)
+    {
+        *reference_out = reference;
+    }
+    return 0;
+}
+
+static void get_target_resolution_dimensions(const BandData* bands, unsigned int band_mask, bool target_10m,
+                                             int* width_out, int* height_out, const char* label)
+{
+    int reference = target_reference_band(band_mask, target_10m);
+    int target_resolution = target_10m ? 10 : 20;
+    const BandInfo* info = band_registry_get(reference);
+    int native_resolution = info ? info->native_resolution_m : target_resolution;
+
+    // Bez pasma o natywnej rozdzielczości celu siatka wynika ze skali względem pasma odniesienia
+    *width_out = (int)((long long)*bands[reference].width * native_resolution / target_resolution);
+    *height_out = (int)((long long)*bands[reference].height * native_resolution / target_resolution);
+
+    log_labeled(stdout, label, "Docelowa rozdzielczość: %dm (odniesienie %s), wymiary: %dx%d\n",
+                target_resolution, pipeline_band_name(reference), *width_out, *height_out);
+}
+
+static bool bands_already_loaded(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if ((band_mask & (1u << i)) && !*(bands[i].raw_data))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Etap pipeline'u mierzony jednocześnie przez planer pamięci i metryki ("pipeline", nazwa etapu)
+static void begin_pipeline_stage(MemoryPlanner* planner, PipelineStage stage, MetricsScope* scope)
+{
+    memory_planner_begin_stage(planner, stage);
+    *scope = metrics_stage_begin("pipeline", memory_planner_stage_name(stage));
+}
+
+static void end_pipeline_stage(MemoryPlanner* planner, MetricsScope* scope)
+{
+    metrics_stage_end(scope, 0, 0, 0);
+    memory_planner_end_stage(planner);
+}
+
+static ProcessingResult* new_processing_result(void)
+{
+    ProcessingResult* result = malloc(sizeof(ProcessingResult));
+    if (!result)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla ProcessingResult.\n", get_timestamp());
+        return NULL;
+    }
+    result->width = 0;
+    result->height = 0;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        result->index_data[k] = NULL;
+        result->index_int16[k] = NULL;
+        index_stats_reset(&result->index_stats[k]);
+        memset(&result->index_blocks[k], 0, sizeof(result->index_blocks[k]));
+    }
+    return result;
+}
+
+static int index_count(unsigned int indices)
+{
+    int count = 0;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        count += (indices >> k) & 1u;
+    }
+    return count;
+}
+
+// Nazwa jądra wskaźników w metrykach - metryki przechowują wskaźnik do napisu, więc tylko stałe napisy
+static const char* index_metrics_name(unsigned int indices)
+{
+    if (indices == PIPELINE_INDEX_DEFAULT)
+    {
+        return "NDVI+NDMI";
+    }
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (indices == 1u << k)
+        {
+            return PIPELINE_INDEX_NAMES[k];
+        }
+    }
+    return "wybrane";
+}
+
+static int selected_band_count(unsigned int band_mask)
+{
+    int count = 0;
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        count += (band_mask >> i) & 1u;
+    }
+    return count;
+}
+
+static int resample_bands_releasing_raw(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                        int target_width, int target_height, MemoryPlanner* planner)
+{
+    log_labeled(stdout, planner->label, "Rozpoczynanie resamplingu do wymiarów %dx%d.\n", target_width, target_height);
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+
+        bool from_cache = restore_cached_resampled_band(&bands[i], target_width, target_height);
+        if (!from_cache && resample_band_to_target_resolution(&bands[i], target_width, target_height) != 0)
+        {
+            log_labeled(stderr, planner->label, "Błąd podczas resamplingu pasma %s.\n", bands[i].band_name);
+            return -1;
+        }
+
+        // Surowe dane nie są już potrzebne, gdy pasmo ma nowy bufor po resamplingu
+        if (*bands[i].processed_data != *bands[i].raw_data)
+        {
+            if (!from_cache)
+            {
+                cache_resampled_band(&bands[i], target_width, target_height);
+            }
+            memory_planner_track_alloc(planner, band_buffer_bytes(target_width, target_height));
+            release_raw_buffer(&bands[i], planner);
+        }
+    }
+
+    log_labeled(stdout, planner->label, "Resampling zakończony pomyślnie.\n");
+    return 0;
+}
+
+static ProcessingResult* process_bands_in_strips(BandData bands[PIPELINE_BAND_COUNT], unsigned int indices,
+                                                 ProcessingResult* result, const MemoryBudgetPlan* plan,
+                                                 PipelineValueType value_type, const char* label,
+                                                 PipelineProgressCallback on_progress, void* user_data)
+{
+    // Czytnik pasów otwiera tylko pasma potrzebne wybranym wskaźnikom
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    BandData selected[PIPELINE_BAND_COUNT];
+    int reader_slot[PIPELINE_BAND_COUNT];
+    int selected_count = 0;
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        reader_slot[i] = -1;
+        if (band_mask & (1u << i))
+        {
+            reader_slot[i] = selected_count;
+            selected[selected_count++] = bands[i];
+        }
+    }
+
+    StripReader reader;
+    if (strip_reader_open(&reader, selected, selected_count, result->width, result->height,
+                          plan->strip_rows, plan->decode_concurrency) != 0)
+    {
+        log_labeled(stderr, label, "Błąd otwierania pasm do przetwarzania pasami.\n");
+        free(result);
+        return NULL;
+    }
+
+    acquire_result_rasters(result, indices, value_type);
+    if (!validate_processing_result(result, indices))
+    {
+        log_labeled(stderr, label, "Błąd alokacji pamięci dla wyników wskaźników.\n");
+        strip_reader_close(&reader);
+        free_processing_result(result);
+        return NULL;
+    }
+
+    log_labeled(stdout, label, "Rozpoczynanie przetwarzania pasami po %d wierszy.\n", reader.max_strip_rows);
+
+    for (int y = 0; y < result->height; y += reader.max_strip_rows)
+    {
+        int y_end = y + reader.max_strip_rows < result->height ? y + reader.max_strip_rows : result->height;
+        TraceSpan strip_span = trace_begin("strip", "pas");
+
+        if (strip_reader_read(&reader, y, y_end) != 0)
+        {
+            log_labeled(stderr, label, "Błąd wczytywania pasa wierszy %d-%d.\n", y, y_end);
+            strip_reader_close(&reader);
+            free_processing_result(result);
+            return NULL;
+        }
+
+        size_t offset = (size_t)y * result->width;
+        size_t strip_pixels = (size_t)(y_end - y) * result->width;
+
+        const float* inputs[PIPELINE_BAND_COUNT] = {NULL};
+        for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+        {
+            if (reader_slot[i] >= 0)
+            {
+                inputs[i] = strip_reader_band(&reader, reader_slot[i]);
+            }
+        }
+        if (calculate_pipeline_indices(indices, inputs, strip_pixels, result, offset, NULL) != 0)
+        {
+            log_labeled(stderr, label, "Błąd obliczania wskaźników dla pasa wierszy %d-%d.\n", y, y_end);
+            strip_reader_close(&reader);
+            free_processing_result(result);
+            return NULL;
+        }
+
+        trace_end_with_arg(&strip_span, "y", y);
+
+        // Wiersze [0, y_end) wyniku są już kompletne
+        if (on_progress && !on_progress(result, y, y_end, user_data))
+        {
+            log_labeled(stdout, label, "Przetwarzanie pasami przerwane po wierszu %d.\n", y_end);
+            strip_reader_close(&reader);
+            free_processing_result(result);
+            return NULL;
+        }
+
+        // Ukończony pas wyników w pliku roboczym może opuścić pamięć - RAM zajmuje tylko bieżący pas
+        advise_raster_rows(NULL, result, indices, result->width, y, y_end, RASTER_ACCESS_DONE);
+    }
+
+    strip_reader_close(&reader);
+
+    if (!validate_processing_result(result, indices))
+    {
+        log_labeled(stderr, label, "Błąd walidacji wyników przetwarzania.\n");
+        free_processing_result(result);
+        return NULL;
+    }
+
+    log_labeled(stdout, label, "Przetwarzanie pasami zakończone pomyślnie. Wymiary: %dx%d\n",
+                result->width, result->height);
+    build_result_block_indices(result, indices, label);
+    log_index_stats(result, indices, label);
+    return result;
+}
+
+char* pipeline_index_cache_key(const BandData bands[PIPELINE_BAND_COUNT], bool target_10m, const char* index_name)
+{
+    if (!stage_cache_enabled())
+    {
+        return NULL;
+    }
+
+    // Klucz obejmuje zawartość wszystkich pasm, od których zależy formuła wskaźnika (wraz z SCL)
+    unsigned int band_mask = pipeline_index_band_mask(pipeline_index_from_name(index_name));
+    GString* key = g_string_new(index_name);
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        char* file_key = stage_cache_file_key(*bands[i].path);
+        if (!file_key)
+        {
+            g_string_free(key, TRUE);
+            return NULL;
+        }
+        g_string_append_printf(key, "|%s", file_key);
+        g_free(file_key);
+    }
+    g_string_append_printf(key, "|%dm", target_10m ? 10 : 20);
+    return g_string_free(key, FALSE);
+}
+
+static bool restore_cached_indices(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, unsigned int indices,
+                                   ProcessingResult* result)
+{
+    float* data[PIPELINE_INDEX_COUNT] = {NULL};
+    int width = 0, height = 0;
+    bool complete = true;
+
+    for (int k = 0; k < PIPELINE_INDEX_COUNT && complete; k++)
+    {
+        if (!(indices & (1u << k)))
+        {
+            continue;
+        }
+        char* key = pipeline_index_cache_key(bands, target_10m, PIPELINE_INDEX_NAMES[k]);
+        int index_width = 0, index_height = 0;
+        data[k] = key ? stage_cache_lookup_raster(key, &index_width, &index_height) : NULL;
+        g_free(key);
+
+        // Wszystkie wybrane wskaźniki muszą pochodzić z tej samej siatki
+        complete = data[k] && (width == 0 || (index_width == width && index_height == height));
+        width = index_width;
+        height = index_height;
+    }
+
+    if (!complete)
+    {
+        for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+        {
+            raster_pool_release(data[k]);
+        }
+        return false;
+    }
+
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        *result_index_slot(result, k) = data[k];
+    }
+    result->width = width;
+    result->height = height;
+    return true;
+}
+
+static void restore_cached_bands(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)) || *bands[i].raw_data)
+        {
+            continue;
+        }
+
+        char* key = band_stage_key(&bands[i], "decoded", 0, 0);
+        if (!key)
+        {
+            continue;
+        }
+
+        float* data = stage_cache_lookup_raster(key, bands[i].width, bands[i].height);
+        if (data)
+        {
+            *bands[i].raw_data = data;
+            *bands[i].processed_data = data;
+            printf("[%s] [%s] Pasmo z pamięci podręcznej etapów (%dx%d pikseli).\n",
+                   get_timestamp(), bands[i].band_name, *bands[i].width, *bands[i].height);
+        }
+        g_free(key);
+    }
+}
+
+static void cache_decoded_bands(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        char* key = band_stage_key(&bands[i], "decoded", 0, 0);
+        if (key)
+        {
+            stage_cache_store_raster(key, *bands[i].raw_data, *bands[i].width, *bands[i].height);
+            g_free(key);
+        }
+    }
+}
+
+static bool restore_cached_resampled_band(BandData* band, int target_width, int target_height)
+{
+    if (*band->width == target_width && *band->height == target_height)
+    {
+        return false;
+    }
+
+    char* key = band_stage_key(band, "resampled", target_width, target_height);
+    if (!key)
+    {
+        return false;
+    }
+
+    float* data = stage_cache_lookup_raster(key, NULL, NULL);
+    g_free(key);
+    if (!data)
+    {
+        return false;
+    }
+
+    *band->processed_data = data;
+    printf("[%s] [%s] Resampling z pamięci podręcznej etapów.\n", get_timestamp(), band->band_name);
+    return true;
+}
+
+static void cache_resampled_band(const BandData* band, int target_width, int target_height)
+{
+    char* key = band_stage_key(band, "resampled", target_width, target_height);
+    if (key)
+    {
+        stage_cache_store_raster(key, *band->processed_data, target_width, target_height);
+        g_free(key);
+    }
+}
+
+static void cache_indices(const BandData bands[PIPELINE_BAND_COUNT], bool target_10m, unsigned int indices,
+                          const ProcessingResult* result)
+{
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (!(indices & (1u << k)))
+        {
+            continue;
+        }
+        char* key = pipeline_index_cache_key(bands, target_10m, PIPELINE_INDEX_NAMES[k]);
+        if (key)
+        {
+            stage_cache_store_raster(key, *result_index_slot((ProcessingResult*)result, k),
+                                     result->width, result->height);
+            g_free(key);
+        }
+    }
+}
+
+// Klucz wyniku etapu pasma: etap, zawartość pliku i (dla resamplingu) wymiary docelowe
+static char* band_stage_key(const BandData* band, const char* stage, int width, int height)
+{
+    if (!stage_cache_enabled())
+    {
+        return NULL;
+    }
+
+    char* file_key = stage_cache_file_key(*band->path);
+    if (!file_key)
+    {
+        return NULL;
+    }
+
+    char* key = g_strdup_printf("%s|%s|%dx%d", stage, file_key, width, height);
+    g_free(file_key);
+    return key;
+}
+
+static int plan_memory_budget(BandData bands[PIPELINE_BAND_COUNT], unsigned int indices, bool target_10m,
+                              PipelineValueType value_type, size_t budget_bytes, const char* label,
+                              MemoryBudgetPlan* plan)
+{
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    int band_count = selected_band_count(band_mask);
+
+    plan->mode = PROCESSING_MODE_WHOLE_SCENE;
+    plan->strip_rows = 0;
+    plan->decode_concurrency = band_count;
+    plan->estimated_peak_bytes = 0;
+
+    if (budget_bytes == 0)
+    {
+        return 0;
+    }
+
+    // Wymiary z nagłówków plików - bez dekodowania pikseli
+    int block_rows = 1;
+    int reference = target_reference_band(band_mask, target_10m);
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        int band_block_rows = 1;
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        if (read_band_dimensions(*(bands[i].path), bands[i].width, bands[i].height, &band_block_rows) != 0)
+        {
+            return -1;
+        }
+        if (i == reference)
+        {
+            block_rows = band_block_rows;
+        }
+    }
+
+    int target_width, target_height;
+    get_target_resolution_dimensions(bands, band_mask, target_10m, &target_width, &target_height, label);
+
+    // Najpierw cała scena, z jak największą liczbą jednocześnie dekodowanych pasm
+    for (int concurrency = band_count; concurrency >= 1; concurrency--)
+    {
+        size_t peak = estimate_whole_scene_peak(bands, indices, value_type, target_width, target_height,
+                                                concurrency);
+        if (peak <= budget_bytes)
+        {
+            plan->decode_concurrency = concurrency;
+            plan->estimated_peak_bytes = peak;
+            memory_planner_log_plan(plan, budget_bytes, label);
+            return 0;
+        }
+    }
+
+    // Przetwarzanie pasami - w pamięci pozostają tylko pełne wyniki wybranych wskaźników,
+    // a wyniki w plikach roboczych zajmują RAM tylko w obrębie bieżącego pasa
+    size_t results_bytes = result_buffers_bytes(indices, value_type, target_width, target_height);
+    size_t raster_bytes = (size_t)target_width * target_height *
+                          (value_type == PIPELINE_VALUES_INT16 ? sizeof(int16_t) : sizeof(float));
+    if (raster_pool_uses_scratch(raster_bytes))
+    {
+        log_labeled(stdout, label, "Wyniki wskaźników w plikach roboczych (%.0f MB na dysku) - "
+                    "poza budżetem pamięci.\n", results_bytes / (1024.0 * 1024.0));
+        results_bytes = 0;
+    }
+    int widths[PIPELINE_BAND_COUNT], heights[PIPELINE_BAND_COUNT];
+    selected_band_dimensions(bands, band_mask, widths, heights);
+
+    for (int concurrency = band_count; concurrency >= 1 && results_bytes < budget_bytes; concurrency--)
+    {
+        int rows = find_strip_rows(bands, band_mask, target_width, target_height, budget_bytes - results_bytes,
+                                   concurrency, block_rows);
+        if (rows > 0)
+        {
+            plan->mode = PROCESSING_MODE_STRIPS;
+            plan->strip_rows = rows;
+            plan->decode_concurrency = concurrency;
+            plan->estimated_peak_bytes = results_bytes +
+                strip_reader_estimate_bytes(widths, heights, band_count, target_width, target_height,
+                                            rows, concurrency);
+            memory_planner_log_plan(plan, budget_bytes, label);
+            return 0;
+        }
+    }
+
+    size_t minimum_bytes = results_bytes +
+        strip_reader_estimate_bytes(widths, heights, band_count, target_width, target_height, MIN_STRIP_ROWS, 1);
+    log_labeled(stderr, label, "Błąd: Budżet pamięci %.0f MB jest za mały dla sceny %dx%d (%dm). "
+                "Potrzeba co najmniej %.0f MB przy przetwarzaniu pasami.\n",
+                budget_bytes / (1024.0 * 1024.0), target_width, target_height,
+                target_10m ? 10 : 20, minimum_bytes / (1024.0 * 1024.0));
+    return -1;
+}
 
-// ====== WALIDACJA ======
-static int validate_processing_inputs(const BandData bands[4]);
-static int validate_processing_result(const ProcessingResult* result);
+static size_t estimate_whole_scene_peak(const BandData bands[PIPELINE_BAND_COUNT], unsigned int indices,
+                                        PipelineValueType value_type, int target_width, int target_height,
+                                        int decode_concurrency)
+{
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    size_t target_bytes = band_buffer_bytes(target_width, target_height);
+    size_t raw_bytes[PIPELINE_BAND_COUNT] = {0};
+    size_t live = 0;
+    size_t largest = 0;
+    bool resampled[PIPELINE_BAND_COUNT] = {false};
+
+    // Wczytywanie: wszystkie potrzebne surowe pasma + przestrzeń robocza równolegle pracujących dekoderów
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        raw_bytes[i] = band_buffer_bytes(*bands[i].width, *bands[i].height);
+        resampled[i] = *bands[i].width != target_width || *bands[i].height != target_height;
+        live += raw_bytes[i];
+        if (raw_bytes[i] > largest)
+        {
+            largest = raw_bytes[i];
+        }
+    }
+    size_t peak = live + (size_t)decode_concurrency * DECODE_WORKSPACE_FACTOR * largest;
+
+    // Resampling: nowy bufor, potem zwolnienie surowego - ta sama kolejność co w pipeline
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (resampled[i])
+        {
+            live += target_bytes;
+            peak = live > peak ? live : peak;
+            live -= raw_bytes[i];
+        }
+    }
+
+    // Wskaźniki: bufory wybranych wyników naraz (jeden przebieg), potem zwolnienie pasm zgodnie z BAND_LAST_USE
+    live += result_buffers_bytes(indices, value_type, target_width, target_height);
+    peak = live > peak ? live : peak;
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if ((band_mask & (1u << i)) && BAND_LAST_USE[i] == PIPELINE_STAGE_INDICES)
+        {
+            live -= resampled[i] ? target_bytes : raw_bytes[i];
+        }
+    }
 
-ProcessingResult* process_bands_and_calculate_indices(BandData bands[4], bool target_10m)
+    return peak;
+}
+
+static int find_strip_rows(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                           int target_width, int target_height,
+                           size_t available_bytes, int decode_concurrency, int block_rows)
 {
-    if (!validate_processing_inputs(bands))
+    int widths[PIPELINE_BAND_COUNT], heights[PIPELINE_BAND_COUNT];
+    int band_count = selected_band_dimensions(bands, band_mask, widths, heights);
+
+    int low = MIN_STRIP_ROWS < target_height ? MIN_STRIP_ROWS : target_height;
+    if (strip_reader_estimate_bytes(widths, heights, band_count, target_width, target_height, low,
+                                    decode_concurrency) > available_bytes)
     {
-        fprintf(stderr, "[%s] Błąd walidacji danych wejściowych.\n", get_timestamp());
-        return NULL;
+        return 0;
     }
 
-    ProcessingResult* result = malloc(sizeof(ProcessingResult));
+    // Wyszukiwanie binarne największego pasa mieszczącego się w budżecie
+    int high = target_height;
+    while (low < high)
+    {
+        int mid = low + (high - low + 1) / 2;
+        if (strip_reader_estimate_bytes(widths, heights, band_count, target_width, target_height, mid,
+                                        decode_concurrency) <= available_bytes)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    // Wyrównanie do wysokości bloku pliku, by każdy blok był dekodowany tylko raz
+    if (block_rows > 1 && low >= block_rows)
+    {
+        low -= low % block_rows;
+    }
+    return low;
+}
+
+// Wymiary potrzebnych pasm w zwartej tablicy (kolejność jak w czytniku pasów); zwraca ich liczbę
+static int selected_band_dimensions(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                    int widths[PIPELINE_BAND_COUNT], int heights[PIPELINE_BAND_COUNT])
+{
+    int count = 0;
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (band_mask & (1u << i))
+        {
+            widths[count] = *bands[i].width;
+            heights[count] = *bands[i].height;
+            count++;
+        }
+    }
+    return count;
+}
+
+void free_processing_result(ProcessingResult* result)
+{
     if (!result)
     {
-        fprintf(stderr, "[%s] Błąd alokacji pamięci dla ProcessingResult.\n", get_timestamp());
-        return NULL;
+        return;
     }
 
-    // Inicjalizacja wyniku
-    result->ndvi_data = NULL;
-    result->ndmi_data = NULL;
-    result->width = 0;
-    result->height = 0;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        raster_pool_release(result->index_data[k]);
+        raster_pool_release_int16(result->index_int16[k]);
+        block_index_free(&result->index_blocks[k]);
+        result->index_data[k] = NULL;
+        result->index_int16[k] = NULL;
+    }
+    free(result);
+    printf("[%s] Zwolniono pamięć ProcessingResult.\n", get_timestamp());
+}
 
-    // Ładowanie danych pasm
-    if (load_all_bands_data(bands) != 0)
+static void free_band_data(BandData bands[PIPELINE_BAND_COUNT])
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
     {
-        fprintf(stderr, "[%s] Błąd ładowania danych pasm.\n", get_timestamp());
-        free(result);
-        return NULL;
+        // Zwolnienie processed_data jeśli różni się od raw_data
+        if (*(bands[i].processed_data) && *(bands[i].processed_data) != *(bands[i].raw_data))
+        {
+            raster_pool_release(*(bands[i].processed_data));
+            *(bands[i].processed_data) = NULL;
+        }
+
+        // Zwolnienie raw_data
+        if (*(bands[i].raw_data))
+        {
+            raster_pool_release(*(bands[i].raw_data));
+            *(bands[i].raw_data) = NULL;
+        }
+
+        *(bands[i].processed_data) = NULL;
     }
 
-    // Określenie docelowych wymiarów
-    get_target_resolution_dimensions(bands, target_10m, &result->width, &result->height);
+    printf("[%s] Zwolniono pamięć danych pasm.\n", get_timestamp());
+}
 
-    // Resampling pasm do docelowej rozdzielczości
-    if (resample_all_bands_to_target_resolution(bands, 4, target_10m) != 0)
+static size_t band_buffer_bytes(int width, int height)
+{
+    return (size_t)width * height * sizeof(float);
+}
+
+// Bufory wyników wybranych wskaźników - int16 zajmuje połowę rastra float
+static size_t result_buffers_bytes(unsigned int indices, PipelineValueType value_type, int width, int height)
+{
+    size_t value_bytes = value_type == PIPELINE_VALUES_INT16 ? sizeof(int16_t) : sizeof(float);
+    return index_count(indices) * (size_t)width * height * value_bytes;
+}
+
+static void release_raw_buffer(BandData* band, MemoryPlanner* planner)
+{
+    if (!*(band->raw_data))
     {
-        fprintf(stderr, "[%s] Błąd resamplingu pasm.\n", get_timestamp());
-        free_band_data(bands);
-        free(result);
-        return NULL;
+        return;
     }
 
-    // Obliczanie NDVI
-    result->ndvi_data = calculate_ndvi(*bands[B08].processed_data, *bands[B04].processed_data,
-                                       result->width, result->height,
-                                       *bands[SCL].processed_data);
-    if (!result->ndvi_data)
+    raster_pool_release(*(band->raw_data));
+    *(band->raw_data) = NULL;
+    memory_planner_track_free(planner, band_buffer_bytes(*band->width, *band->height));
+}
+
+static void release_band_buffers(BandData* band, int target_width, int target_height, MemoryPlanner* planner)
+{
+    float* processed = *(band->processed_data);
+    if (!processed && !*(band->raw_data))
     {
-        fprintf(stderr, "[%s] Błąd podczas obliczania NDVI.\n", get_timestamp());
-        free_band_data(bands);
-        free(result);
-        return NULL;
+        // Już zwolnione (np. po spakowaniu w kafle)
+        return;
     }
 
-    // Obliczanie NDMI
-    result->ndmi_data = calculate_ndmi(*bands[B08].processed_data, *bands[B11].processed_data,
-                                       result->width, result->height,
-                                       *bands[SCL].processed_data);
-    if (!result->ndmi_data)
+    if (processed && processed != *(band->raw_data))
     {
-        fprintf(stderr, "[%s] Błąd podczas obliczania NDMI.\n", get_timestamp());
-        free(result->ndvi_data);
-        free_band_data(bands);
-        free(result);
-        return NULL;
+        raster_pool_release(processed);
+        memory_planner_track_free(planner, band_buffer_bytes(target_width, target_height));
     }
+    *(band->processed_data) = NULL;
+
+    release_raw_buffer(band, planner);
 
-    // Zwalnianie danych pasm - już nie potrzebne
-    free_band_data(bands);
+    log_labeled(stdout, planner->label, "[%s] Zwolniono bufory pasma po ostatnim użyciu.\n", band->band_name);
+}
 
-    if (!validate_processing_result(result))
+static void release_expired_buffers(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                    PipelineStage completed_stage,
+                                    int target_width, int target_height, MemoryPlanner* planner)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
     {
-        fprintf(stderr, "[%s] Błąd walidacji wyników przetwarzania.\n", get_timestamp());
-        free_processing_result(result);
-        return NULL;
+        if ((band_mask & (1u << i)) && BAND_LAST_USE[i] == completed_stage)
+        {
+            release_band_buffers(&bands[i], target_width, target_height, planner);
+        }
     }
+}
 
-    printf("[%s] Przetwarzanie zakończone pomyślnie. Wymiary: %dx%d\n",
-           get_timestamp(), result->width, result->height);
+// Wybrane wskaźniki przez silnik band_math - każde pasmo wejściowe czytane jest z pamięci jeden raz.
+// Wyniki trafiają do rastrów z result od piksela offset.
+static int calculate_pipeline_indices(unsigned int indices, const float* const inputs[PIPELINE_BAND_COUNT],
+                                      size_t num_pixels, ProcessingResult* result, size_t offset,
+                                      const TiledBands* tiled)
+{
+    MetricsScope metrics_scope = metrics_stage_begin("index", index_metrics_name(indices));
 
-    return result;
+    BandMathProgram* programs[PIPELINE_INDEX_COUNT] = {NULL};
+    float* outputs[PIPELINE_INDEX_COUNT] = {NULL};
+    int16_t* quantized_outputs[PIPELINE_INDEX_COUNT] = {NULL};
+    bool quantized = result_is_quantized(result);
+    int program_count = 0;
+    int status = 0;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (indices & (1u << k))
+        {
+            programs[program_count] = band_math_compile_builtin(PIPELINE_INDEX_NAMES[k]);
+            if (quantized)
+            {
+                quantized_outputs[program_count] = *result_quantized_slot(result, k) + offset;
+            }
+            else
+            {
+                outputs[program_count] = *result_index_slot(result, k) + offset;
+            }
+            if (!programs[program_count++])
+            {
+                status = -1;
+            }
+        }
+    }
+
+    const float* band_inputs[BAND_MATH_BAND_COUNT] = {NULL};
+    int band_slots[BAND_MATH_BAND_COUNT];
+    unsigned int tiled_mask = tiled ? pipeline_index_band_mask(indices) : 0;
+    int band_count = 0;
+    for (int b = 0; b < BAND_MATH_BAND_COUNT; b++)
+    {
+        band_slots[b] = -1;
+    }
+    for (int i = 0; i < SCL; i++)
+    {
+        if (inputs[i])
+        {
+            band_inputs[i] = inputs[i];
+            band_count++;
+        }
+        else if (tiled_mask & (1u << i))
+        {
+            band_slots[i] = band_tile_slot(tiled_mask, i);
+            band_count++;
+        }
+    }
+
+    // Statystyki fragmentu zbierane w tym samym przebiegu i doliczane do statystyk wyniku
+    IndexStats stats[PIPELINE_INDEX_COUNT];
+    for (int p = 0; p < program_count; p++)
+    {
+        index_stats_reset(&stats[p]);
+    }
+    int scl_slot = band_tile_slot(tiled_mask, SCL);
+    if (status == 0 && quantized)
+    {
+        // Kwantyzacja w jądrze - blok wyników float istnieje tylko w buforze wątku
+        status = tiled ? band_math_evaluate_tiled_quantized(programs, program_count, tiled, band_slots, scl_slot,
+                                                            quantized_outputs, stats)
+                       : band_math_evaluate_quantized(programs, program_count, band_inputs, inputs[SCL],
+                                                      num_pixels, quantized_outputs, stats);
+    }
+    else if (status == 0)
+    {
+        status = tiled ? band_math_evaluate_tiled(programs, program_count, tiled, band_slots, scl_slot,
+                                                  outputs, stats)
+                       : band_math_evaluate_with_stats(programs, program_count, band_inputs, inputs[SCL],
+                                                       num_pixels, outputs, stats);
+    }
+    for (int k = 0, p = 0; status == 0 && k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (indices & (1u << k))
+        {
+            index_stats_merge(result_stats_slot(result, k), &stats[p++]);
+        }
+    }
+    for (int k = 0; k < program_count; k++)
+    {
+        band_math_free(programs[k]);
+    }
+
+    // Odczyt potrzebnych pasm i SCL, zapis rastrów wybranych wyników
+    metrics_stage_end(&metrics_scope, (band_count + 1) * num_pixels * sizeof(float),
+                      program_count * num_pixels * (quantized ? sizeof(int16_t) : sizeof(float)), num_pixels);
+    return status;
+}
+
+// Czy któryś z rastrów przebiegu jest mapowaniem pliku roboczego (raster_pool_set_scratch())
+static bool rasters_on_scratch(const float* const inputs[PIPELINE_BAND_COUNT], ProcessingResult* result,
+                               unsigned int indices)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (inputs[i] && raster_pool_is_scratch(inputs[i]))
+        {
+            return true;
+        }
+    }
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (!(indices & (1u << k)))
+        {
+            continue;
+        }
+        const void* raster = result_is_quantized(result) ? (const void*)*result_quantized_slot(result, k)
+                                                         : (const void*)*result_index_slot(result, k);
+        if (raster_pool_is_scratch(raster))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Wskaźniki liczone oknami SCRATCH_WINDOW_ROWS wierszy w kolejności rastra: wszystkie wątki pracują
+// w jednym oknie, więc z dysku czytany jest jeden ciągły fragment każdego pasma. Kolejne okno
+// jest czytane z wyprzedzeniem, a strony ukończonego (pasm i wyników) mogą opuścić pamięć
+static int calculate_indices_in_windows(unsigned int indices, const float* const inputs[PIPELINE_BAND_COUNT],
+                                        ProcessingResult* result, const char* label)
+{
+    int window_rows = SCRATCH_WINDOW_ROWS < result->height ? SCRATCH_WINDOW_ROWS : result->height;
+    log_labeled(stdout, label, "Rastry w plikach roboczych - wskaźniki liczone oknami po %d wierszy.\n", window_rows);
+
+    advise_raster_rows(inputs, NULL, indices, result->width, 0, window_rows, RASTER_ACCESS_WILLNEED);
+    for (int y = 0; y < result->height; y += window_rows)
+    {
+        int y_end = y + window_rows < result->height ? y + window_rows : result->height;
+        int next_end = y_end + window_rows < result->height ? y_end + window_rows : result->height;
+        advise_raster_rows(inputs, NULL, indices, result->width, y_end, next_end, RASTER_ACCESS_WILLNEED);
+
+        size_t offset = (size_t)y * result->width;
+        const float* window[PIPELINE_BAND_COUNT] = {NULL};
+        for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+        {
+            window[i] = inputs[i] ? inputs[i] + offset : NULL;
+        }
+        if (calculate_pipeline_indices(indices, window, (size_t)(y_end - y) * result->width,
+                                       result, offset, NULL) != 0)
+        {
+            return -1;
+        }
+
+        advise_raster_rows(inputs, result, indices, result->width, y, y_end, RASTER_ACCESS_DONE);
+    }
+    return 0;
 }
 
+// Wskazówka raster_pool_advise() dla wierszy [y_start, y_end) pasm (inputs lub NULL) i wyników (result lub NULL)
+static void advise_raster_rows(const float* const inputs[PIPELINE_BAND_COUNT], ProcessingResult* result,
+                               unsigned int indices, int width, int y_start, int y_end, RasterAccess access)
+{
+    size_t first_pixel = (size_t)y_start * width;
+    size_t pixels = (size_t)(y_end - y_start) * width;
+    for (int i = 0; inputs && i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (inputs[i])
+        {
+            raster_pool_advise(inputs[i], first_pixel * sizeof(float), pixels * sizeof(float), access);
+        }
+    }
+    for (int k = 0; result && k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (!(indices & (1u << k)))
+        {
+            continue;
+        }
+        if (result_is_quantized(result))
+        {
+            raster_pool_advise(*result_quantized_slot(result, k), first_pixel * sizeof(int16_t),
+                               pixels * sizeof(int16_t), access);
+        }
+        else
+        {
+            raster_pool_advise(*result_index_slot(result, k), first_pixel * sizeof(float),
+                               pixels * sizeof(float), access);
+        }
+    }
+}
 
-static void get_target_resolution_dimensions(const BandData* bands, bool target_10m,
-                                             int* width_out, int* height_out)
+// Pasma z maski trafiają do kolejnych slotów kafla; bufor wierszowy pasma jest zwalniany zaraz po
+// skopiowaniu, a strony bufora kafli zajmowane są przy pierwszym zapisie, więc pamięć rośnie o jedno pasmo
+static int pack_bands_into_tiles(BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask,
+                                 int width, int height, TiledBands* tiled, MemoryPlanner* planner)
 {
-    if (target_10m)
+    if (tiled_bands_init(tiled, band_tile_slot(band_mask, PIPELINE_BAND_COUNT), (size_t)width * height, 0) != 0)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
     {
-        // Używamy wymiarów pasm 10m (B04, B08)
-        *width_out = *bands[B04].width;
-        *height_out = *bands[B04].height;
+        if (band_mask & (1u << i))
+        {
+            tiled_bands_store(tiled, band_tile_slot(band_mask, i), *bands[i].processed_data);
+            memory_planner_track_alloc(planner, band_buffer_bytes(width, height));
+            release_band_buffers(&bands[i], width, height, planner);
+        }
     }
-    else
+
+    log_labeled(stdout, planner->label, "Pasma spakowane w kafle: %d pasm, %zu kafli po %zu pikseli.\n",
+                tiled->band_count, tiled->tile_count, tiled->tile_pixels);
+    return 0;
+}
+
+// Slot pasma w kaflu - liczba pasm maski przed nim
+static int band_tile_slot(unsigned int band_mask, int band)
+{
+    int slot = 0;
+    for (int i = 0; i < band; i++)
     {
-        // Używamy wymiarów pasm 20m (B11, SCL)
-        *width_out = *bands[B11].width;
-        *height_out = *bands[B11].height;
+        slot += (band_mask >> i) & 1u;
     }
+    return slot;
+}
+
+static float** result_index_slot(ProcessingResult* result, int index)
+{
+    return &result->index_data[index];
+}
 
-    printf("[%s] Docelowa rozdzielczość: %dm, wymiary: %dx%d\n",
-           get_timestamp(), target_10m ? 10 : 20, *width_out, *height_out);
+static int16_t** result_quantized_slot(ProcessingResult* result, int index)
+{
+    return &result->index_int16[index];
 }
 
-static void free_processing_result(ProcessingResult* result)
+static bool result_is_quantized(const ProcessingResult* result)
 {
-    if (!result)
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
     {
-        return;
+        if (result->index_int16[k])
+        {
+            return true;
+        }
     }
+    return false;
+}
 
-    if (result->ndvi_data)
+// Rastry wybranych wskaźników w reprezentacji value_type; brak pamięci wykrywa validate_processing_result()
+static void acquire_result_rasters(ProcessingResult* result, unsigned int indices, PipelineValueType value_type)
+{
+    size_t num_pixels = (size_t)result->width * result->height;
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
     {
-        free(result->ndvi_data);
-        result->ndvi_data = NULL;
+        if (!(indices & (1u << k)))
+        {
+            continue;
+        }
+        if (value_type == PIPELINE_VALUES_INT16)
+        {
+            *result_quantized_slot(result, k) = raster_pool_acquire_int16(num_pixels);
+        }
+        else
+        {
+            *result_index_slot(result, k) = raster_pool_acquire(num_pixels);
+        }
     }
+}
 
-    if (result->ndmi_data)
+static IndexStats* result_stats_slot(ProcessingResult* result, int index)
+{
+    return &result->index_stats[index];
+}
+
+static void log_index_stats(ProcessingResult* result, unsigned int indices, const char* label)
+{
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
     {
-        free(result->ndmi_data);
-        result->ndmi_data = NULL;
+        if (indices & (1u << k))
+        {
+            // Etykieta sceny poprzedza nazwę wskaźnika w linii statystyk
+            char* name = label ? g_strdup_printf("[%s] %s", label, PIPELINE_INDEX_NAMES[k])
+                               : g_strdup(PIPELINE_INDEX_NAMES[k]);
+            index_stats_log(name, result_stats_slot(result, k));
+            g_free(name);
+        }
     }
+}
 
-    free(result);
-    printf("[%s] Zwolniono pamięć ProcessingResult.\n", get_timestamp());
+static BlockIndex* result_blocks_slot(ProcessingResult* result, int index)
+{
+    return &result->index_blocks[index];
 }
 
-static void free_band_data(BandData bands[4])
+// Indeks bloków jest pomocniczy - błąd budowy zostawia pusty indeks, ale nie unieważnia wyniku
+static void build_result_block_indices(ProcessingResult* result, unsigned int indices, const char* label)
 {
-    for (int i = 0; i < 4; i++)
+    gint64 start_us = g_get_monotonic_time();
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
     {
-        // Zwolnienie processed_data jeśli różni się od raw_data
-        if (*(bands[i].processed_data) && *(bands[i].processed_data) != *(bands[i].raw_data))
+        if (!(indices & (1u << k)))
         {
-            free(*(bands[i].processed_data));
-            *(bands[i].processed_data) = NULL;
+            continue;
+        }
+        int status = result_is_quantized(result) ?
+                     block_index_build_quantized(result_blocks_slot(result, k), *result_quantized_slot(result, k),
+                                                 result->width, result->height, BLOCK_INDEX_DEFAULT_SIZE) :
+                     block_index_build(result_blocks_slot(result, k), *result_index_slot(result, k),
+                                       result->width, result->height, BLOCK_INDEX_DEFAULT_SIZE);
+        if (status != 0)
+        {
+            log_labeled(stderr, label, "Nie udało się zbudować indeksu bloków %s.\n", PIPELINE_INDEX_NAMES[k]);
         }
+    }
+    log_labeled(stdout, label, "Indeksy bloków %dx%d zbudowane w %.3fs.\n", BLOCK_INDEX_DEFAULT_SIZE,
+                BLOCK_INDEX_DEFAULT_SIZE, (g_get_monotonic_time() - start_us) / 1e6);
+}
 
-        // Zwolnienie raw_data
-        if (*(bands[i].raw_data))
+int write_processing_stats_json(const ProcessingResult* result, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można zapisać raportu statystyk %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    bool first = true;
+
+    fprintf(file, "{\"width\":%d,\"height\":%d,\"indices\":{", result->width, result->height);
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (!result->index_data[k] && !result->index_int16[k])
         {
-            free(*(bands[i].raw_data));
-            *(bands[i].raw_data) = NULL;
+            continue;
         }
+        fprintf(file, "%s\"%s\":", first ? "" : ",", PIPELINE_INDEX_NAMES[k]);
+        index_stats_write_json(file, &result->index_stats[k]);
+        first = false;
+    }
+    fputs("}}\n", file);
 
-        *(bands[i].processed_data) = NULL;
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0)
+    {
+        status = -1;
     }
+    return status;
+}
 
-    printf("[%s] Zwolniono pamięć danych pasm.\n", get_timestamp());
+int write_processing_blocks_json(const ProcessingResult* result, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można zapisać indeksu bloków %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    // Siatka bloków jest wspólna dla wszystkich wskaźników - opisuje ją pierwszy zbudowany indeks
+    const BlockIndex* layout = &result->index_blocks[0];
+    for (int k = 0; k < PIPELINE_INDEX_COUNT && !layout->blocks; k++)
+    {
+        layout = &result->index_blocks[k];
+    }
+    bool first = true;
+
+    fprintf(file, "{\"width\":%d,\"height\":%d,\"block_size\":%d,\"blocks_x\":%d,\"blocks_y\":%d,\"indices\":{",
+            result->width, result->height, layout->block_size, layout->blocks_x, layout->blocks_y);
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
+    {
+        if (!result->index_blocks[k].blocks)
+        {
+            continue;
+        }
+        fprintf(file, "%s\"%s\":", first ? "" : ",", PIPELINE_INDEX_NAMES[k]);
+        block_index_write_json(file, &result->index_blocks[k]);
+        first = false;
+    }
+    fputs("}}\n", file);
+
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0)
+    {
+        status = -1;
+    }
+    return status;
 }
 
-static int validate_processing_inputs(const BandData bands[4])
+static int validate_processing_inputs(const BandData bands[PIPELINE_BAND_COUNT], unsigned int band_mask)
 {
-    for (int i = 0; i < 4; i++)
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
     {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+
         if (!bands[i].path)
         {
             fprintf(stderr, "[%s] Błąd walidacji: Brak ścieżki dla pasma %s.\n",
@@ -203,7 +1810,7 @@ static int validate_processing_inputs(const BandData bands[4])
     return 1;
 }
 
-static int validate_processing_result(const ProcessingResult* result)
+static int validate_processing_result(const ProcessingResult* result, unsigned int indices)
 {
     if (!result)
     {
@@ -211,16 +1818,14 @@ static int validate_processing_result(const ProcessingResult* result)
         return 0;
     }
 
-    if (!result->ndvi_data)
+    for (int k = 0; k < PIPELINE_INDEX_COUNT; k++)
     {
-        fprintf(stderr, "[%s] Błąd walidacji: Brak danych NDVI w wyniku.\n", get_timestamp());
-        return 0;
-    }
-
-    if (!result->ndmi_data)
-    {
-        fprintf(stderr, "[%s] Błąd walidacji: Brak danych NDMI w wyniku.\n", get_timestamp());
-        return 0;
+        if ((indices & (1u << k)) && !result->index_data[k] && !result->index_int16[k])
+        {
+            fprintf(stderr, "[%s] Błąd walidacji: Brak danych %s w wyniku.\n", get_timestamp(),
+                    PIPELINE_INDEX_NAMES[k]);
+            return 0;
+        }
     }
 
     if (result->width <= 0 || result->height <= 0)
@@ -2,53 +2,318 @@
 #define PROCESSING_PIPELINE_H
 
 #include "../data_types/data_types.h"
+#include "../index_stats/index_stats.h"
+#include "../block_index/block_index.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+/**
+ * @brief Wskaźniki wbudowane pipeline'u - pozycje w tablicach ProcessingResult i bity PipelineIndex
+ *
+ * Kolejność i nazwy odpowiadają wbudowanym formułom band_math (band_math_builtin_indices()).
+ */
+enum IndexType
+{
+    NDVI,
+    NDMI,
+    NDWI,
+    NBR,
+    NDRE,
+    EVI,
+    SAVI
+};
+
+// Liczba wskaźników (pozycji IndexType i bitów PipelineIndex)
+#define PIPELINE_INDEX_COUNT 7
+
+/**
+ * @brief Wynik przebiegu pipeline'u
+ *
+ * Statystyki wskaźników zbierane są w tym samym przebiegu co wartości (band_math), więc
+ * nie wymagają ponownego czytania rastrów. Dla wskaźnika spoza wyboru mają total_pixels == 0.
+ *
+ * Indeksy bloków (BLOCK_INDEX_DEFAULT_SIZE) pozwalają odpowiadać na zapytania progowe i o pokrycie
+ * bez przeglądania całych rastrów. Dla wskaźnika spoza wyboru (lub gdy budowa się nie powiodła)
+ * mają blocks == NULL; zwalniane są przez block_index_free() razem z rastrami.
+ *
+ * Tablice wyniku indeksowane są pozycją IndexType (np. index_data[NDVI]). Przy PIPELINE_VALUES_INT16
+ * wartości wskaźników są w index_int16 (quantize_index_values()), a index_data jest NULL;
+ * w przeciwnym razie odwrotnie.
+ */
 typedef struct
 {
-    float* ndvi_data;
-    float* ndmi_data;
+    float* index_data[PIPELINE_INDEX_COUNT];
+    int16_t* index_int16[PIPELINE_INDEX_COUNT];
     int width;
     int height;
+    IndexStats index_stats[PIPELINE_INDEX_COUNT];
+    BlockIndex index_blocks[PIPELINE_INDEX_COUNT];
 } ProcessingResult;
 
+/**
+ * @brief Wskaźniki liczone przez pipeline (flagi bitowe, bit = IndexType)
+ *
+ * Wskaźnik spoza wyboru ma NULL w odpowiednich tablicach ProcessingResult.
+ */
+typedef enum
+{
+    PIPELINE_INDEX_NDVI = 1 << NDVI,
+    PIPELINE_INDEX_NDMI = 1 << NDMI,
+    PIPELINE_INDEX_NDWI = 1 << NDWI,
+    PIPELINE_INDEX_NBR = 1 << NBR,
+    PIPELINE_INDEX_NDRE = 1 << NDRE,
+    PIPELINE_INDEX_EVI = 1 << EVI,
+    PIPELINE_INDEX_SAVI = 1 << SAVI
+} PipelineIndex;
+
+#define PIPELINE_INDEX_ALL ((1u << PIPELINE_INDEX_COUNT) - 1)
+
+// Wskaźniki liczone domyślnie oraz zawsze w GUI - wymagają tylko pasm B04, B08, B11 i SCL
+#define PIPELINE_INDEX_DEFAULT (PIPELINE_INDEX_NDVI | PIPELINE_INDEX_NDMI)
+
+/**
+ * @brief Układ pasm w pamięci na etapie wskaźników (przetwarzanie całej sceny)
+ */
+typedef enum
+{
+    // Każde pasmo w osobnym rastrze wierszowym
+    PIPELINE_LAYOUT_PLANAR,
+    // Pasma spakowane w kafle mieszczące się w cache (patrz TiledBands)
+    PIPELINE_LAYOUT_TILED
+} PipelineBandLayout;
+
+/**
+ * @brief Reprezentacja wartości wskaźników w wyniku pipeline'u
+ */
+typedef enum
+{
+    // float, INDEX_NO_DATA_VALUE dla pikseli bez danych
+    PIPELINE_VALUES_FLOAT32,
+    // int16 skalowane przez INDEX_INT16_SCALE, INDEX_INT16_NO_DATA dla pikseli bez danych - połowa pamięci
+    PIPELINE_VALUES_INT16
+} PipelineValueType;
+
+/**
+ * @brief Wywoływana po każdym ukończonym pasie wierszy przetwarzania progresywnego
+ *
+ * @param partial Wynik w trakcie obliczania - wiersze [0, y_end) są już kompletne
+ * @param y_start Pierwszy wiersz ukończonego pasa
+ * @param y_end Wiersz za ostatnim wierszem ukończonego pasa
+ * @return false przerywa przetwarzanie (wynik jest wtedy zwalniany, a funkcja zwraca NULL)
+ *
+ * @note Wywoływana w wątku wykonującym pipeline
+ */
+typedef bool (*PipelineProgressCallback)(const ProcessingResult* partial, int y_start, int y_end, void* user_data);
+
 /**
  * @brief Główna funkcja pipeline'u przetwarzania danych satelitarnych Sentinel-2
  *
  * Funkcja wykonuje kompletny proces przetwarzania danych satelitarnych:
  * 1. Waliduje dane wejściowe
- * 2. Wczytuje dane wszystkich pasm (B04, B08, B11, SCL)
+ * 2. Wczytuje dane pasm potrzebnych wybranym wskaźnikom (set_pipeline_index_selection())
  * 3. Wykonuje resampling do wspólnej rozdzielczości (10m lub 20m)
- * 4. Oblicza wskaźniki wegetacji NDVI i NDMI z zastosowaniem maski SCL
+ * 4. Oblicza wybrane wskaźniki (domyślnie NDVI i NDMI) z zastosowaniem maski SCL
  * 5. Waliduje wyniki i zwraca strukturę ProcessingResult
  *
- * Pipeline automatycznie zarządza pamięcią - w przypadku błędu na którymkolwiek etapie
+ * Pipeline automatycznie zarządza pamięcią - każdy bufor pasma zwalniany jest zaraz po
+ * ostatnim etapie, który go czyta (surowe B11/SCL po upsamplingu, B04 po NDVI), a szczytowa
+ * pamięć każdego etapu jest raportowana na stdout. W przypadku błędu na którymkolwiek etapie
  * zwalnia już zaalokowane zasoby i zwraca NULL.
  *
- * @param bands Tablica 4 struktur BandData w określonej kolejności:
- *              - bands[0] (B04): Pasmo czerwone (RED), rozdzielczość 10m
- *              - bands[1] (B08): Pasmo bliskiej podczerwieni (NIR), rozdzielczość 10m
- *              - bands[2] (B11): Pasmo średniej podczerwieni (SWIR1), rozdzielczość 20m
- *              - bands[3] (SCL): Warstwa klasyfikacji sceny, rozdzielczość 20m
+ * @param bands Tablica PIPELINE_BAND_COUNT struktur BandData w kolejności BandType (rejestru pasm).
+ *              Ścieżki muszą mieć tylko pasma z pipeline_index_band_mask() wybranych wskaźników,
+ *              np. B04, B08, B11 i SCL dla NDVI i NDMI - pozostałe pozycje nie są czytane
  *
  * @param target_10m Flaga określająca docelową rozdzielczość:
  *                   - true: upscaling do 10m (powiększenie pasm 20m)
  *                   - false: downscaling do 20m (zmniejszenie pasm 10m)
  *
  * @return Wskaźnik do struktury ProcessingResult zawierającej:
- *         - ndvi_data: Tablica wartości NDVI w zakresie [-1, 1]
- *         - ndmi_data: Tablica wartości NDMI w zakresie [-1, 1]
+ *         - index_data[k]: Raster wartości wskaźnika k (IndexType) lub NULL dla wskaźnika spoza wyboru
  *         - width, height: Wymiary wynikowych tablic w pikselach
  *
  *         NULL w przypadku błędu (szczegóły w stderr)
  *
  * @note Zwrócona struktura musi zostać zwolniona przez free_processing_result()
  * @note Funkcja automatycznie stosuje maskę SCL do wykluczenia nieprawidłowych pikseli
- * @note Po pomyślnym przetwarzaniu zwalnia pamięć danych pasm (bands)
+ * @note Po pomyślnym przetwarzaniu wszystkie bufory pasm (bands) są już zwolnione
+ * @note Jeśli potrzebne pasma mają już raw_data (wczytane z wyprzedzeniem przez load_bands_data()),
+ *       etap wczytywania jest pomijany, a scena przetwarzana w całości niezależnie od budżetu pamięci
+ *
+ * @note Przy włączonej pamięci podręcznej etapów (stage_cache_set_capacity()) zdekodowane pasma,
+ *       pasma po resamplingu i wskaźniki są zapamiętywane. Kolejny przebieg dla tych samych plików
+ *       liczy tylko etapy zależne od zmienionych parametrów - np. zmiana rozdzielczości pomija
+ *       dekodowanie JP2. Bufory wyniku mogą być wtedy współdzielone z pamięcią podręczną
+ *       i nie mogą być modyfikowane.
  *
- * @warning Zakłada że tablica bands ma dokładnie 4 elementy w określonej kolejności
+ * @warning Zakłada że tablica bands ma PIPELINE_BAND_COUNT elementów w kolejności BandType
  * @warning Modyfikuje struktury BandData (zwalnia pamięć processed_data i raw_data)
  */
-ProcessingResult* process_bands_and_calculate_indices(BandData bands[4], bool target_10m);
+ProcessingResult* process_bands_and_calculate_indices(BandData bands[PIPELINE_BAND_COUNT], bool target_10m);
+
+/**
+ * @brief Wariant process_bands_and_calculate_indices() z jawnym budżetem pamięci
+ *
+ * Wszystkie parametry przebiegu przekazywane są jawnie, a ze stanu globalnego czytana jest tylko
+ * konfiguracja GDAL, więc funkcja może być wywoływana równolegle z wielu wątków dla niezależnych scen.
+ *
+ * @param memory_budget Budżet w bajtach, 0 oznacza brak limitu
+ * @param indices Suma flag PipelineIndex - pasma, od których nie zależy żaden wybrany wskaźnik,
+ *                nie są wczytywane (np. B11 przy samym NDVI)
+ * @param value_type Reprezentacja wartości wskaźników w wyniku. Przy PIPELINE_VALUES_INT16 kwantyzacja
+ *                   odbywa się w jądrze wskaźników (band_math_evaluate_quantized()), więc rastry float
+ *                   wyników nie powstają. Statystyki liczone są z wartości przed kwantyzacją, a pamięć
+ *                   podręczna etapów nie jest używana dla wskaźników (przechowuje rastry float).
+ * @param band_layout Układ pasm na etapie wskaźników. W układzie PIPELINE_LAYOUT_TILED pasma po resamplingu
+ *                    są pakowane w kafle (tiled_bands_store()), a bufor wierszowy każdego pasma zwalniany
+ *                    zaraz po skopiowaniu, po czym wskaźniki liczone są kafel po kaflu
+ *                    (band_math_evaluate_tiled()). Dotyczy tylko przetwarzania całej sceny - tryb pasami
+ *                    wierszy (budżet pamięci mniejszy niż scena) zawsze czyta pasma wierszowo.
+ * @param label Etykieta sceny poprzedzająca komunikaty przebiegu w logach (może być NULL) - przy kilku
+ *              scenach naraz pozwala przypisać linie etapów, planu pamięci i statystyk do sceny
+ */
+ProcessingResult* process_bands_with_budget(BandData bands[PIPELINE_BAND_COUNT], bool target_10m,
+                                            size_t memory_budget, unsigned int indices,
+                                            PipelineValueType value_type, PipelineBandLayout band_layout,
+                                            const char* label);
+
+/**
+ * @brief Przetwarza scenę pasami wierszy, zgłaszając każdy ukończony pas
+ *
+ * Pozwala wyświetlać wynik w trakcie obliczeń: pierwsze wiersze pełnej rozdzielczości są
+ * gotowe po zdekodowaniu pierwszego pasa, a nie po zdekodowaniu całych pasm. Gdy wyniki
+ * lub wszystkie zdekodowane pasma są w pamięci podręcznej etapów, scena liczona jest w całości
+ * i zgłaszana jednym wywołaniem on_progress. Wyniki trafiają do pamięci podręcznej etapów.
+ *
+ * @param strip_rows Wysokość pasa w wierszach docelowych (zaokrąglana w górę do bloku pliku)
+ * @param on_progress Funkcja wywoływana po każdym pasie (może być NULL)
+ * @return Wynik jak z process_bands_and_calculate_indices() lub NULL przy błędzie lub przerwaniu
+ */
+ProcessingResult* process_bands_progressive(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, int strip_rows,
+                                            PipelineProgressCallback on_progress, void* user_data);
+
+/**
+ * @brief Oblicza zgrubny podgląd NDVI/NDMI ze zmniejszonych poziomów rozdzielczości plików
+ *
+ * Pasma są czytane przez read_band_overview() bezpośrednio w wymiarach podglądu, więc dla
+ * JPEG2000 dekodowana jest tylko niewielka część danych. Nie zmienia buforów pasm.
+ *
+ * @param max_dimension Maksymalna długość dłuższego boku podglądu w pikselach
+ * @param target_width_out Wskaźnik na szerokość pełnej sceny w docelowej rozdzielczości (może być NULL)
+ * @param target_height_out Wskaźnik na wysokość pełnej sceny w docelowej rozdzielczości (może być NULL)
+ * @return Wynik w wymiarach podglądu (zwalniany jak wynik pipeline'u) lub NULL w przypadku błędu
+ */
+ProcessingResult* process_bands_quicklook(BandData bands[PIPELINE_BAND_COUNT], bool target_10m, int max_dimension,
+                                          int* target_width_out, int* target_height_out);
+
+/**
+ * @brief Sprawdza, czy NDVI i NDMI (PIPELINE_INDEX_DEFAULT) dla tych plików i rozdzielczości
+ *        są w pamięci podręcznej etapów
+ */
+bool pipeline_indices_cached(BandData bands[PIPELINE_BAND_COUNT], bool target_10m);
+
+/**
+ * @brief Ustawia budżet pamięci dla kolejnych przebiegów pipeline'u
+ *
+ * Przy niezerowym budżecie pipeline przed wczytaniem danych odczytuje wymiary rastrów
+ * z nagłówków plików i szacuje szczytowe zużycie pamięci. Jeśli cała scena się nie mieści,
+ * przechodzi na przetwarzanie pasami wierszy i ogranicza liczbę jednocześnie dekodowanych
+ * pasm. Jeśli nie mieszczą się nawet same wyniki, przebieg kończy się błędem przed alokacjami.
+ *
+ * @param budget_bytes Budżet w bajtach, 0 wyłącza limit (domyślnie)
+ */
+void set_pipeline_memory_budget(size_t budget_bytes);
+
+/**
+ * @brief Zwraca domyślny budżet pamięci ustawiony przez set_pipeline_memory_budget()
+ */
+size_t get_pipeline_memory_budget(void);
+
+/**
+ * @brief Ustawia wskaźniki liczone przez process_bands_and_calculate_indices()
+ *
+ * @param indices Suma flag PipelineIndex; 0 przywraca domyślne PIPELINE_INDEX_DEFAULT
+ */
+void set_pipeline_index_selection(unsigned int indices);
+
+/**
+ * @brief Zwraca wybór wskaźników ustawiony przez set_pipeline_index_selection()
+ */
+unsigned int get_pipeline_index_selection(void);
+
+/**
+ * @brief Maska pasm (bit = BandType) potrzebnych do obliczenia wybranych wskaźników
+ *
+ * Wyznaczana z zależności formuł band_math wskaźników; SCL jest zawsze częścią maski.
+ */
+unsigned int pipeline_index_band_mask(unsigned int indices);
+
+/**
+ * @brief Nazwa pasma z rejestru pasm dla pozycji BandType lub NULL spoza zakresu
+ */
+const char* pipeline_band_name(int band);
+
+/**
+ * @brief Nazwa wskaźnika dla pozycji IndexType ("NDVI", "NDMI", ...) lub NULL spoza zakresu
+ */
+const char* pipeline_index_name(int index);
+
+/**
+ * @brief Flaga PipelineIndex dla nazwy wskaźnika (bez rozróżniania wielkości liter), 0 gdy nieznana
+ */
+unsigned int pipeline_index_from_name(const char* name);
+
+/**
+ * @brief Wyznacza siatkę wyniku sceny z nagłówków plików pasm, bez wczytywania pikseli
+ *
+ * Siatkę wyznacza pierwsze pasmo z band_mask o natywnej rozdzielczości celu, tak jak
+ * w process_bands_and_calculate_indices().
+ *
+ * @param reference_out [out] Pasmo (BandType) wyznaczające siatkę, może być NULL
+ * @return 0 w przypadku sukcesu, -1 gdy pliku pasma odniesienia nie można odczytać
+ */
+int pipeline_target_grid(char* const paths[PIPELINE_BAND_COUNT], unsigned int band_mask, bool target_10m,
+                         int* width_out, int* height_out, int* reference_out);
+
+/**
+ * @brief Zapisuje raport statystyk wskaźników wyniku jako JSON
+ *
+ * Format: {"width":W,"height":H,"indices":{"NDVI":{...},"NDMI":{...}}} - pola wskaźnika
+ * opisuje index_stats_write_json(). Wskaźniki spoza wyboru są pomijane.
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy pliku nie można zapisać
+ */
+int write_processing_stats_json(const ProcessingResult* result, const char* path);
+
+/**
+ * @brief Zapisuje indeksy bloków wskaźników wyniku jako JSON
+ *
+ * Format: {"width":W,"height":H,"block_size":S,"blocks_x":BX,"blocks_y":BY,"indices":{"NDVI":{...}}}
+ * - pola wskaźnika opisuje block_index_write_json(). Wskaźniki bez indeksu bloków są pomijane.
+ *
+ * @return 0 w przypadku sukcesu, -1 gdy pliku nie można zapisać
+ */
+int write_processing_blocks_json(const ProcessingResult* result, const char* path);
+
+/**
+ * @brief Zwalnia wynik pipeline'u: rastry wskaźników (float lub int16), indeksy bloków i strukturę
+ *
+ * @param result Wynik lub NULL
+ */
+void free_processing_result(ProcessingResult* result);
+
+/**
+ * @brief Buduje klucz wskaźnika w pamięci podręcznej etapów
+ *
+ * Klucz zależy od zawartości plików pasm wejściowych wskaźnika (ścieżka, rozmiar, czas
+ * modyfikacji) i docelowej rozdzielczości. Służy też do zapamiętywania etapów pochodnych,
+ * np. wyrenderowanych map w GUI.
+ *
+ * @param index_name Nazwa wskaźnika wbudowanego, np. "NDVI"
+ * @return Napis do zwolnienia przez g_free() lub NULL, gdy pamięć podręczna jest wyłączona
+ *         albo któregoś pliku nie można odczytać
+ */
+char* pipeline_index_cache_key(const BandData bands[PIPELINE_BAND_COUNT], bool target_10m, const char* index_name);
 
 #endif // PROCESSING_PIPELINE_H
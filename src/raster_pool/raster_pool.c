@@ -0,0 +1,359 @@
+#define _GNU_SOURCE
+#include "raster_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../utils/utils.h"
+
+/**
+ * @brief Nagłówek poprzedzający dane bufora
+ *
+ * Przechowuje rozmiar bufora, dzięki czemu raster_pool_release() nie potrzebuje go od
+ * wywołującego, oraz licznik referencji. Rozmiar nagłówka (64 B) zachowuje wyrównanie
+ * danych do linii cache. Bufor w pliku roboczym zaczyna się nagłówkiem na początku
+ * mapowania (wyrównanego do strony), a mapped_bytes to długość całego mapowania.
+ */
+typedef struct RasterBlock
+{
+    _Alignas(64) size_t bytes;
+    uint32_t magic;
+    int refs;
+    struct RasterBlock* next;
+    // 0 - bufor z aligned_alloc(), w przeciwnym razie długość mapowania pliku roboczego
+    size_t mapped_bytes;
+} RasterBlock;
+
+_Static_assert(sizeof(RasterBlock) == 64, "Nagłówek bufora musi zajmować jedną linię cache");
+
+#define RASTER_BLOCK_MAGIC 0x52415354u
+
+// Lista wolnych buforów - dostęp tylko w sekcji krytycznej "raster_pool"
+static RasterBlock* free_blocks = NULL;
+static size_t cached_bytes = 0;
+static size_t capacity_bytes = 0;
+
+// Katalog plików roboczych (NULL - wyłączone) i najmniejszy bufor w nich umieszczany.
+// Ustawiane przed przebiegami, tylko do odczytu w ich trakcie
+static char* scratch_dir = NULL;
+static size_t scratch_min_bytes = 0;
+
+// ====== POMOCNICZE ======
+static RasterBlock* block_from_data(float* data);
+static void evict_until_fits(size_t limit_bytes);
+static RasterBlock* allocate_block(size_t bytes);
+static RasterBlock* map_scratch_block(size_t bytes);
+static void free_block(RasterBlock* block);
+
+float* raster_pool_acquire(size_t num_pixels)
+{
+    size_t bytes = num_pixels * sizeof(float);
+    RasterBlock* block = NULL;
+
+    #pragma omp critical(raster_pool)
+    {
+        RasterBlock** link = &free_blocks;
+        while (*link)
+        {
+            if ((*link)->bytes == bytes)
+            {
+                block = *link;
+                *link = block->next;
+                cached_bytes -= bytes;
+                break;
+            }
+            link = &(*link)->next;
+        }
+    }
+
+    if (!block)
+    {
+        block = allocate_block(bytes);
+        if (!block)
+        {
+            return NULL;
+        }
+    }
+
+    block->next = NULL;
+    block->refs = 1;
+    return (float*)(block + 1);
+}
+
+int16_t* raster_pool_acquire_int16(size_t num_pixels)
+{
+    // Dane bufora są wyrównane do 64 B, więc mogą przechowywać dowolny typ
+    return (int16_t*)raster_pool_acquire((num_pixels * sizeof(int16_t) + sizeof(float) - 1) / sizeof(float));
+}
+
+void raster_pool_release_int16(int16_t* data)
+{
+    raster_pool_release((float*)data);
+}
+
+float* raster_pool_retain(float* data)
+{
+    if (!data)
+    {
+        return NULL;
+    }
+
+    RasterBlock* block = block_from_data(data);
+    if (!block)
+    {
+        return NULL;
+    }
+
+    #pragma omp atomic
+    block->refs++;
+
+    return data;
+}
+
+void raster_pool_release(float* data)
+{
+    if (!data)
+    {
+        return;
+    }
+
+    RasterBlock* block = block_from_data(data);
+    if (!block)
+    {
+        return;
+    }
+
+    // Bufor współdzielony (raster_pool_retain()) wraca do puli dopiero po ostatnim zwolnieniu
+    int remaining_refs;
+    #pragma omp atomic capture
+    remaining_refs = --block->refs;
+
+    if (remaining_refs > 0)
+    {
+        return;
+    }
+
+    int cached = 0;
+
+    #pragma omp critical(raster_pool)
+    {
+        if (block->bytes <= capacity_bytes)
+        {
+            evict_until_fits(capacity_bytes - block->bytes);
+            block->next = free_blocks;
+            free_blocks = block;
+            cached_bytes += block->bytes;
+            cached = 1;
+        }
+    }
+
+    if (!cached)
+    {
+        free_block(block);
+    }
+}
+
+void raster_pool_set_capacity(size_t new_capacity_bytes)
+{
+    #pragma omp critical(raster_pool)
+    {
+        capacity_bytes = new_capacity_bytes;
+        evict_until_fits(capacity_bytes);
+    }
+}
+
+void raster_pool_trim(void)
+{
+    #pragma omp critical(raster_pool)
+    {
+        evict_until_fits(0);
+    }
+}
+
+// ====== PLIKI ROBOCZE ======
+
+int raster_pool_set_scratch(const char* directory, size_t min_bytes)
+{
+    if (directory && access(directory, W_OK | X_OK) != 0)
+    {
+        fprintf(stderr, "[%s] Błąd: Katalog plików roboczych '%s' jest niedostępny do zapisu: %s\n",
+                get_timestamp(), directory, strerror(errno));
+        return -1;
+    }
+
+    char* copy = directory ? strdup(directory) : NULL;
+    if (directory && !copy)
+    {
+        return -1;
+    }
+
+    free(scratch_dir);
+    scratch_dir = copy;
+    scratch_min_bytes = min_bytes;
+    return 0;
+}
+
+bool raster_pool_uses_scratch(size_t bytes)
+{
+    return scratch_dir && bytes >= scratch_min_bytes;
+}
+
+bool raster_pool_is_scratch(const void* data)
+{
+    if (!data)
+    {
+        return false;
+    }
+    RasterBlock* block = block_from_data((float*)data);
+    return block && block->mapped_bytes > 0;
+}
+
+void raster_pool_advise(const void* data, size_t first_byte, size_t length, RasterAccess access)
+{
+    RasterBlock* block = data ? block_from_data((float*)data) : NULL;
+    // Dla buforów z aligned_alloc() MADV_DONTNEED wyzerowałby dane - wskazówki tylko dla plików roboczych
+    if (!block || block->mapped_bytes == 0 || length == 0 || first_byte >= block->bytes)
+    {
+        return;
+    }
+    if (length > block->bytes - first_byte)
+    {
+        length = block->bytes - first_byte;
+    }
+
+    // Zakres rozszerzony do pełnych stron - MADV_DONTNEED dla mapowania współdzielonego pliku
+    // nie traci danych, tylko zwalnia strony z procesu (brudne zapisze jądro)
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)data + first_byte;
+    uintptr_t end = start + length;
+    start &= ~(uintptr_t)(page - 1);
+    end = (end + page - 1) & ~(uintptr_t)(page - 1);
+
+    int advice = access == RASTER_ACCESS_SEQUENTIAL ? MADV_SEQUENTIAL :
+                 access == RASTER_ACCESS_WILLNEED ? MADV_WILLNEED : MADV_DONTNEED;
+    if (madvise((void*)start, end - start, advice) != 0)
+    {
+        fprintf(stderr, "[%s] Ostrzeżenie: madvise pliku roboczego nie powiodło się: %s\n",
+                get_timestamp(), strerror(errno));
+    }
+}
+
+// ====== POMOCNICZE ======
+
+static RasterBlock* allocate_block(size_t bytes)
+{
+    RasterBlock* block;
+    if (raster_pool_uses_scratch(bytes))
+    {
+        block = map_scratch_block(bytes);
+    }
+    else
+    {
+        block = aligned_alloc(64, sizeof(RasterBlock) + ((bytes + 63) & ~(size_t)63));
+        if (block)
+        {
+            block->mapped_bytes = 0;
+        }
+    }
+    if (!block)
+    {
+        return NULL;
+    }
+
+    block->bytes = bytes;
+    block->magic = RASTER_BLOCK_MAGIC;
+    return block;
+}
+
+// Bufor w nienazwanym pliku roboczym: plik usuwany jest zaraz po utworzeniu, więc znika razem
+// z mapowaniem także po awarii procesu. Miejsce na dysku rezerwowane z góry - brak miejsca to
+// błąd alokacji zamiast SIGBUS przy pierwszym zapisie
+static RasterBlock* map_scratch_block(size_t bytes)
+{
+    size_t mapped_bytes = sizeof(RasterBlock) + bytes;
+    size_t path_length = strlen(scratch_dir) + sizeof("/ndindex-scratch-XXXXXX");
+    char* path = malloc(path_length);
+    if (!path)
+    {
+        return NULL;
+    }
+    snprintf(path, path_length, "%s/ndindex-scratch-XXXXXX", scratch_dir);
+
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        fprintf(stderr, "[%s] Błąd tworzenia pliku roboczego w '%s': %s\n",
+                get_timestamp(), scratch_dir, strerror(errno));
+        free(path);
+        return NULL;
+    }
+    unlink(path);
+    free(path);
+
+    int status = posix_fallocate(fd, 0, (off_t)mapped_bytes);
+    if (status != 0)
+    {
+        fprintf(stderr, "[%s] Błąd rezerwacji %.0f MB w pliku roboczym: %s\n",
+                get_timestamp(), mapped_bytes / (1024.0 * 1024.0), strerror(status));
+        close(fd);
+        return NULL;
+    }
+
+    void* mapping = mmap(NULL, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        fprintf(stderr, "[%s] Błąd mapowania pliku roboczego: %s\n", get_timestamp(), strerror(errno));
+        return NULL;
+    }
+
+    RasterBlock* block = mapping;
+    block->mapped_bytes = mapped_bytes;
+    return block;
+}
+
+static void free_block(RasterBlock* block)
+{
+    if (block->mapped_bytes > 0)
+    {
+        munmap(block, block->mapped_bytes);
+    }
+    else
+    {
+        free(block);
+    }
+}
+
+static RasterBlock* block_from_data(float* data)
+{
+    RasterBlock* block = (RasterBlock*)data - 1;
+    if (block->magic != RASTER_BLOCK_MAGIC)
+    {
+        fprintf(stderr, "Błąd: Bufor spoza puli przekazany do raster_pool.\n");
+        return NULL;
+    }
+    return block;
+}
+
+// Zwalnia bufory z puli, aż przechowywane bajty nie przekraczają limitu (w sekcji krytycznej)
+static void evict_until_fits(size_t limit_bytes)
+{
+    while (cached_bytes > limit_bytes && free_blocks)
+    {
+        // Najstarszy bufor jest na końcu listy
+        RasterBlock** link = &free_blocks;
+        while ((*link)->next)
+        {
+            link = &(*link)->next;
+        }
+        RasterBlock* oldest = *link;
+        *link = NULL;
+        cached_bytes -= oldest->bytes;
+        free_block(oldest);
+    }
+}
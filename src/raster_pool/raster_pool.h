@@ -0,0 +1,117 @@
+#ifndef RASTER_POOL_H
+#define RASTER_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Domyślnie w plikach roboczych umieszczane są bufory od 64 MiB (pełne rastry sceny, nie pasy)
+#define RASTER_POOL_SCRATCH_MIN_BYTES ((size_t)64 << 20)
+
+/**
+ * @brief Wskazówka o dostępie do fragmentu bufora w pliku roboczym (patrz raster_pool_advise())
+ */
+typedef enum
+{
+    // Fragment będzie czytany sekwencyjnie - jądro czyta z wyprzedzeniem
+    RASTER_ACCESS_SEQUENTIAL,
+    // Fragment będzie potrzebny wkrótce - odczyt z dysku zaczyna się od razu
+    RASTER_ACCESS_WILLNEED,
+    // Fragment jest przetworzony - strony mogą opuścić pamięć (zapis na dysk, dane pozostają)
+    RASTER_ACCESS_DONE
+} RasterAccess;
+
+/**
+ * @brief Przydziela bufor rastra float na num_pixels pikseli
+ *
+ * Jeśli pula zawiera zwolniony bufor o identycznym rozmiarze, jest on użyty ponownie
+ * (bez ponownego mapowania i zerowania stron przez jądro). W przeciwnym razie bufor
+ * jest alokowany. Bezpieczne do wywołania z wielu wątków.
+ *
+ * @return Wskaźnik do bufora lub NULL w przypadku błędu alokacji
+ *
+ * @warning Bufor musi zostać zwolniony przez raster_pool_release(), nie przez free()
+ */
+float* raster_pool_acquire(size_t num_pixels);
+
+/**
+ * @brief Oddaje bufor do puli lub zwalnia go, gdy pula jest pełna
+ *
+ * Zmniejsza licznik referencji bufora - bufor współdzielony przez raster_pool_retain()
+ * jest oddawany dopiero przy ostatnim zwolnieniu.
+ *
+ * @param data Bufor z raster_pool_acquire() lub NULL (nic nie robi)
+ */
+void raster_pool_release(float* data);
+
+/**
+ * @brief Dodaje referencję do bufora z puli
+ *
+ * Pozwala współdzielić bufor bez kopiowania (np. z pamięcią podręczną etapów). Każde
+ * wywołanie musi zostać zrównoważone przez raster_pool_release(). Dane współdzielonego
+ * bufora nie powinny być modyfikowane.
+ *
+ * @return data lub NULL, gdy bufor nie pochodzi z puli
+ */
+float* raster_pool_retain(float* data);
+
+/**
+ * @brief Przydziela z puli bufor rastra int16 na num_pixels pikseli (wskaźniki skwantowane)
+ *
+ * Korzysta z tych samych buforów co raster_pool_acquire() (połowa liczby pikseli float),
+ * więc bufory wskaźników skwantowanych kolejnych scen też są używane ponownie.
+ *
+ * @warning Bufor musi zostać zwolniony przez raster_pool_release_int16()
+ */
+int16_t* raster_pool_acquire_int16(size_t num_pixels);
+
+void raster_pool_release_int16(int16_t* data);
+
+/**
+ * @brief Ustawia maksymalną liczbę bajtów przechowywanych w puli
+ *
+ * Domyślnie 0 - bufory są zwalniane natychmiast. Tryb wsadowy ustawia niezerową pojemność,
+ * aby kolejne sceny tego samego kafla korzystały z tych samych buforów. Zmniejszenie
+ * pojemności zwalnia nadmiarowe bufory.
+ */
+void raster_pool_set_capacity(size_t capacity_bytes);
+
+/**
+ * @brief Zwalnia wszystkie bufory przechowywane w puli
+ */
+void raster_pool_trim(void);
+
+/**
+ * @brief Umieszcza duże bufory w plikach roboczych mapowanych do pamięci zamiast na stercie
+ *
+ * Bufory od min_bytes przydzielane są jako mapowanie (MAP_SHARED) nienazwanego pliku w katalogu
+ * directory, więc rastry większe niż RAM (np. mozaiki kilku kafli) ogranicza miejsce na dysku,
+ * a strony nieużywanych fragmentów jądro zapisuje i zwalnia. Mniejsze bufory (pasy, podglądy)
+ * pozostają na stercie. Ustawiane przed przebiegami; dotyczy tylko nowych alokacji.
+ *
+ * @param directory Katalog plików roboczych lub NULL (wyłącza pliki robocze)
+ * @return 0 w przypadku sukcesu, -1 gdy katalog jest niedostępny do zapisu
+ */
+int raster_pool_set_scratch(const char* directory, size_t min_bytes);
+
+/**
+ * @brief Czy nowy bufor o podanym rozmiarze trafi do pliku roboczego (nie zajmuje stale RAM)
+ */
+bool raster_pool_uses_scratch(size_t bytes);
+
+/**
+ * @brief Czy bufor z puli jest mapowaniem pliku roboczego
+ */
+bool raster_pool_is_scratch(const void* data);
+
+/**
+ * @brief Przekazuje jądru (madvise) wskazówkę o dostępie do bajtów [first_byte, first_byte + length) bufora
+ *
+ * Pozwala przechodzić rastry w plikach roboczych pasami: kolejny pas WILLNEED, ukończony DONE.
+ * Zakres rozszerzany jest do pełnych stron. Dla buforów na stercie nic nie robi.
+ *
+ * @param data Bufor z raster_pool_acquire() lub raster_pool_acquire_int16()
+ */
+void raster_pool_advise(const void* data, size_t first_byte, size_t length, RasterAccess access);
+
+#endif // RASTER_POOL_H
@@ -9,6 +9,10 @@
 
 #include "../utils/utils.h"
 #include "../data_types/data_types.h"
+#include "../metrics/metrics.h"
+#include "../trace/trace.h"
+#include "../raster_pool/raster_pool.h"
+#include "../band_registry/band_registry.h"
 
 typedef struct
 {
@@ -26,8 +30,17 @@ float* prepare_data(const float* input_band, int input_width, int input_height,
                     const char* error_suffix);
 void replace_band_data(BandData* band_data, float* new_data);
 // ====== FUNKCJONALNOŚĆ ======
-int resample_single_band(BandData* band_data, int band_index, const ResamplingParams* params);
+int resample_single_band(BandData* band_data, const ResamplingParams* params);
 // ====== ALGORYTMY RESAMPLINGU ======
+void perform_nearest_neighbor_resample_rows(const float* input_rows, int input_row_offset, float* output_rows,
+                                            int input_width, int input_height, int output_width, int output_height,
+                                            int y_out_start, int y_out_end);
+void perform_bilinear_resample_rows(const float* input_rows, int input_row_offset, float* output_rows,
+                                    int input_width, int input_height, int output_width, int output_height,
+                                    int y_out_start, int y_out_end);
+void perform_average_resample_rows(const float* input_rows, int input_row_offset, float* output_rows,
+                                   int input_width, int input_height, int output_width, int output_height,
+                                   int y_out_start, int y_out_end);
 void perform_nearest_neighbor_resample(const float* input_band, float* output_band, int input_width, int input_height,
                                        int output_width, int output_height);
 float* nearest_neighbor_resample_scl(const float* input_band, int input_width, int input_height, int output_width,
@@ -42,7 +55,7 @@ float* average_resample_float(const float* input_band, int input_width, int inpu
                               int output_height);
 
 
-int resample_all_bands_to_target_resolution(BandData* bands, int band_count, gboolean target_resolution_10m)
+int resample_all_bands_to_target_resolution(BandData* bands, int band_count, bool target_resolution_10m)
 {
     // Przygotuj parametry resamplingu
     ResamplingParams params;
@@ -66,7 +79,7 @@ int resample_all_bands_to_target_resolution(BandData* bands, int band_count, gbo
     // Wykonaj resampling dla każdego pasma
     for (int i = 0; i < band_count; i++)
     {
-        if (resample_single_band(&bands[i], i, &params) != 0)
+        if (resample_single_band(&bands[i], &params) != 0)
         {
             fprintf(stderr, "Błąd podczas resamplingu pasma %s.\n", bands[i].band_name);
             return -1;
@@ -77,6 +90,80 @@ int resample_all_bands_to_target_resolution(BandData* bands, int band_count, gbo
     return 0;
 }
 
+ResampleMethod resample_method_for_band(const char* band_name, int input_width, int output_width)
+{
+    // Kody klas nie mogą być interpolowane ani uśredniane
+    if (band_registry_is_categorical(band_registry_find(band_name)))
+    {
+        return RESAMPLE_NEAREST;
+    }
+    return output_width > input_width ? RESAMPLE_BILINEAR : RESAMPLE_AVERAGE;
+}
+
+void resample_input_row_range(ResampleMethod method, int input_height, int output_height,
+                              int y_out_start, int y_out_end, int* y_in_start, int* y_in_end)
+{
+    float y_ratio = (float)input_height / output_height;
+    int y_last = y_out_end - 1;
+
+    // Wyrażenia muszą być identyczne jak w jądrach, żeby pas wejściowy obejmował każdy czytany wiersz
+    switch (method)
+    {
+    case RESAMPLE_NEAREST:
+        *y_in_start = clamp((int)(y_out_start * y_ratio + 0.5f), 0, input_height - 1);
+        *y_in_end = clamp((int)(y_last * y_ratio + 0.5f), 0, input_height - 1) + 1;
+        break;
+
+    case RESAMPLE_BILINEAR:
+        *y_in_start = clamp((int)floorf((y_out_start + 0.5f) * y_ratio - 0.5f), 0, input_height - 1);
+        *y_in_end = clamp((int)floorf((y_last + 0.5f) * y_ratio - 0.5f) + 1, 0, input_height - 1) + 1;
+        break;
+
+    case RESAMPLE_AVERAGE:
+    default:
+        {
+            *y_in_start = clamp((int)roundf(y_out_start * y_ratio), 0, input_height - 1);
+            int y_last_start = clamp((int)roundf(y_last * y_ratio), 0, input_height - 1);
+            *y_in_end = clamp((int)roundf((y_last + 1) * y_ratio), y_last_start + 1, input_height);
+        }
+        break;
+    }
+}
+
+void resample_rows(ResampleMethod method, const float* input_rows, int input_row_offset, float* output_rows,
+                   int input_width, int input_height, int output_width, int output_height,
+                   int y_out_start, int y_out_end)
+{
+    switch (method)
+    {
+    case RESAMPLE_NEAREST:
+        perform_nearest_neighbor_resample_rows(input_rows, input_row_offset, output_rows,
+                                               input_width, input_height, output_width, output_height,
+                                               y_out_start, y_out_end);
+        break;
+    case RESAMPLE_BILINEAR:
+        perform_bilinear_resample_rows(input_rows, input_row_offset, output_rows,
+                                       input_width, input_height, output_width, output_height,
+                                       y_out_start, y_out_end);
+        break;
+    case RESAMPLE_AVERAGE:
+    default:
+        perform_average_resample_rows(input_rows, input_row_offset, output_rows,
+                                      input_width, input_height, output_width, output_height,
+                                      y_out_start, y_out_end);
+        break;
+    }
+}
+
+int resample_band_to_target_resolution(BandData* band, int target_width, int target_height)
+{
+    ResamplingParams params;
+    params.target_width = target_width;
+    params.target_height = target_height;
+
+    return resample_single_band(band, &params);
+}
+
 int validate_input_params(const float* input_band, int input_width, int input_height,
                           int output_width, int output_height)
 {
@@ -113,7 +200,7 @@ int validate_output_size(int output_width, int output_height, size_t* num_pixels
 
 float* allocate_output_band(size_t num_pixels)
 {
-    float* output_band = malloc(num_pixels * sizeof(float));
+    float* output_band = raster_pool_acquire(num_pixels);
     if (output_band == NULL)
     {
         fprintf(stderr, "Error: Memory allocation failed for output band");
@@ -172,32 +259,48 @@ float* prepare_data(
     return output_band;
 }
 
-void perform_nearest_neighbor_resample(const float* input_band, float* output_band,
-                                       int input_width, int input_height,
-                                       int output_width, int output_height)
+void perform_nearest_neighbor_resample_rows(const float* input_rows, int input_row_offset, float* output_rows,
+                                            int input_width, int input_height, int output_width, int output_height,
+                                            int y_out_start, int y_out_end)
 {
     float x_ratio = (float)input_width / output_width;
     float y_ratio = (float)input_height / output_height;
 
-    #pragma omp parallel for shared(input_band, output_band, x_ratio, y_ratio) collapse(2)
-    for (int y_out = 0; y_out < output_height; y_out++)
+    #pragma omp parallel shared(input_rows, output_rows, x_ratio, y_ratio)
     {
-        for (int x_out = 0; x_out < output_width; x_out++)
+        TraceSpan chunk_span = trace_begin("resample", "chunk");
+
+        #pragma omp for collapse(2) nowait
+        for (int y_out = y_out_start; y_out < y_out_end; y_out++)
         {
-            // Standardowe mapowanie z zaokrągleniem do najbliższego sąsiada
-            int x_in = (int)(x_out * x_ratio + 0.5f);
-            int y_in = (int)(y_out * y_ratio + 0.5f);
+            for (int x_out = 0; x_out < output_width; x_out++)
+            {
+                // Standardowe mapowanie z zaokrągleniem do najbliższego sąsiada
+                int x_in = (int)(x_out * x_ratio + 0.5f);
+                int y_in = (int)(y_out * y_ratio + 0.5f);
 
-            // Zaciskanie współrzędnych do granic obrazu wejściowego
-            x_in = clamp(x_in, 0, input_width - 1);
-            y_in = clamp(y_in, 0, input_height - 1);
+                // Zaciskanie współrzędnych do granic obrazu wejściowego
+                x_in = clamp(x_in, 0, input_width - 1);
+                y_in = clamp(y_in, 0, input_height - 1);
 
-            output_band[pixel_index(x_out, y_out, output_width)] =
-                input_band[pixel_index(x_in, y_in, input_width)];
+                output_rows[pixel_index(x_out, y_out - y_out_start, output_width)] =
+                    input_rows[pixel_index(x_in, y_in - input_row_offset, input_width)];
+            }
         }
+
+        trace_end(&chunk_span);
     }
 }
 
+void perform_nearest_neighbor_resample(const float* input_band, float* output_band,
+                                       int input_width, int input_height,
+                                       int output_width, int output_height)
+{
+    perform_nearest_neighbor_resample_rows(input_band, 0, output_band,
+                                           input_width, input_height, output_width, output_height,
+                                           0, output_height);
+}
+
 float* nearest_neighbor_resample_scl(
     const float* input_band,
     int input_width,
@@ -223,56 +326,72 @@ float* nearest_neighbor_resample_scl(
     return output_band;
 }
 
-void perform_bilinear_resample(const float* input_band, float* output_band,
-                               int input_width, int input_height,
-                               int output_width, int output_height)
+void perform_bilinear_resample_rows(const float* input_rows, int input_row_offset, float* output_rows,
+                                    int input_width, int input_height, int output_width, int output_height,
+                                    int y_out_start, int y_out_end)
 {
     float x_ratio = (float)input_width / output_width;
     float y_ratio = (float)input_height / output_height;
 
-    #pragma omp parallel for shared(input_band, output_band, x_ratio, y_ratio) collapse(2)
-    for (int y_out = 0; y_out < output_height; y_out++)
+    #pragma omp parallel shared(input_rows, output_rows, x_ratio, y_ratio)
     {
-        for (int x_out = 0; x_out < output_width; x_out++)
+        TraceSpan chunk_span = trace_begin("resample", "chunk");
+
+        #pragma omp for collapse(2) nowait
+        for (int y_out = y_out_start; y_out < y_out_end; y_out++)
         {
-            // Mapowanie środka piksela wyjściowego na siatkę wejściową
-            float x_in_proj = (x_out + 0.5f) * x_ratio - 0.5f;
-            float y_in_proj = (y_out + 0.5f) * y_ratio - 0.5f;
-
-            // Piksele graniczne
-            int x1 = (int)floorf(x_in_proj);
-            int y1 = (int)floorf(y_in_proj);
-            int x2 = x1 + 1;
-            int y2 = y1 + 1;
-
-            // Ułamkowe odległości
-            float dx = x_in_proj - (float)x1;
-            float dy = y_in_proj - (float)y1;
-
-            // Zaciskanie współrzędnych do granic obrazu wejściowego
-            x1 = clamp(x1, 0, input_width - 1);
-            y1 = clamp(y1, 0, input_height - 1);
-            x2 = clamp(x2, 0, input_width - 1);
-            y2 = clamp(y2, 0, input_height - 1);
-
-            // Wartości pikseli otaczających
-            float p11 = input_band[pixel_index(x1, y1, input_width)];
-            float p21 = input_band[pixel_index(x2, y1, input_width)];
-            float p12 = input_band[pixel_index(x1, y2, input_width)];
-            float p22 = input_band[pixel_index(x2, y2, input_width)];
-
-            // Interpolacja dwuliniowa
-            float interpolated_value =
-                p11 * (1.0f - dx) * (1.0f - dy) +
-                p21 * dx * (1.0f - dy) +
-                p12 * (1.0f - dx) * dy +
-                p22 * dx * dy;
-
-            output_band[pixel_index(x_out, y_out, output_width)] = interpolated_value;
+            for (int x_out = 0; x_out < output_width; x_out++)
+            {
+                // Mapowanie środka piksela wyjściowego na siatkę wejściową
+                float x_in_proj = (x_out + 0.5f) * x_ratio - 0.5f;
+                float y_in_proj = (y_out + 0.5f) * y_ratio - 0.5f;
+
+                // Piksele graniczne
+                int x1 = (int)floorf(x_in_proj);
+                int y1 = (int)floorf(y_in_proj);
+                int x2 = x1 + 1;
+                int y2 = y1 + 1;
+
+                // Ułamkowe odległości
+                float dx = x_in_proj - (float)x1;
+                float dy = y_in_proj - (float)y1;
+
+                // Zaciskanie współrzędnych do granic obrazu wejściowego
+                x1 = clamp(x1, 0, input_width - 1);
+                y1 = clamp(y1, 0, input_height - 1);
+                x2 = clamp(x2, 0, input_width - 1);
+                y2 = clamp(y2, 0, input_height - 1);
+
+                // Wartości pikseli otaczających
+                float p11 = input_rows[pixel_index(x1, y1 - input_row_offset, input_width)];
+                float p21 = input_rows[pixel_index(x2, y1 - input_row_offset, input_width)];
+                float p12 = input_rows[pixel_index(x1, y2 - input_row_offset, input_width)];
+                float p22 = input_rows[pixel_index(x2, y2 - input_row_offset, input_width)];
+
+                // Interpolacja dwuliniowa
+                float interpolated_value =
+                    p11 * (1.0f - dx) * (1.0f - dy) +
+                    p21 * dx * (1.0f - dy) +
+                    p12 * (1.0f - dx) * dy +
+                    p22 * dx * dy;
+
+                output_rows[pixel_index(x_out, y_out - y_out_start, output_width)] = interpolated_value;
+            }
         }
+
+        trace_end(&chunk_span);
     }
 }
 
+void perform_bilinear_resample(const float* input_band, float* output_band,
+                               int input_width, int input_height,
+                               int output_width, int output_height)
+{
+    perform_bilinear_resample_rows(input_band, 0, output_band,
+                                   input_width, input_height, output_width, output_height,
+                                   0, output_height);
+}
+
 float* bilinear_resample_float(
     const float* input_band,
     int input_width,
@@ -298,69 +417,85 @@ float* bilinear_resample_float(
     return output_band;
 }
 
-void perform_average_resample(const float* input_band, float* output_band,
-                              int input_width, int input_height,
-                              int output_width, int output_height)
+void perform_average_resample_rows(const float* input_rows, int input_row_offset, float* output_rows,
+                                   int input_width, int input_height, int output_width, int output_height,
+                                   int y_out_start, int y_out_end)
 {
     // Współczynniki skalowania (ile pikseli wejściowych przypada na jeden piksel wyjściowy)
     float x_scale_factor = (float)input_width / output_width;
     float y_scale_factor = (float)input_height / output_height;
 
-    #pragma omp parallel for shared(input_band, output_band, x_scale_factor, y_scale_factor) collapse(2)
-    for (int y_out = 0; y_out < output_height; y_out++)
+    #pragma omp parallel shared(input_rows, output_rows, x_scale_factor, y_scale_factor)
     {
-        for (int x_out = 0; x_out < output_width; x_out++)
+        TraceSpan chunk_span = trace_begin("resample", "chunk");
+
+        #pragma omp for collapse(2) nowait
+        for (int y_out = y_out_start; y_out < y_out_end; y_out++)
         {
-            // Początek bloku (lewy górny róg)
-            int x_start_in = (int)roundf(x_out * x_scale_factor);
-            int y_start_in = (int)roundf(y_out * y_scale_factor);
-            // Koniec bloku (prawy dolny róg + 1, aby objąć piksele do uśrednienia)
-            int x_end_in = (int)roundf((x_out + 1) * x_scale_factor);
-            int y_end_in = (int)roundf((y_out + 1) * y_scale_factor);
-
-            // Zaciskanie do granic obrazu wejściowego
-            x_start_in = clamp(x_start_in, 0, input_width - 1);
-            y_start_in = clamp(y_start_in, 0, input_height - 1);
-
-            // Upewnij się, że jest co najmniej 1 piksel
-            x_end_in = clamp(x_end_in, x_start_in + 1, input_width);
-            y_end_in = clamp(y_end_in, y_start_in + 1, input_height);
-
-            float sum = 0.0f;
-            int count = 0;
-
-            // Sumowanie wartości pikseli
-            for (int y_in = y_start_in; y_in < y_end_in; y_in++)
+            for (int x_out = 0; x_out < output_width; x_out++)
             {
-                for (int x_in = x_start_in; x_in < x_end_in; x_in++)
+                // Początek bloku (lewy górny róg)
+                int x_start_in = (int)roundf(x_out * x_scale_factor);
+                int y_start_in = (int)roundf(y_out * y_scale_factor);
+                // Koniec bloku (prawy dolny róg + 1, aby objąć piksele do uśrednienia)
+                int x_end_in = (int)roundf((x_out + 1) * x_scale_factor);
+                int y_end_in = (int)roundf((y_out + 1) * y_scale_factor);
+
+                // Zaciskanie do granic obrazu wejściowego
+                x_start_in = clamp(x_start_in, 0, input_width - 1);
+                y_start_in = clamp(y_start_in, 0, input_height - 1);
+
+                // Upewnij się, że jest co najmniej 1 piksel
+                x_end_in = clamp(x_end_in, x_start_in + 1, input_width);
+                y_end_in = clamp(y_end_in, y_start_in + 1, input_height);
+
+                float sum = 0.0f;
+                int count = 0;
+
+                // Sumowanie wartości pikseli
+                for (int y_in = y_start_in; y_in < y_end_in; y_in++)
                 {
-                    sum += input_band[pixel_index(x_in, y_in, input_width)];
-                    count++;
+                    for (int x_in = x_start_in; x_in < x_end_in; x_in++)
+                    {
+                        sum += input_rows[pixel_index(x_in, y_in - input_row_offset, input_width)];
+                        count++;
+                    }
                 }
-            }
 
-            // Obliczenie średniej lub fallback do najbliższego sąsiada
-            if (count > 0)
-            {
-                output_band[pixel_index(x_out, y_out, output_width)] = sum / count;
-            }
-            else
-            {
-                // Sytuacja awaryjna, nie powinno się zdarzyć przy poprawnym zaciskaniu
-                // Nie pozwalamy na brak przypisania żadnej wartości
-                int center_x_in = (x_start_in + x_end_in - 1) / 2;
-                int center_y_in = (y_start_in + y_end_in - 1) / 2;
+                // Obliczenie średniej lub fallback do najbliższego sąsiada
+                if (count > 0)
+                {
+                    output_rows[pixel_index(x_out, y_out - y_out_start, output_width)] = sum / count;
+                }
+                else
+                {
+                    // Sytuacja awaryjna, nie powinno się zdarzyć przy poprawnym zaciskaniu
+                    // Nie pozwalamy na brak przypisania żadnej wartości
+                    int center_x_in = (x_start_in + x_end_in - 1) / 2;
+                    int center_y_in = (y_start_in + y_end_in - 1) / 2;
 
-                center_x_in = clamp(center_x_in, 0, input_width - 1);
-                center_y_in = clamp(center_y_in, 0, input_height - 1);
+                    center_x_in = clamp(center_x_in, 0, input_width - 1);
+                    center_y_in = clamp(center_y_in, 0, input_height - 1);
 
-                output_band[pixel_index(x_out, y_out, output_width)] =
-                    input_band[pixel_index(center_x_in, center_y_in, input_width)];
+                    output_rows[pixel_index(x_out, y_out - y_out_start, output_width)] =
+                        input_rows[pixel_index(center_x_in, center_y_in - input_row_offset, input_width)];
+                }
             }
         }
+
+        trace_end(&chunk_span);
     }
 }
 
+void perform_average_resample(const float* input_band, float* output_band,
+                              int input_width, int input_height,
+                              int output_width, int output_height)
+{
+    perform_average_resample_rows(input_band, 0, output_band,
+                                  input_width, input_height, output_width, output_height,
+                                  0, output_height);
+}
+
 float* average_resample_float(
     const float* input_band,
     int input_width,
@@ -397,7 +532,7 @@ void replace_band_data(BandData* band_data, float* new_data)
     *band_data->processed_data = new_data;
 }
 
-int resample_single_band(BandData* band_data, int band_index, const ResamplingParams* params)
+int resample_single_band(BandData* band_data, const ResamplingParams* params)
 {
     // Sprawdź czy resampling jest potrzebny
     if (*band_data->width == params->target_width && *band_data->height == params->target_height)
@@ -406,63 +541,33 @@ int resample_single_band(BandData* band_data, int band_index, const ResamplingPa
     }
 
     float* resampled = NULL;
-    struct timeval start_time, end_time;
     double elapsed_time;
-
-    switch (band_index)
+    size_t input_pixels = (size_t)*band_data->width * *band_data->height;
+    size_t output_pixels = (size_t)params->target_width * params->target_height;
+    const char* direction = params->target_width > *band_data->width ? "upsampling" : "downsampling";
+    ResampleMethod method = resample_method_for_band(band_data->band_name, *band_data->width, params->target_width);
+    MetricsScope metrics_scope = metrics_stage_begin("resample", band_data->band_name);
+
+    g_print("[%s] [%s] Rozpoczynam %s\n", get_timestamp(), band_data->band_name, direction);
+    switch (method)
     {
-    case B11:
-        gettimeofday(&start_time, NULL);
-        g_print("[%s] [B11] Rozpoczynam upsampling\n", get_timestamp());
-        resampled = bilinear_resample_float(
-            *band_data->raw_data,
-            *band_data->width,
-            *band_data->height,
-            params->target_width,
-            params->target_height
-        );
-        gettimeofday(&end_time, NULL);
-        elapsed_time = get_time_diff(start_time, end_time);
-        g_print("[%s] [B11] Zakończono upsampling (czas: %.2fs)\n", get_timestamp(), elapsed_time);
+    case RESAMPLE_NEAREST:
+        resampled = nearest_neighbor_resample_scl(*band_data->raw_data, *band_data->width, *band_data->height,
+                                                  params->target_width, params->target_height);
         break;
-
-    case SCL:
-        gettimeofday(&start_time, NULL);
-        g_print("[%s] [SCL] Rozpoczynam upsampling\n", get_timestamp());
-        resampled = nearest_neighbor_resample_scl(
-            *band_data->raw_data,
-            *band_data->width,
-            *band_data->height,
-            params->target_width,
-            params->target_height
-        );
-        gettimeofday(&end_time, NULL);
-        elapsed_time = get_time_diff(start_time, end_time);
-        g_print("[%s] [SCL] Zakończono upsampling (czas: %.2fs)\n", get_timestamp(), elapsed_time);
+    case RESAMPLE_BILINEAR:
+        resampled = bilinear_resample_float(*band_data->raw_data, *band_data->width, *band_data->height,
+                                            params->target_width, params->target_height);
         break;
-
-    case B04:
-    case B08:
-        // B04 i B08 - averaging downsampling
-        gettimeofday(&start_time, NULL);
-        g_print("[%s] [%s] Rozpoczynam downsampling\n", get_timestamp(), band_data->band_name);
-        resampled = average_resample_float(
-            *band_data->raw_data,
-            *band_data->width,
-            *band_data->height,
-            params->target_width,
-            params->target_height
-        );
-        gettimeofday(&end_time, NULL);
-        elapsed_time = get_time_diff(start_time, end_time);
-        g_print("[%s] [%s] Zakończono downsampling (czas: %.2fs)\n", get_timestamp(), band_data->band_name,
-                elapsed_time);
+    case RESAMPLE_AVERAGE:
+        resampled = average_resample_float(*band_data->raw_data, *band_data->width, *band_data->height,
+                                           params->target_width, params->target_height);
         break;
-
-    default:
-        // B04 i B08 już mają rozdzielczość 10m
-        return 0;
     }
+    elapsed_time = metrics_stage_end(&metrics_scope, input_pixels * sizeof(float),
+                                     output_pixels * sizeof(float), output_pixels);
+    g_print("[%s] [%s] Zakończono %s (czas: %.2fs)\n", get_timestamp(), band_data->band_name, direction,
+            elapsed_time);
 
     if (!resampled)
     {
@@ -1,11 +1,75 @@
 #ifndef RESAMPLER_H
 #define RESAMPLER_H
 
-#include <gtk/gtk.h>
-#include <glib/gtypes.h>
+#include <stdbool.h>
 
 #include "../data_types/data_types.h"
 
-int resample_all_bands_to_target_resolution(BandData* bands, int band_count, gboolean target_resolution_10m);
+typedef enum
+{
+    RESAMPLE_NEAREST,
+    RESAMPLE_BILINEAR,
+    RESAMPLE_AVERAGE
+} ResampleMethod;
+
+int resample_all_bands_to_target_resolution(BandData* bands, int band_count, bool target_resolution_10m);
+
+/**
+ * @brief Resampluje jedno pasmo do podanych wymiarów docelowych
+ *
+ * Metodę resamplingu wybiera resample_method_for_band() na podstawie band_name pasma.
+ * Jeśli wymiary pasma są już docelowe, funkcja nic nie robi.
+ * Po resamplingu processed_data wskazuje na nowy bufor, a raw_data pozostaje nienaruszone,
+ * więc wywołujący może zwolnić je natychmiast po tym wywołaniu.
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu
+ */
+int resample_band_to_target_resolution(BandData* band, int target_width, int target_height);
+
+/**
+ * @brief Zwraca metodę resamplingu stosowaną dla pasma o podanej nazwie (z rejestru pasm)
+ *
+ * Pasma klasyfikacyjne (SCL) - najbliższy sąsiad, pozostałe przy powiększaniu - interpolacja
+ * dwuliniowa, przy zmniejszaniu - uśrednianie.
+ */
+ResampleMethod resample_method_for_band(const char* band_name, int input_width, int output_width);
+
+/**
+ * @brief Wyznacza zakres wierszy wejściowych potrzebnych do obliczenia pasa wierszy wyjściowych
+ *
+ * @param y_out_start Pierwszy wiersz wyjściowy pasa
+ * @param y_out_end Wiersz wyjściowy za ostatnim wierszem pasa
+ * @param y_in_start [out] Pierwszy potrzebny wiersz wejściowy
+ * @param y_in_end [out] Wiersz wejściowy za ostatnim potrzebnym wierszem
+ */
+void resample_input_row_range(ResampleMethod method, int input_height, int output_height,
+                              int y_out_start, int y_out_end, int* y_in_start, int* y_in_end);
+
+/**
+ * @brief Resampluje pas wierszy [y_out_start, y_out_end) obrazu wyjściowego
+ *
+ * Współczynniki skali liczone są z pełnych wymiarów obrazów, więc wynik jest identyczny
+ * z resamplingiem całej sceny. input_rows wskazuje na wiersz input_row_offset obrazu wejściowego
+ * i musi obejmować zakres zwrócony przez resample_input_row_range(). output_rows wskazuje
+ * na miejsce wiersza y_out_start.
+ */
+void resample_rows(ResampleMethod method, const float* input_rows, int input_row_offset, float* output_rows,
+                   int input_width, int input_height, int output_width, int output_height,
+                   int y_out_start, int y_out_end);
+
+/**
+ * @brief Jądra resamplingu całego obrazu do istniejącego bufora (używane też przez benchmarki)
+ */
+void perform_nearest_neighbor_resample(const float* input_band, float* output_band,
+                                       int input_width, int input_height,
+                                       int output_width, int output_height);
+
+void perform_bilinear_resample(const float* input_band, float* output_band,
+                               int input_width, int input_height,
+                               int output_width, int output_height);
+
+void perform_average_resample(const float* input_band, float* output_band,
+                              int input_width, int input_height,
+                              int output_width, int output_height);
 
 #endif
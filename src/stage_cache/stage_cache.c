@@ -0,0 +1,227 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stage_cache.h"
+#include <stdio.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+#include "../raster_pool/raster_pool.h"
+
+/**
+ * @brief Wpis pamięci podręcznej - wynik jednego etapu
+ *
+ * Wpis trzyma własną referencję do obiektu. Rastry przechowywane są jako bufory
+ * raster_pool z licznikiem referencji, pozostałe obiekty przez podane funkcje ref/unref.
+ */
+typedef struct
+{
+    char* key;
+    void* object;
+    size_t bytes;
+    int width;
+    int height;
+    bool is_raster;
+    StageCacheRefFunc ref;
+    StageCacheUnrefFunc unref;
+    GList* lru_link;
+} StageCacheEntry;
+
+// Stan pamięci podręcznej - dostęp tylko w sekcji krytycznej "stage_cache"
+static GHashTable* entries = NULL;
+static GQueue lru_order = G_QUEUE_INIT;
+static size_t cached_bytes = 0;
+static size_t capacity_bytes = 0;
+
+// ====== POMOCNICZE ======
+static void* retain_raster(void* data);
+static void release_raster(void* data);
+static StageCacheEntry* find_entry(const char* key);
+static void store_entry(const char* key, void* object, size_t bytes, int width, int height,
+                        bool is_raster, StageCacheRefFunc ref, StageCacheUnrefFunc unref);
+static void remove_entry(StageCacheEntry* entry);
+static void evict_until_fits(size_t limit_bytes);
+
+void stage_cache_set_capacity(size_t new_capacity_bytes)
+{
+    #pragma omp critical(stage_cache)
+    {
+        capacity_bytes = new_capacity_bytes;
+        evict_until_fits(capacity_bytes);
+    }
+}
+
+bool stage_cache_enabled(void)
+{
+    bool enabled;
+    #pragma omp critical(stage_cache)
+    {
+        enabled = capacity_bytes > 0;
+    }
+    return enabled;
+}
+
+float* stage_cache_lookup_raster(const char* key, int* width_out, int* height_out)
+{
+    float* data = NULL;
+
+    #pragma omp critical(stage_cache)
+    {
+        StageCacheEntry* entry = find_entry(key);
+        if (entry && entry->is_raster)
+        {
+            data = raster_pool_retain(entry->object);
+            if (width_out) *width_out = entry->width;
+            if (height_out) *height_out = entry->height;
+        }
+    }
+
+    return data;
+}
+
+void stage_cache_store_raster(const char* key, float* data, int width, int height)
+{
+    if (!key || !data)
+    {
+        return;
+    }
+
+    size_t bytes = (size_t)width * height * sizeof(float);
+    #pragma omp critical(stage_cache)
+    {
+        store_entry(key, data, bytes, width, height, true, retain_raster, release_raster);
+    }
+}
+
+void* stage_cache_lookup_object(const char* key)
+{
+    void* object = NULL;
+
+    #pragma omp critical(stage_cache)
+    {
+        StageCacheEntry* entry = find_entry(key);
+        if (entry && !entry->is_raster)
+        {
+            object = entry->ref(entry->object);
+        }
+    }
+
+    return object;
+}
+
+void stage_cache_store_object(const char* key, void* object, size_t bytes,
+                              StageCacheRefFunc ref, StageCacheUnrefFunc unref)
+{
+    if (!key || !object || !ref || !unref)
+    {
+        return;
+    }
+
+    #pragma omp critical(stage_cache)
+    {
+        store_entry(key, object, bytes, 0, 0, false, ref, unref);
+    }
+}
+
+char* stage_cache_file_key(const char* path)
+{
+    struct stat file_stat;
+    if (!path || stat(path, &file_stat) != 0)
+    {
+        return NULL;
+    }
+
+    return g_strdup_printf("%s@%lld:%lld.%09ld", path, (long long)file_stat.st_size,
+                           (long long)file_stat.st_mtim.tv_sec, (long)file_stat.st_mtim.tv_nsec);
+}
+
+void stage_cache_clear(void)
+{
+    #pragma omp critical(stage_cache)
+    {
+        evict_until_fits(0);
+    }
+}
+
+static void* retain_raster(void* data)
+{
+    return raster_pool_retain(data);
+}
+
+static void release_raster(void* data)
+{
+    raster_pool_release(data);
+}
+
+// Wyszukuje wpis i oznacza go jako ostatnio używany (w sekcji krytycznej)
+static StageCacheEntry* find_entry(const char* key)
+{
+    if (!entries || !key)
+    {
+        return NULL;
+    }
+
+    StageCacheEntry* entry = g_hash_table_lookup(entries, key);
+    if (entry)
+    {
+        g_queue_unlink(&lru_order, entry->lru_link);
+        g_queue_push_head_link(&lru_order, entry->lru_link);
+    }
+    return entry;
+}
+
+// Zapisuje wpis, zastępując poprzedni o tym samym kluczu (w sekcji krytycznej)
+static void store_entry(const char* key, void* object, size_t bytes, int width, int height,
+                        bool is_raster, StageCacheRefFunc ref, StageCacheUnrefFunc unref)
+{
+    if (bytes > capacity_bytes)
+    {
+        return;
+    }
+
+    if (!entries)
+    {
+        entries = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+
+    StageCacheEntry* previous = g_hash_table_lookup(entries, key);
+    if (previous)
+    {
+        remove_entry(previous);
+    }
+    evict_until_fits(capacity_bytes - bytes);
+
+    StageCacheEntry* entry = g_new0(StageCacheEntry, 1);
+    entry->key = g_strdup(key);
+    entry->object = ref(object);
+    entry->bytes = bytes;
+    entry->width = width;
+    entry->height = height;
+    entry->is_raster = is_raster;
+    entry->ref = ref;
+    entry->unref = unref;
+
+    g_queue_push_head(&lru_order, entry);
+    entry->lru_link = lru_order.head;
+    g_hash_table_insert(entries, entry->key, entry);
+    cached_bytes += bytes;
+}
+
+static void remove_entry(StageCacheEntry* entry)
+{
+    g_hash_table_remove(entries, entry->key);
+    g_queue_delete_link(&lru_order, entry->lru_link);
+    cached_bytes -= entry->bytes;
+
+    entry->unref(entry->object);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+// Usuwa najdawniej używane wpisy, aż przechowywane bajty nie przekraczają limitu (w sekcji krytycznej)
+static void evict_until_fits(size_t limit_bytes)
+{
+    // Limit 0 usuwa wszystkie wpisy, także te o zerowym rozmiarze
+    while ((cached_bytes > limit_bytes || limit_bytes == 0) && lru_order.tail)
+    {
+        remove_entry(lru_order.tail->data);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef STAGE_CACHE_H
+#define STAGE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Funkcje zarządzające referencjami obiektu przechowywanego w pamięci podręcznej
+ *
+ * ref zwraca nową referencję do obiektu, unref ją oddaje (np. g_object_ref/g_object_unref).
+ */
+typedef void* (*StageCacheRefFunc)(void* object);
+typedef void (*StageCacheUnrefFunc)(void* object);
+
+/**
+ * @brief Ustawia maksymalną liczbę bajtów wyników etapów przechowywanych w pamięci
+ *
+ * Domyślnie 0 - pamięć podręczna jest wyłączona i pipeline liczy każdy etap od nowa.
+ * Zmniejszenie pojemności usuwa najdawniej używane wpisy.
+ */
+void stage_cache_set_capacity(size_t capacity_bytes);
+
+/**
+ * @brief Sprawdza, czy pamięć podręczna etapów ma niezerową pojemność
+ */
+bool stage_cache_enabled(void);
+
+/**
+ * @brief Zwraca wynik etapu zapisany pod kluczem
+ *
+ * @param width_out Wskaźnik na szerokość rastra (może być NULL)
+ * @param height_out Wskaźnik na wysokość rastra (może być NULL)
+ * @return Nowa referencja do bufora z raster_pool (zwalniana przez raster_pool_release())
+ *         lub NULL, gdy klucza nie ma w pamięci podręcznej
+ *
+ * @warning Bufor jest współdzielony z pamięcią podręczną i nie może być modyfikowany
+ */
+float* stage_cache_lookup_raster(const char* key, int* width_out, int* height_out);
+
+/**
+ * @brief Zapisuje bufor z raster_pool jako wynik etapu
+ *
+ * Pamięć podręczna dodaje własną referencję (raster_pool_retain()), więc wywołujący nadal
+ * zwalnia swój bufor jak dotychczas. Wpis większy niż pojemność nie jest zapisywany.
+ */
+void stage_cache_store_raster(const char* key, float* data, int width, int height);
+
+/**
+ * @brief Zwraca obiekt zapisany pod kluczem (np. wyrenderowaną mapę)
+ *
+ * @return Nowa referencja do obiektu (oddawana funkcją unref podaną przy zapisie)
+ *         lub NULL, gdy klucza nie ma w pamięci podręcznej
+ */
+void* stage_cache_lookup_object(const char* key);
+
+/**
+ * @brief Zapisuje obiekt z licznikiem referencji jako wynik etapu
+ *
+ * @param bytes Rozmiar obiektu w pamięci, wliczany do pojemności
+ * @param ref Funkcja dodająca referencję (wywoływana przy zapisie i każdym trafieniu)
+ * @param unref Funkcja oddająca referencję (wywoływana przy usunięciu wpisu)
+ */
+void stage_cache_store_object(const char* key, void* object, size_t bytes,
+                              StageCacheRefFunc ref, StageCacheUnrefFunc unref);
+
+/**
+ * @brief Buduje identyfikator zawartości pliku do kluczy pamięci podręcznej
+ *
+ * Identyfikator zawiera ścieżkę, rozmiar i czas modyfikacji pliku, więc nadpisanie pliku
+ * unieważnia wszystkie wyniki etapów zależne od jego zawartości.
+ *
+ * @return Napis do zwolnienia przez g_free() lub NULL, gdy pliku nie można odczytać
+ */
+char* stage_cache_file_key(const char* path);
+
+/**
+ * @brief Usuwa wszystkie wpisy z pamięci podręcznej
+ */
+void stage_cache_clear(void);
+
+#endif // STAGE_CACHE_H
@@ -0,0 +1,92 @@
+#include "strip_indices.h"
+#include <string.h>
+
+#include "../band_registry/band_registry.h"
+#include "../data_loader/data_loader.h"
+
+// Wysokość pasa, dla której szacowana jest pamięć czytnika (rośnie liniowo z wysokością)
+#define ROW_ESTIMATE_STRIP_ROWS 64
+
+int strip_index_source_open(StripIndexSource* source, char* const paths[PIPELINE_BAND_COUNT], unsigned int indices,
+                            int width, int height, int max_strip_rows)
+{
+    memset(source, 0, sizeof(*source));
+
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    char* band_paths[PIPELINE_BAND_COUNT];
+    float* raw_data[PIPELINE_BAND_COUNT] = {NULL};
+    float* processed_data[PIPELINE_BAND_COUNT] = {NULL};
+    int widths[PIPELINE_BAND_COUNT], heights[PIPELINE_BAND_COUNT];
+    BandData selected[PIPELINE_BAND_COUNT];
+    int selected_count = 0;
+
+    // Czytnik korzysta z BandData tylko przy otwieraniu, więc wystarczą zmienne lokalne
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        band_paths[i] = paths[i];
+        source->reader_slot[i] = -1;
+        if (band_mask & (1u << i))
+        {
+            source->reader_slot[i] = selected_count;
+            selected[selected_count++] = (BandData){
+                &band_paths[i], &raw_data[i], &processed_data[i], &widths[i], &heights[i], pipeline_band_name(i)
+            };
+        }
+    }
+
+    return strip_reader_open(&source->reader, selected, selected_count, width, height, max_strip_rows,
+                             selected_count);
+}
+
+int strip_index_source_evaluate(StripIndexSource* source, BandMathProgram* const* programs, int program_count,
+                                int y_start, int y_end, float* const outputs[])
+{
+    if (strip_reader_read(&source->reader, y_start, y_end) != 0)
+    {
+        return -1;
+    }
+
+    const float* band_inputs[BAND_MATH_BAND_COUNT] = {NULL};
+    for (int i = 0; i < SCL; i++)
+    {
+        int band_index = band_registry_find(pipeline_band_name(i));
+        if (band_index >= 0 && source->reader_slot[i] >= 0)
+        {
+            band_inputs[band_index] = strip_reader_band(&source->reader, source->reader_slot[i]);
+        }
+    }
+    const float* scl = source->reader_slot[SCL] >= 0 ? strip_reader_band(&source->reader, source->reader_slot[SCL])
+                                                    : NULL;
+
+    size_t strip_pixels = (size_t)(y_end - y_start) * source->reader.target_width;
+    return band_math_evaluate(programs, program_count, band_inputs, scl, strip_pixels, outputs);
+}
+
+void strip_index_source_close(StripIndexSource* source)
+{
+    strip_reader_close(&source->reader);
+}
+
+size_t strip_index_source_row_bytes(char* const paths[PIPELINE_BAND_COUNT], unsigned int indices,
+                                    int width, int height)
+{
+    unsigned int band_mask = pipeline_index_band_mask(indices);
+    int widths[PIPELINE_BAND_COUNT], heights[PIPELINE_BAND_COUNT];
+    int band_count = 0;
+
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        if (!(band_mask & (1u << i)))
+        {
+            continue;
+        }
+        if (read_band_dimensions(paths[i], &widths[band_count], &heights[band_count], NULL) != 0)
+        {
+            return 0;
+        }
+        band_count++;
+    }
+
+    return strip_reader_estimate_bytes(widths, heights, band_count, width, height, ROW_ESTIMATE_STRIP_ROWS,
+                                       band_count) / ROW_ESTIMATE_STRIP_ROWS;
+}
@@ -0,0 +1,54 @@
+#ifndef STRIP_INDICES_H
+#define STRIP_INDICES_H
+
+#include <stddef.h>
+
+#include "../band_math/band_math.h"
+#include "../data_types/data_types.h"
+#include "../processing_pipeline/processing_pipeline.h"
+#include "../strip_reader/strip_reader.h"
+
+/**
+ * @brief Źródło wskaźników jednej sceny liczonych pasami wierszy na wspólnej siatce
+ *
+ * Łączy czytnik pasów (tylko pasma potrzebne wybranym wskaźnikom) z wywołaniem silnika
+ * band_math z maskowaniem SCL. Pełnorozdzielcze rastry wskaźników sceny nigdy nie powstają -
+ * wywołujący dostaje tylko bieżący pas. Kilka źródeł może być otwartych jednocześnie
+ * (np. dwie daty w trybie wykrywania zmian).
+ */
+typedef struct
+{
+    StripReader reader;
+    // Indeks pasma (BandType) w czytniku lub -1, gdy wybrane wskaźniki go nie potrzebują
+    int reader_slot[PIPELINE_BAND_COUNT];
+} StripIndexSource;
+
+/**
+ * @brief Otwiera pasma sceny potrzebne wskaźnikom z indices na siatce width x height
+ *
+ * @param paths Ścieżki pasm w kolejności BandType (pasma spoza maski mogą być NULL)
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu (zasoby są wtedy zwolnione)
+ */
+int strip_index_source_open(StripIndexSource* source, char* const paths[PIPELINE_BAND_COUNT], unsigned int indices,
+                            int width, int height, int max_strip_rows);
+
+/**
+ * @brief Czyta pas [y_start, y_end) i liczy programy band_math do outputs
+ *
+ * @param outputs Tablica program_count buforów na (y_end - y_start) * width pikseli
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu odczytu lub obliczeń
+ */
+int strip_index_source_evaluate(StripIndexSource* source, BandMathProgram* const* programs, int program_count,
+                                int y_start, int y_end, float* const outputs[]);
+
+void strip_index_source_close(StripIndexSource* source);
+
+/**
+ * @brief Szacuje pamięć czytnika źródła na jeden wiersz siatki (z nagłówków plików pasm)
+ *
+ * @return Bajty na wiersz lub 0, gdy nagłówków nie można odczytać
+ */
+size_t strip_index_source_row_bytes(char* const paths[PIPELINE_BAND_COUNT], unsigned int indices,
+                                    int width, int height);
+
+#endif // STRIP_INDICES_H
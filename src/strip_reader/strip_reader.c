@@ -0,0 +1,285 @@
+#include "strip_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../utils/utils.h"
+#include "../metrics/metrics.h"
+
+// ====== PAMIĘĆ ======
+static int input_rows_for_strip(int input_height, int output_height, int strip_rows);
+static int allocate_band_strip_buffers(StripBandReader* band_reader, int target_width, int target_height,
+                                       int max_strip_rows);
+// ====== FUNKCJONALNOŚĆ ======
+static int open_band_reader(StripBandReader* band_reader, const char* path, const char* band_name, int target_width);
+static int read_band_strip(StripBandReader* band_reader, int target_height, int y_start, int y_end,
+                           int* y_in_start_out);
+
+int strip_reader_open(StripReader* reader, BandData* bands, int band_count,
+                      int target_width, int target_height, int max_strip_rows, int decode_concurrency)
+{
+    memset(reader, 0, sizeof(*reader));
+
+    if (band_count <= 0 || band_count > STRIP_READER_MAX_BANDS || max_strip_rows <= 0)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowe parametry czytnika pasów.\n", get_timestamp());
+        return -1;
+    }
+
+    reader->band_count = band_count;
+    reader->target_width = target_width;
+    reader->target_height = target_height;
+    reader->max_strip_rows = max_strip_rows < target_height ? max_strip_rows : target_height;
+    reader->decode_concurrency = decode_concurrency > 0 ? decode_concurrency : 1;
+
+    for (int i = 0; i < band_count; i++)
+    {
+        StripBandReader* band_reader = &reader->bands[i];
+
+        if (open_band_reader(band_reader, *(bands[i].path), bands[i].band_name, target_width) != 0 ||
+            allocate_band_strip_buffers(band_reader, target_width, target_height, reader->max_strip_rows) != 0)
+        {
+            strip_reader_close(reader);
+            return -1;
+        }
+
+        *(bands[i].width) = band_reader->width;
+        *(bands[i].height) = band_reader->height;
+    }
+
+    printf("[%s] Otwarto czytnik pasów: %d pasm, siatka %dx%d, pas do %d wierszy.\n",
+           get_timestamp(), band_count, target_width, target_height, reader->max_strip_rows);
+    return 0;
+}
+
+int strip_reader_read(StripReader* reader, int y_start, int y_end)
+{
+    if (y_start < 0 || y_end > reader->target_height || y_end <= y_start ||
+        y_end - y_start > reader->max_strip_rows)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowy zakres pasa %d-%d.\n", get_timestamp(), y_start, y_end);
+        return -1;
+    }
+
+    int error_flag = 0;
+    int y_in_start[STRIP_READER_MAX_BANDS] = {0};
+
+    // Dekodowanie pasm równolegle, z limitem jednocześnie dekodowanych pasm
+    #pragma omp parallel for num_threads(reader->decode_concurrency) shared(reader, error_flag, y_in_start)
+    for (int i = 0; i < reader->band_count; i++)
+    {
+        if (error_flag)
+        {
+            continue;
+        }
+
+        if (read_band_strip(&reader->bands[i], reader->target_height, y_start, y_end, &y_in_start[i]) != 0)
+        {
+            #pragma omp critical
+            {
+                error_flag = 1;
+            }
+        }
+    }
+
+    if (error_flag)
+    {
+        return -1;
+    }
+
+    // Resampling poza regionem dekodowania, aby jądra miały do dyspozycji wszystkie wątki
+    for (int i = 0; i < reader->band_count; i++)
+    {
+        StripBandReader* band_reader = &reader->bands[i];
+        if (band_reader->needs_resampling)
+        {
+            size_t output_pixels = (size_t)reader->target_width * (y_end - y_start);
+            MetricsScope metrics_scope = metrics_stage_begin("resample", band_reader->band_name);
+            resample_rows(band_reader->method, band_reader->input_rows, y_in_start[i], band_reader->strip_data,
+                          band_reader->width, band_reader->height,
+                          reader->target_width, reader->target_height, y_start, y_end);
+            metrics_stage_end(&metrics_scope,
+                              (size_t)band_reader->width * band_reader->input_rows_read * sizeof(float),
+                              output_pixels * sizeof(float), output_pixels);
+        }
+    }
+
+    reader->strip_y_start = y_start;
+    reader->strip_y_end = y_end;
+    return 0;
+}
+
+const float* strip_reader_band(const StripReader* reader, int band_index)
+{
+    if (band_index < 0 || band_index >= reader->band_count)
+    {
+        return NULL;
+    }
+    return reader->bands[band_index].strip_data;
+}
+
+void strip_reader_close(StripReader* reader)
+{
+    for (int i = 0; i < STRIP_READER_MAX_BANDS; i++)
+    {
+        StripBandReader* band_reader = &reader->bands[i];
+
+        if (band_reader->strip_data && band_reader->strip_data != band_reader->input_rows)
+        {
+            free(band_reader->strip_data);
+        }
+        free(band_reader->input_rows);
+        band_reader->strip_data = NULL;
+        band_reader->input_rows = NULL;
+
+        if (band_reader->dataset)
+        {
+            GDALClose(band_reader->dataset);
+            band_reader->dataset = NULL;
+            band_reader->band = NULL;
+        }
+    }
+}
+
+size_t strip_reader_estimate_bytes(const int widths[], const int heights[], int band_count,
+                                   int target_width, int target_height, int strip_rows, int decode_concurrency)
+{
+    size_t total = 0;
+    size_t largest_window = 0;
+
+    for (int i = 0; i < band_count; i++)
+    {
+        size_t window = (size_t)widths[i] * input_rows_for_strip(heights[i], target_height, strip_rows) *
+            sizeof(float);
+        total += window;
+
+        if (widths[i] != target_width || heights[i] != target_height)
+        {
+            total += (size_t)target_width * strip_rows * sizeof(float);
+        }
+        if (window > largest_window)
+        {
+            largest_window = window;
+        }
+    }
+
+    // Przestrzeń robocza dekodera - w przybliżeniu jedno okno na każde równolegle dekodowane pasmo
+    total += (size_t)decode_concurrency * largest_window;
+    return total;
+}
+
+static int input_rows_for_strip(int input_height, int output_height, int strip_rows)
+{
+    if (input_height == output_height)
+    {
+        return strip_rows;
+    }
+
+    // Górne ograniczenie dla wszystkich metod: ceil(R * skala) + 2 wiersze brzegowe
+    float y_ratio = (float)input_height / output_height;
+    int rows = (int)ceilf(strip_rows * y_ratio) + 2;
+    return rows < input_height ? rows : input_height;
+}
+
+static int allocate_band_strip_buffers(StripBandReader* band_reader, int target_width, int target_height,
+                                       int max_strip_rows)
+{
+    band_reader->needs_resampling = band_reader->width != target_width || band_reader->height != target_height;
+    band_reader->input_capacity_rows = input_rows_for_strip(band_reader->height, target_height, max_strip_rows);
+
+    band_reader->input_rows = malloc((size_t)band_reader->width * band_reader->input_capacity_rows * sizeof(float));
+    if (!band_reader->input_rows)
+    {
+        fprintf(stderr, "Błąd alokacji bufora pasa dla pasma %s.\n", band_reader->band_name);
+        return -1;
+    }
+
+    if (!band_reader->needs_resampling)
+    {
+        band_reader->strip_data = band_reader->input_rows;
+        return 0;
+    }
+
+    band_reader->strip_data = malloc((size_t)target_width * max_strip_rows * sizeof(float));
+    if (!band_reader->strip_data)
+    {
+        fprintf(stderr, "Błąd alokacji bufora pasa po resamplingu dla pasma %s.\n", band_reader->band_name);
+        return -1;
+    }
+    return 0;
+}
+
+static int open_band_reader(StripBandReader* band_reader, const char* path, const char* band_name, int target_width)
+{
+    band_reader->band_name = band_name;
+
+    if (!path)
+    {
+        fprintf(stderr, "Error: Filename is NULL\n");
+        return -1;
+    }
+
+    band_reader->dataset = GDALOpen(path, GA_ReadOnly);
+    if (!band_reader->dataset)
+    {
+        fprintf(stderr, "Nie można otworzyć pliku %s: %s\n", path, CPLGetLastErrorMsg());
+        return -1;
+    }
+
+    band_reader->width = GDALGetRasterXSize(band_reader->dataset);
+    band_reader->height = GDALGetRasterYSize(band_reader->dataset);
+    if (band_reader->width <= 0 || band_reader->height <= 0)
+    {
+        fprintf(stderr, "Nieprawidłowe wymiary rastra w pliku %s (%dx%d).\n",
+                path, band_reader->width, band_reader->height);
+        return -1;
+    }
+
+    band_reader->band = GDALGetRasterBand(band_reader->dataset, 1);
+    if (!band_reader->band)
+    {
+        fprintf(stderr, "Nie można pobrać pasma z pliku %s: %s\n", path, CPLGetLastErrorMsg());
+        return -1;
+    }
+
+    band_reader->method = resample_method_for_band(band_name, band_reader->width, target_width);
+    return 0;
+}
+
+static int read_band_strip(StripBandReader* band_reader, int target_height, int y_start, int y_end,
+                           int* y_in_start_out)
+{
+    int y_in_start = y_start;
+    int y_in_end = y_end;
+
+    if (band_reader->needs_resampling)
+    {
+        resample_input_row_range(band_reader->method, band_reader->height, target_height,
+                                 y_start, y_end, &y_in_start, &y_in_end);
+    }
+
+    int rows = y_in_end - y_in_start;
+    size_t window_pixels = (size_t)band_reader->width * rows;
+    if (rows > band_reader->input_capacity_rows)
+    {
+        fprintf(stderr, "[%s] [%s] Błąd: Pas wymaga %d wierszy wejściowych, bufor mieści %d.\n",
+                get_timestamp(), band_reader->band_name, rows, band_reader->input_capacity_rows);
+        return -1;
+    }
+
+    MetricsScope metrics_scope = metrics_stage_begin("load", band_reader->band_name);
+    CPLErr err = GDALRasterIO(band_reader->band, GF_Read, 0, y_in_start, band_reader->width, rows,
+                              band_reader->input_rows, band_reader->width, rows, GDT_Float32, 0, 0);
+    metrics_stage_end(&metrics_scope, 0, window_pixels * sizeof(float), window_pixels);
+    if (err != CE_None)
+    {
+        fprintf(stderr, "Błąd podczas wczytywania pasa %d-%d pasma %s: %s\n",
+                y_in_start, y_in_end, band_reader->band_name, CPLGetLastErrorMsg());
+        return -1;
+    }
+
+    band_reader->input_rows_read = rows;
+    *y_in_start_out = y_in_start;
+    return 0;
+}
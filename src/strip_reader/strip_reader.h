@@ -0,0 +1,84 @@
+#ifndef STRIP_READER_H
+#define STRIP_READER_H
+
+#include <gdal.h>
+#include <stddef.h>
+
+#include "../data_types/data_types.h"
+#include "../resampler/resampler.h"
+
+// Czytnik może otworzyć każde pasmo produktu (pozycje BandType)
+#define STRIP_READER_MAX_BANDS PIPELINE_BAND_COUNT
+
+typedef struct
+{
+    GDALDatasetH dataset;
+    GDALRasterBandH band;
+    int width;
+    int height;
+    ResampleMethod method;
+    int needs_resampling;
+    int input_capacity_rows;
+    int input_rows_read;
+    float* input_rows;
+    float* strip_data;
+    const char* band_name;
+} StripBandReader;
+
+/**
+ * @brief Czytnik pasów wierszy wszystkich pasm na wspólnej siatce docelowej
+ *
+ * Trzyma otwarte datasety GDAL i czyta z nich tylko te wiersze, które są potrzebne
+ * do obliczenia bieżącego pasa wierszy wyjściowych, a następnie resampluje je
+ * do rozdzielczości docelowej. Pamięć zależy od wysokości pasa, a nie od rozmiaru sceny.
+ */
+typedef struct
+{
+    StripBandReader bands[STRIP_READER_MAX_BANDS];
+    int band_count;
+    int target_width;
+    int target_height;
+    int max_strip_rows;
+    int decode_concurrency;
+    int strip_y_start;
+    int strip_y_end;
+} StripReader;
+
+/**
+ * @brief Otwiera pliki pasm i alokuje bufory pasów
+ *
+ * @param bands Tablica pasm - używane są ścieżki (path) i nazwy; wymiary natywne
+ *              zapisywane są do width/height każdego pasma
+ * @param band_count Liczba pasm (metodę resamplingu wyznacza nazwa pasma, jak w resamplerze)
+ * @param max_strip_rows Maksymalna liczba wierszy wyjściowych w jednym pasie
+ * @param decode_concurrency Ile pasm może być dekodowanych jednocześnie
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu (zasoby są wtedy zwolnione)
+ */
+int strip_reader_open(StripReader* reader, BandData* bands, int band_count,
+                      int target_width, int target_height, int max_strip_rows, int decode_concurrency);
+
+/**
+ * @brief Wczytuje pas wierszy [y_start, y_end) siatki docelowej dla wszystkich pasm
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu odczytu
+ */
+int strip_reader_read(StripReader* reader, int y_start, int y_end);
+
+/**
+ * @brief Zwraca dane bieżącego pasa danego pasma na siatce docelowej (wiersz y_start na początku)
+ */
+const float* strip_reader_band(const StripReader* reader, int band_index);
+
+void strip_reader_close(StripReader* reader);
+
+/**
+ * @brief Szacuje pamięć buforów czytnika dla pasów o podanej wysokości
+ *
+ * Uwzględnia okna wierszy wejściowych, bufory po resamplingu oraz przestrzeń roboczą
+ * dekodera dla decode_concurrency równolegle czytanych pasm.
+ */
+size_t strip_reader_estimate_bytes(const int widths[], const int heights[], int band_count,
+                                   int target_width, int target_height, int strip_rows, int decode_concurrency);
+
+#endif // STRIP_READER_H
@@ -0,0 +1,91 @@
+#include "tiled_bands.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "../raster_pool/raster_pool.h"
+#include "../utils/utils.h"
+
+int tiled_bands_init(TiledBands* tiled, int band_count, size_t num_pixels, size_t tile_pixels)
+{
+    memset(tiled, 0, sizeof(*tiled));
+    if (band_count <= 0 || band_count > TILED_BANDS_MAX_BANDS || num_pixels == 0)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowe parametry układu kafli.\n", get_timestamp());
+        return -1;
+    }
+
+    tiled->band_count = band_count;
+    tiled->num_pixels = num_pixels;
+    tiled->tile_pixels = tile_pixels > 0 ? tile_pixels : TILED_BANDS_DEFAULT_TILE_PIXELS;
+    tiled->tile_count = (num_pixels + tiled->tile_pixels - 1) / tiled->tile_pixels;
+
+    // Bufor z puli - wyrównany i po zwolnieniu dostępny dla kolejnych rastrów sceny
+    tiled->data = raster_pool_acquire(tiled_bands_bytes(band_count, num_pixels, tiled->tile_pixels) / sizeof(float));
+    if (!tiled->data)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla układu kafli (%d pasm, %zu pikseli).\n",
+                get_timestamp(), band_count, num_pixels);
+        return -1;
+    }
+    return 0;
+}
+
+int tiled_bands_pack(TiledBands* tiled, const float* const bands[], int band_count, size_t num_pixels,
+                     size_t tile_pixels)
+{
+    if (tiled_bands_init(tiled, band_count, num_pixels, tile_pixels) != 0)
+    {
+        return -1;
+    }
+
+    // Kafel naraz dla wszystkich pasm - każdy wątek zapisuje ciągły fragment bufora kafli
+    #pragma omp parallel for schedule(static)
+    for (size_t tile = 0; tile < tiled->tile_count; tile++)
+    {
+        size_t start = tile * tiled->tile_pixels;
+        size_t length = tiled_bands_tile_length(tiled, tile);
+        for (int band = 0; band < band_count; band++)
+        {
+            if (bands[band])
+            {
+                memcpy((float*)tiled_bands_tile(tiled, tile, band), bands[band] + start, length * sizeof(float));
+            }
+        }
+    }
+    return 0;
+}
+
+void tiled_bands_store(TiledBands* tiled, int band, const float* values)
+{
+    #pragma omp parallel for schedule(static)
+    for (size_t tile = 0; tile < tiled->tile_count; tile++)
+    {
+        memcpy((float*)tiled_bands_tile(tiled, tile, band), values + tile * tiled->tile_pixels,
+               tiled_bands_tile_length(tiled, tile) * sizeof(float));
+    }
+}
+
+const float* tiled_bands_tile(const TiledBands* tiled, size_t tile, int band)
+{
+    return tiled->data + (tile * tiled->band_count + band) * tiled->tile_pixels;
+}
+
+size_t tiled_bands_tile_length(const TiledBands* tiled, size_t tile)
+{
+    size_t start = tile * tiled->tile_pixels;
+    return tiled->num_pixels - start < tiled->tile_pixels ? tiled->num_pixels - start : tiled->tile_pixels;
+}
+
+size_t tiled_bands_bytes(int band_count, size_t num_pixels, size_t tile_pixels)
+{
+    tile_pixels = tile_pixels > 0 ? tile_pixels : TILED_BANDS_DEFAULT_TILE_PIXELS;
+    size_t tile_count = (num_pixels + tile_pixels - 1) / tile_pixels;
+    return tile_count * tile_pixels * (size_t)band_count * sizeof(float);
+}
+
+void tiled_bands_free(TiledBands* tiled)
+{
+    raster_pool_release(tiled->data);
+    tiled->data = NULL;
+    tiled->tile_count = 0;
+}
@@ -0,0 +1,72 @@
+#ifndef TILED_BANDS_H
+#define TILED_BANDS_H
+
+#include <stddef.h>
+
+// Największa liczba pasm w jednym kaflu - pasma wszystkich wbudowanych wskaźników (B02-B05, B08, B11, B12) i SCL
+#define TILED_BANDS_MAX_BANDS 8
+// Domyślny kafel: 4 pasma x 8192 piksele x 4 B = 128 KiB, mieści się w L2 razem z wynikami
+#define TILED_BANDS_DEFAULT_TILE_PIXELS 8192
+
+/**
+ * @brief Pasma sceny spakowane w kafle - pasma kafla leżą obok siebie w jednym bloku pamięci
+ *
+ * Kafel to tile_pixels kolejnych pikseli rastra (w kolejności wierszy), a w kaflu każde
+ * pasmo zajmuje ciągły fragment (układ planarny w kaflu):
+ *
+ *   [kafel 0: pasmo 0 | pasmo 1 | ... ][kafel 1: pasmo 0 | pasmo 1 | ... ] ...
+ *
+ * Jądro wielopasmowe czyta wtedy jeden ciągły strumień zamiast band_count odległych tablic,
+ * a wszystkie wejścia piksela kafla są jednocześnie w cache. Ostatni kafel jest dopełniony
+ * do pełnego rozmiaru. Wyniki jąder pozostają w zwykłym układzie wierszowym.
+ */
+typedef struct
+{
+    float* data;
+    int band_count;
+    size_t num_pixels;
+    size_t tile_pixels;
+    size_t tile_count;
+} TiledBands;
+
+/**
+ * @brief Pakuje band_count rastrów num_pixels pikseli w kafle (równolegle po kaflach)
+ *
+ * @param bands Rastry pasm w układzie wierszowym; NULL - pasmo pominięte (slot pozostaje pusty)
+ * @param tile_pixels Rozmiar kafla w pikselach, 0 - TILED_BANDS_DEFAULT_TILE_PIXELS
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu parametrów lub alokacji
+ */
+int tiled_bands_pack(TiledBands* tiled, const float* const bands[], int band_count, size_t num_pixels,
+                     size_t tile_pixels);
+
+/**
+ * @brief Alokuje pusty układ kafli - pasma dopisywane są potem przez tiled_bands_store()
+ *
+ * Pozwala pakować pasma pojedynczo i zwalniać oryginał zaraz po skopiowaniu, więc
+ * szczytowa pamięć rośnie o jedno pasmo, a nie o całą scenę.
+ */
+int tiled_bands_init(TiledBands* tiled, int band_count, size_t num_pixels, size_t tile_pixels);
+
+/**
+ * @brief Kopiuje raster pasma (układ wierszowy) do slotu band wszystkich kafli
+ */
+void tiled_bands_store(TiledBands* tiled, int band, const float* values);
+
+/**
+ * @brief Zwraca początek pasma band w kaflu tile (tiled_bands_tile_length() pikseli)
+ */
+const float* tiled_bands_tile(const TiledBands* tiled, size_t tile, int band);
+
+/**
+ * @brief Liczba pikseli rastra w kaflu tile (mniejsza od tile_pixels tylko dla ostatniego)
+ */
+size_t tiled_bands_tile_length(const TiledBands* tiled, size_t tile);
+
+/**
+ * @brief Bajty bufora kafli dla podanych parametrów (z dopełnieniem ostatniego kafla)
+ */
+size_t tiled_bands_bytes(int band_count, size_t num_pixels, size_t tile_pixels);
+
+void tiled_bands_free(TiledBands* tiled);
+
+#endif // TILED_BANDS_H
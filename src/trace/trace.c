@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <omp.h>
+
+#include "../utils/utils.h"
+
+#define TRACE_EVENTS_PER_BLOCK 4096
+
+typedef struct
+{
+    const char* category;
+    const char* name;
+    const char* arg_name;
+    long arg_value;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} TraceEvent;
+
+typedef struct TraceBlock
+{
+    TraceEvent events[TRACE_EVENTS_PER_BLOCK];
+    int count;
+    struct TraceBlock* next;
+} TraceBlock;
+
+typedef struct TraceBuffer
+{
+    int tid;
+    int omp_thread;
+    TraceBlock* first;
+    TraceBlock* current;
+    struct TraceBuffer* next;
+} TraceBuffer;
+
+static volatile int trace_enabled = 0;
+static uint64_t trace_base_ns = 0;
+
+// Lista buforów wszystkich wątków - modyfikowana tylko w sekcji krytycznej "trace"
+static TraceBuffer* buffers = NULL;
+static int next_tid = 1;
+
+static _Thread_local TraceBuffer* thread_buffer = NULL;
+
+// ====== POMOCNICZE ======
+static uint64_t now_ns(void);
+static TraceBuffer* get_thread_buffer(void);
+static void record_event(const TraceSpan* span, const char* arg_name, long arg_value);
+
+void trace_start(void)
+{
+    trace_base_ns = now_ns();
+    trace_enabled = 1;
+}
+
+int trace_is_enabled(void)
+{
+    return trace_enabled;
+}
+
+TraceSpan trace_begin(const char* category, const char* name)
+{
+    TraceSpan span;
+    span.category = category;
+    span.name = name;
+    span.start_ns = trace_enabled ? now_ns() : 0;
+    return span;
+}
+
+void trace_end(TraceSpan* span)
+{
+    if (span->start_ns != 0)
+    {
+        record_event(span, NULL, 0);
+    }
+}
+
+void trace_end_with_arg(TraceSpan* span, const char* arg_name, long arg_value)
+{
+    if (span->start_ns != 0)
+    {
+        record_event(span, arg_name, arg_value);
+    }
+}
+
+int trace_write_chrome_json(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można otworzyć pliku śladu %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    size_t event_count = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ndvi-ndmi\"}}");
+
+    for (TraceBuffer* buffer = buffers; buffer; buffer = buffer->next)
+    {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"wątek %d (omp %d)\"}}",
+                buffer->tid, buffer->tid, buffer->omp_thread);
+
+        for (TraceBlock* block = buffer->first; block; block = block->next)
+        {
+            for (int i = 0; i < block->count; i++)
+            {
+                const TraceEvent* event = &block->events[i];
+                // Nazwy to nazwy etapów i pasm - nie zawierają znaków wymagających escapowania
+                fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                        "\"ts\":%.3f,\"dur\":%.3f",
+                        event->name, event->category, buffer->tid,
+                        (event->start_ns - trace_base_ns) / 1000.0,
+                        (event->end_ns - event->start_ns) / 1000.0);
+                if (event->arg_name)
+                {
+                    fprintf(file, ",\"args\":{\"%s\":%ld}", event->arg_name, event->arg_value);
+                }
+                fputc('}', file);
+                event_count++;
+            }
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("[%s] Zapisano ślad (%zu zdarzeń) do %s.\n", get_timestamp(), event_count, path);
+    return 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Bufor bieżącego wątku - tworzony i rejestrowany przy pierwszym zdarzeniu
+static TraceBuffer* get_thread_buffer(void)
+{
+    if (thread_buffer)
+    {
+        return thread_buffer;
+    }
+
+    TraceBuffer* buffer = calloc(1, sizeof(TraceBuffer));
+    TraceBlock* block = calloc(1, sizeof(TraceBlock));
+    if (!buffer || !block)
+    {
+        free(buffer);
+        free(block);
+        return NULL;
+    }
+
+    buffer->first = block;
+    buffer->current = block;
+    buffer->omp_thread = omp_get_thread_num();
+
+    #pragma omp critical(trace)
+    {
+        buffer->tid = next_tid++;
+        buffer->next = buffers;
+        buffers = buffer;
+    }
+
+    thread_buffer = buffer;
+    return buffer;
+}
+
+static void record_event(const TraceSpan* span, const char* arg_name, long arg_value)
+{
+    uint64_t end_ns = now_ns();
+    TraceBuffer* buffer = get_thread_buffer();
+    if (!buffer)
+    {
+        return;
+    }
+
+    TraceBlock* block = buffer->current;
+    if (block->count == TRACE_EVENTS_PER_BLOCK)
+    {
+        TraceBlock* next_block = calloc(1, sizeof(TraceBlock));
+        if (!next_block)
+        {
+            return;
+        }
+        block->next = next_block;
+        buffer->current = next_block;
+        block = next_block;
+    }
+
+    TraceEvent* event = &block->events[block->count++];
+    event->category = span->category;
+    event->name = span->name;
+    event->arg_name = arg_name;
+    event->arg_value = arg_value;
+    event->start_ns = span->start_ns;
+    event->end_ns = end_ns;
+}
@@ -0,0 +1,62 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Otwarty odcinek śledzenia (zdarzenie "X" w formacie Chrome trace)
+ *
+ * start_ns == 0 oznacza, że śledzenie było wyłączone w chwili rozpoczęcia
+ * i trace_end() nic nie zapisze.
+ */
+typedef struct
+{
+    const char* category;
+    const char* name;
+    uint64_t start_ns;
+} TraceSpan;
+
+/**
+ * @brief Włącza zbieranie zdarzeń
+ *
+ * Zdarzenia trafiają do buforów prywatnych dla każdego wątku, bez blokad - jedyną
+ * synchronizacją jest jednorazowa rejestracja bufora przy pierwszym zdarzeniu wątku.
+ */
+void trace_start(void);
+
+/**
+ * @brief Czy śledzenie jest włączone (jedno odczytanie flagi - koszt przy wyłączonym śledzeniu)
+ */
+int trace_is_enabled(void);
+
+/**
+ * @brief Rozpoczyna odcinek
+ *
+ * @param category Kategoria (np. "load", "resample", "index")
+ * @param name Nazwa odcinka (np. nazwa pasma)
+ *
+ * @note Oba napisy muszą żyć do zapisu śladu (literały lub nazwy pasm z BandData)
+ */
+TraceSpan trace_begin(const char* category, const char* name);
+
+/**
+ * @brief Kończy odcinek i zapisuje go do bufora bieżącego wątku
+ */
+void trace_end(TraceSpan* span);
+
+/**
+ * @brief Kończy odcinek z jednym argumentem liczbowym widocznym w Perfetto (np. numer pasa)
+ */
+void trace_end_with_arg(TraceSpan* span, const char* arg_name, long arg_value);
+
+/**
+ * @brief Zapisuje wszystkie zebrane zdarzenia jako plik JSON w formacie Chrome trace
+ *
+ * Plik można otworzyć w Perfetto (ui.perfetto.dev) lub chrome://tracing.
+ *
+ * @warning Wywoływać, gdy żaden wątek nie zapisuje już zdarzeń (np. na końcu programu)
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu zapisu
+ */
+int trace_write_chrome_json(const char* path);
+
+#endif // TRACE_H
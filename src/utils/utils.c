@@ -1,9 +1,14 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "utils.h"
+#include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
 #include <sys/time.h>
 
+#include "../band_registry/band_registry.h"
+
 const char* get_short_filename(const char* filepath)
 {
     if (!filepath)
@@ -38,32 +43,47 @@ size_t pixel_index(int x, int y, int width)
 
 const char* detect_band_from_filename(const char* filename)
 {
-    if (filename == NULL) return "UNKNOWN";
-
-    if (strstr(filename, "B04") || strstr(filename, "_B04_")) return "B04";
-    if (strstr(filename, "B08") || strstr(filename, "_B08_")) return "B08";
-    if (strstr(filename, "B11") || strstr(filename, "_B11_")) return "B11";
-    if (strstr(filename, "SCL") || strstr(filename, "_SCL_")) return "SCL";
-
-    return "UNKNOWN";
+    const BandInfo* info = band_registry_get(band_registry_detect_filename(filename));
+    return info ? info->name : "UNKNOWN";
 }
 
 char* get_timestamp()
 {
-    static char timestamp[64];
+    // Osobny bufor dla każdego wątku - funkcja jest wywoływana z regionów OpenMP
+    static _Thread_local char timestamp[64];
     struct timeval tv;
-    struct tm* tm_info;
+    struct tm tm_info;
 
     gettimeofday(&tv, NULL);
-    tm_info = localtime(&tv.tv_sec);
+    localtime_r(&tv.tv_sec, &tm_info);
 
     snprintf(timestamp, sizeof(timestamp), "%02d:%02d:%02d.%03ld",
-             tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec,
+             tm_info.tm_hour, tm_info.tm_min, tm_info.tm_sec,
              tv.tv_usec / 1000);
 
     return timestamp;
 }
 
+void log_labeled(FILE* stream, const char* label, const char* format, ...)
+{
+    char message[512];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    // Jeden zapis na komunikat - wiersze scen przetwarzanych w innych wątkach się nie przeplatają
+    if (label)
+    {
+        fprintf(stream, "[%s] [%s] %s", get_timestamp(), label, message);
+    }
+    else
+    {
+        fprintf(stream, "[%s] %s", get_timestamp(), message);
+    }
+}
+
 double get_time_diff(struct timeval start, struct timeval end)
 {
     return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
@@ -76,3 +96,25 @@ int clamp(int value, int min, int max)
     if (value > max) return max;
     return value;
 }
+
+void write_json_string(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        }
+        else
+        {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
@@ -1,6 +1,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
 
@@ -10,5 +11,9 @@ const char* detect_band_from_filename(const char* filename);
 char* get_timestamp();
 double get_time_diff(struct timeval start, struct timeval end);
 int clamp(int value, int min, int max);
+// Wypisuje komunikat poprzedzony znacznikiem czasu i etykietą sceny (pominiętą, gdy NULL) jednym zapisem
+void log_labeled(FILE* stream, const char* label, const char* format, ...);
+// Zapisuje tekst jako napis JSON w cudzysłowach (z escapowaniem " \ i znaków sterujących)
+void write_json_string(FILE* file, const char* text);
 
 #endif
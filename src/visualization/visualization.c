@@ -1,17 +1,12 @@
 #include "visualization.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
 
 #include "../utils/utils.h"
+#include "../metrics/metrics.h"
+#include "../trace/trace.h"
 
-// Linear interpolation
-static float lerp(float a, float b, float t)
-{
-    return a + t * (b - a);
-}
-
-static GdkPixbuf* create_image_display_buffer(const float* index_data, int width, int height)
+static GdkPixbuf* create_image_display_buffer(const void* index_data, int width, int height)
 {
     if (!index_data || width <= 0 || height <= 0)
     {
@@ -28,42 +23,25 @@ static GdkPixbuf* create_image_display_buffer(const float* index_data, int width
     return pixbuf;
 }
 
-// Calculates the memory address of a specific pixel (x,y) in a raw pixel buffer.
-static guchar* get_pixel_pointer(guchar* pixels, int y, int x, int rowstride, int n_channels)
-{
-    return pixels + (size_t)y * rowstride + (size_t)x * n_channels;
-}
-
-void map_index_value_to_rgb(float value, unsigned char* r,
-                            unsigned char* g, unsigned char* b)
+GdkPixbuf* generate_pixbuf_from_index_data(const float* index_data, int width, int height)
 {
-    if (value == INDEX_NO_DATA_VALUE || isnan(value) || isinf(value))
+    GdkPixbuf* pixbuf = create_image_display_buffer(index_data, width, height);
+    if (!pixbuf)
     {
-        *r = 0;
-        *g = 0;
-        *b = 0;
-        return;
+        return NULL;
     }
 
-    if (value < 0.0f)
-    {
-        // t rośnie od 0 (dla value = -1.0) do 1 (dla value = 0.0)
-        float t = (value - (-1.0f)) / (0.0f - (-1.0f));
-        *r = 255;
-        *g = (unsigned char)lerp(0.0f, 255.0f, t);
-        *b = 0;
-    }
-    else
-    {
-        // t rośnie od 0 (dla value = 0.0) do 1 (dla value = 1.0)
-        float t = (value - 0.0f) / (1.0f - 0.0f);
-        *r = (unsigned char)lerp(255.0f, 0.0f, t); // essa
-        *g = 255;
-        *b = 0;
-    }
+    size_t num_pixels = (size_t)width * height;
+    MetricsScope metrics_scope = metrics_stage_begin("visualize", "pixbuf");
+
+    render_index_rows_to_pixbuf(pixbuf, index_data, 0, height);
+
+    metrics_stage_end(&metrics_scope, num_pixels * sizeof(float),
+                      num_pixels * gdk_pixbuf_get_n_channels(pixbuf), num_pixels);
+    return pixbuf;
 }
 
-GdkPixbuf* generate_pixbuf_from_index_data(const float* index_data, int width, int height)
+GdkPixbuf* generate_pixbuf_from_quantized_index(const int16_t* index_data, int width, int height)
 {
     GdkPixbuf* pixbuf = create_image_display_buffer(index_data, width, height);
     if (!pixbuf)
@@ -71,6 +49,9 @@ GdkPixbuf* generate_pixbuf_from_index_data(const float* index_data, int width, i
         return NULL;
     }
 
+    size_t num_pixels = (size_t)width * height;
+    MetricsScope metrics_scope = metrics_stage_begin("visualize", "pixbuf_int16");
+
     guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
     int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
     int n_channels = gdk_pixbuf_get_n_channels(pixbuf);
@@ -78,12 +59,32 @@ GdkPixbuf* generate_pixbuf_from_index_data(const float* index_data, int width, i
     #pragma omp parallel for shared(index_data, pixels, rowstride, n_channels)
     for (int y = 0; y < height; y++)
     {
-        for (int x = 0; x < width; x++)
+        colorize_quantized_index_row(index_data + pixel_index(0, y, width), width,
+                                     pixels + (size_t)y * rowstride, n_channels);
+    }
+
+    metrics_stage_end(&metrics_scope, num_pixels * sizeof(int16_t), num_pixels * n_channels, num_pixels);
+    return pixbuf;
+}
+
+void render_index_rows_to_pixbuf(GdkPixbuf* pixbuf, const float* index_data, int y_start, int y_end)
+{
+    guchar* pixels = gdk_pixbuf_get_pixels(pixbuf);
+    int width = gdk_pixbuf_get_width(pixbuf);
+    int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+    int n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+
+    #pragma omp parallel shared(index_data, pixels, rowstride, n_channels)
+    {
+        TraceSpan chunk_span = trace_begin("visualize", "chunk");
+
+        #pragma omp for nowait
+        for (int y = y_start; y < y_end; y++)
         {
-            size_t pixel_idx_float = pixel_index(x, y, width);
-            guchar* p = get_pixel_pointer(pixels, y, x, rowstride, n_channels);
-            map_index_value_to_rgb(index_data[pixel_idx_float], &p[0], &p[1], &p[2]);
+            colorize_index_row(index_data + pixel_index(0, y, width), width,
+                               pixels + (size_t)y * rowstride, n_channels);
         }
+
+        trace_end(&chunk_span);
     }
-    return pixbuf;
 }
@@ -3,9 +3,20 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include "../index_calculator/index_calculator.h"
-
-void map_index_value_to_rgb(float value, unsigned char* r, unsigned char* g, unsigned char* b);
+#include "../colormap/colormap.h"
 
 GdkPixbuf* generate_pixbuf_from_index_data(const float* index_data, int width, int height);
 
+/**
+ * @brief generate_pixbuf_from_index_data() dla wskaźnika skwantowanego do int16 - bez rastra float
+ */
+GdkPixbuf* generate_pixbuf_from_quantized_index(const int16_t* index_data, int width, int height);
+
+/**
+ * @brief Koloruje wiersze [y_start, y_end) wskaźnika do istniejącego pixbufa o tych samych wymiarach
+ *
+ * Pozostałe wiersze pixbufa nie są modyfikowane - pozwala dopracowywać mapę pasami w trakcie obliczeń.
+ */
+void render_index_rows_to_pixbuf(GdkPixbuf* pixbuf, const float* index_data, int y_start, int y_end);
+
 #endif
@@ -0,0 +1,457 @@
+#define _GNU_SOURCE
+
+#include "watch_daemon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <glib.h>
+#include <omp.h>
+
+#include "../pipeline_context/pipeline_context.h"
+#include "../batch_scheduler/batch_scheduler.h"
+#include "../raster_pool/raster_pool.h"
+#include "../metrics/metrics.h"
+#include "../utils/utils.h"
+#include "../band_registry/band_registry.h"
+
+#define COMPLETION_MANIFEST_NAME "completed.jsonl"
+
+// Co ile milisekund pętla zdarzeń sprawdza, czy przyszedł sygnał zatrzymania
+#define WATCH_POLL_INTERVAL_MS 500
+
+/**
+ * @brief Scena, której pliki pasm jeszcze napływają
+ */
+typedef struct
+{
+    char* paths[PIPELINE_BAND_COUNT];
+    gint64 last_arrival_us;
+} PendingScene;
+
+/**
+ * @brief Kompletna scena przekazana do puli wątków
+ */
+typedef struct
+{
+    char* name;
+    char* paths[PIPELINE_BAND_COUNT];
+    gint64 last_arrival_us;
+} WatchJob;
+
+typedef struct
+{
+    const WatchConfig* config;
+    char* manifest_path;
+    gint succeeded;
+    gint failed;
+    // Chroni plik manifestu i przebieg metryk - wątki GThreadPool nie są wątkami OpenMP,
+    // więc sekcje krytyczne OpenMP ich nie szeregują
+    GMutex lock;
+    // Sceny w toku w bieżącym przebiegu metryk i czy któraś z nich zakończyła się błędem
+    int active_jobs;
+    bool run_failed;
+} WatchState;
+
+// Ustawiane przez obsługę SIGINT/SIGTERM
+static volatile sig_atomic_t stop_requested = 0;
+
+// ====== WALIDACJA ======
+static int validate_watch_config(const WatchConfig* config);
+
+// ====== PAMIĘĆ ======
+static void free_pending_scene(gpointer data);
+static void free_watch_job(WatchJob* job);
+
+// ====== FUNKCJONALNOŚĆ ======
+static void handle_incoming_file(GHashTable* pending, GThreadPool* pool, const char* directory, const char* filename);
+static void scan_existing_files(GHashTable* pending, GThreadPool* pool, const char* directory);
+static void process_watch_job(gpointer data, gpointer user_data);
+static void append_completion_record(WatchState* state, const WatchJob* job, const char* status,
+                                     double compute_s, double latency_s);
+static void begin_job_metrics(WatchState* state, const WatchJob* job);
+static void end_job_metrics(WatchState* state, int status);
+
+// ====== POMOCNICZE ======
+// Przebieg metryk obejmuje okres, w którym demon ma sceny w toku: przy jednej scenie naraz
+// to dokładnie jedna scena, przy kilku - sceny nakładające się w czasie (jak przebieg --batch)
+static void begin_job_metrics(WatchState* state, const WatchJob* job)
+{
+    g_mutex_lock(&state->lock);
+    if (state->active_jobs++ == 0)
+    {
+        metrics_begin_run(state->config->workers == 1 ? job->name : "watch");
+        state->run_failed = false;
+    }
+    g_mutex_unlock(&state->lock);
+}
+
+static void end_job_metrics(WatchState* state, int status)
+{
+    g_mutex_lock(&state->lock);
+    state->run_failed = state->run_failed || status != 0;
+    if (--state->active_jobs == 0)
+    {
+        metrics_end_run(state->run_failed ? "error" : "ok");
+    }
+    g_mutex_unlock(&state->lock);
+}
+
+static void on_stop_signal(int signal_number);
+static void install_stop_handlers(void);
+static unsigned int required_band_mask(void);
+static char* scene_key_from_filename(const char* filename, int band);
+static bool is_raster_filename(const char* filename);
+
+int run_watch_daemon(const WatchConfig* config)
+{
+    if (!validate_watch_config(config))
+    {
+        return -1;
+    }
+
+    if (g_mkdir_with_parents(config->output_dir, 0755) != 0)
+    {
+        fprintf(stderr, "[%s] Nie można utworzyć katalogu wyjściowego %s.\n", get_timestamp(), config->output_dir);
+        return -1;
+    }
+
+    int inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd < 0 || inotify_add_watch(inotify_fd, config->watch_dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        fprintf(stderr, "[%s] Nie można obserwować katalogu %s: %s\n", get_timestamp(), config->watch_dir,
+                strerror(errno));
+        if (inotify_fd >= 0)
+        {
+            close(inotify_fd);
+        }
+        return -1;
+    }
+
+    // Rozgrzanie procesu: sterowniki GDAL i pula buforów są gotowe przed pierwszą sceną
+    pipeline_global_init();
+    raster_pool_set_capacity(config->buffer_pool_bytes);
+    install_stop_handlers();
+
+    WatchState state;
+    memset(&state, 0, sizeof(state));
+    state.config = config;
+    g_mutex_init(&state.lock);
+    state.manifest_path = g_build_filename(config->output_dir, COMPLETION_MANIFEST_NAME, NULL);
+
+    GThreadPool* pool = g_thread_pool_new(process_watch_job, &state, config->workers, FALSE, NULL);
+    GHashTable* pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_pending_scene);
+
+    printf("[%s] [DEMON] Obserwuję %s, wyniki w %s, %d scen jednocześnie po %d wątków\n",
+           get_timestamp(), config->watch_dir, config->output_dir, config->workers, config->threads_per_scene);
+
+    scan_existing_files(pending, pool, config->watch_dir);
+
+    // Bufor na zdarzenia wyrównany zgodnie z wymaganiami struct inotify_event
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd poll_fd = {.fd = inotify_fd, .events = POLLIN};
+
+    while (!stop_requested)
+    {
+        int ready = poll(&poll_fd, 1, WATCH_POLL_INTERVAL_MS);
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(inotify_fd, events, sizeof(events))) > 0)
+        {
+            for (char* ptr = events; ptr < events + length;)
+            {
+                const struct inotify_event* event = (const struct inotify_event*)ptr;
+                if (event->len > 0 && !(event->mask & IN_ISDIR))
+                {
+                    handle_incoming_file(pending, pool, config->watch_dir, event->name);
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+
+    printf("[%s] [DEMON] Zatrzymywanie - kończenie %u scen w kolejce, %u niekompletnych scen pominiętych\n",
+           get_timestamp(), g_thread_pool_unprocessed(pool), g_hash_table_size(pending));
+
+    // Czeka na zakończenie scen już przekazanych do puli
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_hash_table_destroy(pending);
+    close(inotify_fd);
+    raster_pool_set_capacity(0);
+
+    printf("[%s] [DEMON] Zakończono: %d scen poprawnie, %d z błędem\n", get_timestamp(),
+           g_atomic_int_get(&state.succeeded), g_atomic_int_get(&state.failed));
+
+    g_mutex_clear(&state.lock);
+    g_free(state.manifest_path);
+    return 0;
+}
+
+static int validate_watch_config(const WatchConfig* config)
+{
+    if (!config || !config->watch_dir || !config->output_dir)
+    {
+        fprintf(stderr, "[%s] Błąd: Brak katalogu obserwowanego lub wyjściowego.\n", get_timestamp());
+        return 0;
+    }
+    if (!g_file_test(config->watch_dir, G_FILE_TEST_IS_DIR))
+    {
+        fprintf(stderr, "[%s] Błąd: %s nie jest katalogiem.\n", get_timestamp(), config->watch_dir);
+        return 0;
+    }
+    if (config->workers <= 0 || config->threads_per_scene <= 0)
+    {
+        fprintf(stderr, "[%s] Błąd: Nieprawidłowa liczba scen jednocześnie lub wątków.\n", get_timestamp());
+        return 0;
+    }
+    return 1;
+}
+
+static void free_pending_scene(gpointer data)
+{
+    PendingScene* scene = data;
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        g_free(scene->paths[i]);
+    }
+    g_free(scene);
+}
+
+static void free_watch_job(WatchJob* job)
+{
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        g_free(job->paths[i]);
+    }
+    g_free(job->name);
+    g_free(job);
+}
+
+// Dopisuje plik do sceny; kompletna scena jest przenoszona z listy oczekujących do puli wątków
+static void handle_incoming_file(GHashTable* pending, GThreadPool* pool, const char* directory, const char* filename)
+{
+    // Pliki pasm niepotrzebnych wybranym wskaźnikom nie są nawet przypisywane do sceny
+    // Indeks rejestru pasm jest zarazem indeksem BandData (BandType)
+    int band = band_registry_detect_filename(filename);
+    if (!is_raster_filename(filename) || band < 0 || !(required_band_mask() & (1u << band)) ||
+        band_registry_has_foreign_resolution(filename, band))
+    {
+        return;
+    }
+
+    char* key = scene_key_from_filename(filename, band);
+    PendingScene* scene = g_hash_table_lookup(pending, key);
+    if (!scene)
+    {
+        scene = g_new0(PendingScene, 1);
+        g_hash_table_insert(pending, g_strdup(key), scene);
+    }
+
+    g_free(scene->paths[band]);
+    scene->paths[band] = g_build_filename(directory, filename, NULL);
+    scene->last_arrival_us = g_get_monotonic_time();
+
+    bool complete = true;
+    unsigned int band_mask = required_band_mask();
+    for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+    {
+        complete = complete && (!(band_mask & (1u << i)) || scene->paths[i] != NULL);
+    }
+
+    if (complete)
+    {
+        WatchJob* job = g_new0(WatchJob, 1);
+        job->name = g_strdup(key);
+        job->last_arrival_us = scene->last_arrival_us;
+        for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+        {
+            job->paths[i] = scene->paths[i];
+            scene->paths[i] = NULL;
+        }
+        g_hash_table_remove(pending, key);
+
+        printf("[%s] [DEMON] Scena %s kompletna, przekazana do przetwarzania\n", get_timestamp(), job->name);
+        g_thread_pool_push(pool, job, NULL);
+    }
+
+    g_free(key);
+}
+
+static void scan_existing_files(GHashTable* pending, GThreadPool* pool, const char* directory)
+{
+    GDir* dir = g_dir_open(directory, 0, NULL);
+    if (!dir)
+    {
+        return;
+    }
+
+    const gchar* entry;
+    while ((entry = g_dir_read_name(dir)) != NULL)
+    {
+        handle_incoming_file(pending, pool, directory, entry);
+    }
+    g_dir_close(dir);
+}
+
+// Wątek puli: cały przebieg sceny w jej własnym kontekście, bez ponownej inicjalizacji GDAL
+static void process_watch_job(gpointer data, gpointer user_data)
+{
+    WatchJob* job = data;
+    WatchState* state = user_data;
+    const WatchConfig* config = state->config;
+
+    omp_set_num_threads(config->threads_per_scene);
+    begin_job_metrics(state, job);
+    gint64 start_us = g_get_monotonic_time();
+    int status = -1;
+
+    PipelineContext* ctx = pipeline_context_new(job->name);
+    if (ctx)
+    {
+        for (int i = 0; i < PIPELINE_BAND_COUNT; i++)
+        {
+            pipeline_context_set_band_path(ctx, i, job->paths[i]);
+        }
+        ctx->target_10m = config->target_10m;
+        ctx->value_type = config->value_type;
+        ctx->band_layout = config->band_layout;
+
+        ProcessingResult* result = pipeline_context_run(ctx);
+        if (result)
+        {
+            status = batch_export_result(result, config->output_dir, job->name, config->export_formats);
+            if (status == 0 && config->zones.path)
+            {
+                status = batch_export_zonal_stats(result, job->paths, &config->zones, config->output_dir, job->name);
+            }
+            free_processing_result(result);
+        }
+        pipeline_context_free(ctx);
+    }
+
+    gint64 end_us = g_get_monotonic_time();
+    double compute_s = (end_us - start_us) / 1e6;
+    double latency_s = (end_us - job->last_arrival_us) / 1e6;
+
+    g_atomic_int_inc(status == 0 ? &state->succeeded : &state->failed);
+    end_job_metrics(state, status);
+    append_completion_record(state, job, status == 0 ? "ok" : "error", compute_s, latency_s);
+
+    printf("[%s] [DEMON] Scena %s: %s, obliczenia %.2fs, opóźnienie od nadejścia pliku %.2fs\n",
+           get_timestamp(), job->name, status == 0 ? "gotowa" : "błąd", compute_s, latency_s);
+
+    free_watch_job(job);
+}
+
+static void append_completion_record(WatchState* state, const WatchJob* job, const char* status,
+                                     double compute_s, double latency_s)
+{
+    unsigned int indices = get_pipeline_index_selection();
+    unsigned int formats = state->config->export_formats ? state->config->export_formats : BATCH_EXPORT_PNG;
+
+    g_mutex_lock(&state->lock);
+    FILE* manifest = fopen(state->manifest_path, "a");
+    if (manifest)
+    {
+        fputs("{\"scene\":", manifest);
+        write_json_string(manifest, job->name);
+        fprintf(manifest, ",\"status\":\"%s\"", status);
+
+        // Pole na każdy wybrany wskaźnik, np. "ndvi":"scena_NDVI.png"
+        for (int k = 0; (formats & BATCH_EXPORT_PNG) && pipeline_index_name(k); k++)
+        {
+            if (!(indices & (1u << k)))
+            {
+                continue;
+            }
+            gchar* field = g_ascii_strdown(pipeline_index_name(k), -1);
+            gchar* png_name = g_strdup_printf("%s_%s.png", job->name, pipeline_index_name(k));
+            fprintf(manifest, ",\"%s\":", field);
+            write_json_string(manifest, png_name);
+            g_free(png_name);
+            g_free(field);
+        }
+        if (formats & BATCH_EXPORT_ZARR)
+        {
+            gchar* zarr_name = g_strdup_printf("%s.zarr", job->name);
+            fputs(",\"zarr\":", manifest);
+            write_json_string(manifest, zarr_name);
+            g_free(zarr_name);
+        }
+        gchar* stats_name = g_strdup_printf("%s_stats.json", job->name);
+        fputs(",\"stats\":", manifest);
+        write_json_string(manifest, stats_name);
+        g_free(stats_name);
+        if (state->config->zones.path)
+        {
+            gchar* zones_name = g_strdup_printf("%s_zones.%s", job->name,
+                                                state->config->zones.as_json ? "json" : "csv");
+            fputs(",\"zones\":", manifest);
+            write_json_string(manifest, zones_name);
+            g_free(zones_name);
+        }
+        fprintf(manifest, ",\"compute_s\":%.3f,\"latency_s\":%.3f}\n", compute_s, latency_s);
+        fclose(manifest);
+    }
+    else
+    {
+        fprintf(stderr, "[%s] Nie można dopisać do %s.\n", get_timestamp(), state->manifest_path);
+    }
+    g_mutex_unlock(&state->lock);
+}
+
+static void on_stop_signal(int signal_number)
+{
+    (void)signal_number;
+    stop_requested = 1;
+}
+
+static void install_stop_handlers(void)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+static unsigned int required_band_mask(void)
+{
+    return pipeline_index_band_mask(get_pipeline_index_selection());
+}
+
+// Klucz sceny: część nazwy przed nazwą pasma, bez końcowych separatorów
+static char* scene_key_from_filename(const char* filename, int band)
+{
+    const char* band_position = strstr(filename, pipeline_band_name(band));
+    char* key = g_strndup(filename, band_position - filename);
+
+    size_t length = strlen(key);
+    while (length > 0 && (key[length - 1] == '_' || key[length - 1] == '-' || key[length - 1] == '.'))
+    {
+        key[--length] = '\0';
+    }
+
+    if (length == 0)
+    {
+        g_free(key);
+        return g_strdup("scena");
+    }
+    return key;
+}
+
+static bool is_raster_filename(const char* filename)
+{
+    return filename[0] != '.' &&
+           (g_str_has_suffix(filename, ".jp2") || g_str_has_suffix(filename, ".tif") ||
+            g_str_has_suffix(filename, ".tiff"));
+}
@@ -0,0 +1,52 @@
+#ifndef WATCH_DAEMON_H
+#define WATCH_DAEMON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../batch_scheduler/batch_scheduler.h"
+
+/**
+ * @brief Konfiguracja trybu demona obserwującego katalog wejściowy
+ */
+typedef struct
+{
+    const char* watch_dir;
+    const char* output_dir;
+    int workers;
+    int threads_per_scene;
+    bool target_10m;
+    // Reprezentacja wskaźników w wynikach scen (PIPELINE_VALUES_INT16 - połowa pamięci)
+    PipelineValueType value_type;
+    // Układ pasm na etapie wskaźników (PIPELINE_LAYOUT_TILED - pasma spakowane w kafle)
+    PipelineBandLayout band_layout;
+    // Pojemność puli buforów rastrów współdzielonej przez kolejne sceny, 0 wyłącza ponowne użycie
+    size_t buffer_pool_bytes;
+    // Suma flag BatchExportFormat, 0 - BATCH_EXPORT_PNG
+    unsigned int export_formats;
+    ZonalExportConfig zones;
+} WatchConfig;
+
+/**
+ * @brief Obserwuje katalog (inotify) i przetwarza kompletne sceny w ciepłej puli wątków
+ *
+ * Pliki .jp2/.tif/.tiff zapisane (IN_CLOSE_WRITE) lub przeniesione (IN_MOVED_TO) do katalogu
+ * grupowane są w sceny według części nazwy przed nazwą pasma (np. T34UDC_20230601T095031
+ * dla T34UDC_20230601T095031_B04_10m.jp2); pasmo rozpoznawane jest przez
+ * band_registry_detect_filename(). Pliki w rozdzielczości innej niż natywna dla pasma są
+ * pomijane. Gdy scena ma komplet pasm wybranych wskaźników (pipeline_index_band_mask(), np. B04/B08/B11/SCL
+ * dla NDVI i NDMI), trafia do puli wątków, która zapisuje
+ * <scena>_NDVI.png i <scena>_NDMI.png (lub <scena>.zarr, patrz export_formats) w katalogu
+ * wyjściowym i dopisuje linię JSON do <output_dir>/completed.jsonl (status, ścieżki map,
+ * opóźnienie od nadejścia ostatniego pliku). Przy --metrics-json każda scena (przy kilku
+ * scenach jednocześnie - każdy okres nakładających się scen) dopisuje przebieg metryk.
+ *
+ * Pliki obecne w katalogu przy starcie są traktowane jak nowo przybyłe. Sterowniki GDAL
+ * rejestrowane są raz, przy starcie. Demon działa do SIGINT/SIGTERM, po których kończy
+ * sceny już przekazane do puli.
+ *
+ * @return 0 po poprawnym zatrzymaniu, -1 gdy nie można obserwować katalogu
+ */
+int run_watch_daemon(const WatchConfig* config);
+
+#endif // WATCH_DAEMON_H
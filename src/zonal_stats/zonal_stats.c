@@ -0,0 +1,537 @@
+#include "zonal_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <omp.h>
+
+#include "../index_calculator/index_calculator.h"
+#include "../utils/utils.h"
+
+// Początkowa pojemność tablicy stref wątku (potęga 2), rośnie dwukrotnie przy zapełnieniu w połowie
+#define INITIAL_ZONE_CAPACITY 1024
+#define ZONE_SLOT_NONE ((size_t)-1)
+
+/**
+ * @brief Tablica mieszająca stref jednego wątku (adresowanie otwarte, próbkowanie liniowe)
+ *
+ * Wolne wpisy mają klucz ZONE_BACKGROUND_LABEL, który nigdy nie jest wstawiany.
+ */
+typedef struct
+{
+    size_t capacity;
+    size_t count;
+    int index_count;
+    uint32_t* keys;
+    uint64_t* pixel_counts;
+    ZoneIndexStats* stats;
+} ZoneTable;
+
+typedef struct
+{
+    uint32_t label;
+    size_t slot;
+} ZoneEntry;
+
+// ====== TABLICA STREF ======
+static int zone_table_init(ZoneTable* table, int index_count, size_t capacity);
+static void zone_table_free(ZoneTable* table);
+static size_t zone_table_slot(ZoneTable* table, uint32_t label);
+static int zone_table_grow(ZoneTable* table);
+static uint32_t hash_label(uint32_t label);
+// ====== AKUMULACJA ======
+static ZonalStats* compute_zones(const uint32_t* labels, const float* const* values,
+                                 const int16_t* const* quantized, int index_count, size_t num_pixels);
+static int accumulate_zone_range(ZoneTable* table, const uint32_t* labels, const float* const* values,
+                                 const int16_t* const* quantized, size_t begin, size_t end);
+static void accumulate_zone_run(ZoneIndexStats* stats, const float* values, size_t begin, size_t end);
+static void accumulate_quantized_zone_run(ZoneIndexStats* stats, const int16_t* values, size_t begin, size_t end);
+static void merge_zone_index_stats(ZoneIndexStats* dst, const ZoneIndexStats* src);
+static ZonalStats* collect_zones(ZoneTable* tables, int table_count);
+static int compare_zone_entries(const void* a, const void* b);
+
+ZonalStats* zonal_stats_compute(const uint32_t* labels, const float* const* values, int index_count,
+                                size_t num_pixels)
+{
+    return compute_zones(labels, values, NULL, index_count, num_pixels);
+}
+
+ZonalStats* zonal_stats_compute_quantized(const uint32_t* labels, const int16_t* const* values, int index_count,
+                                          size_t num_pixels)
+{
+    return compute_zones(labels, NULL, values, index_count, num_pixels);
+}
+
+void zonal_stats_free(ZonalStats* zonal)
+{
+    if (!zonal)
+    {
+        return;
+    }
+    free(zonal->labels);
+    free(zonal->pixel_counts);
+    free(zonal->stats);
+    free(zonal);
+}
+
+double zone_index_mean(const ZoneIndexStats* stats)
+{
+    return stats->valid_pixels > 0 ? stats->sum / stats->valid_pixels : 0.0;
+}
+
+double zone_index_stddev(const ZoneIndexStats* stats)
+{
+    if (stats->valid_pixels == 0)
+    {
+        return 0.0;
+    }
+    double mean = zone_index_mean(stats);
+    double variance = stats->sum_squares / stats->valid_pixels - mean * mean;
+    return variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+// ====== ZAPIS ======
+
+int zonal_stats_write_csv(const ZonalStats* zonal, const char* const* index_names, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można zapisać statystyk stref %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    fputs("zone,pixels", file);
+    for (int k = 0; k < zonal->index_count; k++)
+    {
+        const char* name = index_names[k];
+        fprintf(file, ",%s_count,%s_mean,%s_min,%s_max,%s_stddev", name, name, name, name, name);
+    }
+    fputc('\n', file);
+
+    for (size_t z = 0; z < zonal->zone_count; z++)
+    {
+        fprintf(file, "%u,%llu", zonal->labels[z], (unsigned long long)zonal->pixel_counts[z]);
+        for (int k = 0; k < zonal->index_count; k++)
+        {
+            const ZoneIndexStats* stats = &zonal->stats[z * zonal->index_count + k];
+            if (stats->valid_pixels == 0)
+            {
+                fputs(",0,,,,", file);
+                continue;
+            }
+            fprintf(file, ",%llu,%.6f,%.6f,%.6f,%.6f", (unsigned long long)stats->valid_pixels,
+                    zone_index_mean(stats), stats->min, stats->max, zone_index_stddev(stats));
+        }
+        fputc('\n', file);
+    }
+
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0)
+    {
+        status = -1;
+    }
+    return status;
+}
+
+int zonal_stats_write_json(const ZonalStats* zonal, const char* const* index_names, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s] Nie można zapisać statystyk stref %s.\n", get_timestamp(), path);
+        return -1;
+    }
+
+    fputs("{\"zones\":[", file);
+    for (size_t z = 0; z < zonal->zone_count; z++)
+    {
+        fprintf(file, "%s\n{\"zone\":%u,\"pixels\":%llu", z > 0 ? "," : "", zonal->labels[z],
+                (unsigned long long)zonal->pixel_counts[z]);
+        for (int k = 0; k < zonal->index_count; k++)
+        {
+            const ZoneIndexStats* stats = &zonal->stats[z * zonal->index_count + k];
+            if (stats->valid_pixels == 0)
+            {
+                fprintf(file, ",\"%s\":null", index_names[k]);
+                continue;
+            }
+            fprintf(file, ",\"%s\":{\"count\":%llu,\"mean\":%.6f,\"min\":%.6f,\"max\":%.6f,\"stddev\":%.6f}",
+                    index_names[k], (unsigned long long)stats->valid_pixels, zone_index_mean(stats),
+                    stats->min, stats->max, zone_index_stddev(stats));
+        }
+        fputc('}', file);
+    }
+    fputs("\n]}\n", file);
+
+    int status = ferror(file) ? -1 : 0;
+    if (fclose(file) != 0)
+    {
+        status = -1;
+    }
+    return status;
+}
+
+// ====== AKUMULACJA ======
+
+// Rastry float (values) albo int16 (quantized) - drugi wskaźnik jest NULL
+static ZonalStats* compute_zones(const uint32_t* labels, const float* const* values,
+                                 const int16_t* const* quantized, int index_count, size_t num_pixels)
+{
+    if (!labels || (!values && !quantized) || index_count <= 0)
+    {
+        fprintf(stderr, "[%s] Nieprawidłowe dane wejściowe statystyk stref.\n", get_timestamp());
+        return NULL;
+    }
+
+    int max_threads = omp_get_max_threads();
+    ZoneTable* tables = calloc(max_threads, sizeof(ZoneTable));
+    if (!tables)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla statystyk stref.\n", get_timestamp());
+        return NULL;
+    }
+
+    int thread_count = 1;
+    int error_flag = 0;
+
+    // Każdy wątek dostaje ciągły zakres pikseli (pas wierszy) - działki leżą w nim w całości
+    // lub na granicy pasów, więc tablice wątków są małe, a ciągi pikseli strefy długie
+    #pragma omp parallel num_threads(max_threads) shared(tables, thread_count, error_flag)
+    {
+        int thread = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        size_t begin = num_pixels * thread / threads;
+        size_t end = num_pixels * (thread + 1) / threads;
+
+        #pragma omp single nowait
+        thread_count = threads;
+
+        if (zone_table_init(&tables[thread], index_count, INITIAL_ZONE_CAPACITY) != 0 ||
+            accumulate_zone_range(&tables[thread], labels, values, quantized, begin, end) != 0)
+        {
+            #pragma omp atomic write
+            error_flag = 1;
+        }
+    }
+
+    ZonalStats* zonal = NULL;
+    if (error_flag)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla statystyk stref.\n", get_timestamp());
+    }
+    else
+    {
+        zonal = collect_zones(tables, thread_count);
+    }
+
+    for (int t = 0; t < max_threads; t++)
+    {
+        zone_table_free(&tables[t]);
+    }
+    free(tables);
+    return zonal;
+}
+
+static int accumulate_zone_range(ZoneTable* table, const uint32_t* labels, const float* const* values,
+                                 const int16_t* const* quantized, size_t begin, size_t end)
+{
+    const int index_count = table->index_count;
+    size_t i = begin;
+
+    while (i < end)
+    {
+        uint32_t label = labels[i];
+        size_t run_end = i + 1;
+        while (run_end < end && labels[run_end] == label)
+        {
+            run_end++;
+        }
+        if (label == ZONE_BACKGROUND_LABEL)
+        {
+            i = run_end;
+            continue;
+        }
+
+        size_t slot = zone_table_slot(table, label);
+        if (slot == ZONE_SLOT_NONE)
+        {
+            return -1;
+        }
+        table->pixel_counts[slot] += run_end - i;
+
+        ZoneIndexStats* stats = &table->stats[slot * index_count];
+        for (int k = 0; k < index_count; k++)
+        {
+            if (quantized)
+            {
+                accumulate_quantized_zone_run(&stats[k], quantized[k], i, run_end);
+            }
+            else
+            {
+                accumulate_zone_run(&stats[k], values[k], i, run_end);
+            }
+        }
+        i = run_end;
+    }
+    return 0;
+}
+
+// Ciąg pikseli strefy wzdłuż wiersza sumowany w zmiennych lokalnych, wpis strefy
+// aktualizowany raz na ciąg
+static void accumulate_zone_run(ZoneIndexStats* stats, const float* values, size_t begin, size_t end)
+{
+    uint64_t valid = 0;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    float min = stats->min;
+    float max = stats->max;
+
+    for (size_t p = begin; p < end; p++)
+    {
+        float value = values[p];
+        if (value == INDEX_NO_DATA_VALUE)
+        {
+            continue;
+        }
+        valid++;
+        sum += value;
+        sum_squares += (double)value * value;
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+
+    stats->valid_pixels += valid;
+    stats->sum += sum;
+    stats->sum_squares += sum_squares;
+    stats->min = min;
+    stats->max = max;
+}
+
+// Wartości int16 czytane wprost - skalowanie jak w dequantize_index_values(), więc statystyki
+// są takie same jak dla rastra float odtworzonego z tych wartości
+static void accumulate_quantized_zone_run(ZoneIndexStats* stats, const int16_t* values, size_t begin, size_t end)
+{
+    const float inverse_scale = 1.0f / INDEX_INT16_SCALE;
+    uint64_t valid = 0;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    float min = stats->min;
+    float max = stats->max;
+
+    for (size_t p = begin; p < end; p++)
+    {
+        if (values[p] == INDEX_INT16_NO_DATA)
+        {
+            continue;
+        }
+        float value = values[p] * inverse_scale;
+        valid++;
+        sum += value;
+        sum_squares += (double)value * value;
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+
+    stats->valid_pixels += valid;
+    stats->sum += sum;
+    stats->sum_squares += sum_squares;
+    stats->min = min;
+    stats->max = max;
+}
+
+static void merge_zone_index_stats(ZoneIndexStats* dst, const ZoneIndexStats* src)
+{
+    dst->valid_pixels += src->valid_pixels;
+    dst->sum += src->sum;
+    dst->sum_squares += src->sum_squares;
+    dst->min = src->min < dst->min ? src->min : dst->min;
+    dst->max = src->max > dst->max ? src->max : dst->max;
+}
+
+// Łączy tablice wątków w pierwszą i zwraca strefy posortowane według etykiety
+static ZonalStats* collect_zones(ZoneTable* tables, int table_count)
+{
+    ZoneTable* merged = &tables[0];
+    const int index_count = merged->index_count;
+
+    // Wspólne są tylko strefy przecinające granice pasów wątków, więc łączenie jest krótkie
+    for (int t = 1; t < table_count; t++)
+    {
+        const ZoneTable* table = &tables[t];
+        for (size_t s = 0; s < table->capacity; s++)
+        {
+            if (table->keys[s] == ZONE_BACKGROUND_LABEL)
+            {
+                continue;
+            }
+            size_t slot = zone_table_slot(merged, table->keys[s]);
+            if (slot == ZONE_SLOT_NONE)
+            {
+                fprintf(stderr, "[%s] Błąd alokacji pamięci dla statystyk stref.\n", get_timestamp());
+                return NULL;
+            }
+            merged->pixel_counts[slot] += table->pixel_counts[s];
+            for (int k = 0; k < index_count; k++)
+            {
+                merge_zone_index_stats(&merged->stats[slot * index_count + k],
+                                       &table->stats[s * index_count + k]);
+            }
+        }
+    }
+
+    size_t zone_count = merged->count;
+    ZonalStats* zonal = calloc(1, sizeof(ZonalStats));
+    ZoneEntry* entries = malloc((zone_count > 0 ? zone_count : 1) * sizeof(ZoneEntry));
+    if (zonal)
+    {
+        zonal->zone_count = zone_count;
+        zonal->index_count = index_count;
+        zonal->labels = malloc((zone_count > 0 ? zone_count : 1) * sizeof(uint32_t));
+        zonal->pixel_counts = malloc((zone_count > 0 ? zone_count : 1) * sizeof(uint64_t));
+        zonal->stats = malloc((zone_count > 0 ? zone_count : 1) * index_count * sizeof(ZoneIndexStats));
+    }
+    if (!zonal || !entries || !zonal->labels || !zonal->pixel_counts || !zonal->stats)
+    {
+        fprintf(stderr, "[%s] Błąd alokacji pamięci dla statystyk stref.\n", get_timestamp());
+        free(entries);
+        zonal_stats_free(zonal);
+        return NULL;
+    }
+
+    size_t n = 0;
+    for (size_t s = 0; s < merged->capacity; s++)
+    {
+        if (merged->keys[s] != ZONE_BACKGROUND_LABEL)
+        {
+            entries[n].label = merged->keys[s];
+            entries[n].slot = s;
+            n++;
+        }
+    }
+    qsort(entries, zone_count, sizeof(ZoneEntry), compare_zone_entries);
+
+    for (size_t z = 0; z < zone_count; z++)
+    {
+        size_t s = entries[z].slot;
+        zonal->labels[z] = entries[z].label;
+        zonal->pixel_counts[z] = merged->pixel_counts[s];
+        memcpy(&zonal->stats[z * index_count], &merged->stats[s * index_count],
+               index_count * sizeof(ZoneIndexStats));
+    }
+
+    free(entries);
+    return zonal;
+}
+
+static int compare_zone_entries(const void* a, const void* b)
+{
+    uint32_t label_a = ((const ZoneEntry*)a)->label;
+    uint32_t label_b = ((const ZoneEntry*)b)->label;
+    return (label_a > label_b) - (label_a < label_b);
+}
+
+// ====== TABLICA STREF ======
+
+static int zone_table_init(ZoneTable* table, int index_count, size_t capacity)
+{
+    table->capacity = capacity;
+    table->count = 0;
+    table->index_count = index_count;
+    table->keys = calloc(capacity, sizeof(uint32_t));
+    table->pixel_counts = malloc(capacity * sizeof(uint64_t));
+    table->stats = malloc(capacity * index_count * sizeof(ZoneIndexStats));
+    return table->keys && table->pixel_counts && table->stats ? 0 : -1;
+}
+
+static void zone_table_free(ZoneTable* table)
+{
+    free(table->keys);
+    free(table->pixel_counts);
+    free(table->stats);
+    memset(table, 0, sizeof(*table));
+}
+
+// Zwraca wpis strefy, wstawiając nowy (wyzerowany) przy pierwszym wystąpieniu etykiety
+static size_t zone_table_slot(ZoneTable* table, uint32_t label)
+{
+    size_t mask = table->capacity - 1;
+    size_t slot = hash_label(label) & mask;
+
+    while (table->keys[slot] != ZONE_BACKGROUND_LABEL)
+    {
+        if (table->keys[slot] == label)
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (2 * (table->count + 1) > table->capacity)
+    {
+        if (zone_table_grow(table) != 0)
+        {
+            return ZONE_SLOT_NONE;
+        }
+        return zone_table_slot(table, label);
+    }
+
+    table->keys[slot] = label;
+    table->pixel_counts[slot] = 0;
+    for (int k = 0; k < table->index_count; k++)
+    {
+        ZoneIndexStats* stats = &table->stats[slot * table->index_count + k];
+        stats->valid_pixels = 0;
+        stats->sum = 0.0;
+        stats->sum_squares = 0.0;
+        stats->min = FLT_MAX;
+        stats->max = -FLT_MAX;
+    }
+    table->count++;
+    return slot;
+}
+
+static int zone_table_grow(ZoneTable* table)
+{
+    ZoneTable grown;
+    if (zone_table_init(&grown, table->index_count, table->capacity * 2) != 0)
+    {
+        zone_table_free(&grown);
+        return -1;
+    }
+
+    size_t mask = grown.capacity - 1;
+    for (size_t s = 0; s < table->capacity; s++)
+    {
+        if (table->keys[s] == ZONE_BACKGROUND_LABEL)
+        {
+            continue;
+        }
+        size_t slot = hash_label(table->keys[s]) & mask;
+        while (grown.keys[slot] != ZONE_BACKGROUND_LABEL)
+        {
+            slot = (slot + 1) & mask;
+        }
+        grown.keys[slot] = table->keys[s];
+        grown.pixel_counts[slot] = table->pixel_counts[s];
+        memcpy(&grown.stats[slot * grown.index_count], &table->stats[s * table->index_count],
+               table->index_count * sizeof(ZoneIndexStats));
+    }
+
+    grown.count = table->count;
+    zone_table_free(table);
+    *table = grown;
+    return 0;
+}
+
+// Mieszanie bitów etykiety (finalizer MurmurHash3) - kolejne numery działek nie tworzą skupisk
+static uint32_t hash_label(uint32_t label)
+{
+    label ^= label >> 16;
+    label *= 0x85ebca6bu;
+    label ^= label >> 13;
+    label *= 0xc2b2ae35u;
+    label ^= label >> 16;
+    return label;
+}
@@ -0,0 +1,99 @@
+#ifndef ZONAL_STATS_H
+#define ZONAL_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Etykieta pikseli poza strefami (tło rastra stref, np. wartość początkowa gdal_rasterize)
+#define ZONE_BACKGROUND_LABEL 0u
+
+/**
+ * @brief Statystyki jednego wskaźnika w jednej strefie
+ *
+ * Piksele INDEX_NO_DATA_VALUE nie są wliczane. Suma i suma kwadratów trzymane są w double -
+ * wartości wskaźników mieszczą się w [-1, 1], a strefy (działki) mają zwykle do kilku
+ * milionów pikseli, więc dokładność wariancji jest wystarczająca.
+ */
+typedef struct
+{
+    uint64_t valid_pixels;
+    double sum;
+    double sum_squares;
+    float min;
+    float max;
+} ZoneIndexStats;
+
+/**
+ * @brief Statystyki stref dla zestawu wskaźników
+ *
+ * Strefy posortowane są rosnąco według etykiety. Statystyki wskaźnika k strefy z
+ * znajdują się w stats[z * index_count + k].
+ */
+typedef struct
+{
+    size_t zone_count;
+    int index_count;
+    uint32_t* labels;
+    uint64_t* pixel_counts;
+    ZoneIndexStats* stats;
+} ZonalStats;
+
+/**
+ * @brief Liczy statystyki stref w jednym równoległym przejściu po rastrach (OpenMP)
+ *
+ * Każdy wątek przetwarza ciągły zakres pikseli i zbiera statystyki we własnej tablicy
+ * mieszającej stref, więc nie ma blokad per strefa; ciąg pikseli tej samej strefy wzdłuż
+ * wiersza sumowany jest lokalnie i wymaga jednego wyszukiwania w tablicy. Tablice
+ * wątków są na końcu łączone i sortowane według etykiety. Pamięć rośnie z liczbą stref
+ * widzianych przez wątek, a nie z największą etykietą, więc miliony działek na kafel
+ * nie wymagają tablicy indeksowanej etykietą.
+ *
+ * @param labels Etykiety stref na siatce wyniku (ZONE_BACKGROUND_LABEL - piksel pomijany)
+ * @param values Tablica index_count rastrów wskaźników o num_pixels pikselach
+ * @return Statystyki do zwolnienia przez zonal_stats_free() lub NULL w przypadku błędu
+ */
+ZonalStats* zonal_stats_compute(const uint32_t* labels, const float* const* values, int index_count,
+                                size_t num_pixels);
+
+/**
+ * @brief zonal_stats_compute() dla rastrów skwantowanych do int16 (quantize_index_values())
+ *
+ * Wartości int16 czytane są wprost, bez rastrów float; statystyki są w jednostkach wskaźnika,
+ * a piksele INDEX_INT16_NO_DATA nie są wliczane.
+ */
+ZonalStats* zonal_stats_compute_quantized(const uint32_t* labels, const int16_t* const* values, int index_count,
+                                          size_t num_pixels);
+
+void zonal_stats_free(ZonalStats* zonal);
+
+/**
+ * @brief Średnia wskaźnika w strefie (0 gdy strefa nie ma pikseli ważnych)
+ */
+double zone_index_mean(const ZoneIndexStats* stats);
+
+/**
+ * @brief Odchylenie standardowe (populacji) wskaźnika w strefie
+ */
+double zone_index_stddev(const ZoneIndexStats* stats);
+
+/**
+ * @brief Zapisuje statystyki jako CSV
+ *
+ * Kolumny: zone, pixels oraz dla każdego wskaźnika <NAZWA>_count, <NAZWA>_mean,
+ * <NAZWA>_min, <NAZWA>_max, <NAZWA>_stddev. Strefy bez pikseli ważnych mają puste pola.
+ *
+ * @param index_names Nazwy index_count wskaźników w kolejności values z zonal_stats_compute()
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu zapisu
+ */
+int zonal_stats_write_csv(const ZonalStats* zonal, const char* const* index_names, const char* path);
+
+/**
+ * @brief Zapisuje statystyki jako JSON: {"zones":[{"zone":ID,"pixels":N,"<NAZWA>":{...}}]}
+ *
+ * Wskaźnik bez pikseli ważnych w strefie ma wartość null.
+ *
+ * @return 0 w przypadku sukcesu, -1 w przypadku błędu zapisu
+ */
+int zonal_stats_write_json(const ZonalStats* zonal, const char* const* index_names, const char* path);
+
+#endif // ZONAL_STATS_H